@@ -0,0 +1,380 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Groovy -- A native launcher for Groovy
+#
+#  Copyright © 2007-10 Russel Winder & Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+#
+#  Author : Russel Winder <russel.winder@concertant.com>, Antti Karanta <firstname dot lastname (at) hornankuusi dot fi>
+
+#  Startup time benchmark for the native launchers.  Each scenario is run a number of times both via the native
+#  launcher and via the java executable launching the very same main class with the very same jvm options and
+#  program arguments (these are taken from the debug output of the native launcher, so the comparison stays
+#  honest when the launcher changes).  Wall time and peak RSS of each run are recorded and the statistics written
+#  as JSON.
+#
+#  The launchers find groovy and gant via GROOVY_HOME and GANT_HOME, and java via JAVA_HOME, the same way as
+#  the tests do.  Scenarios that can not be run in the current environment are reported as skipped.
+#
+#  In addition, the time groovy --flat-classpath takes to turn a groovy-starter.conf listing thousands of jars
+#  into a classpath is measured from the launcher trace, for a growing number of jars.  The time per jar should
+#  stay flat, i.e. the classpath assembly be linear in the number of jars.
+#
+#  Likewise, the time groovy takes to classify a huge number of command line arguments (params phase) and to
+#  get everything ready for starting the jvm (params up to dlopen, which includes looking up the values of
+#  the launcher options) is measured for up to 100000 arguments.
+#
+#  Finally, the tail exit latency of groovy -e '', i.e. the time from the main method returning to the process having
+#  exited, is measured both w/ the jvm destroyed as usual and w/ --fast-exit.
+
+import json
+import math
+import os
+import platform
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+import timeit
+
+class NativeLauncherBenchmark :
+
+    def __init__ ( self , buildDirectory , iterations = 20 , outputFile = 'bench-results.json' , warmupRounds = 2 ) :
+        self._buildDirectory = buildDirectory
+        self._iterations = iterations
+        self._outputFile = outputFile
+        self._warmupRounds = warmupRounds
+        self._classpathJarCounts = [ 5000 , 10000 , 20000 ]
+        self._argumentCounts = [ 1000 , 10000 , 100000 ]
+
+    def runBenchmarks ( self , target , source , env ) :
+        executables = { }
+        for item in source :
+            ( root , ext ) = os.path.splitext ( item.name )
+            if root not in executables : executables[ root ] = os.path.abspath ( item.path )
+        workDirectory = tempfile.mkdtemp ( prefix = 'jlauncher-bench' )
+        try :
+            results = [ ]
+            for ( name , launcher , args ) in self._scenarios ( executables , workDirectory ) :
+                results += self._runScenario ( name , launcher , args , workDirectory )
+            classpathResults = self._classpathAssembly ( executables.get ( 'groovy' ) , workDirectory )
+            parameterResults = self._parameterProcessing ( executables.get ( 'groovy' ) , workDirectory )
+            exitResults = self._exitLatency ( executables.get ( 'groovy' ) , workDirectory )
+        finally :
+            shutil.rmtree ( workDirectory , True )
+        report = {
+            'timestamp' : time.strftime ( '%Y-%m-%dT%H:%M:%S' ) ,
+            'platform' : env[ 'PLATFORM' ] ,
+            'machine' : platform.uname ( )[ 4 ] ,
+            'iterations' : self._iterations ,
+            'results' : results ,
+            'classpathAssembly' : classpathResults ,
+            'parameterProcessing' : parameterResults ,
+            'exitLatency' : exitResults ,
+            }
+        outputFile = open ( self._outputFile , 'w' )
+        try :
+            json.dump ( report , outputFile , indent = 2 , sort_keys = True )
+        finally :
+            outputFile.close ( )
+        print ( 'benchmark results written to ' + self._outputFile )
+        return None
+
+    def _scenarios ( self , executables , workDirectory ) :
+        scenarios = [ ]
+        groovy = executables.get ( 'groovy' )
+        if groovy :
+            scenarios.append ( ( "groovy -e ''" , groovy , [ '-e' , '' ] ) )
+            scenarios.append ( ( 'groovy -v' , groovy , [ '-v' ] ) )
+            #  groovyc is the groovy executable under a different name.
+            groovyc = os.path.join ( workDirectory , 'groovyc' + os.path.splitext ( groovy )[ 1 ] )
+            shutil.copy2 ( groovy , groovyc )
+            source = os.path.join ( workDirectory , 'Hello.groovy' )
+            sourceFile = open ( source , 'w' )
+            sourceFile.write ( 'class Hello { static void main ( String[] args ) { println "hello" } }\n' )
+            sourceFile.close ( )
+            scenarios.append ( ( 'groovyc Hello.groovy' , groovyc , [ '-d' , os.path.join ( workDirectory , 'classes' ) , source ] ) )
+        gant = executables.get ( 'gant' )
+        if gant :
+            scenarios.append ( ( 'gant -V' , gant , [ '-V' ] ) )
+        return scenarios
+
+    def _runScenario ( self , name , launcher , args , workDirectory ) :
+        javaCommand = self._equivalentJavaCommand ( launcher , args , workDirectory )
+        if not javaCommand :
+            print ( 'skipping ' + name + ': the launcher does not run in this environment' )
+            return [ { 'name' : name , 'launcher' : 'native' , 'skipped' : True } ]
+        results = [ ]
+        for ( kind , command ) in [ ( 'native' , [ launcher ] + args ) , ( 'java' , javaCommand ) ] :
+            sys.stdout.write ( 'benchmarking ' + name + ' (' + kind + ')' )
+            sys.stdout.flush ( )
+            try :
+                results.append ( self._measure ( name , kind , command , workDirectory ) )
+            except OSError as error :
+                sys.stdout.write ( ' skipped: ' + str ( error ) )
+                results.append ( { 'name' : name , 'launcher' : kind , 'command' : command , 'skipped' : True } )
+            print ( '' )
+        return results
+
+    def _equivalentJavaCommand ( self , launcher , args , workDirectory ) :
+        '''Returns the java command line that starts the same main class with the same jvm options and program
+        args as the given native launcher invocation, or None if the launcher fails.'''
+        environment = dict ( os.environ )
+        environment[ '__JLAUNCHER_DEBUG' ] = 'true'
+        process = subprocess.Popen ( [ launcher ] + args , cwd = workDirectory , env = environment , stdout = subprocess.PIPE , stderr = subprocess.PIPE )
+        ( output , errors ) = process.communicate ( )
+        if process.returncode != 0 : return None
+        lines = errors.decode ( 'utf-8' , 'replace' ).splitlines ( )
+        jvmOptions = self._listAfter ( lines , re.compile ( r'Starting jvm with the following (\d+) options:' ) )
+        programArgs = self._listAfter ( lines , re.compile ( r'passing (\d+) parameters to main method:' ) )
+        mainClass = None
+        for line in lines :
+            match = re.match ( r'DEBUG: invoking (\S+)\.\w+$' , line )
+            if match : mainClass = match.group ( 1 ).replace ( '/' , '.' )
+        if jvmOptions is None or programArgs is None or not mainClass : return None
+        javaHome = os.environ.get ( 'JAVA_HOME' )
+        java = os.path.join ( javaHome , 'bin' , 'java' ) if javaHome else 'java'
+        command = [ java ]
+        for option in jvmOptions :
+            #  The java executable sets java.class.path itself, so it must be given as -cp.
+            if option.startswith ( '-Djava.class.path=' ) : command += [ '-cp' , option[ len ( '-Djava.class.path=' ) : ] ]
+            else : command.append ( option )
+        return command + [ mainClass ] + programArgs
+
+    def _listAfter ( self , lines , headerPattern ) :
+        for i in range ( len ( lines ) ) :
+            match = headerPattern.search ( lines[ i ] )
+            if match :
+                count = int ( match.group ( 1 ) )
+                return [ line[ 2: ] for line in lines[ i + 1 : i + 1 + count ] ]
+        return None
+
+    def _classpathAssembly ( self , groovy , workDirectory ) :
+        '''Times the starterconf launch phase of groovy --flat-classpath w/ a conf file that loads a dir of the given
+        number of (empty) jars.  The jvm is still started, but whether it manages to run anything does not matter.'''
+        if not groovy : return None
+        traceFile = os.path.join ( workDirectory , 'trace.json' )
+        environment = dict ( os.environ )
+        environment[ '__JLAUNCHER_TRACE' ] = traceFile
+        environment[ '__JLAUNCHER_NOCACHE' ] = 'true'
+        environment[ '__JLAUNCHER_NOPREFETCH' ] = 'true'
+        results = [ ]
+        for jarCount in self._classpathJarCounts :
+            libDirectory = os.path.join ( workDirectory , 'lib%d' % jarCount )
+            os.mkdir ( libDirectory )
+            for i in range ( jarCount ) :
+                open ( os.path.join ( libDirectory , 'library-%05d.jar' % i ) , 'w' ).close ( )
+            confFile = os.path.join ( workDirectory , 'starter%d.conf' % jarCount )
+            conf = open ( confFile , 'w' )
+            try :
+                conf.write ( 'load ' + os.path.join ( libDirectory , '*.jar' ) + '\n' )
+            finally :
+                conf.close ( )
+            sys.stdout.write ( 'benchmarking classpath assembly of %d jars' % jarCount )
+            times = [ ]
+            for i in range ( self._warmupRounds + self._iterations ) :
+                if os.path.exists ( traceFile ) : os.remove ( traceFile )
+                devnull = open ( os.devnull , 'w' )
+                try :
+                    subprocess.call ( [ groovy , '--flat-classpath' , '--conf' , confFile , '-e' , '' ] , cwd = workDirectory , env = environment , stdout = devnull , stderr = devnull )
+                finally :
+                    devnull.close ( )
+                duration = self._tracedPhaseDuration ( traceFile , 'starterconf' )
+                if duration is None : break
+                if i < self._warmupRounds : continue
+                times.append ( duration / 1000.0 )
+                sys.stdout.write ( '.' )
+                sys.stdout.flush ( )
+            print ( '' )
+            if not times :
+                print ( 'skipping classpath assembly: the launcher did not record the starterconf phase' )
+                return None
+            statistics = self._statistics ( times )
+            results.append ( {
+                'jars' : jarCount ,
+                'starterconfMs' : statistics ,
+                'microsPerJar' : statistics[ 'median' ] * 1000.0 / jarCount ,
+                } )
+        return results
+
+    def _parameterProcessing ( self , groovy , workDirectory ) :
+        '''Times classifying the given number of groovy options (-d, repeated) followed by -e '', the launcher
+        work up to loading the jvm and turning the arguments into the String[] given to main.  The commands are too long
+        for Windows, so nothing is measured there.'''
+        if not groovy or sys.platform == 'win32' : return None
+        traceFile = os.path.join ( workDirectory , 'trace.json' )
+        environment = dict ( os.environ )
+        environment[ '__JLAUNCHER_TRACE' ] = traceFile
+        environment[ '__JLAUNCHER_NOCACHE' ] = 'true'
+        environment[ '__JLAUNCHER_NOPREFETCH' ] = 'true'
+        results = [ ]
+        for argumentCount in self._argumentCounts :
+            command = [ groovy ] + [ '-d' ] * argumentCount + [ '-e' , '' ]
+            sys.stdout.write ( 'benchmarking processing of %d arguments' % argumentCount )
+            paramsTimes = [ ]
+            launcherTimes = [ ]
+            mainArgsTimes = [ ]
+            for i in range ( self._warmupRounds + self._iterations ) :
+                if os.path.exists ( traceFile ) : os.remove ( traceFile )
+                devnull = open ( os.devnull , 'w' )
+                try :
+                    subprocess.call ( command , cwd = workDirectory , env = environment , stdout = devnull , stderr = devnull )
+                finally :
+                    devnull.close ( )
+                phases = self._tracedPhases ( traceFile )
+                if 'params' not in phases or 'dlopen' not in phases : break
+                if i < self._warmupRounds : continue
+                paramsTimes.append ( phases[ 'params' ][ 'dur' ] / 1000.0 )
+                launcherTimes.append ( ( phases[ 'dlopen' ][ 'ts' ] - phases[ 'params' ][ 'ts' ] ) / 1000.0 )
+                if 'mainargs' in phases : mainArgsTimes.append ( phases[ 'mainargs' ][ 'dur' ] / 1000.0 )
+                sys.stdout.write ( '.' )
+                sys.stdout.flush ( )
+            print ( '' )
+            if not paramsTimes :
+                print ( 'skipping parameter processing: the launcher did not record the params and dlopen phases' )
+                return None
+            statistics = self._statistics ( paramsTimes )
+            results.append ( {
+                'arguments' : argumentCount ,
+                'paramsMs' : statistics ,
+                'launcherMs' : self._statistics ( launcherTimes ) ,
+                'microsPerArgument' : statistics[ 'median' ] * 1000.0 / argumentCount ,
+                'mainArgsMs' : self._statistics ( mainArgsTimes ) if mainArgsTimes else None ,
+                } )
+        return results
+
+    def _exitLatency ( self , groovy , workDirectory ) :
+        '''Times groovy -e '' w/ and w/out --fast-exit.  The tail latency is the wall time less the time from the first
+        traced phase to the end of the main phase, so it also includes the (constant) time from starting the process to
+        the first phase.'''
+        if not groovy : return None
+        traceFile = os.path.join ( workDirectory , 'trace.json' )
+        environment = dict ( os.environ )
+        environment[ '__JLAUNCHER_TRACE' ] = traceFile
+        results = [ ]
+        for ( name , options ) in [ ( 'destroy' , [ ] ) , ( 'fastExit' , [ '--fast-exit' ] ) ] :
+            sys.stdout.write ( 'benchmarking exit latency (' + name + ')' )
+            times = [ ]
+            tailTimes = [ ]
+            failures = 0
+            for i in range ( self._warmupRounds + self._iterations ) :
+                if os.path.exists ( traceFile ) : os.remove ( traceFile )
+                devnull = open ( os.devnull , 'w' )
+                try :
+                    start = timeit.default_timer ( )
+                    exitCode = subprocess.call ( [ groovy ] + options + [ '-e' , '' ] , cwd = workDirectory , env = environment , stdout = devnull , stderr = devnull )
+                    elapsed = ( timeit.default_timer ( ) - start ) * 1000.0
+                finally :
+                    devnull.close ( )
+                phases = self._tracedPhases ( traceFile )
+                if 'main' not in phases : break
+                if i < self._warmupRounds : continue
+                if exitCode != 0 : failures += 1
+                times.append ( elapsed )
+                tailTimes.append ( elapsed - ( phases[ 'main' ][ 'ts' ] + phases[ 'main' ][ 'dur' ] ) / 1000.0 )
+                sys.stdout.write ( '.' )
+                sys.stdout.flush ( )
+            print ( '' )
+            if not times :
+                print ( 'skipping exit latency: the launcher did not record the main phase' )
+                return None
+            results.append ( {
+                'exit' : name ,
+                'failures' : failures ,
+                'wallTimeMs' : self._statistics ( times ) ,
+                'tailMs' : self._statistics ( tailTimes ) ,
+                } )
+        return results
+
+    def _tracedPhases ( self , traceFile ) :
+        '''Returns the events of the given launcher trace by phase name, an empty dictionary if there is no trace.'''
+        try :
+            traceInput = open ( traceFile )
+        except IOError :
+            return { }
+        try :
+            trace = json.load ( traceInput )
+        except ValueError :
+            return { }
+        finally :
+            traceInput.close ( )
+        return dict ( ( event[ 'name' ] , event ) for event in trace[ 'traceEvents' ] if 'dur' in event )
+
+    def _tracedPhaseDuration ( self , traceFile , phaseName ) :
+        '''Returns the duration of the given phase in microseconds from the given launcher trace, None if not there.'''
+        event = self._tracedPhases ( traceFile ).get ( phaseName )
+        return event[ 'dur' ] if event else None
+
+    def _runOnce ( self , command , workDirectory ) :
+        '''Returns a tuple of wall time in milliseconds, peak RSS in kilobytes (None if not available) and the exit code.'''
+        devnull = open ( os.devnull , 'w' )
+        try :
+            start = timeit.default_timer ( )
+            process = subprocess.Popen ( command , cwd = workDirectory , stdout = devnull , stderr = devnull )
+            if hasattr ( os , 'wait4' ) :
+                ( pid , status , usage ) = os.wait4 ( process.pid , 0 )
+                elapsed = timeit.default_timer ( ) - start
+                process.returncode = os.WEXITSTATUS ( status ) if os.WIFEXITED ( status ) else -1
+                #  ru_maxrss is in bytes on Mac OS X, kilobytes elsewhere.  On Linux it also covers the child
+                #  before exec, i.e. a copy of this Python process, which sets a floor of a few megabytes that
+                #  is insignificant compared to a jvm.
+                maxRss = usage.ru_maxrss // 1024 if sys.platform == 'darwin' else usage.ru_maxrss
+            else :
+                process.wait ( )
+                elapsed = timeit.default_timer ( ) - start
+                maxRss = None
+        finally :
+            devnull.close ( )
+        return ( elapsed * 1000.0 , maxRss , process.returncode )
+
+    def _measure ( self , name , kind , command , workDirectory ) :
+        times = [ ]
+        rsses = [ ]
+        failures = 0
+        for i in range ( self._warmupRounds + self._iterations ) :
+            ( elapsed , maxRss , exitCode ) = self._runOnce ( command , workDirectory )
+            if i < self._warmupRounds : continue
+            if exitCode != 0 : failures += 1
+            times.append ( elapsed )
+            if maxRss is not None : rsses.append ( maxRss )
+            sys.stdout.write ( '.' )
+            sys.stdout.flush ( )
+        return {
+            'name' : name ,
+            'launcher' : kind ,
+            'command' : command ,
+            'failures' : failures ,
+            'wallTimeMs' : self._statistics ( times ) ,
+            'maxRssKb' : self._statistics ( rsses ) if rsses else None ,
+            }
+
+    def _statistics ( self , values ) :
+        values = sorted ( values )
+        return {
+            'min' : values[ 0 ] ,
+            'median' : self._percentile ( values , 50 ) ,
+            'p95' : self._percentile ( values , 95 ) ,
+            'p99' : self._percentile ( values , 99 ) ,
+            'max' : values[ -1 ] ,
+            'mean' : sum ( values ) / float ( len ( values ) ) ,
+            }
+
+    def _percentile ( self , sortedValues , percent ) :
+        '''Nearest rank percentile.'''
+        rank = int ( math.ceil ( ( percent / 100.0 ) * len ( sortedValues ) ) )
+        return sortedValues[ max ( rank , 1 ) - 1 ]
+
+if __name__ == '__main__' :
+    print ( 'Run benchmarks using command "scons bench".' )
@@ -57,6 +57,7 @@
 #include "jst_fileutils.h"
 #include "jst_stringutils.h"
 #include "groovyutils.h"
+#include "jst_argfile.h"
 
 #if defined( _WIN32 ) && defined( _cwcompat )
 #  include "jst_cygwin_compatibility.h"
@@ -162,16 +163,17 @@ static int startGant( int argc, char** argv ) {
        *gantHome      = NULL,
        *gantDHome     = NULL, // the -Dgroovy.home=something to pass to the jvm
        *classpath     = NULL,
-       *javaHome      = NULL ;
+       *javaHome      = NULL,
+       **args         = NULL ;
 
-  void** dynReservedPointers = NULL ; // free all reserved pointers at at end of func
-  size_t dreservedPtrsSize   = 0 ;
+  JstArena arena = JST_ARENA_INITIALIZER ; // all the memory reserved in this func, freed at the end
 
   const char *terminatingSuffixes[] = { ".gant", NULL } ;
   char *extraProgramOptions[]       = { "--main", "gant.Gant", "--conf", NULL, "--classpath", ".", NULL },
        *jars[]                      = { NULL, NULL, NULL } ;
 
-  int  exitCode = -1 ;
+  int  exitCode = -1,
+       argCount ;
 
   JstActualParam *processedActualParams ;
 
@@ -185,26 +187,27 @@ static int startGant( int argc, char** argv ) {
   jst_cygwinInit() ;
 #endif
 
-  processedActualParams = jst_processInputParameters( argv + 1, argc - 1, (JstParamInfo*)gantParameters, terminatingSuffixes, JST_CYGWIN_PATH_CONVERSION ) ;
+  if ( ( argCount = jst_expandArgFiles( argc - 1, argv + 1, (JstParamInfo*)gantParameters, terminatingSuffixes, &args, &arena ) ) == -1 ) goto end ;
 
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, processedActualParams, NULL_MEANS_ERROR )
+  processedActualParams = jst_processInputParameters( args, argCount, (JstParamInfo*)gantParameters, terminatingSuffixes, JST_CYGWIN_PATH_CONVERSION ) ;
+
+  MARK_PTR_FOR_FREEING( arena, processedActualParams, NULL_MEANS_ERROR )
 
   classpath = getenv( "CLASSPATH" ) ;
 
   // add "." to the end of the used classpath. This is what the script launcher also does
   if ( classpath ) {
 
-    classpath = jst_append( NULL, NULL, classpath, JST_PATH_SEPARATOR ".", NULL ) ;
-    MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, classpath, NULL_MEANS_ERROR )
+    if ( !( classpath = jst_arenaConcat( &arena, classpath, JST_PATH_SEPARATOR ".", NULL ) ) ) goto end ;
 
     extraProgramOptions[ 5 ] = classpath ;
 
   }
 
   gantHome = getGantHome() ;
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, gantHome, NULL_IS_NOT_ERROR )
+  MARK_PTR_FOR_FREEING( arena, gantHome, NULL_IS_NOT_ERROR )
 
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, jars[ 0 ] = findGantStartupJar( gantHome ), NULL_IS_NOT_ERROR )
+  MARK_PTR_FOR_FREEING( arena, jars[ 0 ] = findGantStartupJar( gantHome ), NULL_IS_NOT_ERROR )
 
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -213,47 +216,35 @@ static int startGant( int argc, char** argv ) {
   gantConfFile = getenv( "GANT_CONF" ) ;
 
   if ( !gantConfFile ) {
-    gantConfFile = jst_createFileName( gantHome, "conf", GANT_CONF_FILE, NULL ) ;
-    MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, gantConfFile, NULL_MEANS_ERROR )
+    if ( !( gantConfFile = jst_arenaCreateFileName( &arena, gantHome, "conf", GANT_CONF_FILE, NULL ) ) ) goto end ;
   }
 
   extraProgramOptions[ 3 ] = gantConfFile ;
 
   {
-    char *groovyDConf = jst_append( NULL, NULL, "-Dgroovy.starter.conf=", gantConfFile, NULL ) ;
-    MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, groovyDConf, NULL_MEANS_ERROR )
-
+    char *groovyDConf = jst_arenaConcat( &arena, "-Dgroovy.starter.conf=", gantConfFile, NULL ) ;
 
-    if ( !appendJvmOption( &extraJvmOptions, groovyDConf, NULL ) ) goto end ;
+    if ( !groovyDConf || !appendJvmOption( &extraJvmOptions, groovyDConf, NULL ) ) goto end ;
   }
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
   javaHome = jst_findJavaHome() ;
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, javaHome, NULL_IS_NOT_ERROR )
+  MARK_PTR_FOR_FREEING( arena, javaHome, NULL_IS_NOT_ERROR )
 
   {
-    char* toolsJarFile = jst_createFileName( javaHome, "lib", "tools.jar", NULL ) ;
+    char* toolsJarFile = jst_arenaCreateFileName( &arena, javaHome, "lib", "tools.jar", NULL ) ;
 
     if ( !toolsJarFile ) goto end ;
     if ( jst_fileExists( toolsJarFile ) ) {
-      char* toolsJarD = jst_append( NULL, NULL, "-Dtools.jar=", toolsJarFile, NULL ) ;
-
-      if ( !toolsJarD ||
-           !jst_appendPointer( &dynReservedPointers, &dreservedPtrsSize, toolsJarD ) ||
-           !appendJvmOption( &extraJvmOptions, toolsJarD, NULL ) ) {
-        free( toolsJarFile ) ;
-        goto end ;
-      }
+      char* toolsJarD = jst_arenaConcat( &arena, "-Dtools.jar=", toolsJarFile, NULL ) ;
 
+      if ( !toolsJarD || !appendJvmOption( &extraJvmOptions, toolsJarD, NULL ) ) goto end ;
     }
-
-    free( toolsJarFile ) ;
   }
 
 
-  gantDHome = jst_append( NULL, NULL, "-Dgant.home=", gantHome, NULL ) ;
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, gantDHome, NULL_MEANS_ERROR )
+  if ( !( gantDHome = jst_arenaConcat( &arena, "-Dgant.home=", gantHome, NULL ) ) ) goto end ;
 
   if ( !appendJvmOption( &extraJvmOptions, gantDHome, NULL ) ) goto end ;
 
@@ -277,15 +268,14 @@ static int startGant( int argc, char** argv ) {
           if ( errno ) goto end ;
         }
 #endif
-        if ( groovyHome ) { MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, groovyHome, NULL_IS_NOT_ERROR ) }
+        if ( groovyHome ) { MARK_PTR_FOR_FREEING( arena, groovyHome, NULL_IS_NOT_ERROR ) }
       }
       if ( groovyHome ) jars[ 1 ] = findGroovyStartupJar( groovyHome, JNI_FALSE ) ;
     }
 
-    MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, jars[ 1 ], NULL_IS_NOT_ERROR )
+    MARK_PTR_FOR_FREEING( arena, jars[ 1 ], NULL_IS_NOT_ERROR )
 
-    groovyDHome = jst_append( NULL, NULL, "-Dgroovy.home=", groovyHome ? groovyHome : gantHome, NULL ) ;
-    MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, groovyDHome, NULL_MEANS_ERROR )
+    if ( !( groovyDHome = jst_arenaConcat( &arena, "-Dgroovy.home=", groovyHome ? groovyHome : gantHome, NULL ) ) ) goto end ;
 
     if ( !appendJvmOption( &extraJvmOptions, groovyDHome, NULL ) ) goto end ;
 
@@ -307,25 +297,25 @@ static int startGant( int argc, char** argv ) {
         if ( errno ) goto end ;
       }
 #endif
-      if ( antHome ) { MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, antHome, NULL_IS_NOT_ERROR ) }
+      if ( antHome ) { MARK_PTR_FOR_FREEING( arena, antHome, NULL_IS_NOT_ERROR ) }
     }
 
     if ( !antHome ) { fprintf( stderr, "error: could not locate ant installation\n" ) ; goto end ; }
 
-    antDHome = jst_append( NULL, NULL, "-Dant.home=", antHome, NULL ) ;
-    MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, antDHome, NULL_IS_NOT_ERROR )
+    if ( !( antDHome = jst_arenaConcat( &arena, "-Dant.home=", antHome, NULL ) ) ) goto end ;
 
     if ( !appendJvmOption( &extraJvmOptions, antDHome, NULL ) ) goto end ;
 
   }
 
 
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, extraJvmOptions.options, NULL_MEANS_ERROR )
+  MARK_PTR_FOR_FREEING( arena, extraJvmOptions.options, NULL_MEANS_ERROR )
 
 
   // populate the startup parameters
 
   options.javaHome            = javaHome ;
+  options.jvmDynLibPath       = NULL ;
   options.jvmSelectStrategy   = JST_CLIENT_FIRST ;
   options.initialClasspath    = NULL ;
   options.unrecognizedParamStrategy = JST_UNRECOGNIZED_TO_JVM ;
@@ -337,7 +327,16 @@ static int startGant( int argc, char** argv ) {
   options.jarDirs             = NULL ;
   options.jars                = jars ;
   options.classpathStrategy   = JST_NORMAL_CLASSPATH ;
-  options.pointersToFreeBeforeRunningMainMethod = &dynReservedPointers ;
+  options.classpathOption     = NULL ;
+  options.prefetchPath        = NULL ;
+  options.serverMode          = JNI_FALSE ;
+  options.useSharedArchive    = JNI_FALSE ;
+  options.fastExit            = JNI_FALSE ;
+  options.mainThreadStackSize = 0 ;
+  options.jvmProfile          = JST_PROFILE_NONE ;
+  options.runHistoryKey       = NULL ;
+  options.mainReturnedHook    = NULL ;
+  options.arenaToFreeBeforeRunningMainMethod = &arena ;
 
 #if defined ( _WIN32 ) && defined ( _cwcompat )
   // see comments in groovy.c
@@ -349,7 +348,7 @@ static int startGant( int argc, char** argv ) {
 
 end:
 
-  jst_freeAll( &dynReservedPointers ) ;
+  jst_freeArena( &arena ) ;
 
   if ( _jst_debug ) fprintf( stderr, "debug: exiting %s with code %d\n", argv[ 0 ], exitCode ) ;
 
@@ -35,6 +35,7 @@
 #include "jst_dynmem.h"
 #include "jst_fileutils.h"
 #include "jst_stringutils.h"
+#include "jst_argfile.h"
 
 #if defined( _WIN32 ) && defined( _cwcompat )
 #  include "jst_cygwin_compatibility.h"
@@ -113,16 +114,10 @@ int startGrails( int argc, char** argv ) {
   JstJvmOptions extraJvmOptions ;
 
   char *grailsHome      = NULL,
-       *javaHome        = NULL ;
+       *javaHome        = NULL,
+       **args           = NULL ;
 
-  void** dynReservedPointers = NULL ; // free all reserved pointers at at end of func
-  size_t dreservedPtrsSize   = 0 ;
-
-// FIXME - go through this source file and replace with the new definition from jst_dynmem.c
-#if defined( MARK_PTR_FOR_FREEING )
-#  undef MARK_PTR_FOR_FREEING
-#endif
-# define MARK_PTR_FOR_FREEING( garbagePtr ) if ( !jst_appendPointer( &dynReservedPointers, &dreservedPtrsSize, ( garbagePtr ) ) ) goto end ;
+  JstArena arena = JST_ARENA_INITIALIZER ; // all the memory reserved in this func, freed at the end
 
   /** terminatingSuffixes contains the suffixes that, if matched, indicate that the matching param and all the rest of the params
    * are launcheeParams, e.g. {".groovy", ".gy", NULL}.
@@ -132,7 +127,8 @@ int startGrails( int argc, char** argv ) {
   const char *terminatingSuffixes[] = { NULL } ;
   char *extraProgramOptions[]       = { NULL } ;
 
-  int  rval = -1 ;
+  int  rval = -1,
+       argCount ;
 
   JVMSelectStrategy jvmSelectStrategy = JST_CLIENT_FIRST ;
 
@@ -149,9 +145,11 @@ int startGrails( int argc, char** argv ) {
   jst_cygwinInit() ;
 #endif
 
-  processedActualParams = jst_processInputParameters( argv + 1, argc - 1, (JstParamInfo*)grailsParameters, terminatingSuffixes, JST_CYGWIN_PATH_CONVERSION ) ;
+  if ( ( argCount = jst_expandArgFiles( argc - 1, argv + 1, (JstParamInfo*)grailsParameters, terminatingSuffixes, &args, &arena ) ) == -1 ) goto end ;
 
-  MARK_PTR_FOR_FREEING( processedActualParams )
+  processedActualParams = jst_processInputParameters( args, argCount, (JstParamInfo*)grailsParameters, terminatingSuffixes, JST_CYGWIN_PATH_CONVERSION ) ;
+
+  MARK_PTR_FOR_FREEING( arena, processedActualParams, NULL_MEANS_ERROR )
 
 
 
@@ -160,7 +158,7 @@ int startGrails( int argc, char** argv ) {
   if ( _jst_debug ) fprintf( stderr, "debug: using grails home set at compile time: %s\n", grailsHome ) ;
 #else
   grailsHome = getGrailsHome() ;
-  MARK_PTR_FOR_FREEING( grailsHome )
+  MARK_PTR_FOR_FREEING( arena, grailsHome, NULL_IS_NOT_ERROR )
 #endif
 
 
@@ -169,52 +167,39 @@ int startGrails( int argc, char** argv ) {
   if ( _jst_debug ) fprintf( stderr, "debug: using java home set at compile time: %s\n", javaHome ) ;
 #else
   javaHome = jst_findJavaHome() ;
-  MARK_PTR_FOR_FREEING( javaHome )
+  MARK_PTR_FOR_FREEING( arena, javaHome, NULL_IS_NOT_ERROR )
 #endif
 
   {
-    char* toolsJarFile = jst_createFileName( javaHome, "lib", "tools.jar", NULL ) ;
+    char* toolsJarFile = jst_arenaCreateFileName( &arena, javaHome, "lib", "tools.jar", NULL ) ;
 
     if ( !toolsJarFile ) goto end ;
     if ( jst_fileExists( toolsJarFile ) ) {
-      char* toolsJarD = jst_append( NULL, NULL, "-Dtools.jar=", toolsJarFile, NULL ) ;
-
-      if ( !toolsJarD ||
-           !jst_appendPointer( &dynReservedPointers, &dreservedPtrsSize, toolsJarD ) ||
-           !appendJvmOption( &extraJvmOptions, toolsJarD, NULL ) ) {
-        free( toolsJarFile ) ;
-        goto end ;
-      }
+      char* toolsJarD = jst_arenaConcat( &arena, "-Dtools.jar=", toolsJarFile, NULL ) ;
 
+      if ( !toolsJarD || !appendJvmOption( &extraJvmOptions, toolsJarD, NULL ) ) goto end ;
     }
-
-    free( toolsJarFile ) ;
   }
 
   {
-    char *grailsDHome = jst_append( NULL, NULL, "-Dgrails.home=", grailsHome, NULL ) ;
-    MARK_PTR_FOR_FREEING( grailsDHome )
-    if ( !appendJvmOption( &extraJvmOptions, grailsDHome, NULL ) ) goto end ;
+    char *grailsDHome = jst_arenaConcat( &arena, "-Dgrails.home=", grailsHome, NULL ) ;
+    if ( !grailsDHome || !appendJvmOption( &extraJvmOptions, grailsDHome, NULL ) ) goto end ;
   }
 
 
-  MARK_PTR_FOR_FREEING( extraJvmOptions.options )
-
   // TODO: extract setting the jar lookup into a separate func?
   {
-    char* jardir = jst_createFileName( grailsHome, "lib", NULL ) ;
+    char* jardir = jst_arenaCreateFileName( &arena, grailsHome, "lib", NULL ) ;
     if ( !jardir ) goto end ;
     jardirs[ 0 ].name = jardir ;
-    MARK_PTR_FOR_FREEING( jardir )
   }
   jardirs[ 0 ].fetchRecursively = JNI_FALSE ;
   jardirs[ 0 ].filter = &grailsJarSelect ;
 
   {
-    char* jardir = jst_createFileName( grailsHome, "dist", NULL ) ;
+    char* jardir = jst_arenaCreateFileName( &arena, grailsHome, "dist", NULL ) ;
     if ( !jardir ) goto end ;
     jardirs[ 1 ].name = jardir ;
-    MARK_PTR_FOR_FREEING( jardir )
   }
   jardirs[ 1 ].fetchRecursively = JNI_FALSE ;
   // TODO: make separate grails jar select and groovy jar select
@@ -226,11 +211,14 @@ int startGrails( int argc, char** argv ) {
   {
     char* javaOptsFromEnvVar = getenv( "JAVA_OPTS" ) ;
     if ( javaOptsFromEnvVar ) {
-      MARK_PTR_FOR_FREEING( javaOptsFromEnvVar = jst_strdup( javaOptsFromEnvVar ) )
-      if ( !handleJVMOptsString( javaOptsFromEnvVar, &extraJvmOptions, &jvmSelectStrategy ) ) goto end ;
+      if ( !( javaOptsFromEnvVar = jst_arenaStrdup( &arena, javaOptsFromEnvVar ) ) ||
+           !handleJVMOptsString( javaOptsFromEnvVar, &extraJvmOptions, &jvmSelectStrategy ) ) goto end ;
     }
   }
 
+  // no more jvm options are added after this, so the options array is not reallocated anymore
+  MARK_PTR_FOR_FREEING( arena, extraJvmOptions.options, NULL_MEANS_ERROR )
+
 
   // populate the startup parameters
   // first, set the memory to 0. This is just a precaution, as NULL (0) is a sensible default value for many options.
@@ -238,6 +226,7 @@ int startGrails( int argc, char** argv ) {
   // memset( &options, 0, sizeof( JavaLauncherOptions ) ) ;
 
   options.javaHome            = javaHome ;
+  options.jvmDynLibPath       = NULL ;
   options.jvmSelectStrategy   = jvmSelectStrategy ;
   options.initialClasspath    = NULL ;
   options.unrecognizedParamStrategy = JST_UNRECOGNIZED_TO_JVM ;
@@ -249,7 +238,16 @@ int startGrails( int argc, char** argv ) {
   options.jarDirs             = jardirs ;
   options.jars                = NULL ;
   options.classpathStrategy   = jst_getParameterValue( processedActualParams, "--quickstart" ) ? JST_BOOTSTRAP_CLASSPATH_A : JST_NORMAL_CLASSPATH ;
-  options.pointersToFreeBeforeRunningMainMethod = &dynReservedPointers ;
+  options.classpathOption     = NULL ;
+  options.prefetchPath        = NULL ;
+  options.serverMode          = JNI_FALSE ;
+  options.useSharedArchive    = ( options.classpathStrategy != JST_NORMAL_CLASSPATH ) ? JNI_TRUE : JNI_FALSE ;
+  options.fastExit            = JNI_FALSE ;
+  options.mainThreadStackSize = 0 ;
+  options.jvmProfile          = JST_PROFILE_NONE ;
+  options.runHistoryKey       = NULL ;
+  options.mainReturnedHook    = NULL ;
+  options.arenaToFreeBeforeRunningMainMethod = &arena ;
 
 
   rval = jst_launchJavaApp( &options ) ;
@@ -261,7 +259,7 @@ int startGrails( int argc, char** argv ) {
 
 end:
 
-  jst_freeAll( &dynReservedPointers ) ;
+  jst_freeArena( &arena ) ;
 
   return rval ;
 
@@ -28,9 +28,18 @@
 
 #if defined ( _WIN32 )
 #  include <Windows.h>
+#  include <direct.h>
 #  define strcasecmp stricmp
+#  if !defined( PATH_MAX )
+#    define PATH_MAX MAX_PATH
+#  endif
 #else
 #  include <strings.h>
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/wait.h>
 #endif
 
 #include "applejnifix.h"
@@ -40,12 +49,45 @@
 #include "jst_dynmem.h"
 #include "jst_fileutils.h"
 #include "jst_stringutils.h"
+#include "jst_cache.h"
+#include "jst_trace.h"
+#include "jst_argfile.h"
+#include "jst_jvminventory.h"
+#include "jst_profile.h"
+#include "jst_jvmoptsfile.h"
+#include "groovygrab.h"
+#include "groovyinfo.h"
+#include "groovycmanifest.h"
+#include "groovyutils.h"
 
 #if defined( _WIN32 ) && defined( _cwcompat )
 #  include "jst_cygwin_compatibility.h"
 #endif
 
 #define GROOVY_CONF_FILE "groovy-starter.conf"
+/** The jvm options of the groovy installation, in $GROOVY_HOME/conf. See jst_jvmoptsfile.h */
+#define JVM_OPTIONS_FILE "jvm.options"
+
+/** Bump this whenever the contents of the launch plan change. */
+#define GROOVY_LAUNCH_PLAN_VERSION "groovy-launch-plan-2"
+
+/** The entries in a cached launch plan, i.e. the things resolved on a previous run that can be reused as long
+ * as the installations involved have not changed. */
+typedef enum {
+  PLAN_GROOVY_HOME,
+  PLAN_GROOVY_CONF,
+  PLAN_STARTUP_JAR,
+  PLAN_JAVA_HOME,
+  PLAN_JVM_DYNLIB,
+  PLAN_CLASSPATH_OPTION,
+  // "" if there is no tools.jar
+  PLAN_TOOLS_JAR_D,
+  PLAN_GROOVY_D_CONF,
+  PLAN_GROOVY_D_HOME,
+  // the jars GroovyStarter loads, prefetched along w/ the jvm startup files. "" if not known
+  PLAN_STARTER_JARS,
+  PLAN_ENTRY_COUNT
+} GroovyLaunchPlanEntry ;
 
 
 // ms visual c++ compiler does not support compound literals
@@ -67,10 +109,15 @@ static const char* groovyLinevarParam[]    = { "-n", NULL } ;
 static const char* groovyVersionParam[]    = { "-v", "--version", NULL } ;
 static const char* groovyClasspathParam[]  = { "-cp", "-classpath", "--classpath", NULL } ;
 static const char* groovyJavahomeParam[]   = { "-jh", "--javahome", NULL } ;
+static const char* groovyJavaVersionParam[] = { "--java-version", NULL } ;
 static const char* groovyConfParam[]       = { "--conf",  NULL } ;
 static const char* groovyClientParam[]     = { "-client", NULL } ;
 static const char* groovyServerParam[]     = { "-server", NULL } ;
 static const char* groovyQuickStartParam[] = { "--quickstart", NULL } ;
+static const char* groovyServerModeParam[] = { "--server-mode", NULL } ;
+static const char* groovyFastExitParam[]   = { "--fast-exit", NULL } ;
+static const char* groovyProfileParam[]    = { "--profile", NULL } ;
+static const char* groovyFlatClasspathParam[] = { "--flat-classpath", NULL } ;
 
 // the parameters accepted by groovy (note that -cp / -classpath / --classpath & --conf
 // are handled separately below
@@ -90,10 +137,15 @@ static const JstParamInfo groovyParameters[] = {
   // native launcher supported extra params
   { groovyClasspathParam,  JST_DOUBLE_PARAM, JST_IGNORE | JST_CYGWIN_PATHLIST_CONVERT },
   { groovyJavahomeParam,   JST_DOUBLE_PARAM, JST_IGNORE | JST_CYGWIN_PATH_CONVERT },
+  { groovyJavaVersionParam, JST_DOUBLE_PARAM, JST_IGNORE },
   { groovyConfParam,       JST_DOUBLE_PARAM, JST_IGNORE | JST_CYGWIN_PATH_CONVERT },
   { groovyClientParam,     JST_SINGLE_PARAM, JST_IGNORE },
   { groovyServerParam,     JST_SINGLE_PARAM, JST_IGNORE },
   { groovyQuickStartParam, JST_SINGLE_PARAM, JST_IGNORE },
+  { groovyServerModeParam, JST_SINGLE_PARAM, JST_IGNORE },
+  { groovyFastExitParam,   JST_SINGLE_PARAM, JST_IGNORE },
+  { groovyProfileParam,    JST_DOUBLE_PARAM, JST_IGNORE },
+  { groovyFlatClasspathParam, JST_SINGLE_PARAM, JST_IGNORE },
   { NULL,          0,                0 }
 } ;
 
@@ -120,6 +172,7 @@ static const JstParamInfo groovycParameters[] = {
   // native launcher supported extra params
   { groovyClasspathParam,   JST_DOUBLE_PARAM, JST_IGNORE | JST_CYGWIN_PATHLIST_CONVERT },
   { groovyJavahomeParam,    JST_DOUBLE_PARAM, JST_IGNORE | JST_CYGWIN_PATH_CONVERT },
+  { groovyJavaVersionParam, JST_DOUBLE_PARAM, JST_IGNORE },
   { groovyConfParam,        JST_DOUBLE_PARAM, JST_IGNORE | JST_CYGWIN_PATH_CONVERT },
   { groovyClientParam,      JST_SINGLE_PARAM, JST_IGNORE },
   { groovyServerParam,      JST_SINGLE_PARAM, JST_IGNORE },
@@ -300,6 +353,14 @@ static GroovyApp* recognizeGroovyApp( const char* cmd ) {
   return app ;
 }
 
+/** Returns true if the terminating param names an existing script file, as opposed to e.g. -e (the code being given inline) or --help. */
+static jboolean isScriptFileGiven( const JstActualParam* processedParams ) {
+  while ( processedParams->param && !( processedParams->handling & JST_TERMINATING_OR_AFTER ) ) processedParams++ ;
+
+  return ( processedParams->param && !processedParams->paramDefinition &&
+           jst_fileExists( processedParams->param ) && !jst_isDir( processedParams->param ) ) ? JNI_TRUE : JNI_FALSE ;
+}
+
 static char* createScriptNameDParam( const char* scriptName ) {
 
   char* scriptNameD = NULL ;
@@ -321,6 +382,703 @@ static char* createScriptNameDParam( const char* scriptName ) {
   return scriptNameD ;
 }
 
+/** Creates the key under which the launch plan is cached. It contains everything that affects how groovy home,
+ * java home etc. are found, so a changed environment simply means a different plan.
+ * Returns NULL on error. Freeing the returned value is up to the caller. */
+static char* createLaunchPlanKey( const char* executable, const JstActualParam* processedActualParams ) {
+  static const char* envVars[] = { "GROOVY_HOME", "GROOVY_CONF", "JAVA_HOME", "JAVA_OPTS", "PATH", NULL } ;
+  static const char* params[]  = { "-jh", "--java-version", "--conf", "-client", "-server", "--quickstart", NULL } ;
+  char   *key,
+         *value ;
+  size_t keySize = 512 ;
+  int    i ;
+
+  if ( !( key = jst_append( NULL, &keySize, GROOVY_LAUNCH_PLAN_VERSION "\n", executable, "\n", NULL ) ) ) return NULL ;
+
+  // a relative path to the executable means the current dir affects where groovy home is found
+  if ( strchr( executable, JST_FILE_SEPARATOR[ 0 ] ) && executable[ 0 ] != JST_FILE_SEPARATOR[ 0 ]
+#if defined( _WIN32 )
+       && executable[ 1 ] != ':'
+#endif
+     ) {
+    char cwd[ PATH_MAX + 1 ] ;
+    if ( !getcwd( cwd, sizeof( cwd ) ) ) {
+      free( key ) ;
+      return NULL ;
+    }
+    if ( !( key = jst_append( key, &keySize, "cwd=", cwd, "\n", NULL ) ) ) return NULL ;
+  }
+
+#if defined( __linux__ )
+  { // the executable may be a symlink, e.g. managed by update-alternatives. The kernel gives us the real location cheaply.
+    char    exe[ PATH_MAX + 1 ] ;
+    ssize_t len = readlink( "/proc/self/exe", exe, PATH_MAX ) ;
+    if ( len > 0 ) {
+      exe[ len ] = '\0' ;
+      if ( !( key = jst_append( key, &keySize, "exe=", exe, "\n", NULL ) ) ) return NULL ;
+    }
+  }
+#endif
+
+  for ( i = 0 ; envVars[ i ] ; i++ ) {
+    value = getenv( envVars[ i ] ) ;
+    if ( !( key = jst_append( key, &keySize, envVars[ i ], value ? "=" : "", value ? value : "", "\n", NULL ) ) ) return NULL ;
+  }
+
+  for ( i = 0 ; params[ i ] ; i++ ) {
+    value = jst_getParameterValue( processedActualParams, params[ i ] ) ;
+    if ( !( key = jst_append( key, &keySize, params[ i ], value ? "=" : "", value ? value : "", "\n", NULL ) ) ) return NULL ;
+  }
+
+  return key ;
+}
+
+/** Caches the given plan. The plan is checked against the modification times of groovy lib and conf dirs, java home & its lib dir,
+ * the dir containing the jvm dynamic library and, if given, the java home location as specified by the user (which may be a symlink).
+ * Failing to store the plan is not an error. */
+static void storeLaunchPlan( const char* key, char** plan, const char* userGivenJavaHome ) {
+  char *stamps[ 7 ],
+       *jvmDynLibDir ;
+  int  i = 0 ;
+
+  memset( stamps, 0, sizeof( stamps ) ) ;
+
+  if ( !( stamps[ i++ ] = jst_createFileName( plan[ PLAN_GROOVY_HOME ], "lib",  NULL ) ) ||
+       !( stamps[ i++ ] = jst_createFileName( plan[ PLAN_GROOVY_HOME ], "conf", NULL ) ) ||
+       !( stamps[ i++ ] = jst_strdup( plan[ PLAN_JAVA_HOME ] ) ) ||
+       !( stamps[ i++ ] = jst_createFileName( plan[ PLAN_JAVA_HOME ], "lib", NULL ) ) ||
+       !( stamps[ i++ ] = jvmDynLibDir = jst_strdup( plan[ PLAN_JVM_DYNLIB ] ) ) ) goto end ;
+
+  jst_pathToParentDir( jvmDynLibDir ) ;
+
+  if ( userGivenJavaHome && !( stamps[ i++ ] = jst_strdup( userGivenJavaHome ) ) ) goto end ;
+
+  jst_storeLaunchPlan( key, plan, stamps ) ;
+
+  end:
+  for ( i = 0 ; stamps[ i ] ; i++ ) free( stamps[ i ] ) ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// compiled script cache
+//
+// Compiling the script is a large part of running a small groovy script. When a script file or a -e one-liner is run
+// w/out any options that affect how GroovyMain runs it, the classes compiled from it on some earlier run are launched directly
+// (via GroovyStarter, so the groovy libs are loaded as usual) instead of having GroovyMain compile it again.
+// If there are no up to date compiled classes, the script is run as usual and groovyc is run in a detached background
+// process to compile it into the cache for the following runs. Compiling in the background is only done on posix systems.
+
+/** Bump this whenever the way scripts are compiled into the cache changes. */
+#define GROOVY_SCRIPT_CACHE_VERSION "groovy-script-cache-1"
+
+#define SCRIPT_CACHE_SUBDIR "scripts"
+
+/** The name GroovyMain gives to the class compiled from a script given w/ -e */
+#define ONELINER_CLASS_NAME "script_from_command_line"
+
+/** If compiling a script into the cache takes longer than this many seconds, the launcher doing it is assumed to have died. */
+#define SCRIPT_COMPILE_TIMEOUT 600
+
+/** The entries in the launch plan stored for a compiled script. */
+typedef enum {
+  // "" if the script could not be cached
+  SCRIPT_MAIN_CLASS,
+  SCRIPT_CLASSES_DIR,
+  SCRIPT_ENTRY_COUNT
+} GroovyScriptCacheEntry ;
+
+typedef struct {
+  /** The index of the script file (or -e) in the processed params. */
+  int        paramIndex ;
+  /** The number of params taken up by the script, i.e. 2 for -e <script> and 1 for a script file. */
+  int        paramCount ;
+  /** NULL for -e */
+  char*      scriptFile ;
+  /** The script given w/ -e, NULL for a script file. */
+  char*      scriptText ;
+  /** The name of the class compiled from the script, w/out the package. */
+  char*      className ;
+  JstHash    sourceHash ;
+  char*      key ;
+  /** Names the files of the script in the cache dir. */
+  char       hex[ JST_HASH_HEX_LEN ] ;
+} GroovyScript ;
+
+/** Returns false if the params contain anything that makes GroovyMain do something else than just compile and run the script,
+ * or if the script is not a readable file. Otherwise fills in the script except for the class name and the key. */
+static jboolean findCacheableScript( const JstActualParam* processedParams, GroovyScript* script ) {
+  JstMappedFile source ;
+  int           i ;
+
+  memset( script, 0, sizeof( GroovyScript ) ) ;
+
+  for ( i = 0 ; processedParams[ i ].param && !( processedParams[ i ].handling & JST_TERMINATING_OR_AFTER ) ; i++ ) {
+    // all the options to groovy itself, e.g. -n, -p or -D, affect how GroovyMain runs the script
+    if ( processedParams[ i ].handling & JST_TO_LAUNCHEE ) return JNI_FALSE ;
+  }
+
+  if ( !processedParams[ i ].param ) return JNI_FALSE ;
+
+  script->paramIndex = i ;
+
+  if ( processedParams[ i ].paramDefinition ) {
+    // a terminating groovy option, e.g. -h. -e is the only one that runs a script.
+    if ( processedParams[ i ].paramDefinition->names != groovyOnelinerParam ) return JNI_FALSE ;
+    script->paramCount = 2 ;
+    script->scriptText = processedParams[ i + 1 ].param ;
+    script->sourceHash = jst_hashString( JST_HASH_INIT, script->scriptText ) ;
+    return JNI_TRUE ;
+  }
+
+  // GroovyMain also looks for the script w/ different suffixes if the given file does not exist. Those are left for it.
+  if ( !jst_fileExists( processedParams[ i ].param ) || jst_isDir( processedParams[ i ].param ) ||
+       !jst_mapFile( processedParams[ i ].param, &source ) ) return JNI_FALSE ;
+
+  script->sourceHash = jst_hashBytes( JST_HASH_INIT, source.data, source.size ) ;
+  jst_unmapFile( &source ) ;
+
+  script->paramCount = 1 ;
+  script->scriptFile = processedParams[ i ].param ;
+
+  return JNI_TRUE ;
+}
+
+/** Returns the name groovy gives to the class compiled from the given script, i.e. the file name w/out the suffix.
+ * Returns NULL on error. Freeing the returned value is up to the caller. */
+static char* createScriptClassName( GroovyScript* script ) {
+  char *fileName,
+       *className,
+       *suffix ;
+
+  if ( script->scriptText ) return jst_strdup( ONELINER_CLASS_NAME ) ;
+
+  fileName = strrchr( script->scriptFile, JST_FILE_SEPARATOR[ 0 ] ) ;
+#if defined( _WIN32 )
+  if ( !fileName ) fileName = strrchr( script->scriptFile, '/' ) ;
+#endif
+  fileName = fileName ? fileName + 1 : script->scriptFile ;
+
+  if ( !( className = jst_strdup( fileName ) ) ) return NULL ;
+  if ( ( suffix = strrchr( className, '.' ) ) ) *suffix = '\0' ;
+
+  return className ;
+}
+
+/** The key contains everything the compiled classes depend on besides the groovy installation (which is checked by the stamps).
+ * The current dir is included as "." is always on the classpath. Returns NULL on error. */
+static char* createScriptCacheKey( GroovyScript* script, const char* startupJar, const char* groovyConfFile, const char* classpath ) {
+  char   cwd[ PATH_MAX + 1 ],
+         sourceHash[ JST_HASH_HEX_LEN ] ;
+  char   *key ;
+  size_t keySize = 512 ;
+
+  if ( !getcwd( cwd, sizeof( cwd ) ) ) return NULL ;
+
+  jst_hashToHex( script->sourceHash, sourceHash ) ;
+
+  if ( !( key = jst_append( NULL, &keySize, GROOVY_SCRIPT_CACHE_VERSION "\n",
+                                            "cwd=", cwd, "\n",
+                                            "jar=", startupJar, "\n",
+                                            "conf=", groovyConfFile, "\n",
+                                            "cp=", classpath, "\n",
+                                            "class=", script->className, "\n",
+                                            "source=", sourceHash, "\n", NULL ) ) ) return NULL ;
+
+  jst_hashToHex( jst_hashString( JST_HASH_INIT, key ), script->hex ) ;
+
+  return key ;
+}
+
+/** Returns a copy of the given params w/out the ones taken up by the script, i.e. the params to give to the compiled script's main
+ * method. Returns NULL on error. */
+static JstActualParam* removeScriptParams( const JstActualParam* processedParams, GroovyScript* script ) {
+  JstActualParam *params ;
+  int            count = 0 ;
+
+  while ( processedParams[ count ].param ) count++ ;
+
+  if ( !( params = jst_malloc( ( count - script->paramCount + 1 ) * sizeof( JstActualParam ) ) ) ) return NULL ;
+
+  memcpy( params, processedParams, script->paramIndex * sizeof( JstActualParam ) ) ;
+  // + 1 for the terminating entry
+  memcpy( params + script->paramIndex, processedParams + script->paramIndex + script->paramCount,
+          ( count - script->paramIndex - script->paramCount + 1 ) * sizeof( JstActualParam ) ) ;
+
+  return params ;
+}
+
+/** The groovy startup jar, the groovy lib dir and the jars on the classpath. Returns NULL on error. */
+static char** createScriptCacheStamps( const char* startupJar, const char* classpath ) {
+  JstDynamicPointerArray stamps ;
+  char   *file          = NULL,
+         *classpathCopy = NULL,
+         *entry ;
+
+  if ( !jst_initializeDynamicPointerArray( &stamps, 8 ) ) return NULL ;
+
+  if ( !( file = jst_strdup( startupJar ) ) || !jst_appendPointerToDynamicArray( &stamps, file ) ) goto error ;
+  if ( !( file = jst_strdup( startupJar ) ) ) goto error ;
+  jst_pathToParentDir( file ) ;
+  if ( !jst_appendPointerToDynamicArray( &stamps, file ) ) goto error ;
+  file = NULL ;
+
+  if ( !( classpathCopy = jst_strdup( classpath ) ) ) goto error ;
+
+  for ( entry = strtok( classpathCopy, JST_PATH_SEPARATOR ) ; entry ; entry = strtok( NULL, JST_PATH_SEPARATOR ) ) {
+    if ( !jst_fileExists( entry ) || jst_isDir( entry ) ) continue ;
+    if ( !( file = jst_strdup( entry ) ) || !jst_appendPointerToDynamicArray( &stamps, file ) ) goto error ;
+    file = NULL ;
+  }
+
+  free( classpathCopy ) ;
+
+  return (char**)stamps.pointers ;
+
+  error:
+  if ( classpathCopy ) free( classpathCopy ) ;
+  if ( file   ) free( file ) ;
+  jst_freeDynamicArray( &stamps, JNI_TRUE ) ;
+  return NULL ;
+}
+
+#if !defined( _WIN32 )
+
+static void removeDirTree( const char* dir ) {
+  char **names,
+       **name,
+       *file ;
+
+  if ( ( names = jst_getFileNames( (char*)dir, NULL, NULL, NULL ) ) ) {
+    for ( name = names ; *name ; name++ ) {
+      if ( !( file = jst_createFileName( dir, *name, NULL ) ) ) continue ;
+      if ( jst_isDir( file ) ) {
+        removeDirTree( file ) ;
+      } else {
+        remove( file ) ;
+      }
+      free( file ) ;
+    }
+    free( names ) ;
+  }
+
+  rmdir( dir ) ;
+}
+
+/** Looks for className.class under the given dir (compiled classes w/ package dirs). Returns the fully qualified name of the class,
+ * or NULL if it was not found. *foreignClasses is set if the dir contains classes that are not the script class or its inner classes
+ * or closures. Those would have been compiled from sources groovyc found on the classpath and must not be cached w/ the script,
+ * as the cache does not notice if those change. */
+static char* findScriptClass( const char* dir, const char* package, const char* className, jboolean* foreignClasses ) {
+  char   **names,
+         **name,
+         *file,
+         *found = NULL,
+         *classInPackage ;
+  size_t classNameLen = strlen( className ) ;
+
+  if ( !( names = jst_getFileNames( (char*)dir, NULL, NULL, NULL ) ) ) return NULL ;
+
+  for ( name = names ; *name && !*foreignClasses ; name++ ) {
+    if ( !( file = jst_createFileName( dir, *name, NULL ) ) ) break ;
+
+    if ( jst_isDir( file ) ) {
+      char *subPackage = jst_append( NULL, NULL, package, *name, ".", NULL ) ;
+      if ( subPackage ) {
+        if ( ( classInPackage = findScriptClass( file, subPackage, className, foreignClasses ) ) ) {
+          if ( found ) *foreignClasses = JNI_TRUE ;
+          found = classInPackage ;
+        }
+        free( subPackage ) ;
+      }
+    } else if ( memcmp( *name, className, classNameLen ) == 0 && strcmp( *name + classNameLen, ".class" ) == 0 ) {
+      if ( found ) *foreignClasses = JNI_TRUE ;
+      found = jst_append( NULL, NULL, package, className, NULL ) ;
+    } else if ( !( memcmp( *name, className, classNameLen ) == 0 && (*name)[ classNameLen ] == '$' ) ) {
+      *foreignClasses = JNI_TRUE ;
+    }
+
+    free( file ) ;
+  }
+
+  free( names ) ;
+
+  return found ;
+}
+
+/** Checks whether the given class file has a static main method, which e.g. a test case compiled from a script does not
+ * (GroovyMain would run it as a test). This is a cheap approximation: the constant pool must contain the utf8 constants
+ * "main" and "([Ljava/lang/String;)V". */
+static jboolean hasMainMethod( const char* classFile ) {
+  static const char mainName[]       = "\001\000\004main",
+                    mainDescriptor[] = "([Ljava/lang/String;)V" ;
+  JstMappedFile     file ;
+  jboolean          nameFound       = JNI_FALSE,
+                    descriptorFound = JNI_FALSE ;
+  size_t            i ;
+
+  if ( !jst_mapFile( classFile, &file ) ) return JNI_FALSE ;
+
+  for ( i = 0 ; i < file.size && !( nameFound && descriptorFound ) ; i++ ) {
+    if ( !nameFound && i + sizeof( mainName ) - 1 <= file.size && memcmp( file.data + i, mainName, sizeof( mainName ) - 1 ) == 0 ) nameFound = JNI_TRUE ;
+    if ( !descriptorFound && i + sizeof( mainDescriptor ) - 1 <= file.size && memcmp( file.data + i, mainDescriptor, sizeof( mainDescriptor ) - 1 ) == 0 ) descriptorFound = JNI_TRUE ;
+  }
+
+  jst_unmapFile( &file ) ;
+
+  return nameFound && descriptorFound ;
+}
+
+int startGroovy( int argc, char** argv ) ;
+
+/** Runs groovyc on the script and moves the result into the cache. Run in the detached background process.
+ * @param classpath, javaHomeParam the values of -cp and -jh given to the launcher, NULL if not given
+ * Returns 0 if the script was not cached. */
+static int compileScriptIntoCache( const char* executable, GroovyScript* script, const char* cacheDir, char** stamps,
+                                   char* groovyConfFile, char* classpath, char* javaHomeParam ) {
+  char     pidSuffix[ 32 ],
+           *classesDir = NULL,
+           *tmpDir     = NULL,
+           *srcDir     = NULL,
+           *sourceFile = NULL,
+           *groovyc    = NULL,
+           *mainClass  = NULL,
+           *mainClassFile,
+           *entries[ SCRIPT_ENTRY_COUNT + 1 ],
+           *args[ 12 ] ;
+  jboolean foreignClasses = JNI_FALSE,
+           cached         = JNI_FALSE ;
+  int      argCount = 0,
+           status ;
+  pid_t    pid ;
+
+  sprintf( pidSuffix, ".%ld.tmp", (long)getpid() ) ;
+
+  if ( !( classesDir = jst_createFileName( cacheDir, script->hex, NULL ) ) ||
+       !( tmpDir = jst_append( NULL, NULL, classesDir, pidSuffix, NULL ) ) ||
+       mkdir( tmpDir, 0700 ) ) goto end ;
+
+  if ( script->scriptText ) {
+    // groovyc names the class after the file, so the one-liner is written into a file named as GroovyMain names the class
+    if ( !( srcDir = jst_append( NULL, NULL, classesDir, pidSuffix, ".src", NULL ) ) ||
+         mkdir( srcDir, 0700 ) ||
+         !( sourceFile = jst_createFileName( srcDir, ONELINER_CLASS_NAME ".groovy", NULL ) ) ||
+         !jst_writeFileAtomically( sourceFile, script->scriptText, strlen( script->scriptText ) ) ) goto end ;
+  } else {
+    if ( !( sourceFile = jst_strdup( script->scriptFile ) ) ) goto end ;
+  }
+
+  // the launcher is groovyc when invoked under that name
+  {
+    const char *fileName = strrchr( executable, JST_FILE_SEPARATOR[ 0 ] ) ;
+    size_t     dirLen    = fileName ? fileName + 1 - executable : 0 ;
+    if ( !( groovyc = jst_malloc( dirLen + sizeof( "groovyc" ) ) ) ) goto end ;
+    memcpy( groovyc, executable, dirLen ) ;
+    strcpy( groovyc + dirLen, "groovyc" ) ;
+  }
+
+  args[ argCount++ ] = groovyc ;
+  args[ argCount++ ] = "-d" ;
+  args[ argCount++ ] = tmpDir ;
+  args[ argCount++ ] = "--conf" ;
+  args[ argCount++ ] = groovyConfFile ;
+  if ( classpath ) {
+    args[ argCount++ ] = "-cp" ;
+    args[ argCount++ ] = classpath ;
+  }
+  if ( javaHomeParam ) {
+    args[ argCount++ ] = "-jh" ;
+    args[ argCount++ ] = javaHomeParam ;
+  }
+  args[ argCount++ ] = sourceFile ;
+  args[ argCount ]   = NULL ;
+
+  // groovyc is run in a child process of its own as it may call System.exit
+  if ( ( pid = fork() ) == -1 ) goto end ;
+  if ( pid == 0 ) _exit( startGroovy( argCount, args ) ) ;
+  if ( waitpid( pid, &status, 0 ) == -1 || !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ) goto store ;
+
+  if ( ( mainClass = findScriptClass( tmpDir, "", script->className, &foreignClasses ) ) && !foreignClasses ) {
+    char *classFile = jst_append( NULL, NULL, mainClass, ".class", NULL ),
+         *c ;
+    if ( classFile ) {
+      // the package separators, but not the one before the suffix
+      for ( c = classFile ; c[ 6 ] ; c++ ) if ( *c == '.' ) *c = JST_FILE_SEPARATOR[ 0 ] ;
+      if ( ( mainClassFile = jst_createFileName( tmpDir, classFile, NULL ) ) ) {
+        cached = hasMainMethod( mainClassFile ) ;
+        free( mainClassFile ) ;
+      }
+      free( classFile ) ;
+    }
+  }
+
+  if ( cached ) {
+    // the old classes of a plan that was invalidated
+    if ( jst_fileExists( classesDir ) ) removeDirTree( classesDir ) ;
+    cached = ( rename( tmpDir, classesDir ) == 0 ) ? JNI_TRUE : JNI_FALSE ;
+  }
+
+  store:
+  // remember the scripts that can not be cached so they are not compiled in vain on every run
+  entries[ SCRIPT_MAIN_CLASS  ] = cached ? mainClass  : "" ;
+  entries[ SCRIPT_CLASSES_DIR ] = cached ? classesDir : "" ;
+  entries[ SCRIPT_ENTRY_COUNT ] = NULL ;
+  jst_storeLaunchPlan( script->key, entries, stamps ) ;
+
+  end:
+  if ( tmpDir && !cached ) removeDirTree( tmpDir ) ;
+  if ( srcDir     ) removeDirTree( srcDir ) ;
+  if ( classesDir ) free( classesDir ) ;
+  if ( tmpDir     ) free( tmpDir ) ;
+  if ( srcDir     ) free( srcDir ) ;
+  if ( sourceFile ) free( sourceFile ) ;
+  if ( groovyc    ) free( groovyc ) ;
+  if ( mainClass  ) free( mainClass ) ;
+
+  return cached ;
+}
+
+/** Forks off a detached process that compiles the script into the cache, unless some other launcher is already compiling it.
+ * Failing to do so is not an error. */
+static void compileScriptInBackground( const char* executable, GroovyScript* script, const char* cacheDir, char** stamps,
+                                       char* groovyConfFile, char* classpath, char* javaHomeParam ) {
+  char  *lockFile ;
+  pid_t pid ;
+  int   devNull ;
+
+  if ( !( lockFile = jst_append( NULL, NULL, cacheDir, JST_FILE_SEPARATOR, script->hex, ".lock", NULL ) ) ) return ;
+
+  if ( !jst_createLockFile( lockFile, SCRIPT_COMPILE_TIMEOUT ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: another launcher is compiling the script into the cache\n" ) ;
+    free( lockFile ) ;
+    return ;
+  }
+
+  if ( _jst_debug ) fprintf( stderr, "debug: compiling the script into the cache in the background\n" ) ;
+
+  fflush( stdout ) ;
+  fflush( stderr ) ;
+
+  if ( ( pid = fork() ) == -1 ) {
+    remove( lockFile ) ;
+  } else if ( pid == 0 ) {
+    // the first child just forks the process doing the work so that it is not left for the launcher to wait for
+    setsid() ;
+    if ( ( pid = fork() ) != 0 ) {
+      if ( pid == -1 ) remove( lockFile ) ;
+      _exit( 0 ) ;
+    }
+
+    if ( ( devNull = open( "/dev/null", O_RDWR ) ) != -1 ) {
+      dup2( devNull, 0 ) ;
+      dup2( devNull, 1 ) ;
+      dup2( devNull, 2 ) ;
+      if ( devNull > 2 ) close( devNull ) ;
+    }
+    _jst_debug = JNI_FALSE ;
+
+    compileScriptIntoCache( executable, script, cacheDir, stamps, groovyConfFile, classpath, javaHomeParam ) ;
+    remove( lockFile ) ;
+    _exit( 0 ) ;
+  } else {
+    waitpid( pid, NULL, 0 ) ;
+  }
+
+  free( lockFile ) ;
+}
+
+#endif
+
+/** If the script to run can be cached and there are up to date compiled classes for it, sets the main class and the classpath
+ * given to GroovyStarter so that those are run and returns the params to pass on w/out the script. Otherwise returns the given
+ * params (and, if the script can be cached, starts compiling it into the cache).
+ * Returns NULL on error. Dynallocated memory is reserved from the given arena.
+ * @param extraProgramOptions the options to GroovyStarter, as in startGroovy */
+static JstActualParam* useScriptCache( const char* executable, JstActualParam* processedParams, char* startupJar, char* groovyConfFile,
+                                       char** extraProgramOptions, JstArena* arena ) {
+  GroovyScript   script ;
+  JstActualParam *rval     = processedParams ;
+  char           *cacheDir = NULL,
+                 **plan    = NULL,
+                 **stamps  = NULL,
+                 *classpath ;
+
+  if ( !findCacheableScript( processedParams, &script ) ) return processedParams ;
+
+  if ( !jst_arenaAdopt( arena, script.className = createScriptClassName( &script ) ) ||
+       !jst_arenaAdopt( arena, script.key = createScriptCacheKey( &script, startupJar, groovyConfFile, extraProgramOptions[ 5 ] ) ) ) return NULL ;
+
+  if ( ( plan = jst_loadLaunchPlan( script.key, SCRIPT_ENTRY_COUNT ) ) ) {
+
+    if ( !*plan[ SCRIPT_MAIN_CLASS ] ) {
+      if ( _jst_debug ) fprintf( stderr, "debug: the script could not be compiled into the cache on an earlier run\n" ) ;
+      goto end ;
+    }
+
+    if ( jst_fileExists( plan[ SCRIPT_CLASSES_DIR ] ) ) {
+      if ( _jst_debug ) fprintf( stderr, "debug: running %s compiled into %s\n", plan[ SCRIPT_MAIN_CLASS ], plan[ SCRIPT_CLASSES_DIR ] ) ;
+
+      // the compiled classes come first, as the class GroovyMain would compile from the script would
+      if ( !( classpath = jst_arenaConcat( arena, plan[ SCRIPT_CLASSES_DIR ], JST_PATH_SEPARATOR, extraProgramOptions[ 5 ], NULL ) ) ||
+           !jst_arenaAdopt( arena, plan ) ) {
+        // plan is freed on failure to adopt it
+        plan = NULL ;
+        rval = NULL ;
+        goto end ;
+      }
+
+      extraProgramOptions[ 1 ] = plan[ SCRIPT_MAIN_CLASS ] ;
+      extraProgramOptions[ 5 ] = classpath ;
+      plan = NULL ;
+
+      rval = jst_arenaAdopt( arena, removeScriptParams( processedParams, &script ) ) ;
+
+      goto end ;
+    }
+  }
+
+#if !defined( _WIN32 )
+  if ( !( cacheDir = jst_getCacheDir( SCRIPT_CACHE_SUBDIR, JNI_TRUE ) ) ) goto end ;
+
+  if ( !( stamps = createScriptCacheStamps( startupJar, extraProgramOptions[ 5 ] ) ) ) {
+    rval = NULL ;
+    goto end ;
+  }
+
+  compileScriptInBackground( executable, &script, cacheDir, stamps, groovyConfFile,
+                             jst_getParameterValue( processedParams, "-cp" ), jst_getParameterValue( processedParams, "-jh" ) ) ;
+#endif
+
+  end:
+  if ( plan     ) free( plan ) ;
+  if ( stamps   ) jst_freeAll( (void***)(void*)&stamps ) ;
+  if ( cacheDir ) free( cacheDir ) ;
+
+  return rval ;
+}
+
+/** The main class run if the app is started via GroovyStarter. */
+#define GROOVY_STARTER_CLASS "org/codehaus/groovy/tools/GroovyStarter"
+
+/** Reads the jars GroovyStarter would put into the RootLoader from the groovy conf file and sets the classpath option to
+ * contain those and the user classpath, so that the main class can be run directly w/out GroovyStarter.
+ * If the conf file contains something that can not be resolved here, or the user classpath contains wildcards (expanded
+ * by GroovyStarter), nothing is done.
+ * Returns 0 on error. Dynallocated memory is reserved from the given arena.
+ * @param extraProgramOptions the options to GroovyStarter, as in startGroovy
+ * @param mainClassName set to the main class to run in the jvm if the flat classpath is used, left untouched otherwise */
+static int useFlatClasspath( char* groovyConfFile, JstJvmOptions* jvmOptions, const JstActualParam* processedParams,
+                             char** extraProgramOptions, JstClasspathStrategy classpathStrategy,
+                             char** classpathOption, char** mainClassName, JstArena* arena ) {
+  JstDynamicPointerArray dOptions ;
+  char   **confJars     = NULL,
+         *userClasspath = extraProgramOptions[ 5 ],
+         *userCpOption  = NULL,
+         *mainClass     = NULL,
+         *cpOption      = NULL,
+         *c ;
+  int    i,
+         rval = 0 ;
+
+  if ( strchr( userClasspath, '*' ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not using a flat classpath, the classpath contains wildcards\n" ) ;
+    return 1 ;
+  }
+
+  if ( !jst_initializeDynamicPointerArray( &dOptions, 8 ) ) return 0 ;
+
+  // the system properties the jvm is started w/, which may be referred to in the conf file
+  for ( i = 0 ; i < jvmOptions->optionsCount ; i++ ) {
+    if ( strncmp( jvmOptions->options[ i ].optionString, "-D", 2 ) == 0 &&
+         !jst_appendPointerToDynamicArray( &dOptions, jvmOptions->options[ i ].optionString ) ) goto end ;
+  }
+  for ( i = 0 ; processedParams[ i ].param && !( processedParams[ i ].handling & JST_TERMINATING_OR_AFTER ) ; i++ ) {
+    if ( ( processedParams[ i ].handling & JST_UNRECOGNIZED ) && strncmp( processedParams[ i ].param, "-D", 2 ) == 0 &&
+         !jst_appendPointerToDynamicArray( &dOptions, processedParams[ i ].param ) ) goto end ;
+  }
+
+  if ( !( confJars = groovyStarterConfClasspath( groovyConfFile, (char**)dOptions.pointers ) ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not using a flat classpath, falling back to GroovyStarter\n" ) ;
+    rval = 1 ;
+    goto end ;
+  }
+
+  if ( classpathStrategy == JST_NORMAL_CLASSPATH ) {
+    if ( !( cpOption = jst_arenaAdopt( arena, jst_constructClasspath( userClasspath, NULL, confJars, JST_NORMAL_CLASSPATH ) ) ) ) goto end ;
+  } else {
+    // the groovy jars are on the boot classpath, the user classpath on the normal one as it would be in the RootLoader
+    if ( !( cpOption     = jst_arenaAdopt( arena, jst_constructClasspath( NULL, NULL, confJars, classpathStrategy ) ) ) ||
+         !( userCpOption = jst_arenaAdopt( arena, jst_constructClasspath( userClasspath, NULL, NULL, JST_NORMAL_CLASSPATH ) ) ) ||
+         !appendJvmOption( jvmOptions, userCpOption, NULL ) ) goto end ;
+  }
+
+  if ( !( mainClass = jst_arenaStrdup( arena, extraProgramOptions[ 1 ] ) ) ) goto end ;
+  for ( c = mainClass ; *c ; c++ ) {
+    if ( *c == '.' ) *c = '/' ;
+  }
+
+  if ( _jst_debug ) fprintf( stderr, "debug: running %s w/ a flat classpath\n", extraProgramOptions[ 1 ] ) ;
+
+  *classpathOption = cpOption ;
+  *mainClassName   = mainClass ;
+  rval = 1 ;
+
+  end:
+  jst_freeDynamicArray( &dOptions, JNI_FALSE ) ;
+  if ( confJars  ) jst_freeAll( (void***)(void*)&confJars ) ;
+
+  return rval ;
+}
+
+/** Returns the jars listed in the given groovy starter conf, separated by JST_PATH_SEPARATOR, so that they can be prefetched
+ * along w/ the jvm startup files (GroovyStarter loads them itself, so they are not on the jvm classpath). Returns "" if they
+ * can not be resolved natively (see groovyStarterConfClasspath), NULL on error. The returned value is freed w/ the given arena.
+ * @param dOptions the system properties the conf may refer to, as -D jvm options */
+static char* createStarterJarsPath( const char* groovyConfFile, char** dOptions, JstArena* arena ) {
+  JstStringBuilder path = JST_STRING_BUILDER_INITIALIZER ;
+  char             **confJars = groovyStarterConfClasspath( groovyConfFile, dOptions ),
+                   **jar,
+                   *rval      = "" ;
+
+  if ( !confJars ) return rval ;
+
+  for ( jar = confJars ; *jar ; jar++ ) {
+    if ( !jst_appendToStringBuilder( &path, ( jar == confJars ) ? "" : JST_PATH_SEPARATOR, *jar, NULL ) ) {
+      rval = NULL ;
+      break ;
+    }
+  }
+
+  if ( rval && path.chars && !( rval = jst_arenaAdopt( arena, path.chars ) ) ) jst_freeStringBuilder( &path ) ;
+
+  jst_freeAll( (void***)(void*)&confJars ) ;
+
+  return rval ;
+}
+
+/** Adds to the standard groovy help message. */
+static void printLauncherHelp( void ) {
+  fprintf( stderr, "\n"
+    " -jh,--javahome <path to jdk/jre> makes groovy use the given jdk/jre\n"
+    "                                 instead of the one pointed to by JAVA_HOME\n"
+    " --java-version <version>        use the fastest starting installed java of the\n"
+    "                                 given version, e.g. 17, 11+ or 8-11\n"
+    " --conf <conf file>              use the given groovy conf file\n"
+    " --flat-classpath                put the jars listed in the conf file on the jvm\n"
+    "                                 classpath and run w/out GroovyStarter\n"
+    " --fast-exit                     exit as soon as the script returns, w/out\n"
+    "                                 waiting for other threads (like System.exit)\n"
+    " --profile <profile>             use the jvm flags of the given profile: startup,\n"
+    "                                 throughput, none or auto (the default), which\n"
+    "                                 picks one by how the previous runs went\n"
+    "\n"
+    " -client/-server                 to use a client/server VM\n"
+    "\n"
+    "In addition, you can give any parameters accepted by the jvm you are using, e.g.\n"
+    "-Xmx<size> (see java -help and java -X for details)\n"
+    "\n"
+  ) ;
+}
+
 static void printProgramArgs( int argc, char** argv ) {
   int i = 0 ;
   fprintf( stderr, "parameters passed to the launcher:\n" ) ;
@@ -336,11 +1094,22 @@ int startGroovy( int argc, char** argv ) {
        *groovyDConf     = NULL, // the -Dgroovy.conf=something to pass to the jvm
        *groovyHome      = NULL,
        *groovyDHome     = NULL, // the -Dgroovy.home=something to pass to the jvm
+       *starterJars     = NULL, // the jars listed in the groovy starter conf, to be prefetched
        *classpath       = NULL,
-       *javaHome        = NULL ;
-
-  void** dynReservedPointers = NULL ; // free all reserved pointers at at end of func
-  size_t dreservedPtrsSize   = 0 ;
+       *javaHome        = NULL,
+       *toolsJarD       = NULL,
+       *jvmDynLibPath   = NULL,
+       *classpathOption = NULL,
+       *userGivenJavaHome = NULL, // java home as given in -jh or JAVA_HOME, NULL if it was searched for
+       *javaVersion     = NULL, // as given in --java-version
+       *profileName     = NULL, // as given in --profile
+       *scriptFile      = NULL, // the full path of the script run by groovy, NULL if not running a script
+       *launchPlanKey   = NULL,
+       *mainClassName   = GROOVY_STARTER_CLASS,
+       **launchPlan     = NULL,
+       **expandedArgs   = NULL ;
+
+  JstArena arena = JST_ARENA_INITIALIZER ; // all the memory reserved in this func, freed at the end
 
   /** terminatingSuffixes contains the suffixes that, if matched, indicate that the matching param and all the rest of the params
    * are launcheeParams, e.g. {".groovy", ".gy", NULL}.
@@ -356,19 +1125,26 @@ int startGroovy( int argc, char** argv ) {
   int  exitCode = -1,
        numSkippedCommandLineParams = 1 ;
 
-  JVMSelectStrategy jvmSelectStrategy = JST_CLIENT_FIRST ;
+  JVMSelectStrategy jvmSelectStrategy     = JST_CLIENT_FIRST,
+                    fileJvmSelectStrategy = JST_CLIENT_FIRST ;
+  JstClasspathStrategy classpathStrategy ;
+  int jvmProfile = JST_PROFILE_NONE ;
 
   jboolean displayHelp          = ( ( numArgs == 0 )                       ||
                                     ( strcmp( argv[ 1 ], "-h"     ) == 0 ) ||
                                     ( strcmp( argv[ 1 ], "--help" ) == 0 )
-                                  ) ? JNI_TRUE : JNI_FALSE ;
+                                  ) ? JNI_TRUE : JNI_FALSE,
+           captureHelp          = JNI_FALSE ;
 
-  JstActualParam *processedActualParams = NULL ;
+  JstActualParam *processedActualParams = NULL,
+                 *launcheeParams        = NULL ; // processedActualParams, or w/out the script if a cached compiled script is run
 
   GroovyApp* groovyApp = NULL ;
 
   jst_initDebugState() ;
 
+  jst_tracePhase( "params" ) ;
+
   if ( _jst_debug ) printProgramArgs( argc, argv ) ;
 
   memset( &extraJvmOptions, 0, sizeof( extraJvmOptions ) ) ;
@@ -396,20 +1172,33 @@ int startGroovy( int argc, char** argv ) {
 
   if ( displayHelp && strcasecmp( "groovy", groovyApp->executableName ) != 0 ) displayHelp = JNI_FALSE ;
 
-  processedActualParams = jst_processInputParameters( argv + numSkippedCommandLineParams, argc - numSkippedCommandLineParams, groovyApp->parameterInfos, terminatingSuffixes, JST_CYGWIN_PATH_CONVERSION ) ;
+  if ( ( numArgs = jst_expandArgFiles( argc - numSkippedCommandLineParams, argv + numSkippedCommandLineParams, groovyApp->parameterInfos,
+                                          terminatingSuffixes, &expandedArgs, &arena ) ) == -1 ) goto end ;
+
+  processedActualParams = jst_processInputParameters( expandedArgs, numArgs, groovyApp->parameterInfos, terminatingSuffixes, JST_CYGWIN_PATH_CONVERSION ) ;
+
+  MARK_PTR_FOR_FREEING( arena, processedActualParams, NULL_MEANS_ERROR )
 
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, processedActualParams, NULL_MEANS_ERROR )
+  javaVersion = jst_getParameterValue( processedActualParams, "--java-version" ) ;
 
   // set -Dscript.name system property if applicable
   if ( numArgs > 0 ) {
     char* scriptName = jst_getParameterAfterTermination( processedActualParams, 0 ) ;
     if ( scriptName ) {
       char* scriptNameD = createScriptNameDParam( scriptName ) ;
-      MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, scriptNameD, NULL_MEANS_ERROR )
+      MARK_PTR_FOR_FREEING( arena, scriptNameD, NULL_MEANS_ERROR )
       if ( !appendJvmOption( &extraJvmOptions, scriptNameD, NULL ) ) goto end ;
+      // scripts may give jvm options in their header, and their flags are tuned by how their previous runs went
+      if ( strcasecmp( "groovy", groovyApp->executableName ) == 0 && isScriptFileGiven( processedActualParams ) ) {
+        scriptFile = scriptNameD + strlen( "-Dscript.name=" ) ;
+        jvmProfile = JST_PROFILE_AUTO ;
+      }
     }
   }
 
+  if ( ( profileName = jst_getParameterValue( processedActualParams, "--profile" ) ) &&
+       ( jvmProfile  = jst_parseJvmProfile( profileName ) ) == -1 ) goto end ;
+
   classpath = jst_getParameterValue( processedActualParams, "-cp" ) ;
   if ( !classpath ) {
     classpath = getenv( "CLASSPATH" ) ;
@@ -418,99 +1207,195 @@ int startGroovy( int argc, char** argv ) {
   // add "." to the end of the used classpath. This is what the script launcher also does
   if ( classpath ) {
 
-    classpath = jst_append( NULL, NULL, classpath, JST_PATH_SEPARATOR ".", NULL ) ;
-    MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, classpath, NULL_MEANS_ERROR )
+    if ( !( classpath = jst_arenaConcat( &arena, classpath, JST_PATH_SEPARATOR ".", NULL ) ) ) goto end ;
 
     extraProgramOptions[ 5 ] = classpath ;
 
   }
 
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  // reuse what was resolved on a previous run, if nothing relevant has changed since
+
+  jst_tracePhase( "launchplan" ) ;
+
+  if ( jst_cachingEnabled() ) {
+    launchPlanKey = createLaunchPlanKey( argv[ 0 ], processedActualParams ) ;
+    MARK_PTR_FOR_FREEING( arena, launchPlanKey, NULL_MEANS_ERROR )
+    if ( ( launchPlan = jst_loadLaunchPlan( launchPlanKey, PLAN_ENTRY_COUNT ) ) ) {
+      MARK_PTR_FOR_FREEING( arena, launchPlan, NULL_MEANS_ERROR )
+      // a java installation better matching the requested version may have been installed since the plan was stored.
+      // The inventory is cached too, so checking this is cheap
+      if ( javaVersion && !jst_getParameterValue( processedActualParams, "-jh" ) ) {
+        char* selectedJavaHome = jst_findJavaHomeByVersion( javaVersion ) ;
+        // no installation matching the version is left, which has been reported already
+        if ( !selectedJavaHome ) goto end ;
+        MARK_PTR_FOR_FREEING( arena, selectedJavaHome, NULL_MEANS_ERROR )
+        if ( strcmp( selectedJavaHome, launchPlan[ PLAN_JAVA_HOME ] ) != 0 ) launchPlan = NULL ;
+      }
+    }
+  }
+
+  if ( launchPlan ) {
+
+    groovyHome      = launchPlan[ PLAN_GROOVY_HOME ] ;
+    groovyConfFile  = launchPlan[ PLAN_GROOVY_CONF ] ;
+    jars[ 0 ]       = launchPlan[ PLAN_STARTUP_JAR ] ;
+    javaHome        = launchPlan[ PLAN_JAVA_HOME ] ;
+    jvmDynLibPath   = launchPlan[ PLAN_JVM_DYNLIB ] ;
+    classpathOption = launchPlan[ PLAN_CLASSPATH_OPTION ] ;
+    toolsJarD       = *launchPlan[ PLAN_TOOLS_JAR_D ] ? launchPlan[ PLAN_TOOLS_JAR_D ] : NULL ;
+    groovyDConf     = launchPlan[ PLAN_GROOVY_D_CONF ] ;
+    groovyDHome     = launchPlan[ PLAN_GROOVY_D_HOME ] ;
+    starterJars     = launchPlan[ PLAN_STARTER_JARS ] ;
+
+    // read the jvm from disk while the rest of the launch is prepared
+    jst_preloadJvmDynLib( javaHome, jvmDynLibPath, jvmSelectStrategy ) ;
+
+  } else {
+
+    jst_tracePhase( "groovyhome" ) ;
+
 #if defined( GROOVY_HOME )
-  // TODO: for some reason this won't accept something that begins with a "/"
-  groovyHome = JST_STRINGIZER( GROOVY_HOME ) ;
-  if ( _jst_debug ) fprintf( stderr, "debug: using groovy home set at compile time: %s\n", groovyHome ) ;
+    // TODO: for some reason this won't accept something that begins with a "/"
+    groovyHome = JST_STRINGIZER( GROOVY_HOME ) ;
+    if ( _jst_debug ) fprintf( stderr, "debug: using groovy home set at compile time: %s\n", groovyHome ) ;
 #else
-  groovyHome = getGroovyHome() ;
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, groovyHome, NULL_IS_NOT_ERROR )
+    groovyHome = getGroovyHome() ;
+    MARK_PTR_FOR_FREEING( arena, groovyHome, NULL_IS_NOT_ERROR )
 #endif
 
-  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-  // find out the groovy conf file to use
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // find out the groovy conf file to use
 
-  groovyConfFile = jst_getParameterValue( processedActualParams, "--conf" ) ;
+    groovyConfFile = jst_getParameterValue( processedActualParams, "--conf" ) ;
 
-  if ( !groovyConfFile  ) groovyConfFile = getenv( "GROOVY_CONF" ) ;
+    if ( !groovyConfFile  ) groovyConfFile = getenv( "GROOVY_CONF" ) ;
 
-  if ( !groovyConfFile ) {
-    groovyConfFile = jst_createFileName( groovyHome, "conf", GROOVY_CONF_FILE, NULL ) ;
-    MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, groovyConfFile, NULL_MEANS_ERROR )
-  }
+    if ( !groovyConfFile ) {
+      if ( !( groovyConfFile = jst_arenaCreateFileName( &arena, groovyHome, "conf", GROOVY_CONF_FILE, NULL ) ) ) goto end ;
+    }
 
 #if defined( GROOVY_STARTUP_JAR )
-  jars[ 0 ] = JST_STRINGIZER( GROOVY_STARTUP_JAR ) ;
-  if ( _jst_debug ) fprintf( stderr, "debug: using groovy startup jar set at compile time: %s\n", jars[ 0 ] ) ;
+    jars[ 0 ] = JST_STRINGIZER( GROOVY_STARTUP_JAR ) ;
+    if ( _jst_debug ) fprintf( stderr, "debug: using groovy startup jar set at compile time: %s\n", jars[ 0 ] ) ;
 #else
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, jars[ 0 ] = findGroovyStartupJar( groovyHome ), NULL_IS_NOT_ERROR )
+    MARK_PTR_FOR_FREEING( arena, jars[ 0 ] = findGroovyStartupJar( groovyHome ), NULL_IS_NOT_ERROR )
 #endif
-  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-  // set -Dgroovy.home and -Dgroovy.starter.conf as jvm options
 
-
-  extraProgramOptions[ 3 ] = groovyConfFile ;
+    jst_tracePhase( "javahome" ) ;
 
 #if defined( JAVA_HOME )
-  javaHome = JST_STRINGIZER( JAVA_HOME ) ;
-  if ( _jst_debug ) fprintf( stderr, "debug: using java home set at compile time: %s\n", javaHome ) ;
+    javaHome = userGivenJavaHome = JST_STRINGIZER( JAVA_HOME ) ;
+    if ( _jst_debug ) fprintf( stderr, "debug: using java home set at compile time: %s\n", javaHome ) ;
 #else
-  errno = 0 ;
-  if ( !( javaHome = getJavaHomeFromParameter( processedActualParams, "-jh" ) ) && !errno ) {
-    javaHome = jst_findJavaHome() ;
-  }
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, javaHome, NULL_IS_NOT_ERROR )
+    errno = 0 ;
+    if ( !( javaHome = getJavaHomeFromParameter( processedActualParams, "-jh" ) ) && !errno ) {
+      if ( javaVersion ) {
+        if ( !( javaHome = jst_findJavaHomeByVersion( javaVersion ) ) ) goto end ;
+      } else {
+        javaHome = jst_findJavaHome() ;
+        userGivenJavaHome = getenv( "JAVA_HOME" ) ;
+        // if JAVA_HOME does not exist, java home was searched for and may change w/out anything in the plan key changing
+        if ( userGivenJavaHome && ( !*userGivenJavaHome || !jst_fileExists( userGivenJavaHome ) ) ) userGivenJavaHome = NULL ;
+      }
+    } else {
+      userGivenJavaHome = jst_getParameterValue( processedActualParams, "-jh" ) ;
+    }
+    MARK_PTR_FOR_FREEING( arena, javaHome, NULL_IS_NOT_ERROR )
 #endif
 
-  {
-    char* toolsJarFile = jst_createFileName( javaHome, "lib", "tools.jar", NULL ) ;
+    // JAVA_OPTS may still select another type of jvm, in which case the preloaded one is not used
+    jst_preloadJvmDynLib( javaHome, NULL, jst_getParameterValue( processedActualParams, "-client" ) ? JST_CLIENTVM :
+                                          jst_getParameterValue( processedActualParams, "-server" ) ? JST_SERVERVM : jvmSelectStrategy ) ;
 
-    if ( !toolsJarFile ) goto end ;
-    if ( jst_fileExists( toolsJarFile ) ) {
-      char* toolsJarD = jst_append( NULL, NULL, "-Dtools.jar=", toolsJarFile, NULL ) ;
+    {
+      char* toolsJarFile = jst_arenaCreateFileName( &arena, javaHome, "lib", "tools.jar", NULL ) ;
 
-      if ( !toolsJarD ||
-           !jst_appendPointer( &dynReservedPointers, &dreservedPtrsSize, toolsJarD ) ||
-           !appendJvmOption( &extraJvmOptions, toolsJarD, NULL ) ) {
-        free( toolsJarFile ) ;
-        goto end ;
+      if ( !toolsJarFile ) goto end ;
+      if ( jst_fileExists( toolsJarFile ) ) {
+        if ( !( toolsJarD = jst_arenaConcat( &arena, "-Dtools.jar=", toolsJarFile, NULL ) ) ) goto end ;
       }
+    }
+
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // set -Dgroovy.home and -Dgroovy.starter.conf as jvm options
+
+    if ( !( groovyDConf = jst_arenaConcat( &arena, "-Dgroovy.starter.conf=", groovyConfFile, NULL ) ) ) goto end ;
+
+    if ( !( groovyDHome = jst_arenaConcat( &arena, "-Dgroovy.home=", groovyHome, NULL ) ) ) goto end ;
 
+    {
+      char* dOptions[ 4 ] ;
+      dOptions[ 0 ] = groovyDHome ;
+      dOptions[ 1 ] = groovyDConf ;
+      dOptions[ 2 ] = toolsJarD ;
+      dOptions[ 3 ] = NULL ;
+      if ( !( starterJars = createStarterJarsPath( groovyConfFile, dOptions, &arena ) ) ) goto end ;
     }
 
-    free( toolsJarFile ) ;
   }
 
-  groovyDConf = jst_append( NULL, NULL, "-Dgroovy.starter.conf=", groovyConfFile, NULL ) ;
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, groovyDConf, NULL_MEANS_ERROR )
+  // tools run groovy -v and --help to find out what is installed, so those are answered w/out starting the jvm when possible
+  if ( numArgs == 1 && strcasecmp( "groovy", groovyApp->executableName ) == 0 && jars[ 0 ] ) {
+    if ( strcmp( expandedArgs[ 0 ], "-v" ) == 0 || strcmp( expandedArgs[ 0 ], "--version" ) == 0 ) {
+      if ( groovyPrintVersion( jars[ 0 ], javaHome ) ) {
+        exitCode = 0 ;
+        goto end ;
+      }
+    } else if ( displayHelp ) {
+      if ( groovyPrintHelp( jars[ 0 ] ) ) {
+        printLauncherHelp() ;
+        exitCode = 0 ;
+        goto end ;
+      }
+      captureHelp = JNI_TRUE ;
+    }
+  }
+
+  jst_tracePhase( "jvmoptions" ) ;
+
+  extraProgramOptions[ 3 ] = groovyConfFile ;
 
+  if ( toolsJarD && !appendJvmOption( &extraJvmOptions, toolsJarD, NULL ) ) goto end ;
 
   if ( !appendJvmOption( &extraJvmOptions, groovyDConf, NULL ) ) goto end ;
 
-  groovyDHome = jst_append( NULL, NULL, "-Dgroovy.home=", groovyHome, NULL ) ;
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, groovyDHome, NULL_MEANS_ERROR )
-
   if ( !appendJvmOption( &extraJvmOptions, groovyDHome, NULL ) ) goto end ;
 
+  // the installation's options, then the script's own, so that JAVA_OPTS and the command line can still override both.
+  // The launch plan key covers neither file, so the jvm they choose is kept apart from jvmSelectStrategy (see below)
+  if ( groovyHome ) {
+    char* jvmOptionsFile = jst_arenaCreateFileName( &arena, groovyHome, "conf", JVM_OPTIONS_FILE, NULL ) ;
+    if ( !jvmOptionsFile || !jst_readJvmOptionsFile( jvmOptionsFile, &extraJvmOptions, &fileJvmSelectStrategy, &arena ) ) goto end ;
+  }
+
+  if ( scriptFile && !jst_readScriptJvmOptions( scriptFile, &extraJvmOptions, &fileJvmSelectStrategy, &arena ) ) goto end ;
+
   {
     char* javaOptsFromEnvVar = getenv( "JAVA_OPTS" ) ;
     if ( javaOptsFromEnvVar ) {
-      MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, javaOptsFromEnvVar = jst_strdup( javaOptsFromEnvVar ), NULL_MEANS_ERROR )
+      if ( !( javaOptsFromEnvVar = jst_arenaStrdup( &arena, javaOptsFromEnvVar ) ) ) goto end ;
       if ( !handleJVMOptsString( javaOptsFromEnvVar, &extraJvmOptions, &jvmSelectStrategy ) ) goto end ;
     }
   }
 
+  // the jars grabbed on an earlier run go on the classpath given to GroovyStarter, so they are in the same class loader as
+  // Grape would have put them in
+  if ( scriptFile && jst_cachingEnabled() ) {
+    jboolean grabError = JNI_FALSE ;
+    char*    grabbedJars ;
 
+    jst_tracePhase( "grabs" ) ;
 
+    if ( ( grabbedJars = groovyGrabbedJars( scriptFile, &grabError ) ) ) {
+      MARK_PTR_FOR_FREEING( arena, grabbedJars, NULL_MEANS_ERROR )
+      if ( !( extraProgramOptions[ 5 ] = jst_arenaConcat( &arena, extraProgramOptions[ 5 ], JST_PATH_SEPARATOR, grabbedJars, NULL ) ) ||
+           !appendJvmOption( &extraJvmOptions, GRAPE_DISABLE_OPTION, NULL ) ) goto end ;
+    } else if ( grabError ) {
+      goto end ;
+    }
+  }
 
-  MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, extraJvmOptions.options, NULL_MEANS_ERROR )
 
 
   if ( jst_getParameterValue( processedActualParams, "-client" ) ) {
@@ -519,6 +1404,78 @@ int startGroovy( int argc, char** argv ) {
     jvmSelectStrategy = JST_SERVERVM ;
   }
 
+  classpathStrategy = jst_getParameterValue( processedActualParams, "--quickstart" ) ? JST_BOOTSTRAP_CLASSPATH_A : JST_NORMAL_CLASSPATH ;
+
+  launcheeParams = processedActualParams ;
+
+  if ( jst_cachingEnabled() && strcasecmp( "groovy", groovyApp->executableName ) == 0 && groovyHome && jars[ 0 ] ) {
+    jst_tracePhase( "scriptcache" ) ;
+    if ( !( launcheeParams = useScriptCache( argv[ 0 ], processedActualParams, jars[ 0 ], groovyConfFile, extraProgramOptions, &arena ) ) ) goto end ;
+  }
+
+  if ( jst_cachingEnabled() && strcasecmp( "groovyc", groovyApp->executableName ) == 0 && groovyHome && jars[ 0 ] ) {
+    jst_tracePhase( "groovyc" ) ;
+    switch ( groovycCheckSources( processedActualParams, &extraJvmOptions, extraProgramOptions[ 5 ], jars[ 0 ], groovyConfFile, javaHome, &launcheeParams ) ) {
+      case GROOVYC_UP_TO_DATE :
+        exitCode = 0 ;
+        goto end ;
+      case GROOVYC_COMPILE_CHANGED :
+        MARK_PTR_FOR_FREEING( arena, launcheeParams, NULL_MEANS_ERROR )
+        // the classes of the sources not compiled are found from the output dir
+        if ( !( extraProgramOptions[ 5 ] = jst_arenaConcat( &arena, jst_getParameterValue( processedActualParams, "-d" ), JST_PATH_SEPARATOR,
+                                                            extraProgramOptions[ 5 ], NULL ) ) ) goto end ;
+        break ;
+      case GROOVYC_COMPILE_ALL :
+        break ;
+      case GROOVYC_ERROR :
+        goto end ;
+    }
+  }
+
+  // resolve the rest of the plan now and cache it for the following runs. Only done if everything was found, otherwise we'd be caching
+  // an error. Java home is only cached if it was given explicitly, as there is no cheap way to tell whether searching for it again
+  // would give a different result. One selected by version is checked against the java installation inventory when the plan is used.
+  if ( launchPlanKey && !launchPlan && groovyHome && jars[ 0 ] && javaHome && ( userGivenJavaHome || javaVersion ) ) {
+    char* plan[ PLAN_ENTRY_COUNT + 1 ] ;
+
+    jst_tracePhase( "storeplan" ) ;
+
+    jvmDynLibPath = jst_findJvmDynLibPath( javaHome, jvmSelectStrategy ) ;
+    MARK_PTR_FOR_FREEING( arena, jvmDynLibPath, NULL_MEANS_ERROR )
+    classpathOption = jst_constructClasspath( NULL, NULL, jars, classpathStrategy ) ;
+    MARK_PTR_FOR_FREEING( arena, classpathOption, NULL_MEANS_ERROR )
+
+    plan[ PLAN_GROOVY_HOME      ] = groovyHome ;
+    plan[ PLAN_GROOVY_CONF      ] = groovyConfFile ;
+    plan[ PLAN_STARTUP_JAR      ] = jars[ 0 ] ;
+    plan[ PLAN_JAVA_HOME        ] = javaHome ;
+    plan[ PLAN_JVM_DYNLIB       ] = jvmDynLibPath ;
+    plan[ PLAN_CLASSPATH_OPTION ] = classpathOption ;
+    plan[ PLAN_TOOLS_JAR_D      ] = toolsJarD ? toolsJarD : "" ;
+    plan[ PLAN_GROOVY_D_CONF    ] = groovyDConf ;
+    plan[ PLAN_GROOVY_D_HOME    ] = groovyDHome ;
+    plan[ PLAN_STARTER_JARS     ] = starterJars ;
+    plan[ PLAN_ENTRY_COUNT      ] = NULL ;
+
+    storeLaunchPlan( launchPlanKey, plan, userGivenJavaHome ) ;
+  }
+
+  // jvmDynLibPath (cached or not) is for the jvm chosen by what the launch plan key covers. If neither JAVA_OPTS nor the
+  // command line chose one, jvm.options or the script header may have, in which case the jvm is looked up at launch
+  if ( jvmSelectStrategy == JST_CLIENT_FIRST && fileJvmSelectStrategy != JST_CLIENT_FIRST ) {
+    jvmSelectStrategy = fileJvmSelectStrategy ;
+    jvmDynLibPath     = NULL ;
+  }
+
+  if ( jst_getParameterValue( processedActualParams, "--flat-classpath" ) ) {
+    jst_tracePhase( "starterconf" ) ;
+    if ( !useFlatClasspath( groovyConfFile, &extraJvmOptions, processedActualParams, extraProgramOptions, classpathStrategy,
+                            &classpathOption, &mainClassName, &arena ) ) goto end ;
+  }
+
+  // no more jvm options are added after this, so the options array is not reallocated anymore
+  MARK_PTR_FOR_FREEING( arena, extraJvmOptions.options, NULL_MEANS_ERROR )
+
 
   // populate the startup parameters
   // first, set the memory to 0. This is just a precaution, as NULL (0) is a sensible default value for many options.
@@ -526,18 +1483,33 @@ int startGroovy( int argc, char** argv ) {
   // memset( &options, 0, sizeof( JavaLauncherOptions ) ) ;
 
   options.javaHome            = javaHome ;
+  options.jvmDynLibPath       = jvmDynLibPath ;
   options.jvmSelectStrategy   = jvmSelectStrategy ;
   options.initialClasspath    = NULL ;
   options.unrecognizedParamStrategy = groovyApp->unrecognizedParamStrategy ;
-  options.parameters          = processedActualParams ;
+  options.parameters          = launcheeParams ;
   options.jvmOptions          = &extraJvmOptions ;
-  options.extraProgramOptions = extraProgramOptions ;
-  options.mainClassName       = "org/codehaus/groovy/tools/GroovyStarter" ;
+  // w/ a flat classpath the main class is run directly, so there is no GroovyStarter to take the options
+  options.extraProgramOptions = ( strcmp( mainClassName, GROOVY_STARTER_CLASS ) == 0 ) ? extraProgramOptions : NULL ;
+  options.mainClassName       = mainClassName ;
   options.mainMethodName      = "main" ;
   options.jarDirs             = NULL ;
   options.jars                = jars ;
-  options.classpathStrategy   = jst_getParameterValue( processedActualParams, "--quickstart" ) ? JST_BOOTSTRAP_CLASSPATH_A : JST_NORMAL_CLASSPATH ;
-  options.pointersToFreeBeforeRunningMainMethod = &dynReservedPointers ;
+  options.classpathStrategy   = classpathStrategy ;
+  options.classpathOption     = classpathOption ;
+  options.prefetchPath        = ( starterJars && *starterJars ) ? starterJars : NULL ;
+  options.serverMode          = jst_getParameterValue( processedActualParams, "--server-mode" ) ? JNI_TRUE : JNI_FALSE ;
+  options.useSharedArchive    = ( classpathStrategy != JST_NORMAL_CLASSPATH ) ? JNI_TRUE : JNI_FALSE ;
+  options.fastExit            = jst_getParameterValue( processedActualParams, "--fast-exit" ) ? JNI_TRUE : JNI_FALSE ;
+  // only if -Xss is given
+  options.mainThreadStackSize = 0 ;
+  options.jvmProfile          = (JstJvmProfile)jvmProfile ;
+  options.runHistoryKey       = scriptFile ;
+  options.mainReturnedHook    = scriptFile ? groovyRecordGrabs : NULL ;
+  options.arenaToFreeBeforeRunningMainMethod = &arena ;
+
+  // the help text of GroovyMain is kept for groovyPrintHelp
+  if ( captureHelp ) captureHelp = groovyStartCapturingHelp( jars[ 0 ] ) ;
 
   exitCode = jst_launchJavaApp( &options ) ;
 
@@ -553,23 +1525,15 @@ int startGroovy( int argc, char** argv ) {
 //  jst_cygwinRelease() ;
 //#endif
 
-  if ( displayHelp ) { // add to the standard groovy help message
-    fprintf( stderr, "\n"
-    " -jh,--javahome <path to jdk/jre> makes groovy use the given jdk/jre\n"
-    "                                 instead of the one pointed to by JAVA_HOME\n"
-    " --conf <conf file>              use the given groovy conf file\n"
-    "\n"
-    " -client/-server                 to use a client/server VM\n"
-    "\n"
-    "In addition, you can give any parameters accepted by the jvm you are using, e.g.\n"
-    "-Xmx<size> (see java -help and java -X for details)\n"
-    "\n"
-    ) ;
-  }
+  if ( captureHelp ) groovyFinishCapturingHelp( exitCode ) ;
+
+  groovycRecordCompile( exitCode ) ;
+
+  if ( displayHelp ) printLauncherHelp() ;
 
 end:
 
-  jst_freeAll( &dynReservedPointers ) ;
+  jst_freeArena( &arena ) ;
 
   if ( _jst_debug ) fprintf( stderr, "debug: exiting %s with code %d\n", argv[ 0 ], exitCode ) ;
 
@@ -0,0 +1,887 @@
+//  Groovy -- A native launcher for Groovy
+//
+//  Copyright (c) 2010 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License") ; you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include <jni.h>
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_cache.h"
+#include "jst_fileutils.h"
+#include "jst_stringutils.h"
+#include "groovycmanifest.h"
+
+/** The manifest of an output dir is stored as a launch plan under this followed by the full path of the dir. */
+#define MANIFEST_KEY_PREFIX "groovyc-manifest-1\n"
+
+/** Dir trees on the classpath w/ more entries than this (or nested deeper) are not gone through, the sources are compiled
+ * w/out tracking them instead. */
+#define MAX_WALKED_FILES 100000
+#define MAX_WALK_DEPTH   64
+
+typedef enum {
+  /** of the compiler flags, the jvm options, the groovy and java installations and the classpath contents */
+  MANIFEST_FINGERPRINT,
+  /** a line per source: content hash, tab, the space separated class names it declares, tab, full path. Sorted by path. */
+  MANIFEST_SOURCES,
+  /** of the paths and modification times of the outputs */
+  MANIFEST_OUTPUTS_STAMP,
+  /** the full paths of the files written to the output dir, a line each, sorted */
+  MANIFEST_OUTPUTS,
+  MANIFEST_ENTRY_COUNT
+} ManifestEntry ;
+
+typedef enum {
+  TRACK_OK,
+  /** the sources are to be compiled w/out tracking them */
+  TRACK_UNTRACKABLE,
+  /** err msg printed */
+  TRACK_ERROR
+} TrackResult ;
+
+typedef struct {
+  /** full path */
+  char*       path ;
+  /** in the params given to groovycCheckSources */
+  int         paramIndex ;
+  char        hash[ JST_HASH_HEX_LEN ] ;
+  /** the space separated names of the classes the source declares, NULL if it has not been scanned */
+  char*       classNames ;
+  /** as in the manifest, NULL for a source not compiled before */
+  const char* recordedHash ;
+  const char* recordedClassNames ;
+  /** the identifiers the source mentions, sorted, NULL if it has not been scanned for them */
+  char**      tokens ;
+  size_t      tokenCount ;
+  jboolean    compile ;
+} Source ;
+
+typedef struct {
+  const char* start ;
+  size_t      length ;
+} Token ;
+
+typedef struct Walk_ Walk ;
+
+struct Walk_ {
+  /** Called w/ the full path of each file found. Returns 0 on error (err msg printed). */
+  int         (*visitFile)( Walk* walk, const char* file, jboolean inMetaInf ) ;
+  /** not gone into, may be NULL */
+  const char* skipDir ;
+  size_t      entryCount ;
+  JstHash     hash ;
+  JstDynamicPointerArray files ;
+} ;
+
+/** What groovycRecordCompile needs to know of the sources being compiled. */
+static struct {
+  jboolean active ;
+  JstArena arena ;
+  /** as given w/ -d */
+  char*    outputDir ;
+  JstHash  settingsHash ;
+  char*    classpath ;
+  /** sorted by path */
+  Source*  sources ;
+  size_t   sourceCount ;
+  /** the outputs in the manifest, sorted */
+  char**   recordedOutputs ;
+  size_t   recordedOutputCount ;
+  /** files modified after this (in nanoseconds) are taken to have been written by the compiler */
+  jlong    compileStarted ;
+} state ;
+
+static const char* sourceSuffixes[]     = { ".groovy", ".gvy", ".gy", ".gsh", ".java", NULL } ;
+/** The files in the classpath dirs the compiler may read. Anything under META-INF is tracked too, e.g. ast transformation
+ * descriptors. */
+static const char* compileInputSuffixes[] = { ".class", ".groovy", ".gvy", ".gy", ".gsh", ".java", ".jar", ".zip", NULL } ;
+/** The words that are followed by the name of the type being declared. */
+static const char* declarationKeywords[] = { "class", "interface", "enum", "trait", "record", NULL } ;
+
+static void releaseState( void ) {
+  jst_freeArena( &state.arena ) ;
+  memset( &state, 0, sizeof( state ) ) ;
+}
+
+static int compareStrings( const void* s1, const void* s2 ) {
+  return strcmp( *(const char**)s1, *(const char**)s2 ) ;
+}
+
+static int compareSources( const void* source1, const void* source2 ) {
+  return strcmp( ( (const Source*)source1 )->path, ( (const Source*)source2 )->path ) ;
+}
+
+/** For looking up a source by its path. */
+static int comparePathToSource( const void* path, const void* source ) {
+  return strcmp( *(const char**)path, ( (const Source*)source )->path ) ;
+}
+
+static int compareTokens( const void* token1, const void* token2 ) {
+  const Token *t1 = (const Token*)token1,
+              *t2 = (const Token*)token2 ;
+  int rval = memcmp( t1->start, t2->start, ( t1->length < t2->length ) ? t1->length : t2->length ) ;
+  return rval ? rval :
+         ( t1->length < t2->length ) ? -1 :
+         ( t1->length > t2->length ) ?  1 : 0 ;
+}
+
+static jboolean isSource( const char* file ) {
+  return bsearch( &file, state.sources, state.sourceCount, sizeof( Source ), comparePathToSource ) ? JNI_TRUE : JNI_FALSE ;
+}
+
+static jboolean hasSuffix( const char* file, const char** suffixes ) {
+  for ( ; *suffixes ; suffixes++ ) {
+    if ( jst_endsWith( file, *suffixes ) ) return JNI_TRUE ;
+  }
+  return JNI_FALSE ;
+}
+
+/** Hashes the given path and the modification time of the file, or that it is missing. */
+static JstHash hashStamp( JstHash hash, const char* file ) {
+  jlong mtime ;
+
+  hash = jst_hashString( hash, file ) ;
+
+  return jst_getModificationTime( file, &mtime ) ? jst_hashBytes( hash, &mtime, sizeof( mtime ) ) : jst_hashString( hash, NULL ) ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// going through dir trees
+
+/** Visits the files under the given dir, those in a dir first (sorted by name), then those under each of its subdirs. */
+static TrackResult walkDir( Walk* walk, char* dir, int depth, jboolean inMetaInf ) {
+  char        **names = NULL,
+              **name,
+              *path   = NULL ;
+  TrackResult rval    = TRACK_UNTRACKABLE,
+              result ;
+
+  if ( depth > MAX_WALK_DEPTH || !( names = jst_getFileNamesOfType( dir, NULL, NULL, JST_FILE_ENTRY, NULL ) ) ) goto end ;
+
+  for ( name = names ; *name ; name++ ) {
+    if ( ++walk->entryCount > MAX_WALKED_FILES ) goto end ;
+    if ( !( path = jst_createFileName( dir, *name, NULL ) ) || !walk->visitFile( walk, path, inMetaInf ) ) {
+      rval = TRACK_ERROR ;
+      goto end ;
+    }
+    jst_free( path ) ;
+  }
+
+  free( names ) ;
+  if ( !( names = jst_getFileNamesOfType( dir, NULL, NULL, JST_DIR_ENTRY, NULL ) ) ) goto end ;
+
+  for ( name = names ; *name ; name++ ) {
+    // there are no packages in these, and e.g. .git may be big
+    if ( **name == '.' ) continue ;
+    if ( ++walk->entryCount > MAX_WALKED_FILES ) goto end ;
+    if ( !( path = jst_createFileName( dir, *name, NULL ) ) ) {
+      rval = TRACK_ERROR ;
+      goto end ;
+    }
+    if ( !walk->skipDir || strcmp( path, walk->skipDir ) != 0 ) {
+      if ( ( result = walkDir( walk, path, depth + 1, inMetaInf || strcmp( *name, "META-INF" ) == 0 ) ) != TRACK_OK ) {
+        rval = result ;
+        goto end ;
+      }
+    }
+    jst_free( path ) ;
+  }
+
+  rval = TRACK_OK ;
+
+  end:
+  if ( names ) free( names ) ;
+  if ( path  ) free( path ) ;
+
+  return rval ;
+}
+
+static int hashCompileInput( Walk* walk, const char* file, jboolean inMetaInf ) {
+  if ( ( inMetaInf || hasSuffix( file, compileInputSuffixes ) ) && !isSource( file ) ) walk->hash = hashStamp( walk->hash, file ) ;
+  return 1 ;
+}
+
+/** Hashes the entries of the classpath and what the compiler may read from them, the sources excepted.
+ * @param outputDir not gone into */
+static TrackResult hashClasspath( const char* classpath, const char* outputDir, JstHash* hash ) {
+  Walk        walk ;
+  char        *entries,
+              *entry,
+              *next,
+              *fullPath = NULL ;
+  TrackResult rval      = TRACK_UNTRACKABLE ;
+
+  if ( !( entries = jst_strdup( classpath ) ) ) return TRACK_ERROR ;
+
+  memset( &walk, 0, sizeof( walk ) ) ;
+  walk.visitFile = hashCompileInput ;
+  walk.skipDir   = outputDir ;
+  walk.hash      = *hash ;
+
+  for ( entry = entries ; entry ; entry = next ) {
+    if ( ( next = strstr( entry, JST_PATH_SEPARATOR ) ) ) {
+      *next = '\0' ;
+      next += sizeof( JST_PATH_SEPARATOR ) - 1 ;
+    }
+
+    // the jars a wildcard expands to may change w/out the modification time of anything on the classpath changing
+    if ( strchr( entry, '*' ) || !( fullPath = jst_fullPathName( entry ) ) ) goto end ;
+
+    walk.hash = jst_hashString( walk.hash, fullPath ) ;
+
+    if ( !jst_fileExists( fullPath ) || !jst_isDir( fullPath ) ) {
+      walk.hash = hashStamp( walk.hash, fullPath ) ;
+    } else if ( strcmp( fullPath, outputDir ) != 0 && ( rval = walkDir( &walk, fullPath, 0, JNI_FALSE ) ) != TRACK_OK ) {
+      goto end ;
+    }
+
+    if ( fullPath != entry ) free( fullPath ) ;
+    fullPath = NULL ;
+  }
+
+  *hash = walk.hash ;
+  rval  = TRACK_OK ;
+
+  end:
+  if ( fullPath && fullPath != entry ) free( fullPath ) ;
+  free( entries ) ;
+
+  return rval ;
+}
+
+/** Hashes the paths and modification times of the given files. */
+static JstHash hashOutputs( char** outputs, size_t count ) {
+  JstHash hash = JST_HASH_INIT ;
+  size_t  i ;
+
+  for ( i = 0 ; i < count ; i++ ) hash = hashStamp( hash, outputs[ i ] ) ;
+
+  return hash ;
+}
+
+static int collectOutput( Walk* walk, const char* file, jboolean inMetaInf ) {
+  jlong mtime ;
+  char* copy ;
+
+  if ( !jst_getModificationTime( file, &mtime ) ) return 1 ;
+
+  // those of the sources not compiled this time were written on earlier runs
+  if ( mtime < state.compileStarted &&
+       ( !state.recordedOutputCount || !bsearch( &file, state.recordedOutputs, state.recordedOutputCount, sizeof( char* ), compareStrings ) ) ) return 1 ;
+
+  return ( copy = jst_arenaStrdup( &state.arena, file ) ) && jst_appendPointerToDynamicArray( &walk->files, copy ) ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// scanning the sources
+
+static jboolean isIdentifierChar( char c ) {
+  // bytes >= 0x80 are parts of non ascii letters in utf-8
+  return ( isalnum( (unsigned char)c ) || c == '_' || c == '$' || (unsigned char)c >= 0x80 ) ? JNI_TRUE : JNI_FALSE ;
+}
+
+static jboolean isDeclarationKeyword( const char* s, size_t len ) {
+  const char** keyword ;
+
+  for ( keyword = declarationKeywords ; *keyword ; keyword++ ) {
+    if ( len == strlen( *keyword ) && memcmp( s, *keyword, len ) == 0 ) return JNI_TRUE ;
+  }
+
+  return JNI_FALSE ;
+}
+
+/** Returns whether the given space separated list contains the given word (of the given length, not nul terminated). */
+static jboolean containsWord( const char* list, const char* word, size_t len ) {
+  const char* end ;
+
+  for ( ; list && *list ; list = *end ? end + 1 : end ) {
+    if ( !( end = strchr( list, ' ' ) ) ) end = list + strlen( list ) ;
+    if ( (size_t)( end - list ) == len && memcmp( list, word, len ) == 0 ) return JNI_TRUE ;
+  }
+
+  return JNI_FALSE ;
+}
+
+/** Returns 0 on error (err msg printed), in which case the builder has been freed. */
+static int appendClassName( JstStringBuilder* names, const char* name, size_t len ) {
+  char* copy ;
+
+  if ( containsWord( names->chars, name, len ) ) return 1 ;
+
+  if ( !( copy = jst_arenaAlloc( &state.arena, len + 1 ) ) ) {
+    jst_freeStringBuilder( names ) ;
+    return 0 ;
+  }
+  memcpy( copy, name, len ) ;
+  copy[ len ] = '\0' ;
+
+  return jst_appendToStringBuilder( names, names->length ? " " : "", copy, NULL ) ? 1 : 0 ;
+}
+
+/** Finds out the names of the classes the given source declares, i.e. those following a declaration keyword. If so requested,
+ * also collects the identifiers the source mentions. Comments and strings are not told apart from code, so this may find too
+ * many, but not too few.
+ * Returns 0 on error (err msg printed). */
+static int scanSource( Source* source, const char* data, size_t size, jboolean collectTokens ) {
+  JstStringBuilder names  = JST_STRING_BUILDER_INITIALIZER ;
+  Token            *tokens = NULL ;
+  size_t           tokenCount    = 0,
+                   tokenCapacity = 0,
+                   i, j ;
+  const char       *pos   = data,
+                   *end   = data + size,
+                   *start ;
+  jboolean         declaring = JNI_FALSE ;
+  int              rval      = 0 ;
+
+  while ( pos < end ) {
+    if ( !isIdentifierChar( *pos ) ) {
+      if ( !isspace( (unsigned char)*pos ) ) declaring = JNI_FALSE ;
+      pos++ ;
+      continue ;
+    }
+
+    for ( start = pos ; pos < end && isIdentifierChar( *pos ) ; pos++ ) ;
+
+    if ( isdigit( (unsigned char)*start ) ) {
+      declaring = JNI_FALSE ;
+      continue ;
+    }
+
+    if ( declaring && !appendClassName( &names, start, (size_t)( pos - start ) ) ) goto end ;
+    // e.g. Foo.class is not a declaration
+    declaring = ( isDeclarationKeyword( start, (size_t)( pos - start ) ) && ( start == data || start[ -1 ] != '.' ) ) ? JNI_TRUE : JNI_FALSE ;
+
+    if ( collectTokens ) {
+      if ( !( tokens = jst_ensureArrayCapacity( tokens, &tokenCapacity, tokenCount + 1, sizeof( Token ) ) ) ) goto end ;
+      tokens[ tokenCount ].start  = start ;
+      tokens[ tokenCount ].length = (size_t)( pos - start ) ;
+      tokenCount++ ;
+    }
+  }
+
+  if ( !( source->classNames = names.chars ? jst_arenaAdopt( &state.arena, names.chars ) : "" ) ) goto end ;
+  names.chars = NULL ;
+
+  if ( collectTokens ) {
+    if ( tokenCount ) qsort( tokens, tokenCount, sizeof( Token ), compareTokens ) ;
+
+    if ( !( source->tokens = jst_arenaAlloc( &state.arena, ( tokenCount + 1 ) * sizeof( char* ) ) ) ) goto end ;
+
+    for ( i = j = 0 ; i < tokenCount ; i++ ) {
+      if ( j && compareTokens( tokens + i, tokens + i - 1 ) == 0 ) continue ;
+      if ( !( source->tokens[ j ] = jst_arenaAlloc( &state.arena, tokens[ i ].length + 1 ) ) ) goto end ;
+      memcpy( source->tokens[ j ], tokens[ i ].start, tokens[ i ].length ) ;
+      source->tokens[ j++ ][ tokens[ i ].length ] = '\0' ;
+    }
+    source->tokens[ j ] = NULL ;
+    source->tokenCount  = j ;
+  }
+
+  rval = 1 ;
+
+  end:
+  if ( names.chars ) jst_freeStringBuilder( &names ) ;
+  if ( tokens      ) free( tokens ) ;
+
+  return rval ;
+}
+
+/** Hashes the contents of the given source, and scans it if it has changed since it was recorded. */
+static TrackResult hashSource( Source* source ) {
+  JstMappedFile file ;
+  TrackResult   rval = TRACK_OK ;
+
+  memset( &file, 0, sizeof( file ) ) ;
+
+  if ( !jst_mapFile( source->path, &file ) ) return TRACK_UNTRACKABLE ;
+
+  jst_hashToHex( jst_hashBytes( JST_HASH_INIT, file.data, file.size ), source->hash ) ;
+
+  if ( ( !source->recordedHash || strcmp( source->hash, source->recordedHash ) != 0 ) ) {
+    source->compile = JNI_TRUE ;
+    if ( !scanSource( source, file.data, file.size, JNI_FALSE ) ) rval = TRACK_ERROR ;
+  }
+
+  jst_unmapFile( &file ) ;
+
+  return rval ;
+}
+
+static TrackResult collectSourceTokens( Source* source ) {
+  JstMappedFile file ;
+  TrackResult   rval ;
+
+  memset( &file, 0, sizeof( file ) ) ;
+
+  if ( !jst_mapFile( source->path, &file ) ) return TRACK_UNTRACKABLE ;
+
+  rval = scanSource( source, file.data, file.size, JNI_TRUE ) ? TRACK_OK : TRACK_ERROR ;
+
+  jst_unmapFile( &file ) ;
+
+  return rval ;
+}
+
+/** Appends copies of the words in the given space separated list to the given array. Returns 0 on error. */
+static int appendWords( JstDynamicPointerArray* array, const char* list ) {
+  char *copy,
+       *word,
+       *next ;
+
+  if ( !list || !*list ) return 1 ;
+  if ( !( copy = jst_arenaStrdup( &state.arena, list ) ) ) return 0 ;
+
+  for ( word = copy ; word ; word = next ) {
+    if ( ( next = strchr( word, ' ' ) ) ) *next++ = '\0' ;
+    if ( !jst_appendPointerToDynamicArray( array, word ) ) return 0 ;
+  }
+
+  return 1 ;
+}
+
+/** Appends the names of the classes the given source declares now and did when it was recorded, and the name of the
+ * class named after the file (the script class if no such class is declared). Returns 0 on error. */
+static int appendClassNames( JstDynamicPointerArray* names, const Source* source ) {
+  const char *baseName  = strrchr( source->path, JST_FILE_SEPARATOR[ 0 ] ) + 1,
+             *extension = strrchr( baseName, '.' ) ;
+  size_t     len       = (size_t)( extension - baseName ) ;
+  char       *className ;
+
+  if ( !( className = jst_arenaAlloc( &state.arena, len + 1 ) ) ) return 0 ;
+  memcpy( className, baseName, len ) ;
+  className[ len ] = '\0' ;
+
+  return jst_appendPointerToDynamicArray( names, className ) &&
+         appendWords( names, source->recordedClassNames ) && appendWords( names, source->classNames ) ;
+}
+
+/** Marks for compilation the sources that mention the classes of those to be compiled, and so on. */
+static TrackResult addDependents( size_t* compileCount ) {
+  JstDynamicPointerArray names ;
+  TrackResult            rval = TRACK_ERROR,
+                         result ;
+  Source                 *source ;
+  size_t                 sortedCount,
+                         i ;
+  jboolean               added ;
+
+  if ( !jst_initializeDynamicPointerArray( &names, 64 ) ) return TRACK_ERROR ;
+
+  for ( source = state.sources ; source < state.sources + state.sourceCount ; source++ ) {
+    if ( source->compile && !appendClassNames( &names, source ) ) goto end ;
+  }
+
+  do {
+    qsort( names.pointers, names.count, sizeof( void* ), compareStrings ) ;
+    sortedCount = names.count ;
+    added       = JNI_FALSE ;
+
+    for ( source = state.sources ; source < state.sources + state.sourceCount && *compileCount < state.sourceCount ; source++ ) {
+      if ( source->compile ) continue ;
+
+      if ( !source->tokens && ( result = collectSourceTokens( source ) ) != TRACK_OK ) {
+        rval = result ;
+        goto end ;
+      }
+
+      for ( i = 0 ; i < source->tokenCount ; i++ ) {
+        if ( bsearch( source->tokens + i, names.pointers, sortedCount, sizeof( void* ), compareStrings ) ) break ;
+      }
+
+      if ( i < source->tokenCount ) {
+        if ( _jst_debug ) fprintf( stderr, "debug: groovyc: %s depends on a changed source\n", source->path ) ;
+        source->compile = added = JNI_TRUE ;
+        ( *compileCount )++ ;
+        if ( !appendClassNames( &names, source ) ) goto end ;
+      }
+    }
+  } while ( added ) ;
+
+  rval = TRACK_OK ;
+
+  end:
+  jst_freeDynamicArray( &names, JNI_FALSE ) ;
+
+  return rval ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// the manifest
+
+static char* createManifestKey( const char* fullOutputDir ) {
+  return jst_arenaConcat( &state.arena, MANIFEST_KEY_PREFIX, fullOutputDir, NULL ) ;
+}
+
+/** Splits the given text into lines (in place). Returns NULL on error. */
+static char** splitLines( char* text, size_t* count ) {
+  char   **lines,
+         *s ;
+  size_t n = 0 ;
+
+  for ( s = text ; *s ; s++ ) {
+    if ( *s == '\n' ) n++ ;
+  }
+
+  if ( !( lines = jst_arenaAlloc( &state.arena, ( n + 1 ) * sizeof( char* ) ) ) ) return NULL ;
+
+  for ( *count = 0, s = text ; *s && *count < n ; s++ ) {
+    lines[ ( *count )++ ] = s ;
+    s  = strchr( s, '\n' ) ;
+    *s = '\0' ;
+  }
+  lines[ *count ] = NULL ;
+
+  return lines ;
+}
+
+/** Matches the sources in the manifest to those given. Returns TRACK_UNTRACKABLE if the manifest is not usable.
+ * @param removed set if some recorded source is not given anymore */
+static TrackResult matchRecordedSources( char* recorded, jboolean* removed ) {
+  char   **lines,
+         *hash,
+         *classNames,
+         *path ;
+  Source *source ;
+  size_t lineCount,
+         i ;
+
+  if ( !( lines = splitLines( recorded, &lineCount ) ) ) return TRACK_ERROR ;
+
+  for ( i = 0 ; i < lineCount ; i++ ) {
+    hash = lines[ i ] ;
+    if ( !( classNames = strchr( hash, '\t' ) ) || !( path = strchr( classNames + 1, '\t' ) ) ) return TRACK_UNTRACKABLE ;
+    *classNames++ = '\0' ;
+    *path++       = '\0' ;
+
+    if ( ( source = bsearch( &path, state.sources, state.sourceCount, sizeof( Source ), comparePathToSource ) ) ) {
+      source->recordedHash       = hash ;
+      source->recordedClassNames = classNames ;
+    } else {
+      *removed = JNI_TRUE ;
+    }
+  }
+
+  return TRACK_OK ;
+}
+
+/** Returns whether some of the classes a changed source declared before is not declared anymore. The classes compiled from
+ * it before would be left in the output dir, where they would be found when compiling only some of the sources. */
+static jboolean classesRemoved( void ) {
+  Source     *source ;
+  const char *name,
+             *end ;
+
+  for ( source = state.sources ; source < state.sources + state.sourceCount ; source++ ) {
+    if ( !source->compile || !source->recordedClassNames ) continue ;
+    for ( name = source->recordedClassNames ; *name ; name = *end ? end + 1 : end ) {
+      if ( !( end = strchr( name, ' ' ) ) ) end = name + strlen( name ) ;
+      if ( !containsWord( source->classNames, name, (size_t)( end - name ) ) ) return JNI_TRUE ;
+    }
+  }
+
+  return JNI_FALSE ;
+}
+
+/** Hashes everything but the classpath contents the compilation depends on. */
+static JstHash hashSettings( const JstActualParam* params, const JstJvmOptions* jvmOptions, const char* classpath,
+                             const char* startupJar, const char* groovyConfFile, const char* javaHome, jboolean* error ) {
+  JstHash hash = JST_HASH_INIT ;
+  char    *libDir,
+          *releaseFile = NULL ;
+  int     i ;
+
+  for ( ; params->param && !( params->handling & JST_TERMINATING_OR_AFTER ) ; params++ ) hash = jst_hashString( hash, params->param ) ;
+  hash = jst_hashString( hash, NULL ) ;
+
+  for ( i = 0 ; i < jvmOptions->optionsCount ; i++ ) hash = jst_hashString( hash, jvmOptions->options[ i ].optionString ) ;
+  hash = jst_hashString( hash, NULL ) ;
+
+  hash = jst_hashString( hash, classpath ) ;
+  hash = jst_hashString( hash, javaHome ) ;
+  hash = hashStamp( hash, startupJar ) ;
+  hash = hashStamp( hash, groovyConfFile ) ;
+
+  // jars added to groovy lib dir, a different jdk installed in the same place
+  if ( !( libDir = jst_arenaStrdup( &state.arena, startupJar ) ) ||
+       ( javaHome && !( releaseFile = jst_arenaCreateFileName( &state.arena, javaHome, "release", NULL ) ) ) ) {
+    *error = JNI_TRUE ;
+    return hash ;
+  }
+  if ( jst_pathToParentDir( libDir ) ) hash = hashStamp( hash, libDir ) ;
+  if ( javaHome ) hash = hashStamp( hash, releaseFile ) ;
+
+  return hash ;
+}
+
+/** Returns a copy of the given params w/ only the sources marked for compilation. */
+static JstActualParam* createCompileParams( const JstActualParam* params ) {
+  JstActualParam *compileParams ;
+  jboolean       *selected ;
+  Source         *source ;
+  int            count = 0,
+                 i, j ;
+
+  while ( params[ count ].param ) count++ ;
+
+  if ( !( selected = jst_arenaAlloc( &state.arena, count * sizeof( jboolean ) ) ) ||
+       !( compileParams = jst_malloc( ( count + 1 ) * sizeof( JstActualParam ) ) ) ) return NULL ;
+
+  memset( selected, 0, count * sizeof( jboolean ) ) ;
+  for ( source = state.sources ; source < state.sources + state.sourceCount ; source++ ) {
+    if ( source->compile ) selected[ source->paramIndex ] = JNI_TRUE ;
+  }
+
+  // + 1 for the terminating entry
+  for ( i = j = 0 ; i <= count ; i++ ) {
+    if ( i == count || !( params[ i ].handling & JST_TERMINATING_OR_AFTER ) || selected[ i ] ) compileParams[ j++ ] = params[ i ] ;
+  }
+
+  return compileParams ;
+}
+
+extern GroovycCheckResult groovycCheckSources( const JstActualParam* params, const JstJvmOptions* jvmOptions, const char* classpath,
+                                               const char* startupJar, const char* groovyConfFile, const char* javaHome,
+                                               JstActualParam** compileParams ) {
+  GroovycCheckResult rval    = GROOVYC_COMPILE_ALL ;
+  TrackResult        result  = TRACK_UNTRACKABLE ;
+  const char         *reason = NULL ;
+  char               *outputDir,
+                     *fullOutputDir = NULL,
+                     **plan  = NULL,
+                     hex[ JST_HASH_HEX_LEN ] ;
+  const JstActualParam *param ;
+  Source             *source ;
+  JstHash            fingerprint ;
+  size_t             compileCount = 0 ;
+  jboolean           error        = JNI_FALSE,
+                     removed      = JNI_FALSE ;
+
+  if ( state.active ) releaseState() ;
+
+  if ( !jst_cachingEnabled() ) return GROOVYC_COMPILE_ALL ;
+
+  if ( !( outputDir = jst_getParameterValue( params, "-d" ) ) ) {
+    reason = "no output dir given" ;
+    goto end ;
+  }
+
+  if ( jst_getParameterValue( params, "-v" ) ) {
+    reason = "not compiling" ;
+    goto end ;
+  }
+
+  for ( param = params ; param->param ; param++ ) {
+    if ( param->handling & JST_TERMINATING_OR_AFTER ) state.sourceCount++ ;
+  }
+
+  if ( !state.sourceCount ) {
+    reason = "no sources given" ;
+    goto end ;
+  }
+
+  // the params are freed before the compiler is run
+  if ( !( state.outputDir = jst_arenaStrdup( &state.arena, outputDir ) ) ||
+       !( state.sources   = jst_arenaAlloc( &state.arena, state.sourceCount * sizeof( Source ) ) ) ) goto error ;
+  memset( state.sources, 0, state.sourceCount * sizeof( Source ) ) ;
+
+  for ( source = state.sources, param = params ; param->param ; param++ ) {
+    char* path ;
+
+    if ( !( param->handling & JST_TERMINATING_OR_AFTER ) ) continue ;
+
+    // options after the sources (or -h), arg files, dirs
+    if ( *param->param == '-' || *param->param == '@' || !hasSuffix( param->param, sourceSuffixes ) ||
+         !jst_fileExists( param->param ) || jst_isDir( param->param ) ) {
+      reason = "not all the args are source files" ;
+      goto end ;
+    }
+
+    if ( !( path = jst_fullPathName( param->param ) ) ) goto end ;
+    if ( ( path == param->param ) ? !( path = jst_arenaStrdup( &state.arena, path ) ) : !jst_arenaAdopt( &state.arena, path ) ) goto error ;
+    if ( strpbrk( path, "\t\n" ) ) {
+      reason = "the path of a source contains a tab or a line feed" ;
+      goto end ;
+    }
+
+    source->path       = path ;
+    source->paramIndex = (int)( param - params ) ;
+    source++ ;
+  }
+
+  qsort( state.sources, state.sourceCount, sizeof( Source ), compareSources ) ;
+  for ( source = state.sources + 1 ; source < state.sources + state.sourceCount ; source++ ) {
+    if ( strcmp( source->path, source[ -1 ].path ) == 0 ) {
+      reason = "a source is given twice" ;
+      goto end ;
+    }
+  }
+
+  if ( !( state.classpath = jst_arenaStrdup( &state.arena, classpath ) ) ) goto error ;
+  state.settingsHash = hashSettings( params, jvmOptions, classpath, startupJar, groovyConfFile, javaHome, &error ) ;
+  if ( error ) goto error ;
+
+  // the time is taken before looking at the sources so that nothing written by the compiler is older
+  state.compileStarted = ( (jlong)time( NULL ) - 1 ) * 1000000000 ;
+
+  if ( jst_fileExists( state.outputDir ) ) {
+    if ( !( fullOutputDir = jst_fullPathName( state.outputDir ) ) ) goto end ;
+    if ( fullOutputDir != state.outputDir && !jst_arenaAdopt( &state.arena, fullOutputDir ) ) goto error ;
+    if ( !( plan = jst_loadLaunchPlan( createManifestKey( fullOutputDir ), MANIFEST_ENTRY_COUNT ) ) ||
+         !jst_arenaAdopt( &state.arena, plan ) ) {
+      plan = NULL ;
+    }
+  }
+
+  if ( plan && ( result = matchRecordedSources( plan[ MANIFEST_SOURCES ], &removed ) ) != TRACK_OK ) {
+    if ( result == TRACK_ERROR ) goto error ;
+    plan = NULL ;
+  }
+
+  for ( source = state.sources ; source < state.sources + state.sourceCount ; source++ ) {
+    if ( ( result = hashSource( source ) ) != TRACK_OK ) {
+      if ( result == TRACK_ERROR ) goto error ;
+      reason = "a source could not be read" ;
+      goto end ;
+    }
+    if ( source->compile ) compileCount++ ;
+  }
+
+  fingerprint = state.settingsHash ;
+  if ( ( result = hashClasspath( classpath, fullOutputDir ? fullOutputDir : state.outputDir, &fingerprint ) ) != TRACK_OK ) {
+    if ( result == TRACK_ERROR ) goto error ;
+    reason = "the classpath can not be tracked" ;
+    goto end ;
+  }
+
+  state.active = JNI_TRUE ;
+
+  if ( !plan ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: groovyc: no manifest for %s, compiling everything\n", state.outputDir ) ;
+    goto end ;
+  }
+
+  if ( !( state.recordedOutputs = splitLines( plan[ MANIFEST_OUTPUTS ], &state.recordedOutputCount ) ) ) goto error ;
+
+  if ( strcmp( jst_hashToHex( fingerprint, hex ), plan[ MANIFEST_FINGERPRINT ] ) != 0 ) {
+    reason = "the flags, the classpath or the groovy or java installation has changed" ;
+  } else if ( strcmp( jst_hashToHex( hashOutputs( state.recordedOutputs, state.recordedOutputCount ), hex ), plan[ MANIFEST_OUTPUTS_STAMP ] ) != 0 ) {
+    reason = "the outputs have been modified" ;
+  } else if ( removed ) {
+    reason = "a source has been removed" ;
+  } else if ( !compileCount ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: groovyc: the outputs in %s are up to date\n", state.outputDir ) ;
+    releaseState() ;
+    return GROOVYC_UP_TO_DATE ;
+  } else if ( jst_getParameterValue( params, "-j" ) ) {
+    reason = "joint compilation" ;
+  } else if ( classesRemoved() ) {
+    reason = "a class has been removed" ;
+  }
+
+  if ( reason ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: groovyc: compiling everything, %s\n", reason ) ;
+    reason = NULL ;
+    goto end ;
+  }
+
+  if ( ( result = addDependents( &compileCount ) ) != TRACK_OK ) {
+    if ( result == TRACK_ERROR ) goto error ;
+    if ( _jst_debug ) fprintf( stderr, "debug: groovyc: compiling everything, a source could not be read\n" ) ;
+    goto end ;
+  }
+
+  if ( compileCount < state.sourceCount ) {
+    if ( !( *compileParams = createCompileParams( params ) ) ) goto error ;
+    if ( _jst_debug ) fprintf( stderr, "debug: groovyc: compiling %d of %d sources\n", (int)compileCount, (int)state.sourceCount ) ;
+    rval = GROOVYC_COMPILE_CHANGED ;
+  }
+
+  end:
+  if ( reason && _jst_debug ) fprintf( stderr, "debug: groovyc: not tracking the sources, %s\n", reason ) ;
+  if ( !state.active ) releaseState() ;
+
+  return rval ;
+
+  error:
+  releaseState() ;
+  return GROOVYC_ERROR ;
+}
+
+extern void groovycRecordCompile( int exitCode ) {
+  Walk             walk ;
+  JstStringBuilder sources = JST_STRING_BUILDER_INITIALIZER,
+                   outputs = JST_STRING_BUILDER_INITIALIZER ;
+  char             *fullOutputDir,
+                   *key,
+                   fingerprintHex[ JST_HASH_HEX_LEN ],
+                   outputsHex[ JST_HASH_HEX_LEN ],
+                   *entries[ MANIFEST_ENTRY_COUNT + 1 ],
+                   *noStamps[] = { NULL } ;
+  Source           *source ;
+  JstHash          fingerprint ;
+  size_t           i ;
+
+  memset( &walk, 0, sizeof( walk ) ) ;
+
+  if ( !state.active || exitCode != 0 ) goto end ;
+
+  if ( !jst_fileExists( state.outputDir ) || !( fullOutputDir = jst_fullPathName( state.outputDir ) ) ||
+       ( fullOutputDir != state.outputDir && !jst_arenaAdopt( &state.arena, fullOutputDir ) ) ||
+       !( key = createManifestKey( fullOutputDir ) ) ) goto end ;
+
+  if ( state.recordedOutputCount ) qsort( state.recordedOutputs, state.recordedOutputCount, sizeof( char* ), compareStrings ) ;
+
+  walk.visitFile = collectOutput ;
+  if ( !jst_initializeDynamicPointerArray( &walk.files, 64 ) || walkDir( &walk, fullOutputDir, 0, JNI_FALSE ) != TRACK_OK ) goto end ;
+  qsort( walk.files.pointers, walk.files.count, sizeof( void* ), compareStrings ) ;
+
+  for ( i = 0 ; i < walk.files.count ; i++ ) {
+    if ( strchr( (char*)walk.files.pointers[ i ], '\n' ) ) goto end ;
+    if ( !jst_appendToStringBuilder( &outputs, (char*)walk.files.pointers[ i ], "\n", NULL ) ) goto end ;
+  }
+
+  for ( source = state.sources ; source < state.sources + state.sourceCount ; source++ ) {
+    if ( !jst_appendToStringBuilder( &sources, source->hash, "\t", source->compile ? source->classNames : source->recordedClassNames,
+                                     "\t", source->path, "\n", NULL ) ) goto end ;
+  }
+
+  // the classpath may have changed while compiling (the output dir is not looked into)
+  fingerprint = state.settingsHash ;
+  if ( hashClasspath( state.classpath, fullOutputDir, &fingerprint ) != TRACK_OK ) goto end ;
+
+  entries[ MANIFEST_FINGERPRINT   ] = jst_hashToHex( fingerprint, fingerprintHex ) ;
+  entries[ MANIFEST_SOURCES       ] = sources.chars ;
+  entries[ MANIFEST_OUTPUTS_STAMP ] = jst_hashToHex( hashOutputs( (char**)walk.files.pointers, walk.files.count ), outputsHex ) ;
+  entries[ MANIFEST_OUTPUTS       ] = outputs.chars ? outputs.chars : "" ;
+  entries[ MANIFEST_ENTRY_COUNT   ] = NULL ;
+
+  jst_storeLaunchPlan( key, entries, noStamps ) ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: groovyc: recorded %d sources and %d outputs\n", (int)state.sourceCount, (int)walk.files.count ) ;
+
+  end:
+  if ( walk.files.pointers ) jst_freeDynamicArray( &walk.files, JNI_FALSE ) ;
+  if ( sources.chars ) jst_freeStringBuilder( &sources ) ;
+  if ( outputs.chars ) jst_freeStringBuilder( &outputs ) ;
+
+  releaseState() ;
+}
@@ -0,0 +1,61 @@
+//  Groovy -- A native launcher for Groovy
+//
+//  Copyright (c) 2010 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License") ; you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Incremental groovyc. Builds run groovyc mostly on sources that have not changed since the previous build, so a manifest is
+// kept for each output dir (given w/ -d): the content hashes of the sources compiled into it, a fingerprint of everything
+// else the compilation depends on (the compiler flags, the classpath and the jars in it, the groovy and java installations)
+// and the modification times of the classes written.
+//
+// If nothing has changed since, the compiler is not run at all. If some of the sources have changed, only those are compiled,
+// along w/ the sources that depend on them, w/ the output dir on the classpath for the classes of the rest. A source is taken
+// to depend on another if it mentions (as a word anywhere in its text, so this errs on the side of compiling too much) a class
+// the other one declares now or did on the previous compilation, and so on transitively. Everything is compiled if a source
+// has been removed or for joint compilation (-j), where java constants may have been inlined.
+//
+// The jars and the classes, sources and META-INF files in the dirs on the classpath are tracked by their modification times,
+// the sources being compiled and the output dir excepted. Dirs whose names start w/ a dot are not looked into, they can not
+// contain packages. The sources are only tracked if they are all given as files after the flags and an output dir is given.
+
+#ifndef GROOVYCMANIFEST_H_
+#  define GROOVYCMANIFEST_H_
+
+#include "jvmstarter.h"
+
+typedef enum {
+  /** The sources are to be compiled as given. */
+  GROOVYC_COMPILE_ALL,
+  /** Only some of the sources are to be compiled. */
+  GROOVYC_COMPILE_CHANGED,
+  /** The outputs are up to date, there is no need to run the compiler. */
+  GROOVYC_UP_TO_DATE,
+  GROOVYC_ERROR
+} GroovycCheckResult ;
+
+/** Checks the sources given to groovyc against the manifest of the output dir.
+ * @param jvmOptions the options given to the jvm in addition to those in params, e.g. from JAVA_OPTS
+ * @param classpath the classpath the compiler is given
+ * @param compileParams on GROOVYC_COMPILE_CHANGED set to a copy of the given params w/ only the sources to compile. Freeing it
+ *        is up to the caller. The output dir is to be appended to the classpath.
+ * @return GROOVYC_ERROR on error (err msg printed) */
+GroovycCheckResult groovycCheckSources( const JstActualParam* params, const JstJvmOptions* jvmOptions, const char* classpath,
+                                        const char* startupJar, const char* groovyConfFile, const char* javaHome,
+                                        JstActualParam** compileParams ) ;
+
+/** Updates the manifest after the compiler has run. Does nothing if it failed or the sources were not checked w/
+ * groovycCheckSources (i.e. they could not be tracked). */
+void groovycRecordCompile( int exitCode ) ;
+
+#endif /* GROOVYCMANIFEST_H_ */
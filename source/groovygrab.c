@@ -0,0 +1,527 @@
+//  Groovy -- A native launcher for Groovy
+//
+//  Copyright (c) 2010 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License") ; you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <jni.h>
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_cache.h"
+#include "jst_stringutils.h"
+#include "jniutils.h"
+#include "groovygrab.h"
+
+/** The canonical form of the grabs of a script (see scanGrabs) follows this in the launch plan key the jars are stored under. */
+#define GRAB_KEY_PREFIX "jst-grabs-1\n"
+
+/** Longer annotation args are not cached. */
+#define MAX_ARG_LEN 512
+
+/** The launch plan key of the grabs of the script being run, if their jars were not recorded. */
+static char* missKey = NULL ;
+
+typedef struct {
+  const char* pos ;
+  const char* end ;
+} Scanner ;
+
+/** The args each annotation may have. The ones given as true / false are passed to Grape as booleans. */
+static const char* grabArgs[]         = { "group", "module", "version", "classifier", "ext", "type", "conf", "transitive", "initClass", NULL } ;
+static const char* grabResolverArgs[] = { "name", "root", "m2Compatible", NULL } ;
+
+static void skipSpace( Scanner* sc ) {
+  while ( sc->pos < sc->end && isspace( (unsigned char)*sc->pos ) ) sc->pos++ ;
+}
+
+static jboolean isIdentifierChar( char c ) {
+  return ( isalnum( (unsigned char)c ) || c == '_' || c == '$' ) ? JNI_TRUE : JNI_FALSE ;
+}
+
+/** Reads a (qualified, if so requested) identifier. Returns its length, 0 if there is none. */
+static size_t readIdentifier( Scanner* sc, jboolean qualified ) {
+  const char* start = sc->pos ;
+
+  while ( sc->pos < sc->end && ( isIdentifierChar( *sc->pos ) || ( qualified && *sc->pos == '.' ) ) ) sc->pos++ ;
+
+  return (size_t)( sc->pos - start ) ;
+}
+
+static jboolean isToken( const char* s, size_t len, const char* token ) {
+  return ( len == strlen( token ) && memcmp( s, token, len ) == 0 ) ? JNI_TRUE : JNI_FALSE ;
+}
+
+/** Reads a literal: true, false or a non empty single line string w/out escapes or interpolation. Copies it to the given
+ * buffer (of MAX_ARG_LEN + 1 chars). Returns false if there is no such literal, or it contains chars that can not be cached. */
+static jboolean readLiteral( Scanner* sc, char* value ) {
+  const char* start ;
+  size_t      len ;
+  char        quote ;
+
+  skipSpace( sc ) ;
+  if ( sc->pos >= sc->end ) return JNI_FALSE ;
+
+  quote = *sc->pos ;
+  if ( quote != '\'' && quote != '"' ) {
+    start = sc->pos ;
+    len   = readIdentifier( sc, JNI_FALSE ) ;
+    if ( !isToken( start, len, "true" ) && !isToken( start, len, "false" ) ) return JNI_FALSE ;
+  } else {
+    start = ++sc->pos ;
+    // the canonical form is space separated, and plain coordinates and urls do not need anything else
+    while ( sc->pos < sc->end && *sc->pos != quote ) {
+      if ( *sc->pos <= ' ' || *sc->pos > '~' || *sc->pos == '\\' || *sc->pos == '$' ) return JNI_FALSE ;
+      sc->pos++ ;
+    }
+    if ( sc->pos >= sc->end ) return JNI_FALSE ;
+    len = (size_t)( sc->pos++ - start ) ;
+  }
+
+  if ( !len || len > MAX_ARG_LEN ) return JNI_FALSE ;
+
+  memcpy( value, start, len ) ;
+  value[ len ] = '\0' ;
+  return JNI_TRUE ;
+}
+
+/** Whether the given version may resolve to different jars over time. */
+static jboolean isDynamicVersion( const char* version ) {
+  return ( strpbrk( version, "[]()*+," ) || strncmp( version, "latest.", 7 ) == 0 || jst_endsWith( version, "SNAPSHOT" ) ) ? JNI_TRUE : JNI_FALSE ;
+}
+
+/** Appends the given arg to the canonical form. Returns 0 on error, in which case the builder has been freed. */
+static int appendArg( JstStringBuilder* grabs, const char* name, const char* value ) {
+  return jst_appendToStringBuilder( grabs, " ", name, "=", value, NULL ) ? 1 : 0 ;
+}
+
+/** Appends the args of a grab given as a single "group:module:version[:classifier]" string. */
+static jboolean appendCoordinates( JstStringBuilder* grabs, char* coordinates, char** version, jboolean* error ) {
+  char *parts[ 4 ],
+       *colon ;
+  int  count = 0,
+       i ;
+
+  for ( parts[ count++ ] = coordinates ; ( colon = strchr( parts[ count - 1 ], ':' ) ) ; parts[ count++ ] = colon + 1 ) {
+    if ( count == 4 ) return JNI_FALSE ;
+    *colon = '\0' ;
+  }
+  if ( count < 3 ) return JNI_FALSE ;
+
+  for ( i = 0 ; i < count ; i++ ) {
+    if ( !*parts[ i ] ) return JNI_FALSE ;
+    if ( !appendArg( grabs, grabArgs[ i ], parts[ i ] ) ) {
+      *error = JNI_TRUE ;
+      return JNI_FALSE ;
+    }
+  }
+
+  *version = parts[ 2 ] ;
+  return JNI_TRUE ;
+}
+
+/** Parses the args of a @Grab or @GrabResolver, the scanner being just after the annotation name, and appends them to the
+ * given canonical form as a line "<annotation> name=value...".
+ * Returns false if the args can not be cached, or on error (*error set, err msg printed). */
+static jboolean parseAnnotationArgs( Scanner* sc, const char* annotation, JstStringBuilder* grabs, jboolean* error ) {
+  jboolean    isGrab    = ( strcmp( annotation, "Grab" ) == 0 ) ? JNI_TRUE : JNI_FALSE,
+              hasModule = JNI_FALSE ;
+  const char* name ;
+  size_t      nameLen ;
+  char        value[ MAX_ARG_LEN + 1 ],
+              version[ MAX_ARG_LEN + 1 ] ;
+  char*       coordinatesVersion = NULL ;
+
+  *version = '\0' ;
+
+  skipSpace( sc ) ;
+  if ( sc->pos >= sc->end || *sc->pos++ != '(' ) return JNI_FALSE ;
+
+  if ( !jst_appendToStringBuilder( grabs, annotation, NULL ) ) {
+    *error = JNI_TRUE ;
+    return JNI_FALSE ;
+  }
+
+  for ( ;; ) {
+    skipSpace( sc ) ;
+    if ( sc->pos < sc->end && ( *sc->pos == '\'' || *sc->pos == '"' ) ) {
+      name    = "value" ;
+      nameLen = 5 ;
+    } else {
+      name    = sc->pos ;
+      nameLen = readIdentifier( sc, JNI_FALSE ) ;
+      skipSpace( sc ) ;
+      if ( !nameLen || sc->pos >= sc->end || *sc->pos++ != '=' ) return JNI_FALSE ;
+    }
+
+    if ( !readLiteral( sc, value ) ) return JNI_FALSE ;
+
+    if ( isToken( name, nameLen, "value" ) ) {
+      if ( isGrab ) {
+        if ( !appendCoordinates( grabs, value, &coordinatesVersion, error ) ) return JNI_FALSE ;
+        strcpy( version, coordinatesVersion ) ;
+        hasModule = JNI_TRUE ;
+      } else if ( !appendArg( grabs, "root", value ) ) {
+        *error = JNI_TRUE ;
+        return JNI_FALSE ;
+      }
+    } else {
+      const char** argName ;
+
+      for ( argName = isGrab ? grabArgs : grabResolverArgs ; *argName && !isToken( name, nameLen, *argName ) ; argName++ ) ;
+      if ( !*argName ) return JNI_FALSE ;
+
+      if ( strcmp( *argName, "module"  ) == 0 ) hasModule = JNI_TRUE ;
+      if ( strcmp( *argName, "version" ) == 0 ) strcpy( version, value ) ;
+
+      // whether Grape adds code initializing the grabs to the class does not affect the jars
+      if ( strcmp( *argName, "initClass" ) != 0 && !appendArg( grabs, *argName, value ) ) {
+        *error = JNI_TRUE ;
+        return JNI_FALSE ;
+      }
+    }
+
+    skipSpace( sc ) ;
+    if ( sc->pos >= sc->end ) return JNI_FALSE ;
+    if ( *sc->pos == ')' ) break ;
+    if ( *sc->pos++ != ',' ) return JNI_FALSE ;
+  }
+
+  if ( isGrab && ( !hasModule || !*version || isDynamicVersion( version ) ) ) return JNI_FALSE ;
+
+  if ( !jst_appendToStringBuilder( grabs, "\n", NULL ) ) {
+    *error = JNI_TRUE ;
+    return JNI_FALSE ;
+  }
+
+  return JNI_TRUE ;
+}
+
+/** Returns the position of the given text in the given data, NULL if it is not there. */
+static const char* findText( const char* data, const char* end, const char* text ) {
+  size_t len = strlen( text ) ;
+
+  for ( ; ( data = memchr( data, *text, (size_t)( end - data ) ) ) && (size_t)( end - data ) >= len ; data++ ) {
+    if ( memcmp( data, text, len ) == 0 ) return data ;
+  }
+
+  return NULL ;
+}
+
+/** Whether the script uses Grape in ways scanning the annotations does not cover, i.e. calls it directly or imports
+ * the annotations w/ another name. */
+static jboolean usesGrapeOtherwise( const char* data, const char* end ) {
+  Scanner sc ;
+
+  if ( findText( data, end, "Grape." ) ) return JNI_TRUE ;
+
+  for ( sc.end = end, sc.pos = data ; ( sc.pos = findText( sc.pos, end, "groovy.lang.Gra" ) ) ; ) {
+    readIdentifier( &sc, JNI_TRUE ) ;
+    while ( sc.pos < end && ( *sc.pos == ' ' || *sc.pos == '\t' ) ) sc.pos++ ;
+    if ( end - sc.pos > 2 && sc.pos[ 0 ] == 'a' && sc.pos[ 1 ] == 's' && isspace( (unsigned char)sc.pos[ 2 ] ) ) return JNI_TRUE ;
+  }
+
+  return JNI_FALSE ;
+}
+
+/** Scans the grab annotations from the given script. Returns their canonical form, one line per annotation, NULL if
+ * there are none, they can not be cached (reason in debug output) or on error (*error set, err msg printed).
+ * The whole script is scanned, as a grab missed here would be missing from the classpath, and comments and strings are
+ * not skipped, which errs on the side of not caching. */
+static char* scanGrabs( const char* data, size_t size, jboolean* error ) {
+  JstStringBuilder grabs = JST_STRING_BUILDER_INITIALIZER ;
+  Scanner          sc ;
+  const char       *name,
+                   *simpleName ;
+  size_t           len ;
+  char             annotation[ 16 ] ;
+
+  sc.pos = data ;
+  sc.end = data + size ;
+
+  while ( sc.pos < sc.end && ( sc.pos = memchr( sc.pos, '@', (size_t)( sc.end - sc.pos ) ) ) ) {
+    name = ++sc.pos ;
+    len  = readIdentifier( &sc, JNI_TRUE ) ;
+
+    for ( simpleName = name + len ; simpleName > name && simpleName[ -1 ] != '.' ; simpleName-- ) ;
+    len -= (size_t)( simpleName - name ) ;
+
+    if ( isToken( simpleName, len, "Grab" ) || isToken( simpleName, len, "GrabResolver" ) ) {
+      memcpy( annotation, simpleName, len ) ;
+      annotation[ len ] = '\0' ;
+      if ( !parseAnnotationArgs( &sc, annotation, &grabs, error ) ) {
+        if ( _jst_debug && !*error ) fprintf( stderr, "debug: not caching the grabs, could not read the @%s at offset %d\n", annotation, (int)( name - data ) ) ;
+        goto fail ;
+      }
+    } else if ( isToken( simpleName, len, "GrabConfig" ) || isToken( simpleName, len, "GrabExclude" ) ) {
+      if ( _jst_debug ) fprintf( stderr, "debug: not caching the grabs, the script uses @%.*s\n", (int)len, simpleName ) ;
+      goto fail ;
+    }
+  }
+
+  if ( grabs.chars && usesGrapeOtherwise( data, sc.end ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not caching the grabs, the script uses Grape directly\n" ) ;
+    goto fail ;
+  }
+
+  return grabs.chars ;
+
+  fail:
+  jst_freeStringBuilder( &grabs ) ;
+  return NULL ;
+}
+
+extern char* groovyGrabbedJars( const char* scriptFile, jboolean* error ) {
+  JstMappedFile script ;
+  char          *grabs,
+                *key,
+                **plan,
+                *classpath = NULL ;
+
+  if ( !jst_mapFile( scriptFile, &script ) ) return NULL ;
+
+  grabs = scanGrabs( script.data, script.size, error ) ;
+  jst_unmapFile( &script ) ;
+  if ( !grabs ) return NULL ;
+
+  key = jst_append( NULL, NULL, GRAB_KEY_PREFIX, grabs, NULL ) ;
+  free( grabs ) ;
+  if ( !key ) {
+    *error = JNI_TRUE ;
+    return NULL ;
+  }
+
+  if ( ( plan = jst_loadLaunchPlan( key, 1 ) ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: using the jars recorded for the grabs: %s\n", plan[ 0 ] ) ;
+    if ( !( classpath = jst_strdup( plan[ 0 ] ) ) ) *error = JNI_TRUE ;
+    free( plan ) ;
+    free( key ) ;
+  } else {
+    if ( _jst_debug ) fprintf( stderr, "debug: no jars recorded for the grabs, resolving them w/ Grape\n" ) ;
+    missKey = key ;
+  }
+
+  return classpath ;
+}
+
+typedef struct {
+  jclass    hashMapClass,
+            booleanClass ;
+  jmethodID hashMapConstructor,
+            putMethod,
+            booleanValueOfMethod ;
+} MapRefs ;
+
+/** Puts the given arg into the given map, true / false as a Boolean and anything else as a String. Returns false on error. */
+static jboolean putArg( JNIEnv* env, const MapRefs* refs, jobject map, const char* name, const char* value ) {
+  jstring jname  = (*env)->NewStringUTF( env, name ) ;
+  jobject jvalue = NULL ;
+
+  if ( !jname ) return JNI_FALSE ;
+
+  if ( strcmp( value, "true" ) == 0 || strcmp( value, "false" ) == 0 ) {
+    jvalue = (*env)->CallStaticObjectMethod( env, refs->booleanClass, refs->booleanValueOfMethod, ( *value == 't' ) ? JNI_TRUE : JNI_FALSE ) ;
+  } else {
+    jvalue = (*env)->NewStringUTF( env, value ) ;
+  }
+  if ( !jvalue ) return JNI_FALSE ;
+
+  (*env)->CallObjectMethod( env, map, refs->putMethod, jname, jvalue ) ;
+  (*env)->DeleteLocalRef( env, jname ) ;
+  (*env)->DeleteLocalRef( env, jvalue ) ;
+
+  return (*env)->ExceptionCheck( env ) ? JNI_FALSE : JNI_TRUE ;
+}
+
+/** Creates a map of the space separated name=value args in the given string, which is modified. Returns NULL on error. */
+static jobject createArgMap( JNIEnv* env, const MapRefs* refs, char* args ) {
+  jobject map = (*env)->NewObject( env, refs->hashMapClass, refs->hashMapConstructor ) ;
+  char    *arg,
+          *next,
+          *value ;
+
+  for ( arg = args ; map && arg ; arg = next ) {
+    if ( ( next = strchr( arg, ' ' ) ) ) *next++ = '\0' ;
+    if ( !*arg ) continue ;
+    if ( !( value = strchr( arg, '=' ) ) ) return NULL ;
+    *value++ = '\0' ;
+    if ( !putArg( env, refs, map, arg, value ) ) return NULL ;
+  }
+
+  return map ;
+}
+
+/** Returns the path of the given file uri as a string in the platform encoding, NULL on error. Freeing is up to the caller. */
+static char* getUriPath( JNIEnv* env, jobject uri, jclass fileClass, jmethodID fileConstructor, jmethodID getPathMethod, jmethodID getBytesMethod ) {
+  jobject    file  = NULL ;
+  jstring    path  = NULL ;
+  jbyteArray bytes = NULL ;
+  jsize      len ;
+  char*      rval  = NULL ;
+
+  if ( ( file  = (*env)->NewObject( env, fileClass, fileConstructor, uri ) ) &&
+       ( path  = (*env)->CallObjectMethod( env, file, getPathMethod ) ) &&
+       ( bytes = (*env)->CallObjectMethod( env, path, getBytesMethod ) ) ) {
+    len = (*env)->GetArrayLength( env, bytes ) ;
+    if ( ( rval = jst_malloc( (size_t)len + 1 ) ) ) {
+      (*env)->GetByteArrayRegion( env, bytes, 0, len, (jbyte*)rval ) ;
+      rval[ len ] = '\0' ;
+    }
+  }
+
+  if ( file  ) (*env)->DeleteLocalRef( env, file ) ;
+  if ( path  ) (*env)->DeleteLocalRef( env, path ) ;
+  if ( bytes ) (*env)->DeleteLocalRef( env, bytes ) ;
+
+  return rval ;
+}
+
+extern void groovyRecordGrabs( JNIEnv* env ) {
+  JstStringBuilder classpath = JST_STRING_BUILDER_INITIALIZER ;
+  MapRefs      refs ;
+  jclass       grapeClass,
+               mapClass,
+               threadClass,
+               fileClass,
+               stringClass ;
+  jmethodID    addResolverMethod,
+               resolveMethod,
+               currentThreadMethod,
+               getLoaderMethod,
+               fileConstructor,
+               getPathMethod,
+               getBytesMethod ;
+  jobject      thread,
+               loader,
+               args,
+               map ;
+  jobjectArray deps,
+               uris ;
+  jstring      classLoaderName ;
+  char         *grabs   = NULL,
+               *entries[ 2 ],
+               *line,
+               *next,
+               *jar ;
+  JstDynamicPointerArray jars ;
+  jint         grabCount = 0,
+               i ;
+  jboolean     recorded = JNI_FALSE ;
+
+  if ( !missKey ) return ;
+
+  memset( &jars, 0, sizeof( jars ) ) ;
+
+  if ( (*env)->PushLocalFrame( env, 64 ) ) {
+    clearException( env ) ;
+    goto end ;
+  }
+
+  if ( !( grabs = jst_strdup( missKey + strlen( GRAB_KEY_PREFIX ) ) ) ) goto popframe ;
+
+  for ( line = grabs ; ( line = strstr( line, "Grab " ) ) ; line++ ) {
+    if ( line == grabs || line[ -1 ] == '\n' ) grabCount++ ;
+  }
+
+  if ( !( grapeClass                 = (*env)->FindClass( env, "groovy/grape/Grape" ) ) ||
+       !( mapClass                   = (*env)->FindClass( env, "java/util/Map" ) ) ||
+       !( refs.hashMapClass          = (*env)->FindClass( env, "java/util/HashMap" ) ) ||
+       !( refs.booleanClass          = (*env)->FindClass( env, "java/lang/Boolean" ) ) ||
+       !( threadClass                = (*env)->FindClass( env, "java/lang/Thread" ) ) ||
+       !( fileClass                  = (*env)->FindClass( env, "java/io/File" ) ) ||
+       !( stringClass                = (*env)->FindClass( env, "java/lang/String" ) ) ||
+       !( refs.hashMapConstructor    = (*env)->GetMethodID( env, refs.hashMapClass, "<init>", "()V" ) ) ||
+       !( refs.putMethod             = (*env)->GetMethodID( env, refs.hashMapClass, "put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;" ) ) ||
+       !( refs.booleanValueOfMethod  = (*env)->GetStaticMethodID( env, refs.booleanClass, "valueOf", "(Z)Ljava/lang/Boolean;" ) ) ||
+       !( addResolverMethod          = (*env)->GetStaticMethodID( env, grapeClass, "addResolver", "(Ljava/util/Map;)V" ) ) ||
+       !( resolveMethod              = (*env)->GetStaticMethodID( env, grapeClass, "resolve", "(Ljava/util/Map;[Ljava/util/Map;)[Ljava/net/URI;" ) ) ||
+       !( currentThreadMethod        = (*env)->GetStaticMethodID( env, threadClass, "currentThread", "()Ljava/lang/Thread;" ) ) ||
+       !( getLoaderMethod            = (*env)->GetMethodID( env, threadClass, "getContextClassLoader", "()Ljava/lang/ClassLoader;" ) ) ||
+       !( fileConstructor            = (*env)->GetMethodID( env, fileClass, "<init>", "(Ljava/net/URI;)V" ) ) ||
+       !( getPathMethod              = (*env)->GetMethodID( env, fileClass, "getPath", "()Ljava/lang/String;" ) ) ||
+       !( getBytesMethod             = (*env)->GetMethodID( env, stringClass, "getBytes", "()[B" ) ) ||
+       !( deps                       = (*env)->NewObjectArray( env, grabCount, mapClass, NULL ) ) ) goto popframe ;
+
+  // the resolvers are added first, as the script does
+  for ( i = 0, line = grabs ; line && *line ; line = next ) {
+    char* argsStart = strchr( line, ' ' ) ;
+
+    if ( ( next = strchr( line, '\n' ) ) ) *next++ = '\0' ;
+    if ( !argsStart || !( map = createArgMap( env, &refs, argsStart + 1 ) ) ) goto popframe ;
+
+    if ( strncmp( line, "GrabResolver ", 13 ) == 0 ) {
+      (*env)->CallStaticVoidMethod( env, grapeClass, addResolverMethod, map ) ;
+    } else {
+      (*env)->SetObjectArrayElement( env, deps, i++, map ) ;
+    }
+    if ( (*env)->ExceptionCheck( env ) ) goto popframe ;
+    (*env)->DeleteLocalRef( env, map ) ;
+  }
+
+  // Grape needs a class loader it could add the jars to, even though resolving does not add them. GroovyStarter has set
+  // its RootLoader as the context class loader
+  if ( !( thread          = (*env)->CallStaticObjectMethod( env, threadClass, currentThreadMethod ) ) ||
+       !( loader          = (*env)->CallObjectMethod( env, thread, getLoaderMethod ) ) ||
+       !( args            = (*env)->NewObject( env, refs.hashMapClass, refs.hashMapConstructor ) ) ||
+       !( classLoaderName = (*env)->NewStringUTF( env, "classLoader" ) ) ) goto popframe ;
+  (*env)->CallObjectMethod( env, args, refs.putMethod, classLoaderName, loader ) ;
+  if ( (*env)->ExceptionCheck( env ) ) goto popframe ;
+
+  if ( !( uris = (*env)->CallStaticObjectMethod( env, grapeClass, resolveMethod, args, deps ) ) ||
+       !jst_initializeDynamicPointerArray( &jars, (size_t)(*env)->GetArrayLength( env, uris ) + 1 ) ) goto popframe ;
+
+  for ( i = 0 ; i < (*env)->GetArrayLength( env, uris ) ; i++ ) {
+    jobject uri = (*env)->GetObjectArrayElement( env, uris, i ) ;
+
+    if ( !uri ) goto popframe ;
+    jar = getUriPath( env, uri, fileClass, fileConstructor, getPathMethod, getBytesMethod ) ;
+    (*env)->DeleteLocalRef( env, uri ) ;
+
+    if ( !jar ) goto popframe ;
+    if ( !jst_appendPointerToDynamicArray( &jars, jar ) ) {
+      free( jar ) ;
+      goto popframe ;
+    }
+    if ( !jst_appendToStringBuilder( &classpath, i ? JST_PATH_SEPARATOR : "", jar, NULL ) ) goto popframe ;
+  }
+
+  if ( classpath.chars ) {
+    entries[ 0 ] = classpath.chars ;
+    entries[ 1 ] = NULL ;
+    // the jars are the stamps, so the recorded classpath is not used if any of them changes
+    recorded = jst_storeLaunchPlan( missKey, entries, (char**)jars.pointers ) ? JNI_TRUE : JNI_FALSE ;
+  }
+
+  popframe:
+  if ( (*env)->ExceptionCheck( env ) ) clearException( env ) ;
+  (*env)->PopLocalFrame( env, NULL ) ;
+
+  end:
+  if ( _jst_debug ) {
+    if ( recorded ) {
+      fprintf( stderr, "debug: recorded the jars of the grabs: %s\n", classpath.chars ) ;
+    } else {
+      fprintf( stderr, "debug: could not record the jars of the grabs\n" ) ;
+    }
+  }
+
+  jst_freeStringBuilder( &classpath ) ;
+  jst_freeDynamicArray( &jars, JNI_TRUE ) ;
+  if ( grabs ) free( grabs ) ;
+  jst_free( missKey ) ;
+}
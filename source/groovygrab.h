@@ -0,0 +1,47 @@
+//  Groovy -- A native launcher for Groovy
+//
+//  Copyright (c) 2010 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License") ; you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Caching the jars @Grab resolves. Grape (i.e. ivy) takes seconds to resolve the grabs of a script on every run, even when
+// everything is already in the grape cache. So the @Grab and @GrabResolver annotations are scanned from the script here and,
+// if the jars they resolve to were recorded on an earlier run, those are put on the classpath and Grape is disabled for the
+// run, which makes the annotations no-ops. Otherwise Grape resolves them as usual and the resulting jars are recorded after
+// the script has run.
+//
+// Only grabs that always resolve to the same jars are cached, i.e. fixed versions given as plain string literals. A script
+// using anything else (e.g. @GrabConfig, @GrabExclude, version ranges, snapshots or Grape directly) is always left to Grape.
+// Note that disabling Grape also disables the grabs of any other scripts the script evaluates.
+
+#ifndef GROOVYGRAB_H_
+#  define GROOVYGRAB_H_
+
+#include <jni.h>
+
+/** Given to the jvm when the recorded jars are used, so that Grape does not resolve the grabs again. */
+#define GRAPE_DISABLE_OPTION "-Dgroovy.grape.enable=false"
+
+/** Returns the classpath (jars separated by JST_PATH_SEPARATOR) recorded for the grabs of the given script, NULL if there is
+ * none, i.e. the script has no cacheable grabs, the jars have not been recorded yet or have changed since. In the last two
+ * cases groovyRecordGrabs records the jars of this run. Freeing the returned value is up to the caller.
+ * @param error set on error (err msg printed) */
+char* groovyGrabbedJars( const char* scriptFile, jboolean* error ) ;
+
+/** If the jars of the grabs of the script given to groovyGrabbedJars were not recorded, has Grape resolve them and records
+ * them. As Grape has just resolved them for the script, this only reads the grape cache. Failing is not an error, it is
+ * reported in debug output. Only the first call does anything.
+ * Meant as JavaLauncherOptions.mainReturnedHook. */
+void groovyRecordGrabs( JNIEnv* env ) ;
+
+#endif /* GROOVYGRAB_H_ */
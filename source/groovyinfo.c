@@ -0,0 +1,274 @@
+//  Groovy -- A native launcher for Groovy
+//
+//  Copyright (c) 2010 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License") ; you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if !defined( _WIN32 )
+#  include <unistd.h>
+#  include <pthread.h>
+#endif
+
+#include <jni.h>
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_cache.h"
+#include "jst_zip.h"
+#include "groovyinfo.h"
+
+/** The launch plan keys the groovy version and the help text are stored under are these followed by the startup jar. */
+#define VERSION_KEY_PREFIX "groovy-version-1\n"
+#define HELP_KEY_PREFIX    "groovy-help-1\n"
+
+/** Longer help texts are not cached. */
+#define MAX_HELP_SIZE 65536
+
+// the os.name system property of the jvm. On the oses not listed here the jvm is needed to print the version.
+#if defined( __APPLE__ )
+#  define JAVA_OS_NAME "Mac OS X"
+#elif defined( __linux__ )
+#  define JAVA_OS_NAME "Linux"
+#elif defined( __sun__ )
+#  define JAVA_OS_NAME "SunOS"
+#endif
+
+/** Returns the single entry stored under the given key prefix for the given startup jar, NULL if there is none.
+ * Freeing the returned value is up to the caller. */
+static char* loadEntry( const char* keyPrefix, const char* startupJar ) {
+  char *key,
+       **plan,
+       *entry = NULL ;
+
+  if ( !jst_cachingEnabled() || !( key = jst_append( NULL, NULL, keyPrefix, startupJar, NULL ) ) ) return NULL ;
+
+  if ( ( plan = jst_loadLaunchPlan( key, 1 ) ) ) {
+    entry = jst_strdup( plan[ 0 ] ) ;
+    free( plan ) ;
+  }
+
+  free( key ) ;
+
+  return entry ;
+}
+
+/** Stores the given entry, valid as long as the startup jar is not changed. */
+static void storeEntry( const char* keyPrefix, const char* startupJar, char* entry ) {
+  char *key,
+       *entries[]    = { entry, NULL },
+       *stampFiles[] = { (char*)startupJar, NULL } ;
+
+  if ( !jst_cachingEnabled() || !( key = jst_append( NULL, NULL, keyPrefix, startupJar, NULL ) ) ) return ;
+
+  jst_storeLaunchPlan( key, entries, stampFiles ) ;
+
+  free( key ) ;
+}
+
+/** Returns the version of the groovy the given startup jar belongs to, NULL if not known. */
+static char* getGroovyVersion( const char* startupJar ) {
+  char* version ;
+
+  if ( ( version = loadEntry( VERSION_KEY_PREFIX, startupJar ) ) ) return version ;
+
+  // reading the manifest means inflating it, so the result is cached
+  if ( ( version = jst_getJarManifestAttribute( startupJar, "Implementation-Version" ) ) ) storeEntry( VERSION_KEY_PREFIX, startupJar, version ) ;
+
+  return version ;
+}
+
+extern jboolean groovyPrintVersion( const char* startupJar, const char* javaHome ) {
+  char     *groovyVersion = NULL,
+           *javaVersion   = NULL,
+           *javaVendor    = NULL ;
+  int      major,
+           minor ;
+  jboolean rval = JNI_FALSE ;
+
+  if ( !( groovyVersion = getGroovyVersion( startupJar ) ) || !( javaVersion = jst_getJavaVersion( javaHome ) ) ||
+       sscanf( groovyVersion, "%d.%d", &major, &minor ) != 2 ) goto end ;
+
+  // the jvm vendor and os were added to the output in groovy 1.8. The vendor in the release file is that of the jdk, which
+  // is the vendor of its jvm too
+  if ( major == 1 && minor < 8 ) {
+    printf( "Groovy Version: %s JVM: %s\n", groovyVersion, javaVersion ) ;
+  } else {
+#if defined( JAVA_OS_NAME )
+    if ( !( javaVendor = jst_getJavaReleaseProperty( javaHome, "IMPLEMENTOR" ) ) ) goto end ;
+    printf( "Groovy Version: %s JVM: %s Vendor: %s OS: %s\n", groovyVersion, javaVersion, javaVendor, JAVA_OS_NAME ) ;
+#else
+    goto end ;
+#endif
+  }
+
+  rval = JNI_TRUE ;
+
+  end:
+  if ( _jst_debug ) fprintf( stderr, "debug: %s\n", rval ? "printed the version w/out starting the jvm" : "the jvm is needed to print the version" ) ;
+
+  if ( groovyVersion ) free( groovyVersion ) ;
+  if ( javaVersion   ) free( javaVersion ) ;
+  if ( javaVendor    ) free( javaVendor ) ;
+
+  return rval ;
+}
+
+extern jboolean groovyPrintHelp( const char* startupJar ) {
+  char* help = loadEntry( HELP_KEY_PREFIX, startupJar ) ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: %s\n", help ? "printing the help text captured earlier" : "no help text captured yet" ) ;
+
+  if ( !help ) return JNI_FALSE ;
+
+  fputs( help, stdout ) ;
+  free( help ) ;
+
+  return JNI_TRUE ;
+}
+
+#if defined( _WIN32 )
+
+// not implemented, the help text always comes from the jvm
+
+extern jboolean groovyStartCapturingHelp( const char* startupJar ) {
+  return JNI_FALSE ;
+}
+
+extern void groovyFinishCapturingHelp( int exitCode ) {
+}
+
+#else
+
+static struct {
+  jboolean  active ;
+  /** The real stdout while capturing. */
+  int       stdoutFd ;
+  /** The read end of the pipe stdout has been replaced with. */
+  int       pipeFd ;
+  pthread_t teeThread ;
+  char*     startupJar ;
+  /** MAX_HELP_SIZE + 1 chars */
+  char*     text ;
+  size_t    size ;
+  /** Set if there was more output than MAX_HELP_SIZE or it could not all be passed on to the real stdout. */
+  jboolean  incomplete ;
+} capture ;
+
+static void releaseCapture( void ) {
+  if ( capture.stdoutFd != -1 ) close( capture.stdoutFd ) ;
+  if ( capture.pipeFd   != -1 ) close( capture.pipeFd ) ;
+  capture.active = JNI_FALSE ;
+  if ( capture.startupJar ) {
+    jst_free( capture.startupJar ) ;
+  }
+  if ( capture.text ) {
+    jst_free( capture.text ) ;
+  }
+}
+
+/** Passes what is printed to the pipe on to the real stdout as it comes, keeping a copy. */
+static void* teeOutput( void* arg ) {
+  char    buffer[ 4096 ],
+          *pos ;
+  ssize_t count,
+          written ;
+
+  while ( ( count = read( capture.pipeFd, buffer, sizeof( buffer ) ) ) != 0 ) {
+    if ( count < 0 ) {
+      if ( errno == EINTR ) continue ;
+      capture.incomplete = JNI_TRUE ;
+      break ;
+    }
+
+    if ( capture.size + (size_t)count <= MAX_HELP_SIZE ) {
+      memcpy( capture.text + capture.size, buffer, (size_t)count ) ;
+      capture.size += (size_t)count ;
+    } else {
+      capture.incomplete = JNI_TRUE ;
+    }
+
+    // the pipe is read until its end even if stdout fails, so that the jvm never blocks writing to it
+    for ( pos = buffer ; count > 0 ; ) {
+      if ( ( written = write( capture.stdoutFd, pos, (size_t)count ) ) > 0 ) {
+        pos   += written ;
+        count -= written ;
+      } else if ( errno != EINTR ) {
+        capture.incomplete = JNI_TRUE ;
+        break ;
+      }
+    }
+  }
+
+  return arg ;
+}
+
+extern jboolean groovyStartCapturingHelp( const char* startupJar ) {
+  int fds[ 2 ] ;
+
+  if ( !jst_cachingEnabled() ) return JNI_FALSE ;
+
+  fflush( stdout ) ;
+
+  capture.active   = JNI_TRUE ;
+  capture.stdoutFd = capture.pipeFd = -1 ;
+
+  if ( !( capture.startupJar = jst_strdup( startupJar ) ) || !( capture.text = malloc( MAX_HELP_SIZE + 1 ) ) || pipe( fds ) != 0 ) goto error ;
+
+  capture.pipeFd = fds[ 0 ] ;
+
+  if ( ( capture.stdoutFd = dup( STDOUT_FILENO ) ) == -1 || dup2( fds[ 1 ], STDOUT_FILENO ) == -1 ) {
+    close( fds[ 1 ] ) ;
+    goto error ;
+  }
+  close( fds[ 1 ] ) ;
+
+  if ( ( errno = pthread_create( &capture.teeThread, NULL, teeOutput, NULL ) ) != 0 ) {
+    dup2( capture.stdoutFd, STDOUT_FILENO ) ;
+    goto error ;
+  }
+
+  if ( _jst_debug ) fprintf( stderr, "debug: capturing the help text\n" ) ;
+
+  return JNI_TRUE ;
+
+  error:
+  if ( _jst_debug ) fprintf( stderr, "debug: could not capture the help text: %s\n", strerror( errno ) ) ;
+  releaseCapture() ;
+  return JNI_FALSE ;
+}
+
+extern void groovyFinishCapturingHelp( int exitCode ) {
+
+  if ( !capture.active ) return ;
+
+  fflush( stdout ) ;
+
+  // this closes the write end of the pipe, so the tee thread finishes once it has passed on everything
+  dup2( capture.stdoutFd, STDOUT_FILENO ) ;
+  pthread_join( capture.teeThread, NULL ) ;
+
+  if ( exitCode == 0 && !capture.incomplete && capture.size > 0 ) {
+    capture.text[ capture.size ] = '\0' ;
+    storeEntry( HELP_KEY_PREFIX, capture.startupJar, capture.text ) ;
+    if ( _jst_debug ) fprintf( stderr, "debug: captured %lu bytes of help text\n", (unsigned long)capture.size ) ;
+  }
+
+  releaseCapture() ;
+}
+
+#endif
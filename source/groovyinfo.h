@@ -0,0 +1,44 @@
+//  Groovy -- A native launcher for Groovy
+//
+//  Copyright (c) 2010 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License") ; you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Answering groovy -v and groovy --help w/out starting a jvm, as tools run those all the time to find out what is installed.
+//
+// The version is printed as groovy.ui.GroovyMain would, the groovy version being read from the manifest of the groovy startup jar
+// and the java version (and vendor) from the release file of the java installation. If any of that is not known, the jvm has to
+// answer.
+// The help text of GroovyMain can not be produced w/out running it, so it is captured from the first run and reused while the
+// groovy startup jar stays the same.
+
+#ifndef GROOVYINFO_H_
+#  define GROOVYINFO_H_
+
+#include <jni.h>
+
+/** Prints what groovy -v would. Returns false (w/out printing anything) if that can not be done w/out starting the jvm. */
+jboolean groovyPrintVersion( const char* startupJar, const char* javaHome ) ;
+
+/** Prints the help text of groovy.ui.GroovyMain as captured on an earlier run. Returns false (w/out printing anything) if there
+ * is none. */
+jboolean groovyPrintHelp( const char* startupJar ) ;
+
+/** Starts capturing what is printed to stdout, to be stored as the help text for groovyPrintHelp. The output is still printed
+ * as usual. Returns false if capturing is not possible (no error msg is printed). */
+jboolean groovyStartCapturingHelp( const char* startupJar ) ;
+
+/** Stops capturing what is printed to stdout and stores it if the jvm exited normally. */
+void groovyFinishCapturingHelp( int exitCode ) ;
+
+#endif /* GROOVYINFO_H_ */
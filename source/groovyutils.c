@@ -15,12 +15,31 @@
 //  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
+
+#if defined( _WIN32 )
+#  include <Windows.h>
+#  include <direct.h>
+#  define getcwd _getcwd
+#  if !defined( PATH_MAX )
+#    define PATH_MAX MAX_PATH
+#  endif
+#else
+#  include <unistd.h>
+#  include <pwd.h>
+#endif
 
 #include <jni.h>
 
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_cache.h"
 #include "jst_stringutils.h"
+#include "groovyutils.h"
 
 extern int gantJarSelect( const char* dirName, const char* fileName ) {
 
@@ -70,3 +89,254 @@ extern int groovyJarSelectForGant( const char* dirName, const char* fileName ) {
   return result ;
 
 }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// groovy starter conf, see org.codehaus.groovy.tools.LoaderConfiguration
+
+/** The prefixes of the system properties the jvm sets itself. Their values are not known until the jvm is running. */
+static const char* jvmPropertyPrefixes[] = { "java.", "javax.", "jdk.", "sun.", "os.", "user.", "file.", "path.", "line.", NULL } ;
+
+/** Looks up the value of the given system property as it will be when the jvm is running.
+ * @return NULL if the property will not be set. *unknown is set if the value can not be determined w/out the jvm. */
+static char* getSystemProperty( const char* name, size_t nameLen, char** jvmDOptions, char* buffer, size_t bufferSize, jboolean* unknown ) {
+  char *value = NULL ;
+  int  i ;
+
+  // if a property is given several times, the last one stands
+  for ( i = 0 ; jvmDOptions[ i ] ; i++ ) {
+    if ( strncmp( jvmDOptions[ i ] + 2, name, nameLen ) == 0 && jvmDOptions[ i ][ nameLen + 2 ] == '=' ) value = jvmDOptions[ i ] + nameLen + 3 ;
+  }
+  if ( value ) return value ;
+
+  if ( nameLen == 9 && memcmp( name, "user.home", 9 ) == 0 ) {
+#if defined( _WIN32 )
+    value = getenv( "USERPROFILE" ) ;
+#else
+    // the jvm uses the home dir from the password database rather than HOME
+    struct passwd *pw = getpwuid( getuid() ) ;
+    value = ( pw && pw->pw_dir && *pw->pw_dir ) ? pw->pw_dir : getenv( "HOME" ) ;
+#endif
+    if ( !value ) *unknown = JNI_TRUE ;
+    return value ;
+  }
+
+  if ( nameLen == 8 && memcmp( name, "user.dir", 8 ) == 0 ) {
+    if ( !( value = getcwd( buffer, bufferSize ) ) ) *unknown = JNI_TRUE ;
+    return value ;
+  }
+
+  for ( i = 0 ; jvmPropertyPrefixes[ i ] ; i++ ) {
+    if ( strncmp( name, jvmPropertyPrefixes[ i ], strlen( jvmPropertyPrefixes[ i ] ) ) == 0 ) *unknown = JNI_TRUE ;
+  }
+
+  return NULL ;
+}
+
+/** Replaces ${property} and !{property} w/ the values of the system properties, as LoaderConfiguration.assignProperties.
+ * Returns NULL if an optional (${}) property is not set, meaning the line is skipped. Also returns NULL and sets *unsupported
+ * if the value of a property is not known natively or on error. A required (!{}) property that is not set is an error
+ * that is left for GroovyStarter to report, so it is treated as unsupported as well.
+ * The given string is modified during the call but restored before returning. Freeing the returned value is up to the caller. */
+static char* assignProperties( char* path, char** jvmDOptions, jboolean* unsupported ) {
+  char   *result    = NULL,
+         *value,
+         *propStart,
+         *propEnd,
+         cwd[ PATH_MAX + 1 ] ;
+  size_t resultSize = 0 ;
+
+  for ( ;; ) {
+    char *optional = strstr( path, "${" ),
+         *required = strstr( path, "!{" ) ;
+
+    propStart = !optional ? required : !required ? optional : optional < required ? optional : required ;
+    if ( !propStart || !( propEnd = strchr( propStart, '}' ) ) ) break ;
+
+    value = getSystemProperty( propStart + 2, propEnd - propStart - 2, jvmDOptions, cwd, sizeof( cwd ), unsupported ) ;
+
+    if ( !value || *unsupported ) {
+      if ( propStart == required ) *unsupported = JNI_TRUE ;
+      if ( result ) free( result ) ;
+      return NULL ;
+    }
+
+    // the text preceding the property
+    *propStart = '\0' ;
+    result = jst_append( result, &resultSize, path, value, NULL ) ;
+    *propStart = propStart == optional ? '$' : '!' ;
+
+    if ( !result ) {
+      *unsupported = JNI_TRUE ;
+      return NULL ;
+    }
+
+    path = propEnd + 1 ;
+  }
+
+  if ( !( result = jst_append( result, &resultSize, path, NULL ) ) ) *unsupported = JNI_TRUE ;
+
+  return result ;
+}
+
+static jboolean isSeparator( char c ) {
+  return c == '/' || c == JST_FILE_SEPARATOR[ 0 ] ;
+}
+
+/** Matches the given path against the given load filter. As in LoaderConfiguration, "*" matches one or more chars other
+ * than a file separator and "**" one or more of any chars. */
+static jboolean matchesLoadFilter( const char* filter, const char* path ) {
+
+  for ( ; *filter ; filter++, path++ ) {
+
+    if ( *filter == '*' ) {
+      jboolean   anyDepth = ( filter[ 1 ] == '*' ) ? JNI_TRUE : JNI_FALSE ;
+      const char *rest    = filter + ( anyDepth ? 2 : 1 ) ;
+
+      for ( ; *path && ( anyDepth || !isSeparator( *path ) ) ; path++ ) {
+        if ( matchesLoadFilter( rest, path + 1 ) ) return JNI_TRUE ;
+      }
+      return JNI_FALSE ;
+    }
+
+    if ( !*path || !( *filter == *path || ( isSeparator( *filter ) && isSeparator( *path ) ) ) ) return JNI_FALSE ;
+  }
+
+  return !*path ;
+}
+
+/** Adds the files under the given dir that match the filter. Returns 0 on error. */
+static int addMatchingFiles( const char* dir, const char* filter, jboolean recursive, JstDynamicPointerArray* files ) {
+  char **names,
+       **name,
+       *file ;
+  int  rval = 1 ;
+
+  // a dir that does not exist or can not be read is silently skipped, as in LoaderConfiguration
+  if ( !jst_fileExists( dir ) || !jst_isDir( dir ) ) return 1 ;
+
+  if ( recursive && ( names = jst_getFileNamesOfType( (char*)dir, NULL, NULL, JST_DIR_ENTRY, NULL ) ) ) {
+    for ( name = names ; *name && rval ; name++ ) {
+      if ( !( file = jst_append( NULL, NULL, dir, JST_FILE_SEPARATOR, *name, NULL ) ) ) {
+        rval = 0 ;
+        break ;
+      }
+      rval = addMatchingFiles( file, filter, recursive, files ) ;
+      free( file ) ;
+    }
+    free( names ) ;
+  }
+
+  if ( !rval || !( names = jst_getFileNamesOfType( (char*)dir, NULL, NULL, JST_FILE_ENTRY, NULL ) ) ) return rval ;
+
+  for ( name = names ; *name && rval ; name++ ) {
+    if ( !( file = jst_append( NULL, NULL, dir, JST_FILE_SEPARATOR, *name, NULL ) ) ) {
+      rval = 0 ;
+      break ;
+    }
+    if ( matchesLoadFilter( filter, file ) ) {
+      if ( jst_appendPointerToDynamicArray( files, file ) ) continue ;
+      rval = 0 ;
+    }
+    free( file ) ;
+  }
+
+  free( names ) ;
+
+  return rval ;
+}
+
+/** As LoaderConfiguration.loadFilteredPath. Returns 0 on error. */
+static int loadFilteredPath( const char* filter, JstDynamicPointerArray* files ) {
+  const char *star = strchr( filter, '*' ),
+             *c ;
+  char       *file,
+             *rootDir ;
+  int        rval ;
+
+  if ( !star ) {
+    if ( !jst_fileExists( filter ) ) return 1 ;
+    if ( !( file = jst_strdup( filter ) ) ) return 0 ;
+    if ( !jst_appendPointerToDynamicArray( files, file ) ) {
+      free( file ) ;
+      return 0 ;
+    }
+    return 1 ;
+  }
+
+  // the dir to search is the one containing the first wildcard
+  for ( c = star ; c > filter && !isSeparator( c[ -1 ] ) ; c-- ) ;
+  if ( c == filter ) return 1 ;
+
+  JST_STRDUPA( rootDir, filter ) ;
+  if ( !rootDir ) return 0 ;
+  rootDir[ c - filter - 1 ] = '\0' ;
+
+  rval = addMatchingFiles( rootDir, filter, strstr( filter, "**" ) ? JNI_TRUE : JNI_FALSE, files ) ;
+
+  jst_freea( rootDir ) ;
+
+  return rval ;
+}
+
+extern char** groovyStarterConfClasspath( const char* confFile, char** jvmDOptions ) {
+  JstMappedFile          conf ;
+  char                   *lines    = NULL,
+                         *line,
+                         *next,
+                         *end,
+                         *path     = NULL ;
+  JstDynamicPointerArray files ;
+  jboolean               unsupported = JNI_FALSE ;
+
+  memset( &files, 0, sizeof( files ) ) ;
+
+  if ( !jst_mapFile( confFile, &conf ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: could not read %s\n", confFile ) ;
+    return NULL ;
+  }
+
+  if ( !( lines = jst_malloc( conf.size + 1 ) ) ) goto end ;
+  memcpy( lines, conf.data, conf.size ) ;
+  lines[ conf.size ] = '\0' ;
+
+  // an empty conf is valid
+  if ( !jst_initializeDynamicPointerArray( &files, 0 ) ) goto end ;
+
+  for ( line = lines ; line && !unsupported ; line = next ) {
+
+    if ( ( next = strpbrk( line, "\r\n" ) ) ) *next++ = '\0' ;
+
+    while ( isspace( (unsigned char)*line ) ) line++ ;
+    for ( end = line + strlen( line ) ; end > line && isspace( (unsigned char)end[ -1 ] ) ; end-- ) ;
+    *end = '\0' ;
+
+    if ( !*line || *line == '#' ) continue ;
+
+    // the main class is always given to GroovyStarter w/ --main, which overrides the one in the conf
+    if ( jst_startsWith( line, "main is" ) ) continue ;
+
+    if ( !jst_startsWith( line, "load" ) || !isspace( (unsigned char)line[ 4 ] ) ) {
+      // e.g. a directive of a newer groovy version. LoaderConfiguration knows how to handle those (or how to complain).
+      if ( _jst_debug ) fprintf( stderr, "debug: unrecognized line in %s: %s\n", confFile, line ) ;
+      unsupported = JNI_TRUE ;
+      break ;
+    }
+
+    for ( line += 4 ; isspace( (unsigned char)*line ) ; line++ ) ;
+
+    if ( ( path = assignProperties( line, jvmDOptions, &unsupported ) ) ) {
+      if ( !loadFilteredPath( path, &files ) ) unsupported = JNI_TRUE ;
+      jst_free( path ) ;
+    }
+
+    if ( unsupported && _jst_debug ) fprintf( stderr, "debug: can not resolve natively the line in %s: load %s\n", confFile, line ) ;
+  }
+
+  end:
+  if ( lines ) free( lines ) ;
+  jst_unmapFile( &conf ) ;
+
+  if ( unsupported || !lines ) jst_freeDynamicArray( &files, JNI_TRUE ) ;
+
+  return (char**)files.pointers ;
+}
@@ -21,4 +21,15 @@ int gantJarSelect( const char* dirName, const char* fileName ) ;
 
 int groovyJarSelectForGant( const char* dirName, const char* fileName ) ;
 
+/** Returns the files the given groovy starter conf (e.g. groovy-starter.conf) makes GroovyStarter load, in the order
+ * org.codehaus.groovy.tools.LoaderConfiguration loads them. Those can then be put on the jvm classpath and the main class
+ * invoked directly, w/out GroovyStarter and the RootLoader it creates.
+ * @param jvmDOptions NULL terminated array of the -Dname=value options given to the jvm, where the values of the system
+ *        properties referenced in the conf are looked up. The ones the jvm sets itself, e.g. user.home, are figured out
+ *        the way the jvm does it, where possible.
+ * @return NULL if the conf can not be handled natively, e.g. it references a system property whose value is only known
+ *         in the running jvm. GroovyStarter should be used then. The reason is printed if debugging is on.
+ *         The returned array and the strings in it are freed w/ jst_freeAll. */
+char** groovyStarterConfClasspath( const char* confFile, char** jvmDOptions ) ;
+
 #endif /* GROOVYUTILS_H_ */
@@ -27,11 +27,19 @@ extern void clearException( JNIEnv* env ) {
 
 extern jclass getJavaStringClass( JNIEnv* env ) {
 
+  // a global ref, as a local one would become invalid when the local frame it was created in is popped
   static jclass strClass = NULL ;
 
-  if ( !strClass && !( strClass = (*env)->FindClass(env, "java/lang/String" ) ) ) {
-    clearException( env ) ;
-    fprintf( stderr, "error: could not find java.lang.String class\n" ) ; // should never happen
+  if ( !strClass ) {
+    jclass localStrClass = (*env)->FindClass( env, "java/lang/String" ) ;
+    if ( localStrClass ) {
+      strClass = (jclass)(*env)->NewGlobalRef( env, localStrClass ) ;
+      (*env)->DeleteLocalRef( env, localStrClass ) ;
+    }
+    if ( !strClass ) {
+      clearException( env ) ;
+      fprintf( stderr, "error: could not find java.lang.String class\n" ) ; // should never happen
+    }
   }
 
   return strClass ;
@@ -0,0 +1,266 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined( _WIN32 )
+#  include <io.h>
+#  include <fcntl.h>
+#else
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#endif
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_argfile.h"
+
+/** How much more room is made at a time when reading a stream that can not be mapped. */
+#define READ_CHUNK_SIZE 65536
+
+/** Reads the rest of the given stream into a buffer adopted by the given arena. Returns NULL on error (err msg printed). */
+static char* readStream( FILE* stream, const char* name, size_t* size, JstArena* arena ) {
+  char   *buffer = NULL,
+         *newBuffer ;
+  size_t capacity = 0,
+         count ;
+
+  *size = 0 ;
+
+  do {
+    if ( !( newBuffer = jst_ensureArrayCapacity( buffer, &capacity, *size + READ_CHUNK_SIZE, 1 ) ) ) {
+      if ( buffer ) free( buffer ) ;
+      return NULL ;
+    }
+    buffer = newBuffer ;
+    count  = fread( buffer + *size, 1, capacity - *size, stream ) ;
+    *size += count ;
+  } while ( count > 0 ) ;
+
+  if ( ferror( stream ) ) {
+    fprintf( stderr, "error: could not read %s\n%s\n", name, strerror( errno ) ) ;
+    free( buffer ) ;
+    return NULL ;
+  }
+
+  return jst_arenaAdopt( arena, buffer ) ;
+}
+
+#if !defined( _WIN32 )
+
+typedef struct {
+  void*  data ;
+  size_t size ;
+} MappedArgs ;
+
+static void unmapArgs( void* mapping ) {
+  munmap( ((MappedArgs*)mapping)->data, ((MappedArgs*)mapping)->size ) ;
+  free( mapping ) ;
+}
+
+/** Maps the given file privately, so the contents can be modified w/out the changes being written to the file. Returns NULL
+ * if the file can not be mapped (e.g. it is a pipe or empty), or on error (*error set). */
+static char* mapArgs( int fd, size_t* size, JstArena* arena, jboolean* error ) {
+  struct stat fileStat ;
+  MappedArgs* mapping ;
+  void*       data ;
+
+  // the mapping starts at the beginning of the file, so a partially read stdin can not be mapped
+  if ( fstat( fd, &fileStat ) || !S_ISREG( fileStat.st_mode ) || fileStat.st_size <= 0 || lseek( fd, 0, SEEK_CUR ) != 0 ) return NULL ;
+
+  if ( ( data = mmap( NULL, (size_t)fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 ) ) == MAP_FAILED ) return NULL ;
+
+  if ( !( mapping = jst_malloc( sizeof( MappedArgs ) ) ) ) {
+    munmap( data, (size_t)fileStat.st_size ) ;
+    *error = JNI_TRUE ;
+    return NULL ;
+  }
+  mapping->data = data ;
+  mapping->size = (size_t)fileStat.st_size ;
+
+  if ( !jst_arenaAdoptResource( arena, mapping, unmapArgs ) ) {
+    *error = JNI_TRUE ;
+    return NULL ;
+  }
+
+  *size = (size_t)fileStat.st_size ;
+  return (char*)data ;
+}
+
+#endif
+
+/** Returns the contents of the given file. They may be modified in place. Returns NULL on error (err msg printed). */
+static char* loadArgFile( const char* fileName, size_t* size, JstArena* arena ) {
+  FILE* file ;
+  char* data = NULL ;
+#if !defined( _WIN32 )
+  jboolean error = JNI_FALSE ;
+  int      fd ;
+
+  if ( ( fd = open( fileName, O_RDONLY ) ) == -1 ) {
+    fprintf( stderr, "error: could not open argument file %s\n%s\n", fileName, strerror( errno ) ) ;
+    return NULL ;
+  }
+
+  if ( ( data = mapArgs( fd, size, arena, &error ) ) || error ) {
+    close( fd ) ;
+    return data ;
+  }
+
+  if ( !( file = fdopen( fd, "rb" ) ) ) close( fd ) ;
+#else
+  file = fopen( fileName, "rb" ) ;
+#endif
+
+  if ( !file ) {
+    fprintf( stderr, "error: could not open argument file %s\n%s\n", fileName, strerror( errno ) ) ;
+    return NULL ;
+  }
+
+  data = readStream( file, fileName, size, arena ) ;
+  fclose( file ) ;
+
+  return data ;
+}
+
+static char* loadStdin( size_t* size, JstArena* arena ) {
+#if !defined( _WIN32 )
+  jboolean error = JNI_FALSE ;
+  char*    data ;
+
+  if ( ( data = mapArgs( fileno( stdin ), size, arena, &error ) ) || error ) return data ;
+#else
+  _setmode( _fileno( stdin ), _O_BINARY ) ;
+#endif
+  return readStream( stdin, "stdin", size, arena ) ;
+}
+
+/** Splits the given data in place into the args separated by the given char and appends them to the given array.
+ * For newline separated data a \r at the end of a line is dropped and empty lines are skipped. Returns 0 on error. */
+static int splitArgs( char* data, size_t size, char separator, JstDynamicPointerArray* args, JstArena* arena ) {
+  char   *arg = data,
+         *end = data + size,
+         *next ;
+  size_t length ;
+
+  while ( arg < end ) {
+    next   = memchr( arg, separator, (size_t)( end - arg ) ) ;
+    length = (size_t)( ( next ? next : end ) - arg ) ;
+
+    if ( separator == '\n' && length > 0 && arg[ length - 1 ] == '\r' ) length-- ;
+
+    if ( next ) {
+      arg[ length ] = '\0' ;
+    } else {
+      // the last arg is not followed by a separator, so there is no room to terminate it in place
+      char* copy ;
+      if ( !( copy = jst_arenaAlloc( arena, length + 1 ) ) ) return 0 ;
+      memcpy( copy, arg, length ) ;
+      copy[ length ] = '\0' ;
+      arg = copy ;
+    }
+
+    if ( ( length > 0 || separator != '\n' ) && !jst_appendPointerToDynamicArray( args, arg ) ) return 0 ;
+
+    if ( !next ) break ;
+    arg = next + 1 ;
+  }
+
+  return 1 ;
+}
+
+/** Whether the given arg names an existing file to read args from. */
+static jboolean isArgFile( const char* arg ) {
+  return ( arg[ 0 ] == '@' && arg[ 1 ] != '@' && jst_fileExists( arg + 1 ) && !jst_isDir( arg + 1 ) ) ? JNI_TRUE : JNI_FALSE ;
+}
+
+extern int jst_expandArgFiles( int argc, char** args, JstParamInfo* paramInfos, const char** terminatingSuffixes, char*** expandedArgs, JstArena* arena ) {
+  JstDynamicPointerArray expanded ;
+  JstParamScanner        *scanner ;
+  char                   *data ;
+  size_t                 size,
+                         countBefore,
+                         j ;
+  int                    i ;
+  jboolean               terminated = JNI_FALSE ;
+
+  // the common case: nothing to expand. An arg starting w/ @ is most likely groovy code, so check the file system only
+  // once it is known there is something that may need expanding
+  for ( i = 0 ; i < argc ; i++ ) {
+    if ( args[ i ][ 0 ] == '@' || strcmp( args[ i ], JST_ARGS_FROM_STDIN0_PARAM ) == 0 ) break ;
+  }
+  if ( i == argc ) {
+    *expandedArgs = args ;
+    return argc ;
+  }
+
+  if ( !( scanner = jst_createParamScanner( paramInfos, terminatingSuffixes ) ) ) return -1 ;
+
+  if ( !jst_initializeDynamicPointerArray( &expanded, (size_t)argc + 1 ) ) {
+    free( scanner ) ;
+    return -1 ;
+  }
+
+  for ( i = 0 ; i < argc ; i++ ) {
+    char *arg = args[ i ],
+         separator ;
+
+    // the args to the launchee and param values are passed on as they are
+    if ( terminated || jst_scannerExpectsValue( scanner ) ) {
+      if ( !jst_appendPointerToDynamicArray( &expanded, arg ) ) goto error ;
+      terminated = jst_scanParam( scanner, arg ) ;
+      continue ;
+    }
+
+    if ( strcmp( arg, JST_ARGS_FROM_STDIN0_PARAM ) == 0 ) {
+      data      = loadStdin( &size, arena ) ;
+      separator = '\0' ;
+    } else if ( isArgFile( arg ) ) {
+      data      = loadArgFile( arg + 1, &size, arena ) ;
+      separator = '\n' ;
+    } else {
+      if ( arg[ 0 ] == '@' && arg[ 1 ] == '@' ) arg++ ;
+      if ( !jst_appendPointerToDynamicArray( &expanded, arg ) ) goto error ;
+      terminated = jst_scanParam( scanner, arg ) ;
+      continue ;
+    }
+
+    countBefore = expanded.count ;
+    if ( !data || !splitArgs( data, size, separator, &expanded, arena ) ) goto error ;
+    if ( _jst_debug ) fprintf( stderr, "debug: expanded %s into %d args\n", arg, (int)( expanded.count - countBefore ) ) ;
+
+    for ( j = countBefore ; j < expanded.count && !terminated ; j++ ) terminated = jst_scanParam( scanner, expanded.pointers[ j ] ) ;
+  }
+
+  free( scanner ) ;
+
+  if ( !jst_arenaAdopt( arena, expanded.pointers ) ) return -1 ;
+
+  *expandedArgs = (char**)expanded.pointers ;
+  return (int)expanded.count ;
+
+  error:
+  free( scanner ) ;
+  jst_freeDynamicArray( &expanded, JNI_FALSE ) ;
+  return -1 ;
+}
@@ -0,0 +1,57 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Argument files, for argument lists too long to be given on the command line (e.g. all the files of a big source tree).
+// An argument of the form @file is replaced by the lines of the given file, one argument per line. A \r at the end of a
+// line is dropped and empty lines are skipped, there is no quoting or comments. Argument files are not expanded
+// recursively. As groovy code often starts w/ an @ (e.g. -e "@Grab(...)"), an argument is only taken to be an argument
+// file if such a file exists. @@ at the start of a command line argument stands for a literal @.
+//
+// Only the params before the terminating param (see jst_processInputParameters) are expanded, so the args to the script
+// and the code given w/ -e are left as they are. Param values (e.g. the one after -cp) are not expanded either. The args
+// read from an argument file are classified too, e.g. a list of source files given to groovyc ends the expansion at the
+// first source file.
+//
+// The argument --args-from-stdin0 is replaced by the NUL separated arguments read from stdin, e.g.
+//   find src -name '*.groovy' -print0 | groovyc --args-from-stdin0
+//
+// The files are mapped into memory (where possible) and split in place, so the arguments are not copied.
+
+#if !defined( _JST_ARGFILE_H_ )
+#  define _JST_ARGFILE_H_
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+#define JST_ARGS_FROM_STDIN0_PARAM "--args-from-stdin0"
+
+/** Expands the argument files and --args-from-stdin0 in the given args, up to the terminating param.
+ * @param args the command line args, not including the program name
+ * @param paramInfos, terminatingSuffixes as given to jst_processInputParameters
+ * @param expandedArgs set to the expanded args, NULL terminated. If nothing needs expanding, this is the given args array.
+ * @param arena the memory of the expanded args and the mapped files is released when this arena is freed
+ * @return the number of expanded args, -1 on error (err msg printed) */
+int jst_expandArgFiles( int argc, char** args, JstParamInfo* paramInfos, const char** terminatingSuffixes, char*** expandedArgs, JstArena* arena ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
@@ -0,0 +1,432 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <assert.h>
+
+#if defined( _WIN32 )
+#  include <Windows.h>
+#  include <direct.h>
+#  include <process.h>
+#  include <io.h>
+#  include <fcntl.h>
+#  define open  _open
+#  define close _close
+#  define O_WRONLY _O_WRONLY
+#  define O_CREAT  _O_CREAT
+#  define O_EXCL   _O_EXCL
+#  define getpid _getpid
+#else
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#endif
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_cache.h"
+
+#define LAUNCH_PLAN_SUBDIR "launchplans"
+#define LAUNCH_PLAN_MAGIC  "JSTPLAN1"
+
+/** Modifications to stamp files less than this many seconds before storing a plan are considered too recent to be
+ * reliably detected on file systems w/ coarse grained timestamps, so the plan is not stored in that case. */
+#define LAUNCH_PLAN_MIN_STAMP_AGE 2
+
+/** The layout of a launch plan file is this header, followed by stampCount jlongs (the modification times of the stamp files)
+ * and then the nul terminated strings: the key, stampCount stamp file names and entryCount entries. */
+typedef struct {
+  char         magic[ 8 ] ;
+  unsigned int fileSize ;
+  unsigned int stampCount ;
+  unsigned int entryCount ;
+  unsigned int reserved ;
+} LaunchPlanHeader ;
+
+
+extern jboolean jst_cachingEnabled( void ) {
+  return getenv( JST_NOCACHE_ENV_VAR_NAME ) ? JNI_FALSE : JNI_TRUE ;
+}
+
+#if defined( _WIN32 )
+#  define makeDir( dirName ) _mkdir( dirName )
+#else
+#  define makeDir( dirName ) mkdir( dirName, 0700 )
+#endif
+
+/** Creates the given dir and any missing parents. Modifies the given string temporarily. Returns 0 on failure. */
+static int createDirs( char* dirName ) {
+  char *s = dirName + 1 ;
+
+  // failures on the intermediate dirs are ignored as those are usually just e.g. drive letters or dirs we have no
+  // write access to but that already exist. If there really is a problem, creating the last dir fails.
+  for ( ; *s ; s++ ) {
+    if ( *s == JST_FILE_SEPARATOR[ 0 ] ) {
+      *s = '\0' ;
+      makeDir( dirName ) ;
+      *s = JST_FILE_SEPARATOR[ 0 ] ;
+    }
+  }
+
+  return makeDir( dirName ) == 0 || errno == EEXIST ;
+}
+
+extern char* jst_getCacheDir( const char* subdir, jboolean create ) {
+  char *base = getenv( JST_CACHEDIR_ENV_VAR_NAME ),
+       *dir  = NULL ;
+
+  if ( base && *base ) {
+    dir = jst_createFileName( base, subdir, NULL ) ;
+  } else {
+#if defined( _WIN32 )
+    if ( ( base = getenv( "LOCALAPPDATA" ) ) && *base ) dir = jst_createFileName( base, "jlauncher", subdir, NULL ) ;
+#else
+    // XDG base dir spec says relative paths are to be ignored
+    if ( ( base = getenv( "XDG_CACHE_HOME" ) ) && *base == '/' ) {
+      dir = jst_createFileName( base, "jlauncher", subdir, NULL ) ;
+    } else if ( ( base = getenv( "HOME" ) ) && *base ) {
+      dir = jst_createFileName( base, ".cache", "jlauncher", subdir, NULL ) ;
+    }
+#endif
+  }
+
+  if ( dir && create && !createDirs( dir ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: could not create cache dir %s: %s\n", dir, strerror( errno ) ) ;
+    jst_free( dir ) ;
+  }
+
+  return dir ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+extern JstHash jst_hashBytes( JstHash hash, const void* bytes, size_t len ) {
+  const unsigned char *p = (const unsigned char*)bytes ;
+
+  while ( len-- ) {
+    hash ^= *p++ ;
+    hash *= 1099511628211U ;
+  }
+
+  return hash ;
+}
+
+extern JstHash jst_hashString( JstHash hash, const char* s ) {
+  return s ? jst_hashBytes( hash, s, strlen( s ) + 1 )
+           : jst_hashBytes( hash, "\1", 1 ) ;
+}
+
+extern char* jst_hashToHex( JstHash hash, char* buffer ) {
+  static const char hexDigits[] = "0123456789abcdef" ;
+  int i ;
+
+  for ( i = JST_HASH_HEX_LEN - 2 ; i >= 0 ; i-- ) {
+    buffer[ i ] = hexDigits[ (int)( hash & 0xf ) ] ;
+    hash >>= 4 ;
+  }
+  buffer[ JST_HASH_HEX_LEN - 1 ] = '\0' ;
+
+  return buffer ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+extern int jst_mapFile( const char* fileName, JstMappedFile* mappedFile ) {
+
+  memset( mappedFile, 0, sizeof( JstMappedFile ) ) ;
+
+#if defined( _WIN32 )
+  {
+    FILE   *f = fopen( fileName, "rb" ) ;
+    long   size ;
+    char   *data = NULL ;
+
+    if ( !f ) return 0 ;
+
+    if ( fseek( f, 0, SEEK_END ) == 0 && ( size = ftell( f ) ) > 0 && fseek( f, 0, SEEK_SET ) == 0 &&
+         ( data = malloc( size ) ) ) {
+      if ( fread( data, 1, size, f ) == (size_t)size ) {
+        mappedFile->data = data ;
+        mappedFile->size = size ;
+      } else {
+        free( data ) ;
+      }
+    }
+
+    fclose( f ) ;
+  }
+#else
+  {
+    struct stat buf ;
+    void        *data ;
+    int         fd = open( fileName, O_RDONLY ) ;
+
+    if ( fd == -1 ) return 0 ;
+
+    if ( fstat( fd, &buf ) == 0 && buf.st_size > 0 ) {
+      data = mmap( NULL, (size_t)buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0 ) ;
+      if ( data != MAP_FAILED ) {
+        mappedFile->data     = data ;
+        mappedFile->size     = (size_t)buf.st_size ;
+        mappedFile->isMapped = JNI_TRUE ;
+      }
+    }
+
+    close( fd ) ;
+  }
+#endif
+
+  return mappedFile->data != NULL ;
+}
+
+extern void jst_unmapFile( JstMappedFile* mappedFile ) {
+  if ( !mappedFile->data ) return ;
+#if !defined( _WIN32 )
+  if ( mappedFile->isMapped ) {
+    munmap( (void*)mappedFile->data, mappedFile->size ) ;
+  } else
+#endif
+  free( (void*)mappedFile->data ) ;
+  mappedFile->data = NULL ;
+  mappedFile->size = 0 ;
+}
+
+extern int jst_replaceFile( const char* fromFileName, const char* toFileName ) {
+#if defined( _WIN32 )
+  // rename does not replace an existing file on windows
+  return MoveFileEx( fromFileName, toFileName, MOVEFILE_REPLACE_EXISTING ) ? 1 : 0 ;
+#else
+  return rename( fromFileName, toFileName ) == 0 ;
+#endif
+}
+
+extern int jst_createLockFile( const char* fileName, int staleAfterSeconds ) {
+  jlong mtime ;
+  int   fd ;
+
+  if ( jst_getModificationTime( fileName, &mtime ) && mtime / 1000000000 < (jlong)time( NULL ) - staleAfterSeconds ) {
+    remove( fileName ) ;
+  }
+
+  if ( ( fd = open( fileName, O_WRONLY | O_CREAT | O_EXCL, 0600 ) ) == -1 ) return 0 ;
+  close( fd ) ;
+
+  return 1 ;
+}
+
+extern int jst_writeFileAtomically( const char* fileName, const void* data, size_t size ) {
+  char     tmpFileName[ 32 ] ;
+  char     *tmpPath ;
+  FILE     *f ;
+  jboolean written = JNI_FALSE ;
+
+  // the pid makes the temp file unique among concurrently running launchers
+  sprintf( tmpFileName, ".%ld.tmp", (long)getpid() ) ;
+
+  JST_CONCATA2( tmpPath, fileName, tmpFileName ) ;
+  if ( !tmpPath ) return 0 ;
+
+  if ( ( f = fopen( tmpPath, "wb" ) ) ) {
+    written = fwrite( data, 1, size, f ) == size ? JNI_TRUE : JNI_FALSE ;
+    if ( fclose( f ) ) written = JNI_FALSE ;
+
+    if ( written && !jst_replaceFile( tmpPath, fileName ) ) written = JNI_FALSE ;
+
+    if ( !written ) remove( tmpPath ) ;
+  }
+
+  jst_freea( tmpPath ) ;
+
+  return written ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+/** Freeing the returned value is up to the caller. */
+static char* getLaunchPlanFileName( const char* key, jboolean createDir ) {
+  char  hex[ JST_HASH_HEX_LEN ],
+        *dir,
+        *fileName ;
+
+  if ( !( dir = jst_getCacheDir( LAUNCH_PLAN_SUBDIR, createDir ) ) ) return NULL ;
+
+  fileName = jst_createFileName( dir, jst_hashToHex( jst_hashString( JST_HASH_INIT, key ), hex ), NULL ) ;
+  free( dir ) ;
+
+  return fileName ;
+}
+
+extern char** jst_loadLaunchPlan( const char* key, int expectedEntryCount ) {
+  JstMappedFile    file ;
+  LaunchPlanHeader header ;
+  char             *fileName  = NULL,
+                   **entries  = NULL,
+                   **plan     = NULL,
+                   *reason    = NULL ;
+  const char       *s, *stamps, *dataEnd ;
+  unsigned int     i ;
+
+  memset( &file, 0, sizeof( file ) ) ;
+
+  if ( !jst_cachingEnabled() ) return NULL ;
+
+  if ( !( fileName = getLaunchPlanFileName( key, JNI_FALSE ) ) ) return NULL ;
+
+  if ( !jst_mapFile( fileName, &file ) ) {
+    reason = "no cached plan" ;
+    goto end ;
+  }
+
+  if ( file.size < sizeof( header ) ) {
+    reason = "corrupted cache file" ;
+    goto end ;
+  }
+
+  memcpy( &header, file.data, sizeof( header ) ) ;
+
+  if ( memcmp( header.magic, LAUNCH_PLAN_MAGIC, sizeof( header.magic ) ) != 0 ||
+       header.fileSize != file.size ||
+       header.entryCount != (unsigned int)expectedEntryCount ||
+       file.size < sizeof( header ) + header.stampCount * sizeof( jlong ) + 1 + header.stampCount + header.entryCount ||
+       file.data[ file.size - 1 ] != '\0' ) {
+    reason = "corrupted or incompatible cache file" ;
+    goto end ;
+  }
+
+  stamps  = file.data + sizeof( header ) ;
+  s       = stamps + header.stampCount * sizeof( jlong ) ;
+  dataEnd = file.data + file.size ;
+
+  // different keys may hash to the same file
+  if ( strcmp( s, key ) != 0 ) {
+    reason = "cached plan is for a different key" ;
+    goto end ;
+  }
+  s += strlen( s ) + 1 ;
+
+  for ( i = 0 ; i < header.stampCount ; i++ ) {
+    jlong storedMtime, mtime ;
+
+    if ( s >= dataEnd ) {
+      reason = "corrupted cache file" ;
+      goto end ;
+    }
+    memcpy( &storedMtime, stamps + i * sizeof( jlong ), sizeof( jlong ) ) ;
+    if ( !jst_getModificationTime( s, &mtime ) || mtime != storedMtime ) {
+      reason = "installation changed since the plan was cached" ;
+      goto end ;
+    }
+    s += strlen( s ) + 1 ;
+  }
+
+  if ( !( entries = jst_malloc( ( header.entryCount + 1 ) * sizeof( char* ) ) ) ) goto end ;
+
+  for ( i = 0 ; i < header.entryCount ; i++ ) {
+    if ( s >= dataEnd ) {
+      reason = "corrupted cache file" ;
+      goto end ;
+    }
+    entries[ i ] = (char*)s ;
+    s += strlen( s ) + 1 ;
+  }
+  entries[ i ] = NULL ;
+
+  plan = jst_packStringArray( entries ) ;
+
+  end:
+
+  if ( _jst_debug ) {
+    if ( plan ) {
+      fprintf( stderr, "debug: using cached launch plan %s\n", fileName ) ;
+    } else if ( reason ) {
+      fprintf( stderr, "debug: not using cached launch plan %s: %s\n", fileName, reason ) ;
+    }
+  }
+
+  if ( entries ) free( entries ) ;
+  jst_unmapFile( &file ) ;
+  free( fileName ) ;
+
+  return plan ;
+}
+
+extern int jst_storeLaunchPlan( const char* key, char** entries, char** stampFiles ) {
+  LaunchPlanHeader header ;
+  char             *fileName = NULL,
+                   *data     = NULL,
+                   *s ;
+  size_t           size ;
+  unsigned int     i ;
+  jlong            mtime,
+                   tooRecent = ( (jlong)time( NULL ) - LAUNCH_PLAN_MIN_STAMP_AGE ) * 1000000000 ;
+  int              stored = 0 ;
+
+  if ( !jst_cachingEnabled() ) return 0 ;
+
+  memset( &header, 0, sizeof( header ) ) ;
+  memcpy( header.magic, LAUNCH_PLAN_MAGIC, sizeof( header.magic ) ) ;
+
+  size = sizeof( header ) + strlen( key ) + 1 ;
+  for ( ; stampFiles[ header.stampCount ] ; header.stampCount++ ) size += sizeof( jlong ) + strlen( stampFiles[ header.stampCount ] ) + 1 ;
+  for ( ; entries[ header.entryCount ] ;    header.entryCount++ ) size += strlen( entries[ header.entryCount ] ) + 1 ;
+  header.fileSize = (unsigned int)size ;
+
+  if ( !( data = jst_malloc( size ) ) ) goto end ;
+
+  memcpy( data, &header, sizeof( header ) ) ;
+
+  for ( i = 0 ; i < header.stampCount ; i++ ) {
+    if ( !jst_getModificationTime( stampFiles[ i ], &mtime ) || mtime >= tooRecent ) {
+      if ( _jst_debug ) fprintf( stderr, "debug: not caching launch plan, %s is missing or too recently modified\n", stampFiles[ i ] ) ;
+      goto end ;
+    }
+    memcpy( data + sizeof( header ) + i * sizeof( jlong ), &mtime, sizeof( jlong ) ) ;
+  }
+
+  s = data + sizeof( header ) + header.stampCount * sizeof( jlong ) ;
+  strcpy( s, key ) ;
+  s += strlen( s ) + 1 ;
+  for ( i = 0 ; i < header.stampCount ; i++ ) {
+    strcpy( s, stampFiles[ i ] ) ;
+    s += strlen( s ) + 1 ;
+  }
+  for ( i = 0 ; i < header.entryCount ; i++ ) {
+    strcpy( s, entries[ i ] ) ;
+    s += strlen( s ) + 1 ;
+  }
+
+  assert( s == data + size ) ;
+
+  if ( !( fileName = getLaunchPlanFileName( key, JNI_TRUE ) ) ) goto end ;
+
+  stored = jst_writeFileAtomically( fileName, data, size ) ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: %s launch plan %s\n", stored ? "cached" : "could not cache", fileName ) ;
+
+  end:
+
+  if ( data     ) free( data ) ;
+  if ( fileName ) free( fileName ) ;
+
+  return stored ;
+}
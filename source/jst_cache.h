@@ -0,0 +1,121 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Persistent, per user caching of things the launcher would otherwise have to figure out again
+// on each run. Everything stored here is an optimization only: a missing, stale or corrupted cache
+// file is simply a cache miss, never an error.
+
+#if !defined( _JST_CACHE_H_ )
+#  define _JST_CACHE_H_
+
+#include <stddef.h>
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** Setting this env var (to any value) disables all the caches kept by the launcher. */
+#define JST_NOCACHE_ENV_VAR_NAME   "__JLAUNCHER_NOCACHE"
+/** If set, the launcher keeps its caches under this dir instead of the default location. */
+#define JST_CACHEDIR_ENV_VAR_NAME  "__JLAUNCHER_CACHE_DIR"
+
+#if defined( _MSC_VER )
+   typedef unsigned __int64   JstHash ;
+#  define JST_HASH_INIT 14695981039346656037ui64
+#else
+   typedef unsigned long long JstHash ;
+#  define JST_HASH_INIT 14695981039346656037ULL
+#endif
+
+/** Size of a buffer large enough to hold a hash printed with jst_hashToHex, including the terminating nul char. */
+#define JST_HASH_HEX_LEN 17
+
+/** Returns false if caching has been disabled by the user. */
+jboolean jst_cachingEnabled( void ) ;
+
+/** Returns the path to the given subdir of the launcher cache dir, e.g. ~/.cache/jlauncher/launchplans.
+ * The location is $__JLAUNCHER_CACHE_DIR, $XDG_CACHE_HOME/jlauncher or $HOME/.cache/jlauncher
+ * (%LOCALAPPDATA%\jlauncher on windows).
+ * @param create if true, the dir (and any missing parent dirs) are created.
+ * @return NULL if there is no usable cache dir, in which case no error msg is printed. Freeing the returned value is up to the caller. */
+char* jst_getCacheDir( const char* subdir, jboolean create ) ;
+
+/** 64 bit FNV-1a hash of the given bytes. Give JST_HASH_INIT as the initial hash. Hashes may be chained by giving
+ * the result of a previous call as the hash parameter. */
+JstHash jst_hashBytes( JstHash hash, const void* bytes, size_t len ) ;
+
+/** Hashes the given string, including the terminating nul char so that e.g. "ab", "c" and "a", "bc" hash differently
+ * when chained. NULL is hashed differently from "". */
+JstHash jst_hashString( JstHash hash, const char* s ) ;
+
+/** Writes the given hash as 16 hex digits (+ nul char) to the given buffer, which must be at least JST_HASH_HEX_LEN chars long. */
+char* jst_hashToHex( JstHash hash, char* buffer ) ;
+
+typedef struct {
+  /** The contents of the file. Read only. */
+  const char* data ;
+  size_t      size ;
+  /** for internal use */
+  jboolean    isMapped ;
+} JstMappedFile ;
+
+/** Maps the given file read only into memory (or reads it on platforms where mapping is not available).
+ * Returns 0 if the file does not exist or could not be read. No error msg is printed. */
+int jst_mapFile( const char* fileName, JstMappedFile* mappedFile ) ;
+
+void jst_unmapFile( JstMappedFile* mappedFile ) ;
+
+/** Renames the given file, replacing the target file if it exists. The target is replaced atomically (on posix systems), i.e. other
+ * processes see either the old or the new file. Returns 0 on failure. No error msg is printed. */
+int jst_replaceFile( const char* fromFileName, const char* toFileName ) ;
+
+/** Writes the given data to the given file so that other processes either see the old or the new file contents, never
+ * a partially written file. Returns 0 on failure. No error msg is printed. */
+int jst_writeFileAtomically( const char* fileName, const void* data, size_t size ) ;
+
+/** Creates the given (empty) file, failing if it already exists. This is used to make sure only one launcher at a time does some
+ * lengthy piece of work, e.g. populating a cache entry. The file should be removed once the work is done. A file older than
+ * the given number of seconds is assumed to have been left behind by a launcher that died and is taken over.
+ * Returns 0 if the file exists (i.e. some other launcher is at it) or could not be created. No error msg is printed. */
+int jst_createLockFile( const char* fileName, int staleAfterSeconds ) ;
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// launch plan caching
+
+/** A launch plan is a set of strings the launcher has resolved on some previous run, e.g. java home and the startup classpath.
+ * A plan is stored under a key that should contain everything the resolution depended on (env vars, command line
+ * params...). In addition, a plan is only valid as long as the modification times of the given stamp
+ * files / dirs are unchanged, so e.g. adding a jar to groovy lib dir or upgrading the jdk invalidates the plan.
+ *
+ * Returns a NULL terminated string array with the entries given to jst_storeLaunchPlan, or NULL if there is no valid plan stored
+ * under the given key.
+ * The returned array and the contained strings are freed by freeing the returned pointer.
+ * @param expectedEntryCount if the stored plan contains a different number of entries it is not used */
+char** jst_loadLaunchPlan( const char* key, int expectedEntryCount ) ;
+
+/** Stores the given entries under the given key.
+ * @param entries NULL terminated. May not contain NULLs, use "" for missing values.
+ * @param stampFiles NULL terminated array of the files / dirs whose modification time is checked when loading the plan.
+ *                   If some of them does not exist, the plan is not stored.
+ * @return 0 if the plan was not stored. This is not an error, so no error msg is printed. */
+int jst_storeLaunchPlan( const char* key, char** entries, char** stampFiles ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
@@ -0,0 +1,217 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_cache.h"
+#include "jst_cds.h"
+
+#define SHARED_ARCHIVE_SUBDIR "cds"
+
+/** Only one launcher at a time does a training run for an archive. If the training file is older than this many seconds,
+ * the launcher doing the training is assumed to have died (e.g. the jvm crashed) and the next launch may take over. */
+#define TRAINING_TIMEOUT 600
+
+/** The jvm options that mean the user is managing class data sharing herself. */
+static const char* userSharingOptions[] = { "-Xshare", "-XX:SharedArchiveFile", "-XX:ArchiveClassesAtExit", "-XX:AOTCache", "-XX:AOTMode", "-XX:AOTConfiguration", NULL } ;
+
+static jboolean userManagesSharing( JstJvmOptions* jvmOptions ) {
+  int i, j ;
+
+  for ( i = 0 ; i < jvmOptions->optionsCount ; i++ ) {
+    for ( j = 0 ; userSharingOptions[ j ] ; j++ ) {
+      if ( strncmp( jvmOptions->options[ i ].optionString, userSharingOptions[ j ], strlen( userSharingOptions[ j ] ) ) == 0 ) return JNI_TRUE ;
+    }
+  }
+
+  return JNI_FALSE ;
+}
+
+/** Whether the given jvm option affects if an archive can be used, i.e. is the classpath or selects the gc. */
+static jboolean isArchiveKeyOption( const char* option ) {
+  size_t len = strlen( option ) ;
+
+  if ( !strncmp( option, "-Djava.class.path=", 18 ) || !strncmp( option, "-Xbootclasspath", 15 ) ) return JNI_TRUE ;
+
+  return ( ( !strncmp( option, "-XX:+Use", 8 ) || !strncmp( option, "-XX:-Use", 8 ) ) && len > 10 && !strcmp( option + len - 2, "GC" ) ) ? JNI_TRUE : JNI_FALSE ;
+}
+
+extern char* jst_createSharedArchiveKey( JstJvmOptions* jvmOptions, int launcherOptionCount, const char* javaHome ) {
+  char   *key = NULL ;
+  size_t keySize = 0 ;
+  int    i ;
+
+  if ( !( key = jst_append( NULL, &keySize, "jst-cds-2\n", javaHome, "\n", NULL ) ) ) return NULL ;
+
+  for ( i = 0 ; i < launcherOptionCount && i < jvmOptions->optionsCount ; i++ ) {
+    if ( !isArchiveKeyOption( jvmOptions->options[ i ].optionString ) ) continue ;
+    if ( !( key = jst_append( key, &keySize, jvmOptions->options[ i ].optionString, "\n", NULL ) ) ) return NULL ;
+  }
+
+  return key ;
+}
+
+/** The jars on the classpath and the java release file (which changes whenever the jvm is upgraded). Classpath entries that
+ * do not exist or are dirs are left out as the jvm does not archive anything from them. Returns 0 on error. */
+static int collectStampFiles( JstSharedArchive* archive, JstJvmOptions* jvmOptions, const char* javaHome ) {
+  JstDynamicPointerArray stamps ;
+  char        *classpath = NULL,
+              *entry,
+              *file ;
+  struct stat entryStat ;
+  int         i ;
+
+  if ( !jst_initializeDynamicPointerArray( &stamps, 8 ) ) return 0 ;
+
+  if ( !( file = jst_createFileName( javaHome, "release", NULL ) ) ||
+       !jst_appendPointerToDynamicArray( &stamps, file ) ) goto error ;
+
+  // both the boot and the normal classpath may be given
+  for ( i = 0 ; i < jvmOptions->optionsCount ; i++ ) {
+    char *option = jvmOptions->options[ i ].optionString ;
+    if ( strncmp( option, "-Djava.class.path=", 18 ) && strncmp( option, "-Xbootclasspath/a:", 18 ) ) continue ;
+
+    file = NULL ;
+    if ( !( classpath = jst_strdup( option + 18 ) ) ) goto error ;
+
+    for ( entry = strtok( classpath, JST_PATH_SEPARATOR ) ; entry ; entry = strtok( NULL, JST_PATH_SEPARATOR ) ) {
+      if ( stat( entry, &entryStat ) || ( entryStat.st_mode & S_IFDIR ) ) continue ;
+      if ( !( file = jst_strdup( entry ) ) || !jst_appendPointerToDynamicArray( &stamps, file ) ) goto error ;
+    }
+
+    free( classpath ) ;
+    classpath = NULL ;
+  }
+
+  archive->stampFiles = (char**)stamps.pointers ;
+
+  return 1 ;
+
+  error:
+  if ( file ) free( file ) ;
+  if ( classpath ) free( classpath ) ;
+  jst_freeDynamicArray( &stamps, JNI_TRUE ) ;
+  return 0 ;
+}
+
+static void freeSharedArchive( JstSharedArchive* archive ) {
+  if ( archive->key          ) free( archive->key ) ;
+  if ( archive->archiveFile  ) free( archive->archiveFile ) ;
+  if ( archive->trainingFile ) free( archive->trainingFile ) ;
+  if ( archive->jvmOption    ) free( archive->jvmOption ) ;
+  if ( archive->stampFiles   ) jst_freeAll( (void***)(void*)&archive->stampFiles ) ;
+
+  memset( archive, 0, sizeof( *archive ) ) ;
+}
+
+extern int jst_addSharedArchiveOption( JstSharedArchive* archive, JstJvmOptions* jvmOptions, int launcherOptionCount, const char* javaHome ) {
+  int      javaVersion ;
+  jboolean aotCache ;
+  char     *dir  = NULL,
+           **plan = NULL,
+           hex[ JST_HASH_HEX_LEN + 4 ] ; // + the file extension
+  int      rval = 0 ;
+
+  memset( archive, 0, sizeof( *archive ) ) ;
+
+  if ( !javaHome || !jst_cachingEnabled() || userManagesSharing( jvmOptions ) ) return 1 ;
+
+  javaVersion = jst_getJavaMajorVersion( javaHome ) ;
+  if ( javaVersion < 13 ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not using a class data sharing archive, java version %d is not supported\n", javaVersion ) ;
+    return 1 ;
+  }
+  aotCache = ( javaVersion >= 25 ) ? JNI_TRUE : JNI_FALSE ;
+
+  if ( !( archive->key = jst_createSharedArchiveKey( jvmOptions, launcherOptionCount, javaHome ) ) ) goto end ;
+
+  if ( !( dir = jst_getCacheDir( SHARED_ARCHIVE_SUBDIR, JNI_TRUE ) ) ) {
+    rval = 1 ;
+    goto end ;
+  }
+
+  jst_hashToHex( jst_hashString( JST_HASH_INIT, archive->key ), hex ) ;
+  strcat( hex, aotCache ? ".aot" : ".jsa" ) ;
+  if ( !( archive->archiveFile = jst_createFileName( dir, hex, NULL ) ) ) goto end ;
+
+  if ( ( plan = jst_loadLaunchPlan( archive->key, 1 ) ) ) {
+    struct stat archiveStat ;
+    // an empty entry means the training run did not produce an archive, so there is no point in trying again
+    // until something changes
+    if ( !*plan[ 0 ] ) {
+      if ( _jst_debug ) fprintf( stderr, "debug: not using a class data sharing archive, the jvm did not create one on the training run\n" ) ;
+      rval = 1 ;
+      goto end ;
+    }
+    if ( stat( archive->archiveFile, &archiveStat ) == 0 ) {
+      if ( !( archive->jvmOption = jst_append( NULL, NULL, aotCache ? "-XX:AOTCache=" : "-XX:SharedArchiveFile=", archive->archiveFile, NULL ) ) ) goto end ;
+    }
+  }
+
+  if ( !archive->jvmOption ) {
+    if ( !collectStampFiles( archive, jvmOptions, javaHome ) ||
+         !( archive->trainingFile = jst_append( NULL, NULL, archive->archiveFile, ".training", NULL ) ) ) goto end ;
+
+    if ( !jst_createLockFile( archive->trainingFile, TRAINING_TIMEOUT ) ) {
+      if ( _jst_debug ) fprintf( stderr, "debug: not using a class data sharing archive, another launcher is creating %s\n", archive->archiveFile ) ;
+      jst_free( archive->trainingFile ) ;
+      rval = 1 ;
+      goto end ;
+    }
+
+    if ( !( archive->jvmOption = jst_append( NULL, NULL, aotCache ? "-XX:AOTCacheOutput=" : "-XX:ArchiveClassesAtExit=", archive->trainingFile, NULL ) ) ) goto end ;
+  }
+
+  if ( _jst_debug ) fprintf( stderr, "debug: %s class data sharing archive %s\n", archive->trainingFile ? "creating" : "using", archive->archiveFile ) ;
+
+  rval = appendJvmOption( jvmOptions, archive->jvmOption, NULL ) ? 1 : 0 ;
+
+  end:
+  if ( !rval && archive->trainingFile ) remove( archive->trainingFile ) ;
+  // on error, or when not using an archive, there is nothing to finish
+  if ( !rval || !archive->jvmOption ) freeSharedArchive( archive ) ;
+  if ( plan ) free( plan ) ;
+  if ( dir  ) free( dir ) ;
+
+  return rval ;
+}
+
+extern void jst_finishSharedArchive( JstSharedArchive* archive ) {
+
+  if ( archive->trainingFile ) {
+    struct stat trainingStat ;
+    char*  entries[ 2 ] ;
+    jboolean created = ( stat( archive->trainingFile, &trainingStat ) == 0 && trainingStat.st_size > 0 &&
+                         jst_replaceFile( archive->trainingFile, archive->archiveFile ) ) ? JNI_TRUE : JNI_FALSE ;
+
+    if ( !created ) remove( archive->trainingFile ) ;
+
+    if ( _jst_debug ) fprintf( stderr, "debug: %s class data sharing archive %s\n", created ? "created" : "the jvm did not create", archive->archiveFile ) ;
+
+    entries[ 0 ] = created ? archive->archiveFile : "" ;
+    entries[ 1 ] = NULL ;
+    jst_storeLaunchPlan( archive->key, entries, archive->stampFiles ) ;
+  }
+
+  freeSharedArchive( archive ) ;
+}
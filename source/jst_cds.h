@@ -0,0 +1,68 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Management of class data sharing archives. The jvm can map the classes loaded by an earlier run from an archive
+// instead of loading, parsing and verifying them again, which cuts a large part of the startup time.
+// The launcher keeps one archive per java home + classpath + gc under the cache dir, shared by all the scripts run w/ them.
+// When there is no up to date archive, the launch is used as a training run: the jvm writes the classes it loaded into
+// an archive at exit. Later launches use that archive until the jvm, the options or the jars on the classpath change.
+//
+// On java 13 - 24 a dynamic CDS archive is used (-XX:ArchiveClassesAtExit / -XX:SharedArchiveFile), on java 25 and newer
+// an AOT cache (-XX:AOTCacheOutput / -XX:AOTCache). Older jvms are not supported, nothing is done on those.
+
+#if !defined( _JST_CDS_H_ )
+#  define _JST_CDS_H_
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+typedef struct {
+  /** The archive key, see jst_loadLaunchPlan. NULL if no archive is being used or created. */
+  char*  key ;
+  char*  archiveFile ;
+  /** The file the jvm writes the archive to at exit if this is a training run, NULL otherwise. */
+  char*  trainingFile ;
+  /** The files whose modification invalidates the archive. */
+  char** stampFiles ;
+  /** The jvm option added. It must not be freed before the jvm has been created. */
+  char*  jvmOption ;
+} JstSharedArchive ;
+
+/** Returns the key of the archive to use w/ the given jvm options, see jst_loadLaunchPlan. Only the options that affect
+ * whether an archive can be used (the classpath, the boot classpath and the gc) are part of it, so that e.g. script.name
+ * does not give each script an archive of its own. Returns NULL on error. Freeing the returned value is up to the caller.
+ * @param launcherOptionCount the number of options given by the launcher and the user. The ones after those tune the jvm
+ *                            for a particular run (e.g. depending on the run history) and are not part of the key. */
+char* jst_createSharedArchiveKey( JstJvmOptions* jvmOptions, int launcherOptionCount, const char* javaHome ) ;
+
+/** Adds the jvm option to use an up to date archive for the given jvm options, or to create one if there is none.
+ * If the user has given any class data sharing options, nothing is done.
+ * Call jst_finishSharedArchive after the jvm has been destroyed, whatever the return value.
+ * @param jvmOptions the complete set of jvm options, including the classpath
+ * @param launcherOptionCount see jst_createSharedArchiveKey
+ * @return 0 on error (err msg printed). Not being able to use an archive is not an error. */
+int jst_addSharedArchiveOption( JstSharedArchive* archive, JstJvmOptions* jvmOptions, int launcherOptionCount, const char* javaHome ) ;
+
+/** If this was a training run, moves the archive written by the jvm into place and records what it was created from.
+ * Frees the memory held by the given struct. */
+void jst_finishSharedArchive( JstSharedArchive* archive ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
@@ -0,0 +1,353 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#if defined( __linux__ )
+// for the cpu affinity macros
+#  define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#if defined( __linux__ )
+#  include <unistd.h>
+#  include <sched.h>
+#endif
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_cgroup.h"
+
+extern int jst_countCpus( const char* cpuList ) {
+  int count = 0 ;
+
+  while ( isdigit( (unsigned char)*cpuList ) ) {
+    char *end ;
+    long first = strtol( cpuList, &end, 10 ),
+         last  = first ;
+
+    if ( *end == '-' ) last = strtol( end + 1, &end, 10 ) ;
+    if ( last >= first ) count += (int)( last - first + 1 ) ;
+
+    if ( *end != ',' ) break ;
+    cpuList = end + 1 ;
+  }
+
+  return count ;
+}
+
+extern int jst_parseJavaUpdateVersion( const char* version, int majorVersion ) {
+  const char* update ;
+
+  if ( majorVersion <= 8 ) {
+    update = strchr( version, '_' ) ;
+  } else {
+    // feature.interim.update.patch
+    update = strchr( version, '.' ) ;
+    if ( update ) update = strchr( update + 1, '.' ) ;
+  }
+
+  return update ? atoi( update + 1 ) : 0 ;
+}
+
+extern JstCgroupSupport jst_getCgroupSupport( const char* version ) {
+  int majorVersion  = jst_parseJavaMajorVersion( version ),
+      updateVersion = jst_parseJavaUpdateVersion( version, majorVersion ) ;
+
+  if ( majorVersion >= 15 || ( majorVersion == 11 && updateVersion >= 16 ) || ( majorVersion == 8 && updateVersion >= 372 ) ) {
+    return JST_CGROUP_V2_SUPPORTED ;
+  }
+  if ( majorVersion >= 10 || ( majorVersion == 8 && updateVersion >= 191 ) ) return JST_CGROUP_ACTIVE_PROCESSOR_COUNT ;
+
+  return JST_CGROUP_UNSUPPORTED ;
+}
+
+#if !defined( __linux__ )
+
+extern int jst_addCgroupSizingOptions( JstJvmOptions* jvmOptions, const char* javaHome ) {
+  return 1 ;
+}
+
+#else
+
+#define PROC_MOUNTS "/proc/self/mounts"
+#define PROC_CGROUP "/proc/self/cgroup"
+
+/** Max length of the lines read from the proc and cgroup files, and of the path of the cgroup dir. */
+#define MAX_LINE_LENGTH 4096
+
+typedef struct {
+  /** memory.max, 0 if not limited */
+  jlong memory ;
+  /** cpu.max quota divided by the period, rounded up. 0 if not limited. */
+  int   quotaCpus ;
+  /** The number of cpus in cpuset.cpus.effective, 0 if not known. */
+  int   cpusetCpus ;
+} CgroupLimits ;
+
+/** The options added. These must live until the jvm has been created. */
+static char maxRamOption[ 40 ],
+            activeProcessorCountOption[ 48 ],
+            parallelGCThreadsOption[ 48 ],
+            ciCompilerCountOption[ 48 ] ;
+
+/** Reads the first line of the given file in the given dir into the given buffer, w/out the newline. Returns 0 if the file
+ * can not be read. */
+static int readCgroupFile( const char* dir, const char* name, char* line ) {
+  char  fileName[ MAX_LINE_LENGTH + 32 ] ;
+  FILE* file ;
+  int   found ;
+
+  sprintf( fileName, "%s/%s", dir, name ) ;
+
+  if ( !( file = fopen( fileName, "r" ) ) ) return 0 ;
+  found = fgets( line, MAX_LINE_LENGTH, file ) != NULL ;
+  fclose( file ) ;
+
+  if ( found ) line[ strcspn( line, "\n" ) ] = '\0' ;
+  return found ;
+}
+
+/** Returns the dir of the cgroup of this process in the unified (v2) hierarchy and sets *rootLength to the length of the
+ * mount point of the hierarchy in it. Returns NULL if there is no such hierarchy or on error. Freeing the returned value is
+ * up to the caller. */
+static char* findCgroupDir( size_t* rootLength ) {
+  char  line[ MAX_LINE_LENGTH ],
+        mountPoint[ MAX_LINE_LENGTH ],
+        *cgroupDir = NULL ;
+  FILE* file ;
+
+  mountPoint[ 0 ] = '\0' ;
+
+  // a line like "cgroup2 /sys/fs/cgroup cgroup2 rw,nosuid,nodev,noexec 0 0"
+  if ( !( file = fopen( PROC_MOUNTS, "r" ) ) ) return NULL ;
+  while ( fgets( line, sizeof( line ), file ) ) {
+    char *mountDir = strchr( line, ' ' ),
+         *fsType   = mountDir ? strchr( mountDir + 1, ' ' ) : NULL ;
+
+    if ( fsType && strncmp( fsType + 1, "cgroup2 ", 8 ) == 0 ) {
+      *fsType = '\0' ;
+      strcpy( mountPoint, mountDir + 1 ) ;
+      break ;
+    }
+  }
+  fclose( file ) ;
+
+  if ( !mountPoint[ 0 ] ) return NULL ;
+
+  // a line like "0::/user.slice/user-1000.slice/session-2.scope", the root being "0::/"
+  if ( !( file = fopen( PROC_CGROUP, "r" ) ) ) return NULL ;
+  while ( fgets( line, sizeof( line ), file ) ) {
+    if ( strncmp( line, "0::/", 4 ) == 0 ) {
+      line[ strcspn( line, "\n" ) ] = '\0' ;
+      if ( strlen( mountPoint ) + strlen( line ) < MAX_LINE_LENGTH ) cgroupDir = jst_append( NULL, NULL, mountPoint, line + 3, NULL ) ;
+      break ;
+    }
+  }
+  fclose( file ) ;
+
+  *rootLength = strlen( mountPoint ) ;
+  return cgroupDir ;
+}
+
+/** The limits of the given cgroup and all its ancestors apply, so the smallest ones are taken. The cpuset is taken from the
+ * nearest one that has the cpuset controller enabled, as its effective cpus already take the ancestors into account. */
+static void readLimits( char* cgroupDir, size_t rootLength, CgroupLimits* limits ) {
+  char line[ MAX_LINE_LENGTH ] ;
+
+  memset( limits, 0, sizeof( *limits ) ) ;
+
+  while ( strlen( cgroupDir ) > rootLength && cgroupDir[ strlen( cgroupDir ) - 1 ] == '/' ) cgroupDir[ strlen( cgroupDir ) - 1 ] = '\0' ;
+
+  for ( ;; ) {
+    char* slash ;
+
+    if ( readCgroupFile( cgroupDir, "memory.max", line ) && isdigit( (unsigned char)line[ 0 ] ) ) {
+      jlong memory = (jlong)strtod( line, NULL ) ;
+      if ( memory > 0 && ( !limits->memory || memory < limits->memory ) ) limits->memory = memory ;
+    }
+
+    // "<quota> <period>", the quota being "max" if not limited
+    if ( readCgroupFile( cgroupDir, "cpu.max", line ) && isdigit( (unsigned char)line[ 0 ] ) ) {
+      char *period ;
+      long quota = strtol( line, &period, 10 ),
+           periodLength = strtol( period, NULL, 10 ) ;
+
+      if ( quota > 0 && periodLength > 0 ) {
+        int cpus = (int)( ( quota + periodLength - 1 ) / periodLength ) ;
+        if ( !limits->quotaCpus || cpus < limits->quotaCpus ) limits->quotaCpus = cpus ;
+      }
+    }
+
+    if ( !limits->cpusetCpus && readCgroupFile( cgroupDir, "cpuset.cpus.effective", line ) ) limits->cpusetCpus = jst_countCpus( line ) ;
+
+    if ( !( slash = strrchr( cgroupDir, '/' ) ) || (size_t)( slash - cgroupDir ) < rootLength ) break ;
+    *slash = '\0' ;
+  }
+}
+
+static const char* containerSupportOffOptions[]    = { "-XX:-UseContainerSupport", NULL } ;
+static const char* heapSizeOptions[]               = { "-Xmx", "-XX:MaxHeapSize=", "-XX:MaxRAM=", NULL } ;
+static const char* activeProcessorCountOptions[]   = { "-XX:ActiveProcessorCount=", NULL } ;
+static const char* parallelGCThreadsOptions[]      = { "-XX:ParallelGCThreads=", NULL } ;
+static const char* ciCompilerCountOptions[]        = { "-XX:CICompilerCount=", NULL } ;
+
+/** Appends the given option (one of the static buffers above) unless the user has given one of the given options. */
+static int addOption( JstJvmOptions* jvmOptions, char* option, const char** userOptions ) {
+  const char* userOption = jst_findJvmOption( jvmOptions, userOptions ) ;
+
+  if ( userOption ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not adding %s, the user has given %s\n", option, userOption ) ;
+    return 1 ;
+  }
+
+  if ( _jst_debug ) fprintf( stderr, "debug: sizing the jvm to the cgroup limits w/ %s\n", option ) ;
+  return appendJvmOption( jvmOptions, option, NULL ) ? 1 : 0 ;
+}
+
+/** The gc thread count the jvm would use for the given number of cpus. */
+static int parallelGCThreads( int cpus ) {
+  return ( cpus <= 8 ) ? cpus : 8 + ( cpus - 8 ) * 5 / 8 ;
+}
+
+static int log2OfInt( int value ) {
+  int log = 0 ;
+  while ( value > 1 ) {
+    value >>= 1 ;
+    log++ ;
+  }
+  return log ;
+}
+
+/** The jit compiler thread count the jvm would use for the given number of cpus w/ tiered compilation, which needs at least 2. */
+static int ciCompilerCount( int cpus ) {
+  int logCpus    = log2OfInt( cpus ),
+      logLogCpus = log2OfInt( logCpus > 1 ? logCpus : 1 ),
+      count      = logCpus * logLogCpus * 3 / 2 ;
+
+  return ( count < 2 ) ? 2 : count ;
+}
+
+/** Binds this thread (and so the threads it creates) to the given number of the cpus it may now run on. The cpus taken are
+ * rotated by the pid so that launchers started at the same time do not all end up on the same cpus. */
+static void pinCpus( int cpuCount ) {
+  cpu_set_t current,
+            pinned ;
+  int       available,
+            skip,
+            count = 0,
+            cpu ;
+
+  if ( sched_getaffinity( 0, sizeof( current ), &current ) || ( available = CPU_COUNT( &current ) ) <= cpuCount ) return ;
+
+  CPU_ZERO( &pinned ) ;
+  skip = (int)( getpid() % available ) ;
+
+  // two rounds, as the cpus skipped at the start may be needed at the end
+  for ( cpu = 0 ; count < cpuCount && cpu < 2 * CPU_SETSIZE ; cpu++ ) {
+    if ( !CPU_ISSET( cpu % CPU_SETSIZE, &current ) ) continue ;
+    if ( skip > 0 ) {
+      skip-- ;
+      continue ;
+    }
+    if ( !CPU_ISSET( cpu % CPU_SETSIZE, &pinned ) ) {
+      CPU_SET( cpu % CPU_SETSIZE, &pinned ) ;
+      count++ ;
+    }
+  }
+
+  if ( sched_setaffinity( 0, sizeof( pinned ), &pinned ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: could not bind the launcher to %d cpus\n", cpuCount ) ;
+  } else if ( _jst_debug ) {
+    fprintf( stderr, "debug: bound the launcher to %d of %d cpus\n", cpuCount, available ) ;
+  }
+}
+
+extern int jst_addCgroupSizingOptions( JstJvmOptions* jvmOptions, const char* javaHome ) {
+  CgroupLimits     limits ;
+  JstCgroupSupport support ;
+  char             *cgroupDir,
+                   *version = NULL ;
+  size_t           rootLength = 0 ;
+  int              cpus ;
+  long             hostCpus  = sysconf( _SC_NPROCESSORS_ONLN ),
+                   pageSize  = sysconf( _SC_PAGESIZE ),
+                   pageCount = sysconf( _SC_PHYS_PAGES ) ;
+  jlong            hostMemory = ( pageSize > 0 && pageCount > 0 ) ? (jlong)pageSize * pageCount : 0 ;
+  int              rval = 1 ;
+
+  if ( !javaHome || getenv( JST_NOCGROUP_ENV_VAR_NAME ) || jst_findJvmOption( jvmOptions, containerSupportOffOptions ) ) return 1 ;
+
+  if ( !( cgroupDir = findCgroupDir( &rootLength ) ) ) return 1 ;
+  if ( _jst_debug ) fprintf( stderr, "debug: reading the limits of cgroup %s\n", cgroupDir ) ;
+  readLimits( cgroupDir, rootLength, &limits ) ;
+
+  cpus = limits.quotaCpus ;
+  if ( limits.cpusetCpus && ( !cpus || limits.cpusetCpus < cpus ) ) cpus = limits.cpusetCpus ;
+  // limits no smaller than what the host has make no difference
+  if ( hostCpus > 0 && cpus >= hostCpus ) cpus = 0 ;
+  if ( hostMemory && limits.memory >= hostMemory ) limits.memory = 0 ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: cgroup limits: memory.max %ld MB, cpu.max %d cpus, cpuset %d cpus (the host has %ld MB, %ld cpus)\n",
+                             (long)( limits.memory >> 20 ), limits.quotaCpus, limits.cpusetCpus, (long)( hostMemory >> 20 ), hostCpus ) ;
+
+  if ( !limits.memory && !cpus ) goto end ;
+
+  if ( !( version = jst_getJavaVersion( javaHome ) ) || !jst_parseJavaMajorVersion( version ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not sizing the jvm to the cgroup limits, the java version in %s is not known\n", javaHome ) ;
+    goto end ;
+  }
+  support = jst_getCgroupSupport( version ) ;
+
+  if ( support == JST_CGROUP_V2_SUPPORTED ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not sizing the jvm to the cgroup limits, java %s does that itself\n", version ) ;
+    goto end ;
+  }
+
+  rval = 0 ;
+
+  if ( limits.memory ) {
+    sprintf( maxRamOption, "-XX:MaxRAM=%ldm", (long)( limits.memory >> 20 ) ) ;
+    if ( !addOption( jvmOptions, maxRamOption, heapSizeOptions ) ) goto end ;
+  }
+
+  if ( cpus ) {
+    if ( support == JST_CGROUP_ACTIVE_PROCESSOR_COUNT ) {
+      // the jvm derives the gc and jit thread counts from this
+      sprintf( activeProcessorCountOption, "-XX:ActiveProcessorCount=%d", cpus ) ;
+      if ( !addOption( jvmOptions, activeProcessorCountOption, activeProcessorCountOptions ) ) goto end ;
+    } else {
+      sprintf( parallelGCThreadsOption, "-XX:ParallelGCThreads=%d", parallelGCThreads( cpus ) ) ;
+      sprintf( ciCompilerCountOption, "-XX:CICompilerCount=%d", ciCompilerCount( cpus ) ) ;
+      if ( !addOption( jvmOptions, parallelGCThreadsOption, parallelGCThreadsOptions ) ||
+           !addOption( jvmOptions, ciCompilerCountOption, ciCompilerCountOptions ) ) goto end ;
+    }
+
+    if ( getenv( JST_PINCPUS_ENV_VAR_NAME ) ) pinCpus( cpus ) ;
+  }
+
+  rval = 1 ;
+
+  end:
+  free( cgroupDir ) ;
+  if ( version ) free( version ) ;
+
+  return rval ;
+}
+
+#endif
@@ -0,0 +1,71 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Sizing the jvm to the cgroup (v2) limits of the launcher, e.g. when run in a container. Jvms older than java 15, 11.0.16
+// and 8u372 do not know about cgroup v2, so they size the heap and the gc and jit thread pools from the totals of the host,
+// which gets them oom killed and oversubscribes the cpus they are given. For such jvms the limits are read from cpu.max,
+// cpuset.cpus.effective and memory.max of the cgroup of this process and its ancestors, and given to the jvm as
+//   -XX:MaxRAM, from which the jvm sizes the heap as it would from the physical memory
+//   -XX:ActiveProcessorCount (8u191+ and 10+), or else -XX:ParallelGCThreads and -XX:CICompilerCount
+// Any of these the user has given (or -Xmx / -XX:MaxHeapSize instead of -XX:MaxRAM) are left alone, as is everything if
+// -XX:-UseContainerSupport is given. Only supported on linux, nothing is done elsewhere.
+
+#if !defined( _JST_CGROUP_H_ )
+#  define _JST_CGROUP_H_
+
+#include "jvmstarter.h"
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** If this env var is set, the jvm is not sized to the cgroup limits. */
+#define JST_NOCGROUP_ENV_VAR_NAME "__JLAUNCHER_NOCGROUP"
+
+/** If this env var is set, the launcher (and so the jvm it starts) is also bound to as many cpus as the cgroup cpu quota
+ * allows, so the threads of the jvm do not get throttled while spread over more cpus than they can use. */
+#define JST_PINCPUS_ENV_VAR_NAME "__JLAUNCHER_PIN_CPUS"
+
+/** What a jvm knows of the cgroup limits, see above. */
+typedef enum {
+  /** sizes itself from the totals of the host, the gc and jit thread counts are to be given */
+  JST_CGROUP_UNSUPPORTED,
+  /** does not know cgroup v2, but takes the cpu count w/ -XX:ActiveProcessorCount */
+  JST_CGROUP_ACTIVE_PROCESSOR_COUNT,
+  /** sizes itself to the cgroup v2 limits */
+  JST_CGROUP_V2_SUPPORTED
+} JstCgroupSupport ;
+
+/** Returns the number of cpus in the given cpu list (as in cpuset.cpus.effective), e.g. 7 for "0-3,8,10-11". */
+int jst_countCpus( const char* cpuList ) ;
+
+/** Returns the update of the given java version, e.g. 372 for "1.8.0_372" and 16 for "11.0.16.1". 0 if there is none. */
+int jst_parseJavaUpdateVersion( const char* version, int majorVersion ) ;
+
+/** Returns what a jvm of the given version (e.g. "1.8.0_372" or "11.0.16") knows of the cgroup limits. */
+JstCgroupSupport jst_getCgroupSupport( const char* version ) ;
+
+/** Appends the options sizing the jvm to the cgroup limits of this process (see above) to the given ones, which must
+ * already contain all the jvm options given by the user. The choices made are reported in debug output.
+ * @param javaHome the java installation to be started, whose version tells whether it sizes itself
+ * @return 0 on error (err msg printed). Not being able to read the limits is not an error, nothing is done then. */
+int jst_addCgroupSizingOptions( JstJvmOptions* jvmOptions, const char* javaHome ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
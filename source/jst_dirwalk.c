@@ -0,0 +1,470 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if !defined( _WIN32 )
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <dirent.h>
+#  include <pthread.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#endif
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_stringutils.h"
+#include "jst_trace.h"
+#include "jst_dirwalk.h"
+
+#if !defined( _WIN32 )
+
+/** The max number of threads reading dirs, including the calling thread. Reading dirs is mostly waiting for the disk,
+ * a handful of threads is enough to keep it busy. */
+#define MAX_WALKER_THREADS 4
+
+/** The dirs waiting to be read are kept open so that they can be opened relative to their parent. Past this many, the
+ * rest are opened by path when their turn comes, so a wide tree does not run the process out of file descriptors. */
+#define MAX_QUEUED_DIR_FDS 256
+
+/** A dir in the tree being searched. Filled in by the thread that reads the dir. */
+typedef struct DirNode_ DirNode ;
+struct DirNode_ {
+  char*     path ;
+  DirNode*  parent ;
+  dev_t     device ;
+  ino_t     inode ;
+  /** NULL terminated, sorted. NULL if the dir could not be read. */
+  char**    jars ;
+  /** the subdirs, in the order of their names */
+  DirNode** children ;
+  int       childCount ;
+} ;
+
+typedef struct {
+  DirNode* node ;
+  /** -1 if the dir is to be opened by path */
+  int      fd ;
+} DirWork ;
+
+typedef struct {
+  pthread_mutex_t lock ;
+  /** signaled when there is more work or when the walk is over */
+  pthread_cond_t  changed ;
+  /** The dirs waiting to be read. Used as a stack, so the walk goes mostly depth first and the queue stays short. */
+  DirWork*        work ;
+  size_t          workCount,
+                  workCapacity ;
+  int             queuedFds ;
+  int             busyThreads ;
+  jboolean        errorOccurred ;
+  int             (*filter)( const char* dirname, const char* filename ) ;
+} DirWalk ;
+
+/** What is needed while reporting the jars found. */
+typedef struct {
+  /** The dirs reported so far, a hash set keyed on their device and inode (open addressing). The capacity is a
+   * power of two, NULL marks a free slot. */
+  DirNode**       reported ;
+  size_t          reportedCount,
+                  reportedCapacity ;
+  int             jarCount ;
+  int             (*jarFound)( void* context, const char* dirName, const char* jarName ) ;
+  void*           context ;
+} JarReport ;
+
+#endif
+
+static int compareNames( const void* name1, const void* name2 ) {
+  return strcmp( *(const char**)name1, *(const char**)name2 ) ;
+}
+
+#if !defined( _WIN32 )
+
+/** @param parent may be NULL, in which case the given name is the whole path. */
+static DirNode* createDirNode( DirNode* parent, const char* name, const struct stat* dirStat ) {
+  DirNode* node = jst_calloc( 1, sizeof( DirNode ) ) ;
+
+  if ( node && !( node->path = parent ? jst_createFileName( parent->path, name, NULL ) : jst_strdup( name ) ) ) {
+    free( node ) ;
+    return NULL ;
+  }
+
+  if ( node ) {
+    node->parent = parent ;
+    node->device = dirStat->st_dev ;
+    node->inode  = dirStat->st_ino ;
+  }
+
+  return node ;
+}
+
+/** Returns true if the given dir is the given node or one of its parents, i.e. going into it would go round in a loop. */
+static jboolean isAncestor( DirNode* node, const struct stat* dirStat ) {
+  for ( ; node ; node = node->parent ) {
+    if ( node->inode == dirStat->st_ino && node->device == dirStat->st_dev ) return JNI_TRUE ;
+  }
+  return JNI_FALSE ;
+}
+
+static void freeDirTree( DirNode* node ) {
+  int i ;
+
+  for ( i = 0 ; i < node->childCount ; i++ ) freeDirTree( node->children[ i ] ) ;
+
+  if ( node->jars     ) jst_freeAll( (void***)(void*)&node->jars ) ;
+  if ( node->children ) free( node->children ) ;
+  free( node->path ) ;
+  free( node ) ;
+}
+
+static size_t hashDir( dev_t device, ino_t inode ) {
+  return (size_t)( ( (unsigned long)inode * 2654435761UL ) ^ (unsigned long)device ) ;
+}
+
+/** Adds the given dir to the set of those reported. Returns 1 if it was added, 0 if it was there already, -1 on error. */
+static int markReported( JarReport* report, DirNode* node ) {
+  DirNode** slot ;
+  size_t    mask,
+            i ;
+
+  // kept at most half full so that the probe sequences stay short
+  if ( ( report->reportedCount + 1 ) * 2 > report->reportedCapacity ) {
+    DirNode** old         = report->reported ;
+    size_t    oldCapacity = report->reportedCapacity ;
+
+    report->reportedCapacity = oldCapacity ? oldCapacity * 2 : 64 ;
+    if ( !( report->reported = jst_calloc( report->reportedCapacity, sizeof( DirNode* ) ) ) ) {
+      report->reported         = old ;
+      report->reportedCapacity = oldCapacity ;
+      return -1 ;
+    }
+
+    mask = report->reportedCapacity - 1 ;
+    for ( i = 0 ; i < oldCapacity ; i++ ) {
+      DirNode* moved = old[ i ] ;
+      size_t   j ;
+      if ( !moved ) continue ;
+      for ( j = hashDir( moved->device, moved->inode ) & mask ; report->reported[ j ] ; j = ( j + 1 ) & mask ) ;
+      report->reported[ j ] = moved ;
+    }
+
+    if ( old ) free( old ) ;
+  }
+
+  mask = report->reportedCapacity - 1 ;
+  for ( i = hashDir( node->device, node->inode ) & mask ; *( slot = report->reported + i ) ; i = ( i + 1 ) & mask ) {
+    if ( (*slot)->inode == node->inode && (*slot)->device == node->device ) return 0 ;
+  }
+
+  *slot = node ;
+  report->reportedCount++ ;
+
+  return 1 ;
+}
+
+/** Calls jarFound for the jars in the given tree, in order. A dir that was reached via several paths is reported
+ * the first time only. Deciding that here rather than while reading the dirs keeps the result independent of which
+ * thread got to a dir first. Returns 0 on error or if jarFound does. */
+static int reportJars( JarReport* report, DirNode* node ) {
+  int i,
+      added = markReported( report, node ) ;
+
+  if ( added == -1 ) return 0 ;
+  if ( !added      ) return 1 ;
+
+  for ( i = 0 ; node->jars && node->jars[ i ] ; i++ ) {
+    report->jarCount++ ;
+    if ( !report->jarFound( report->context, node->path, node->jars[ i ] ) ) return 0 ;
+  }
+
+  for ( i = 0 ; i < node->childCount ; i++ ) {
+    if ( !reportJars( report, node->children[ i ] ) ) return 0 ;
+  }
+
+  return 1 ;
+}
+
+/** Must be called w/ the lock held. Returns 0 on error, in which case the given fd has been closed. */
+static int pushWork( DirWalk* walk, DirNode* node, int fd ) {
+  DirWork* work ;
+
+  if ( fd != -1 && walk->queuedFds >= MAX_QUEUED_DIR_FDS ) {
+    close( fd ) ;
+    fd = -1 ;
+  }
+
+  if ( !( work = jst_ensureArrayCapacity( walk->work, &walk->workCapacity, walk->workCount + 1, sizeof( DirWork ) ) ) ) {
+    if ( fd != -1 ) close( fd ) ;
+    return 0 ;
+  }
+
+  walk->work = work ;
+  walk->work[ walk->workCount   ].node = node ;
+  walk->work[ walk->workCount++ ].fd   = fd ;
+  if ( fd != -1 ) walk->queuedFds++ ;
+
+  pthread_cond_signal( &walk->changed ) ;
+
+  return 1 ;
+}
+
+/** Reads the given dir, collecting its jars and queueing its subdirs. A dir that can not be read is skipped.
+ * Returns 0 on error. */
+static int readDir( DirWalk* walk, DirWork* work ) {
+  DirNode                *node = work->node ;
+  DIR                    *dir  = NULL ;
+  struct dirent          *entry ;
+  struct stat            entryStat ;
+  JstDynamicPointerArray jars,
+                         subdirs ;
+  int                    fd   = work->fd,
+                         rval = 0 ;
+  size_t                 i ;
+
+  memset( &jars,    0, sizeof( jars ) ) ;
+  memset( &subdirs, 0, sizeof( subdirs ) ) ;
+
+  if ( fd == -1 ) fd = open( node->path, O_RDONLY | O_DIRECTORY ) ;
+  if ( fd == -1 || !( dir = fdopendir( fd ) ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: skipping dir %s: %s\n", node->path, strerror( errno ) ) ;
+    if ( fd != -1 ) close( fd ) ;
+    return 1 ;
+  }
+
+  if ( !jst_initializeDynamicPointerArray( &jars, 0 ) || !jst_initializeDynamicPointerArray( &subdirs, 0 ) ) goto end ;
+
+  while ( ( entry = readdir( dir ) ) ) {
+    char *name = entry->d_name,
+         *copy ;
+    int  isDir = -1 ;
+
+    if ( strcmp( name, "." ) == 0 || strcmp( name, ".." ) == 0 ) continue ;
+
+#if defined( DT_DIR )
+    if ( entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK ) isDir = ( entry->d_type == DT_DIR ) ? 1 : 0 ;
+#endif
+    if ( isDir == -1 ) {
+      // follows symlinks. Dangling ones are skipped.
+      if ( fstatat( dirfd( dir ), name, &entryStat, 0 ) ) continue ;
+      isDir = S_ISDIR( entryStat.st_mode ) ? 1 : 0 ;
+    }
+
+    if ( !isDir && ( !jst_endsWith( name, ".jar" ) || ( walk->filter && !walk->filter( node->path, name ) ) ) ) continue ;
+
+    if ( !( copy = jst_strdup( name ) ) ) goto end ;
+    if ( !jst_appendPointerToDynamicArray( isDir ? &subdirs : &jars, copy ) ) {
+      free( copy ) ;
+      goto end ;
+    }
+  }
+
+  qsort( jars.pointers,    jars.count,    sizeof( void* ), compareNames ) ;
+  qsort( subdirs.pointers, subdirs.count, sizeof( void* ), compareNames ) ;
+
+  node->jars = (char**)jars.pointers ;
+  memset( &jars, 0, sizeof( jars ) ) ;
+
+  if ( subdirs.count && !( node->children = jst_calloc( subdirs.count, sizeof( DirNode* ) ) ) ) goto end ;
+
+  for ( i = 0 ; i < subdirs.count ; i++ ) {
+    char    *name   = (char*)subdirs.pointers[ i ] ;
+    int     childFd = openat( dirfd( dir ), name, O_RDONLY | O_DIRECTORY ),
+            queued ;
+    DirNode *child ;
+
+    if ( childFd == -1 || fstat( childFd, &entryStat ) ) {
+      if ( _jst_debug ) fprintf( stderr, "debug: skipping dir %s%s%s: %s\n", node->path, JST_FILE_SEPARATOR, name, strerror( errno ) ) ;
+      if ( childFd != -1 ) close( childFd ) ;
+      continue ;
+    }
+
+    if ( isAncestor( node, &entryStat ) ) {
+      if ( _jst_debug ) fprintf( stderr, "debug: not following %s%s%s, it leads back to a parent dir\n", node->path, JST_FILE_SEPARATOR, name ) ;
+      close( childFd ) ;
+      continue ;
+    }
+
+    if ( !( child = createDirNode( node, name, &entryStat ) ) ) {
+      close( childFd ) ;
+      goto end ;
+    }
+    // attached before queueing, so that it is freed along w/ the tree whatever happens
+    node->children[ node->childCount++ ] = child ;
+
+    pthread_mutex_lock( &walk->lock ) ;
+    queued = pushWork( walk, child, childFd ) ;
+    pthread_mutex_unlock( &walk->lock ) ;
+    if ( !queued ) goto end ;
+  }
+
+  rval = 1 ;
+
+  end:
+  closedir( dir ) ;
+  jst_freeDynamicArray( &jars,    JNI_TRUE ) ;
+  jst_freeDynamicArray( &subdirs, JNI_TRUE ) ;
+
+  return rval ;
+}
+
+/** Reads dirs until there are none left (or an error occurs). Run by each of the threads, including the calling one. */
+static void* walkerThread( void* arg ) {
+  DirWalk* walk = (DirWalk*)arg ;
+  DirWork  work ;
+  int      ok ;
+
+  pthread_mutex_lock( &walk->lock ) ;
+
+  for ( ;; ) {
+    // only a thread reading a dir can find more dirs, so when none are, the walk is over
+    while ( !walk->workCount && walk->busyThreads && !walk->errorOccurred ) pthread_cond_wait( &walk->changed, &walk->lock ) ;
+    if ( !walk->workCount || walk->errorOccurred ) break ;
+
+    work = walk->work[ --walk->workCount ] ;
+    if ( work.fd != -1 ) walk->queuedFds-- ;
+    walk->busyThreads++ ;
+    pthread_mutex_unlock( &walk->lock ) ;
+
+    ok = readDir( walk, &work ) ;
+
+    pthread_mutex_lock( &walk->lock ) ;
+    walk->busyThreads-- ;
+    if ( !ok ) walk->errorOccurred = JNI_TRUE ;
+    if ( walk->errorOccurred || ( !walk->workCount && !walk->busyThreads ) ) pthread_cond_broadcast( &walk->changed ) ;
+  }
+
+  pthread_mutex_unlock( &walk->lock ) ;
+
+  return NULL ;
+}
+
+extern int jst_findJarsRecursively( const char* dirName, int (*filter)( const char* dirname, const char* filename ),
+                                    int (*jarFound)( void* context, const char* dirName, const char* jarName ), void* context ) {
+  DirWalk     walk ;
+  JarReport   report ;
+  DirNode     *root = NULL ;
+  pthread_t   threads[ MAX_WALKER_THREADS - 1 ] ;
+  struct stat dirStat ;
+  jlong       startTime   = jst_monotonicMicros() ;
+  long        cpuCount    = sysconf( _SC_NPROCESSORS_ONLN ) ;
+  int         threadCount = 0,
+              fd,
+              rval = 0 ;
+  size_t      i ;
+
+  if ( ( fd = open( dirName, O_RDONLY | O_DIRECTORY ) ) == -1 || fstat( fd, &dirStat ) ) {
+    fprintf( stderr, "error: could not open directory %s\n%s\n", dirName, strerror( errno ) ) ;
+    if ( fd != -1 ) close( fd ) ;
+    return 0 ;
+  }
+
+  memset( &walk,   0, sizeof( walk ) ) ;
+  memset( &report, 0, sizeof( report ) ) ;
+  walk.filter     = filter ;
+  report.jarFound = jarFound ;
+  report.context  = context ;
+  pthread_mutex_init( &walk.lock, NULL ) ;
+  pthread_cond_init( &walk.changed, NULL ) ;
+
+  if ( !( root = createDirNode( NULL, dirName, &dirStat ) ) ) {
+    close( fd ) ;
+    goto end ;
+  }
+  if ( !pushWork( &walk, root, fd ) ) goto end ;
+
+  for ( ; threadCount < MAX_WALKER_THREADS - 1 && threadCount < cpuCount - 1 ; threadCount++ ) {
+    if ( pthread_create( &threads[ threadCount ], NULL, walkerThread, &walk ) ) break ;
+  }
+
+  walkerThread( &walk ) ;
+
+  for ( i = 0 ; i < (size_t)threadCount ; i++ ) pthread_join( threads[ i ], NULL ) ;
+
+  // left over if the walk was stopped by an error
+  for ( i = 0 ; i < walk.workCount ; i++ ) {
+    if ( walk.work[ i ].fd != -1 ) close( walk.work[ i ].fd ) ;
+  }
+
+  if ( walk.errorOccurred || !( rval = reportJars( &report, root ) ) ) goto end ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: found %d jars in %d dirs under %s in %.1f ms using %d threads\n",
+                             report.jarCount, (int)report.reportedCount, dirName, ( jst_monotonicMicros() - startTime ) / 1000.0, threadCount + 1 ) ;
+
+  end:
+  if ( root            ) freeDirTree( root ) ;
+  if ( walk.work       ) free( walk.work ) ;
+  if ( report.reported ) free( report.reported ) ;
+  pthread_cond_destroy( &walk.changed ) ;
+  pthread_mutex_destroy( &walk.lock ) ;
+
+  return rval ;
+}
+
+#else
+
+/** Windows has no openat, and getting the unique id of a dir takes opening it, so the tree is gone through sequentially.
+ * Junctions are not followed back to a dir already visited, as windows does not list them as dirs. */
+static int findJars( const char* dirName, int (*filter)( const char* dirname, const char* filename ),
+                     int (*jarFound)( void* context, const char* dirName, const char* jarName ), void* context, int* dirCount, int* jarCount ) {
+  char **names,
+       **name,
+       *subdir ;
+  int  rval = 1 ;
+
+  (*dirCount)++ ;
+
+  if ( !( names = jst_getFileNamesOfType( (char*)dirName, NULL, ".jar", JST_FILE_ENTRY, filter ) ) ) return 0 ;
+  for ( name = names ; *name && rval ; name++ ) {
+    (*jarCount)++ ;
+    rval = jarFound( context, dirName, *name ) ;
+  }
+  free( names ) ;
+
+  if ( !rval || !( names = jst_getFileNamesOfType( (char*)dirName, NULL, NULL, JST_DIR_ENTRY, NULL ) ) ) return 0 ;
+  for ( name = names ; *name && rval ; name++ ) {
+    if ( !( subdir = jst_createFileName( dirName, *name, NULL ) ) ) {
+      rval = 0 ;
+      break ;
+    }
+    rval = findJars( subdir, filter, jarFound, context, dirCount, jarCount ) ;
+    free( subdir ) ;
+  }
+  free( names ) ;
+
+  return rval ;
+}
+
+extern int jst_findJarsRecursively( const char* dirName, int (*filter)( const char* dirname, const char* filename ),
+                                    int (*jarFound)( void* context, const char* dirName, const char* jarName ), void* context ) {
+  jlong startTime = jst_monotonicMicros() ;
+  int   dirCount  = 0,
+        jarCount  = 0,
+        rval      = findJars( dirName, filter, jarFound, context, &dirCount, &jarCount ) ;
+
+  if ( rval && _jst_debug ) fprintf( stderr, "debug: found %d jars in %d dirs under %s in %.1f ms\n",
+                                     jarCount, dirCount, dirName, ( jst_monotonicMicros() - startTime ) / 1000.0 ) ;
+
+  return rval ;
+}
+
+#endif
@@ -0,0 +1,47 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+
+// Recursive search for jars under a dir tree, e.g. an app w/ plugins that each have their own lib dir.
+// On posix systems the subdirs are read in parallel by a small pool of threads, each dir relative to the already open
+// parent dir. However the work happens to be divided between the threads, the jars are reported in the same order:
+// the jars in a dir first (sorted by name), then those under each of its subdirs (also in the order of the subdir names).
+//
+// Symlinks are followed, except those leading back to a dir being gone through (which would make the walk go round in
+// a loop). The jars of a dir reachable through several paths are only reported once, under the first path in the above
+// order.
+
+#if !defined( _JST_DIRWALK_H_ )
+#  define _JST_DIRWALK_H_
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** Finds the jars under the given dir and all of its subdirs.
+ * @param filter may be NULL. Called w/ the dir a jar is in and the name of the jar, returns 0 if the jar is to be left out.
+ *        Note that this is called from several threads at once.
+ * @param jarFound called for each jar found (from the calling thread, in the order described above) w/ the given context,
+ *        the dir and the name of the jar. Returning 0 stops the search and makes this func return 0.
+ * @return 0 on error (err msg printed). Subdirs that can not be read are skipped. */
+int jst_findJarsRecursively( const char* dirName, int (*filter)( const char* dirname, const char* filename ),
+                             int (*jarFound)( void* context, const char* dirName, const char* jarName ), void* context ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
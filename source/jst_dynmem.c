@@ -58,25 +58,38 @@ extern char* jst_strdup( const char* s ) {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+/** The minimum size of a dynamic array that has to grow. After that, arrays grow by half of their size at a time. */
 #define DYNAMIC_ARRAY_LENGTH_INCREMENT 5
 
-extern void* jst_appendArrayItem( void* array, int indx, size_t* arlen, void* item, int item_size_in_bytes ) {
-  // Note that ansi-c has no data type byte. However, by definition sizeof( char ) == 1, i.e. it is one byte in size.
-
-  // allocate array if requested
-  if ( !array ) {
-    if  ( *arlen < (size_t)( indx + 1 ) ) {
-      *arlen = (size_t)( indx + DYNAMIC_ARRAY_LENGTH_INCREMENT ) ;
-    }
-    if ( ! ( array = jst_calloc( *arlen, item_size_in_bytes ) ) ) return NULL ;
-  } else if ( ((size_t)indx) >= *arlen ) { // ensure there is enough space
-    size_t previousSize = *arlen ;
+extern void* jst_ensureArrayCapacity( void* array, size_t* capacity, size_t minCapacity, size_t itemSize ) {
+  size_t previousCapacity = array ? *capacity : 0,
+         newCapacity ;
 
-    if ( !( array = jst_realloc( array, ( *arlen += DYNAMIC_ARRAY_LENGTH_INCREMENT ) * item_size_in_bytes ) ) ) return NULL ;
+  if ( array && minCapacity <= *capacity ) return array ;
 
-    memset( ((char*)array) + previousSize * item_size_in_bytes, 0, ( *arlen - previousSize ) * item_size_in_bytes ) ;
+  if ( !array && *capacity >= minCapacity ) {
+    // a new array of the requested size
+    newCapacity = *capacity ;
+  } else {
+    newCapacity = previousCapacity + previousCapacity / 2 ;
+    if ( newCapacity < DYNAMIC_ARRAY_LENGTH_INCREMENT ) newCapacity = DYNAMIC_ARRAY_LENGTH_INCREMENT ;
+    if ( newCapacity < minCapacity ) newCapacity = minCapacity ;
   }
 
+  if ( !( array = jst_realloc( array, newCapacity * itemSize ) ) ) return NULL ;
+
+  memset( ((char*)array) + previousCapacity * itemSize, 0, ( newCapacity - previousCapacity ) * itemSize ) ;
+  *capacity = newCapacity ;
+
+  return array ;
+}
+
+extern void* jst_appendArrayItem( void* array, int indx, size_t* arlen, void* item, int item_size_in_bytes ) {
+  // Note that ansi-c has no data type byte. However, by definition sizeof( char ) == 1, i.e. it is one byte in size.
+
+  // allocate the array if requested, ensure there is enough space otherwise
+  if ( !( array = jst_ensureArrayCapacity( array, arlen, (size_t)indx + 1, (size_t)item_size_in_bytes ) ) ) return NULL ;
+
   // append the new item.
   if ( item ) {
     memcpy( ((char*)array) + indx * item_size_in_bytes, item, item_size_in_bytes ) ;
@@ -139,55 +152,39 @@ extern char* jst_concat_overwrite( char* target, ... ) {
 
 extern char* jst_append( char* target, size_t* bufsize, ... ) {
   va_list args ;
-  size_t targetlen = ( target ? strlen( target ) : 0 ),
-         numArgs   = 10 ; // the size of the buffer we are storing the param strings into. Enlarged as necessary.
+  size_t targetlen = ( target ? strlen( target ) : 0 ) ;
   size_t totalSize = targetlen + 1 ; // 1 for the terminating nul char
   char   *s,
-         *t,
-         **stringsToAppend = NULL ;
-  int    i = 0 ;
-
-  errno = 0 ;
-  stringsToAppend = jst_malloc( numArgs * sizeof( char* ) ) ;
-  if ( !stringsToAppend ) goto end ;
+         *t ;
 
+  // the strings are gone through twice, first to count the space needed, then to copy them
   va_start( args, bufsize ) ;
-  while ( ( s = va_arg( args, char* ) ) ) {
-    if ( s[ 0 ] ) { // skip empty strings
-      if ( !( stringsToAppend = jst_appendArrayItem( stringsToAppend, i++, &numArgs, &s, sizeof( char* ) ) ) ) goto end ;
-      totalSize += strlen( s ) ;
-    }
-  }
-  // s = NULL ; // s is now NULL, no need to assign
-  if ( !( stringsToAppend = jst_appendArrayItem( stringsToAppend, i, &numArgs, &s, sizeof( char* ) ) ) ) goto end ;
+  while ( ( s = va_arg( args, char* ) ) ) totalSize += strlen( s ) ;
+  va_end( args ) ;
 
   if ( !target || *bufsize < totalSize ) {
-    // if taget == NULL and bufsize is given, it means we should reserve the given amount of space
-    if ( !target && bufsize && ( *bufsize > totalSize ) ) totalSize = *bufsize ;
+    if ( !target ) {
+      // if taget == NULL and bufsize is given, it means we should reserve the given amount of space
+      if ( bufsize && ( *bufsize > totalSize ) ) totalSize = *bufsize ;
+    } else if ( totalSize < *bufsize + *bufsize / 2 ) {
+      // grow geometrically so that appending repeatedly to the same buffer does not realloc every time
+      totalSize = *bufsize + *bufsize / 2 ;
+    }
     target = target ? jst_realloc( target, totalSize * sizeof( char ) ) :
                       jst_malloc( totalSize * sizeof( char ) ) ;
-    if ( !target ) goto end ;
+    if ( !target ) return NULL ;
     if ( bufsize ) *bufsize = totalSize ; // in case target == NULL, bufsize may also be NULL
   }
 
-  s = target + targetlen ;
-  for ( i = 0 ; ( t = stringsToAppend[ i ] ) ; i++ ) {
-    //size_t len = strlen( t ) ;
-    //memcpy( s, t, len ) ;
-    //s += len ;
-    // or shorter:
-    while ( *t ) *s++ = *t++ ;
+  t = target + targetlen ;
+  va_start( args, bufsize ) ;
+  while ( ( s = va_arg( args, char* ) ) ) {
+    while ( *s ) *t++ = *s++ ;
   }
-
-  *s = '\0' ;
-
-
-  end:
-
   va_end( args ) ;
 
-  if ( errno ) target = NULL ;
-  if ( stringsToAppend ) free( stringsToAppend ) ;
+  *t = '\0' ;
+
   return target ;
 
 }
@@ -229,8 +226,8 @@ extern void** jst_appendPointer( void*** pointerToNullTerminatedPointerArray, si
     while ( (*pointerToNullTerminatedPointerArray)[ count ] ) count++ ;
 
     if ( *arrSize <= count + 1 ) { // +1 for terminating null
-      *arrSize = count + DYNAMIC_ARRAY_LENGTH_INCREMENT ;
-      if ( !( *pointerToNullTerminatedPointerArray = jst_realloc( *pointerToNullTerminatedPointerArray, *arrSize * sizeof( void* ) ) ) ) return NULL ;
+      void** array = jst_ensureArrayCapacity( *pointerToNullTerminatedPointerArray, arrSize, count + 2, sizeof( void* ) ) ;
+      if ( !( *pointerToNullTerminatedPointerArray = array ) ) return NULL ;
     }
 
     (*pointerToNullTerminatedPointerArray)[ count ]     = item ;
@@ -373,27 +370,219 @@ extern int jst_nullTerminatedArrayLen( void* array, size_t elementSizeInBytes )
 
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+/** The size of the blocks memory is handed out from. Allocations bigger than a quarter of this get a block of their own. */
+#define ARENA_BLOCK_SIZE 8192
+
+/** Allocations are aligned on the size of this. */
+typedef union { void* p ; double d ; jlong l ; } JstArenaAlignment ;
+
+#define ARENA_ALIGN( size ) ( ( ( size ) + sizeof( JstArenaAlignment ) - 1 ) / sizeof( JstArenaAlignment ) * sizeof( JstArenaAlignment ) )
+
+struct JstArenaBlock_ {
+  JstArenaBlock* next ;
+  size_t         size ;
+  size_t         used ;
+} ;
+
+#define ARENA_BLOCK_HEADER_SIZE ARENA_ALIGN( sizeof( JstArenaBlock ) )
+
+struct JstArenaAdopted_ {
+  JstArenaAdopted* next ;
+  void*            ptr ;
+  void             (*release)( void* ptr ) ;
+} ;
+
+extern void* jst_arenaAlloc( JstArena* arena, size_t size ) {
+  JstArenaBlock* block = arena->blocks ;
+  void*          mem ;
+
+  size = ARENA_ALIGN( size ? size : 1 ) ;
+
+  if ( !block || block->size - block->used < size ) {
+    size_t blockSize = ( size > ARENA_BLOCK_SIZE / 4 ) ? size : ARENA_BLOCK_SIZE ;
+
+    if ( !( block = jst_malloc( ARENA_BLOCK_HEADER_SIZE + blockSize ) ) ) return NULL ;
+    block->size = blockSize ;
+    block->used = 0 ;
+
+    if ( blockSize == size && arena->blocks ) {
+      // a block of its own is full right away, so keep handing out memory from the current one
+      block->next          = arena->blocks->next ;
+      arena->blocks->next  = block ;
+    } else {
+      block->next   = arena->blocks ;
+      arena->blocks = block ;
+    }
+  }
+
+  mem = (char*)block + ARENA_BLOCK_HEADER_SIZE + block->used ;
+  block->used += size ;
+
+  return mem ;
+}
+
+extern char* jst_arenaStrdup( JstArena* arena, const char* s ) {
+  size_t len ;
+  char*  copy ;
+
+  if ( !s ) return NULL ;
+
+  len = strlen( s ) + 1 ;
+  if ( ( copy = jst_arenaAlloc( arena, len ) ) ) memcpy( copy, s, len ) ;
+
+  return copy ;
+}
+
+extern char* jst_arenaConcat( JstArena* arena, ... ) {
+  va_list args ;
+  size_t  len = 0 ;
+  char    *s,
+          *result,
+          *target ;
+
+  va_start( args, arena ) ;
+  while ( ( s = va_arg( args, char* ) ) ) len += strlen( s ) ;
+  va_end( args ) ;
+
+  if ( !( result = target = jst_arenaAlloc( arena, len + 1 ) ) ) return NULL ;
+
+  va_start( args, arena ) ;
+  while ( ( s = va_arg( args, char* ) ) ) {
+    while ( *s ) *target++ = *s++ ;
+  }
+  va_end( args ) ;
+
+  *target = '\0' ;
+
+  return result ;
+}
+
+extern void* jst_arenaAdopt( JstArena* arena, void* ptr ) {
+  return jst_arenaAdoptResource( arena, ptr, free ) ;
+}
+
+extern void* jst_arenaAdoptResource( JstArena* arena, void* resource, void (*release)( void* resource ) ) {
+  JstArenaAdopted* adopted ;
+
+  if ( !resource ) return NULL ;
+
+  if ( !( adopted = jst_arenaAlloc( arena, sizeof( JstArenaAdopted ) ) ) ) {
+    release( resource ) ;
+    return NULL ;
+  }
+
+  adopted->ptr     = resource ;
+  adopted->release = release ;
+  adopted->next    = arena->adopted ;
+  arena->adopted   = adopted ;
+
+  return resource ;
+}
+
+extern void jst_freeArena( JstArena* arena ) {
+  JstArenaAdopted* adopted ;
+  JstArenaBlock*   block ;
+
+  // the list of adopted pointers lives in the blocks, so go through it first
+  for ( adopted = arena->adopted ; adopted ; adopted = adopted->next ) adopted->release( adopted->ptr ) ;
+
+  while ( ( block = arena->blocks ) ) {
+    arena->blocks = block->next ;
+    free( block ) ;
+  }
+
+  arena->adopted = NULL ;
+}
+
 void printMemoryErrorExitDebugMessage( const char* file, int line, int iserror ) {
   if ( iserror ) {
     fprintf( stderr, "debug: exiting %s due to a memory problem on line %d. Please report this bug.\n", file, line ) ;
   }
 }
 
-extern JstDynamicPointerArray* jst_initializeDynamicPointerArray( JstDynamicPointerArray* array, size_t initialCapacity, size_t sizeIncrement ) {
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-  if ( initialCapacity > 0 ) {
-    array->count = 0 ;
-    // FIXME - allocate space to array->pointers
-    array->capacity = initialCapacity ;
-  } else {
-    memset( array, 0, sizeof( JstDynamicPointerArray ) ) ;
+extern JstDynamicPointerArray* jst_initializeDynamicPointerArray( JstDynamicPointerArray* array, size_t initialCapacity ) {
+
+  memset( array, 0, sizeof( JstDynamicPointerArray ) ) ;
+
+  array->capacity = initialCapacity ? initialCapacity : 1 ;
+  if ( !( array->pointers = jst_calloc( array->capacity, sizeof( void* ) ) ) ) {
+    array->capacity = 0 ;
+    return NULL ;
   }
 
   return array ;
 }
 
-// TODO:
-//void* jst_appendPointerToDynamicArray( JstDynamicPointerArray* array, void* item ) ;
+extern void* jst_appendPointerToDynamicArray( JstDynamicPointerArray* array, void* item ) {
+  void** pointers ;
 
-//void jst_freeDynamicArray( JstDynamicPointerArray* array, jboolean freeContents ) ;
+  // + 1 for the terminating NULL. Note that the new space is zeroed, so the array stays NULL terminated
+  if ( !( pointers = jst_ensureArrayCapacity( array->pointers, &array->capacity, array->count + 2, sizeof( void* ) ) ) ) return NULL ;
+
+  array->pointers = pointers ;
+  array->pointers[ array->count++ ] = item ;
+
+  return item ;
+}
+
+extern void jst_freeDynamicArray( JstDynamicPointerArray* array, jboolean freeContents ) {
+
+  if ( array->pointers ) {
+    if ( freeContents ) {
+      size_t i ;
+      for ( i = 0 ; i < array->count ; i++ ) {
+        if ( array->pointers[ i ] ) free( array->pointers[ i ] ) ;
+      }
+    }
+    free( array->pointers ) ;
+  }
+
+  memset( array, 0, sizeof( JstDynamicPointerArray ) ) ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+extern char* jst_appendToStringBuilder( JstStringBuilder* builder, ... ) {
+  va_list args ;
+  size_t  length = builder->length ;
+  char    *s,
+          *t ;
+
+  va_start( args, builder ) ;
+  while ( ( s = va_arg( args, char* ) ) ) length += strlen( s ) ;
+  va_end( args ) ;
+
+  if ( !builder->chars || length >= builder->capacity ) {
+    // + 1 for the terminating nul char
+    char* chars = jst_ensureArrayCapacity( builder->chars, &builder->capacity, length + 1, sizeof( char ) ) ;
+    if ( !chars ) {
+      jst_freeStringBuilder( builder ) ;
+      return NULL ;
+    }
+    builder->chars = chars ;
+  }
+
+  t = builder->chars + builder->length ;
+  va_start( args, builder ) ;
+  while ( ( s = va_arg( args, char* ) ) ) {
+    while ( *s ) *t++ = *s++ ;
+  }
+  va_end( args ) ;
+
+  *t = '\0' ;
+  builder->length = length ;
+
+  return builder->chars ;
+}
+
+extern void jst_freeStringBuilder( JstStringBuilder* builder ) {
+  if ( builder->chars ) free( builder->chars ) ;
+  builder->chars    = NULL ;
+  builder->length   = 0 ;
+  builder->capacity = 0 ;
+}
 
@@ -37,7 +37,8 @@
  * dynamically allocated, i.e. not from stack). If necessary, target is reallocated into a bigger space.
  * Returns the possibly new location of target, and modifies the size inout parameter accordingly.
  * If target is NULL, it is allocated w/ the given size (or bigger if given size does not fit all the given strings).
- * In case target is NULL and you are not interested how big the buffer became, you can give NULL as size. */
+ * In case target is NULL and you are not interested how big the buffer became, you can give NULL as size.
+ * Note that the length of target is counted on every call, so use a JstStringBuilder for building long strings piece by piece. */
 char* jst_append( char* target, size_t* size, ... ) ;
 
 /** Concatenates the strings in the given null terminated str array to a single string, which must be freed by the caller. Returns null on error. */
@@ -47,6 +48,12 @@ char* jst_concatenateStrArray( char** nullTerminatedStringArray ) ;
  * The newly allocated memory (in both cases) contains all 0s. If NULL is given as the item, zeroes are added at the given array position. */
 void* jst_appendArrayItem( void* array, int indx, size_t* arlen, void* item, int item_size_in_bytes ) ;
 
+/** Makes sure the given dynallocated array (may be NULL) has room for at least minCapacity items. The array grows
+ * geometrically, so filling an array one item at a time takes amortized constant time per item. The newly allocated memory
+ * is zeroed. Returns the possibly new location of the array and sets *capacity accordingly, NULL on error (err msg printed,
+ * the given array is left untouched). */
+void* jst_ensureArrayCapacity( void* array, size_t* capacity, size_t minCapacity, size_t itemSize ) ;
+
 /** Appends the given pointer to the given null terminated pointer array.
  * given pointer to array may point to NULL, in which case a new array is created.
  * Returns NULL on error.
@@ -144,26 +151,83 @@ char* jst_concat_overwrite( char* target, ... ) ;
 /** Frees all the pointers in the given array, the array itself and sets the reference to NULL */
 void jst_freeAll( void*** pointerToNullTerminatedPointerArray ) ;
 
-/** The members of this struct should not be manipulated except via the provided functions. */
+/** A pointer array that keeps track of its length and grows geometrically, i.e. appending is amortized O(1) (unlike w/
+ * jst_appendPointer, which looks for the end of the array on every call).
+ * The members of this struct should not be manipulated except via the provided functions. */
 typedef struct {
   size_t count ;
   size_t capacity ;
-  /** number of elements by which the array size is grown if more items are inserted than currently fits. */
-  size_t sizeIncrement ;
-  /** NULL terminated even though size can be looked up from count field. This enables using as param to funcs that expect NULL terminated pointer array */
+  /** NULL terminated even though size can be looked up from count field. This enables using as param to funcs that expect NULL terminated pointer array.
+   * The array is malloc'd, so the caller may take it over (and free it) instead of calling jst_freeDynamicArray. */
   void** pointers ;
 } JstDynamicPointerArray ;
 
-JstDynamicPointerArray* jst_initializeDynamicPointerArray( JstDynamicPointerArray* array, size_t initialCapacity, size_t sizeIncrement ) ;
+/** Allocates room for the given number of pointers (at least one). Returns NULL on error (err msg printed). */
+JstDynamicPointerArray* jst_initializeDynamicPointerArray( JstDynamicPointerArray* array, size_t initialCapacity ) ;
 /** returns the given item or NULL on error. */
 void* jst_appendPointerToDynamicArray( JstDynamicPointerArray* array, void* item ) ;
 
+/** Frees the pointer array (and the pointers in it if freeContents is true) and zeroes the given struct. */
 void jst_freeDynamicArray( JstDynamicPointerArray* array, jboolean freeContents ) ;
 
+/** A string that keeps track of its length, so appending to it does not need to go through what is already there.
+ * The buffer grows geometrically, i.e. appending is amortized O(1) per char.
+ * Initialize w/ JST_STRING_BUILDER_INITIALIZER. chars is NULL until something is appended, after that a nul terminated
+ * malloc'd string the caller may take over. */
+typedef struct {
+  char*  chars ;
+  size_t length ;
+  size_t capacity ;
+} JstStringBuilder ;
+
+#define JST_STRING_BUILDER_INITIALIZER { NULL, 0, 0 }
+
+/** Appends the given strings, the last param must be NULL. Returns the built string, NULL on error (err msg printed), in
+ * which case the builder has been freed. */
+char* jst_appendToStringBuilder( JstStringBuilder* builder, ... ) ;
+
+/** Frees the built string and reinitializes the builder. */
+void jst_freeStringBuilder( JstStringBuilder* builder ) ;
+
+typedef struct JstArenaBlock_   JstArenaBlock ;
+typedef struct JstArenaAdopted_ JstArenaAdopted ;
+
+/** A bump allocator. Memory is handed out from big blocks and all of it is released w/ one call to jst_freeArena, so there is
+ * no need to keep track of (or free) the individual allocations. Memory malloc'd elsewhere can be handed over to be
+ * freed along w/ the arena using jst_arenaAdopt.
+ * Initialize w/ JST_ARENA_INITIALIZER. The members should not be manipulated except via the provided functions. */
+typedef struct {
+  JstArenaBlock*   blocks ;
+  JstArenaAdopted* adopted ;
+} JstArena ;
+
+#define JST_ARENA_INITIALIZER { NULL, NULL }
+
+/** Returns NULL on error (err msg printed). The memory is suitably aligned for any type. */
+void* jst_arenaAlloc( JstArena* arena, size_t size ) ;
+
+/** Returns NULL if s is NULL or on error (err msg printed). */
+char* jst_arenaStrdup( JstArena* arena, const char* s ) ;
+
+/** Concatenates the given strings, the last param must be NULL. Returns NULL on error (err msg printed). */
+char* jst_arenaConcat( JstArena* arena, ... ) ;
+
+/** The given malloc'd memory is freed when the arena is. Returns the given pointer, NULL if it is NULL or on error.
+ * On error the given memory is freed. */
+void* jst_arenaAdopt( JstArena* arena, void* ptr ) ;
+
+/** As jst_arenaAdopt, but the given resource is released w/ the given func instead of free, e.g. to unmap a mapped file.
+ * On error the resource is released right away. */
+void* jst_arenaAdoptResource( JstArena* arena, void* resource, void (*release)( void* resource ) ) ;
+
+/** Frees all the memory allocated from or adopted by the given arena and reinitializes it. */
+void jst_freeArena( JstArena* arena ) ;
+
 /** Used to print debug messages from the below macro. If iserror==0 then this is a nop. */
 void printMemoryErrorExitDebugMessage( const char* file, int line, int iserror ) ;
 
-#define MARK_PTR_FOR_FREEING( dynReservedPointers, dreservedPtrsSize, garbagePtr, nullMeansError ) if ( !jst_appendPointer( &dynReservedPointers, &dreservedPtrsSize, ( garbagePtr ) ) ) { printMemoryErrorExitDebugMessage( __FILE__, __LINE__, nullMeansError ) ; goto end ; }
+/** Hands the given dynallocated memory over to the given arena. If the pointer is NULL (or on error), jumps to label end. */
+#define MARK_PTR_FOR_FREEING( arena, garbagePtr, nullMeansError ) if ( !jst_arenaAdopt( &arena, ( garbagePtr ) ) ) { printMemoryErrorExitDebugMessage( __FILE__, __LINE__, nullMeansError ) ; goto end ; }
 #define NULL_MEANS_ERROR 1
 #define NULL_IS_NOT_ERROR 0
 
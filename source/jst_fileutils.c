@@ -37,6 +37,10 @@
 
 #  include <dirent.h>
 #  include <unistd.h>
+#  include <fcntl.h>
+#  if defined( __linux__ )
+#    include <sys/syscall.h>
+#  endif
 #  if defined( __APPLE__ )
 #    include <CoreFoundation/CFBundle.h>
 
@@ -125,6 +129,22 @@ extern int jst_isDir( const char* fileName ) {
   return ( buf.st_mode & S_IFDIR ) ? 1 : 0 ;
 }
 
+extern int jst_getModificationTime( const char* fileName, jlong* mtime ) {
+  struct stat buf ;
+
+  if ( stat( fileName, &buf ) ) return 0 ;
+
+#if defined( __linux__ ) || defined( __sun__ )
+  *mtime = (jlong)buf.st_mtim.tv_sec * 1000000000 + buf.st_mtim.tv_nsec ;
+#elif defined( __APPLE__ )
+  *mtime = (jlong)buf.st_mtimespec.tv_sec * 1000000000 + buf.st_mtimespec.tv_nsec ;
+#else
+  *mtime = (jlong)buf.st_mtime * 1000000000 ;
+#endif
+
+  return 1 ;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 extern jboolean jst_dirNameEndsWithSeparator( const char* dirName ) {
@@ -185,8 +205,17 @@ static jboolean checkForInvalidFileHandle( HANDLE fileHandle, const char* dirNam
 
 #endif
 
+/** The names found by a dir scan, packed one after another (each nul terminated) into a single buffer. */
+typedef struct {
+  char*  names ;
+  /** the number of bytes used in the above buffer */
+  size_t size ;
+  size_t capacity ;
+  size_t count ;
+} FileNameList ;
+
 /** adds filename to list, return true on error and changes the value of errorOccurred accordingly. */
-static jboolean addFileToList( char ***fileNames, int *fileNameCount, size_t *resultSize, const char* dirName, const char* fileName, int (*selector)( const char* dirname, const char* filename ), jboolean *errorOccurred ) {
+static jboolean addFileToList( FileNameList* fileNames, const char* dirName, const char* fileName, int (*selector)( const char* dirname, const char* filename ), jboolean *errorOccurred ) {
 
   int okToInclude = JNI_TRUE ;
 
@@ -197,9 +226,14 @@ static jboolean addFileToList( char ***fileNames, int *fileNameCount, size_t *re
   }
 
   if ( !*errorOccurred && okToInclude ) {
-    char* temp = jst_strdup( fileName ) ;
-    if ( !temp ||
-         !( *fileNames = jst_appendArrayItem( *fileNames, (*fileNameCount)++, resultSize, &temp, sizeof( char* ) ) ) ) {
+    size_t len   = strlen( fileName ) + 1 ;
+    char*  names = jst_ensureArrayCapacity( fileNames->names, &fileNames->capacity, fileNames->size + len, sizeof( char ) ) ;
+    if ( names ) {
+      memcpy( names + fileNames->size, fileName, len ) ;
+      fileNames->names = names ;
+      fileNames->size += len ;
+      fileNames->count++ ;
+    } else {
       *errorOccurred = JNI_TRUE ;
     }
   }
@@ -207,6 +241,60 @@ static jboolean addFileToList( char ***fileNames, int *fileNameCount, size_t *re
   return *errorOccurred ;
 }
 
+/** Tells whether the given dir entry is of the wanted type.
+ * @param isDir 1 if the entry is known to be a dir, 0 if it is known not to be one, -1 if not known (in which case the file is stat'd). */
+static jboolean isOfEntryType( const char* dirName, const char* fileName, int isDir, JstDirEntryType entryType ) {
+
+  if ( entryType == JST_ANY_ENTRY ) return JNI_TRUE ;
+
+  if ( isDir == -1 ) {
+    char* fullName = jst_createFileName( dirName, fileName, NULL ) ;
+    if ( !fullName ) return JNI_FALSE ;
+    isDir = jst_isDir( fullName ) ? 1 : 0 ;
+    free( fullName ) ;
+  }
+
+  return ( entryType == JST_DIR_ENTRY ) == ( isDir == 1 ) ;
+}
+
+/** Adds the given dir entry to the list if it matches all the given criteria. return true on error and changes the value of errorOccurred accordingly. */
+static jboolean considerDirEntry( FileNameList* fileNames, const char* dirName, const char* fileName, int isDir, const char* fileNamePrefix, const char* fileNameSuffix, JstDirEntryType entryType, int (*selector)( const char* dirname, const char* filename ), jboolean *errorOccurred ) {
+
+  if ( ( strcmp( ".", fileName ) == 0 ) || ( strcmp( "..", fileName ) == 0 ) ) return *errorOccurred ;
+
+  if ( matchPrefixAndSuffixToFileName( fileName, fileNamePrefix, fileNameSuffix ) && isOfEntryType( dirName, fileName, isDir, entryType ) ) {
+    addFileToList( fileNames, dirName, fileName, selector, errorOccurred ) ;
+  }
+
+  return *errorOccurred ;
+}
+
+static int compareFileNames( const void* name1, const void* name2 ) {
+  return strcmp( *(const char**)name1, *(const char**)name2 ) ;
+}
+
+/** Packs the names into a sorted NULL terminated string array that is freed w/ a single call to free. Returns NULL on error. */
+static char** packFileNameList( FileNameList* fileNames ) {
+  char   **packed,
+         *name ;
+  size_t i ;
+
+  if ( !( packed = jst_malloc( ( fileNames->count + 1 ) * sizeof( char* ) + fileNames->size ) ) ) return NULL ;
+
+  name = (char*)( packed + fileNames->count + 1 ) ;
+  if ( fileNames->size ) memcpy( name, fileNames->names, fileNames->size ) ;
+
+  for ( i = 0 ; i < fileNames->count ; i++ ) {
+    packed[ i ] = name ;
+    name += strlen( name ) + 1 ;
+  }
+  packed[ i ] = NULL ;
+
+  // the order the os lists the files in depends on the file system, so sort to make e.g. the classpath reproducible
+  qsort( packed, fileNames->count, sizeof( char* ), compareFileNames ) ;
+
+  return packed ;
+}
 
 #if defined( _WIN32 )
 
@@ -237,7 +325,7 @@ extern int matchPrefixAndSuffixToFileName( const char* fileName, const char* pre
 #if defined( _WIN32 )
 
 /** Inserts the names of files matching the given criteria into the given (dynallocated) string array. returns true on error */
-static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char* fileNameSuffix, char*** fileNamesOut, size_t* fileNamesSize, int* fileNameCount, int (*selector)( const char* dirname, const char* filename ) ) {
+static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char* fileNameSuffix, JstDirEntryType entryType, FileNameList* fileNamesOut, int (*selector)( const char* dirname, const char* filename ) ) {
 
   // windows does not have dirent.h, it does things different from other os'es
 
@@ -272,7 +360,8 @@ static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char*
 
     do {
 
-      if ( addFileToList( fileNamesOut, fileNameCount, fileNamesSize, dirName, fdata.cFileName, selector, &errorOccurred ) ) goto end ;
+      if ( considerDirEntry( fileNamesOut, dirName, fdata.cFileName, ( fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) ? 1 : 0,
+                             NULL, NULL, entryType, selector, &errorOccurred ) ) goto end ;
 
     } while ( FindNextFile( fileHandle, &fdata ) ) ;
 
@@ -294,9 +383,67 @@ static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char*
 
 }
 
+#elif defined( __linux__ )
+
+/** The size of the buffer dir entries are read into. Big enough for hundreds of entries, so that even a dir w/ thousands of
+ * jars is read w/ a handful of system calls. */
+#define DIR_SCAN_BUFFER_SIZE 32768
+
+/** The layout of the records returned by the getdents64 system call. */
+typedef struct {
+  jlong          d_ino ;
+  jlong          d_off ;
+  unsigned short d_reclen ;
+  unsigned char  d_type ;
+  char           d_name[ 1 ] ;
+} LinuxDirent64 ;
+
+static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char* fileNameSuffix, JstDirEntryType entryType, FileNameList* fileNamesOut, int (*selector)( const char* dirname, const char* filename ) ) {
+
+  char     *buffer ;
+  long     bytesRead,
+           offset ;
+  int      fd ;
+  jboolean errorOccurred = JNI_FALSE ;
+
+  fd = open( dirName, O_RDONLY | O_DIRECTORY ) ;
+  if ( fd == -1 ) {
+    fprintf( stderr, "error: could not open directory %s\n%s", dirName, strerror( errno ) ) ;
+    return JNI_TRUE ;
+  }
+
+  if ( !( buffer = jst_malloc( DIR_SCAN_BUFFER_SIZE ) ) ) {
+    close( fd ) ;
+    return JNI_TRUE ;
+  }
+
+  while ( ( bytesRead = syscall( SYS_getdents64, fd, buffer, DIR_SCAN_BUFFER_SIZE ) ) > 0 ) {
+    for ( offset = 0 ; offset < bytesRead ; offset += ( (LinuxDirent64*)( buffer + offset ) )->d_reclen ) {
+      LinuxDirent64 *entry = (LinuxDirent64*)( buffer + offset ) ;
+      // symlinks and entries on file systems that do not report the type are stat'd if the type matters
+      int           isDir  = ( entry->d_type == DT_DIR ) ? 1 : ( entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK ) ? -1 : 0 ;
+
+      if ( considerDirEntry( fileNamesOut, dirName, entry->d_name, isDir, fileNamePrefix, fileNameSuffix, entryType, selector, &errorOccurred ) ) goto end ;
+    }
+  }
+
+  if ( bytesRead < 0 ) {
+    fprintf( stderr, "error: could not read directory %s\n%s", dirName, strerror( errno ) ) ;
+    errorOccurred = JNI_TRUE ;
+  }
+
+  end:
+
+  free( buffer ) ;
+  close( fd ) ;
+
+  return errorOccurred ;
+
+}
+
 #else
 
-static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char* fileNameSuffix, char*** fileNamesOut, size_t* fileNamesSize, int* fileNameCount, int (*selector)( const char* dirname, const char* filename ) ) {
+static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char* fileNameSuffix, JstDirEntryType entryType, FileNameList* fileNamesOut, int (*selector)( const char* dirname, const char* filename ) ) {
 
   DIR           *dir ;
   struct dirent *entry ;
@@ -310,15 +457,15 @@ static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char*
 
   while ( ( entry = readdir( dir ) ) ) {
 
-    char *fileName = entry->d_name ;
-
-    if ( ( strcmp( ".", fileName ) == 0 ) || ( strcmp( "..", fileName ) == 0 ) ) continue ;
-
-    if ( matchPrefixAndSuffixToFileName( fileName, fileNamePrefix, fileNameSuffix ) ) {
+#if defined( DT_DIR )
+    int isDir = ( entry->d_type == DT_DIR ) ? 1 : ( entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK ) ? -1 : 0 ;
+#else
+    // e.g. solaris does not tell the entry type
+    int isDir = -1 ;
+#endif
 
-      if ( addFileToList( fileNamesOut, fileNameCount, fileNamesSize, dirName, fileName, selector, &errorOccurred ) ) goto end ;
+    if ( considerDirEntry( fileNamesOut, dirName, entry->d_name, isDir, fileNamePrefix, fileNameSuffix, entryType, selector, &errorOccurred ) ) goto end ;
 
-    }
   }
 
 
@@ -335,33 +482,23 @@ static jboolean getFileNamesToArray( char* dirName, char* fileNamePrefix, char*
 // FIXME - if an error occurs, the caller has no way of distinguishing it from a situation where no files were found
 
 extern char** jst_getFileNames( char* dirName, char* fileNamePrefix, char* fileNameSuffix, int (*selector)( const char* dirname, const char* filename ) ) {
+  return jst_getFileNamesOfType( dirName, fileNamePrefix, fileNameSuffix, JST_ANY_ENTRY, selector ) ;
+}
 
-  char     **fileNamesTmp ;
-  size_t   resultSize    = 30 ;
-  jboolean errorOccurred = JNI_FALSE ;
-  int      fileNameCount = 0 ;
-
-  if ( !( fileNamesTmp = jst_calloc( resultSize, sizeof( char* ) ) ) ) return NULL ;
-
-
-  errorOccurred = getFileNamesToArray( dirName, fileNamePrefix, fileNameSuffix, &fileNamesTmp, &resultSize, &fileNameCount, selector ) ;
+extern char** jst_getFileNamesOfType( char* dirName, char* fileNamePrefix, char* fileNameSuffix, JstDirEntryType entryType, int (*selector)( const char* dirname, const char* filename ) ) {
 
+  FileNameList fileNames ;
+  jboolean     errorOccurred ;
+  char**       rval = NULL ;
 
-  if ( fileNamesTmp && fileNameCount > 0 ) {
-    fileNamesTmp = jst_appendArrayItem( fileNamesTmp, fileNameCount, &resultSize, NULL, sizeof( char* ) ) ;
-    if ( !fileNamesTmp ) errorOccurred = JNI_TRUE ;
-  }
+  memset( &fileNames, 0, sizeof( fileNames ) ) ;
 
-  {
-    char** rval = NULL ;
+  errorOccurred = getFileNamesToArray( dirName, fileNamePrefix, fileNameSuffix, entryType, &fileNames, selector ) ;
 
-    if ( fileNamesTmp ) {
-      if ( !errorOccurred ) rval = jst_packStringArray( fileNamesTmp ) ;
-      jst_freeAll( (void***)(void*)&fileNamesTmp ) ;
-    }
+  if ( !errorOccurred ) rval = packFileNameList( &fileNames ) ;
+  if ( fileNames.names ) free( fileNames.names ) ;
 
-    return rval ;
-  }
+  return rval ;
 
 }
 
@@ -496,48 +633,83 @@ extern char* jst_getExecutableHome() {
 
 }
 
-extern char* jst_createFileName( const char* root, ... ) {
-
-  static const char* filesep = JST_FILE_SEPARATOR ; // we can not pass a reference to a define, so this is read into a var
+/** Writes the file name made of the given root and the elements in args into target, if target is not NULL.
+ * Returns the length of the file name (w/out the terminating nul char). */
+static size_t buildFileName( char* target, const char* root, va_list args ) {
 
-  va_list args ;
-  char    **pathElements = NULL,
-          *s,
-          *previous,
-          *fileName = NULL ;
-  size_t  pathElementsSize = 0 ;
-
-  assert( root ) ;
+  const char *s,
+             *previous ;
+  size_t     len = strlen( root ),
+             elementLen ;
 
-  if ( !jst_appendPointer( (void***)(void*)&pathElements, &pathElementsSize, (void*)root ) ) return NULL ;
+  if ( target ) memcpy( target, root, len ) ;
 
   // empty string denotes root dir. In case of empty string, add that explicitly so the following
   // loop does not get confused (it assumes skipping empty strings).
-  previous = root[ 0 ] ? (char*)root : JST_FILE_SEPARATOR ;
+  previous = root[ 0 ] ? root : JST_FILE_SEPARATOR ;
 
-  va_start( args, root ) ;
-
-  while ( ( s = va_arg( args, char* ) ) ) {
+  while ( ( s = va_arg( args, const char* ) ) ) {
 
     if ( s[ 0 ] ) { // skip empty strings
 
-      if ( ( s[ 0 ] != filesep[ 0 ] ) &&
-           ( previous[ strlen( previous ) - 1 ] != filesep[ 0 ] ) &&
-           !jst_appendPointer( (void***)(void*)&pathElements, &pathElementsSize, (void*)filesep ) ) goto end ; 
+      if ( ( s[ 0 ] != JST_FILE_SEPARATOR[ 0 ] ) && ( previous[ strlen( previous ) - 1 ] != JST_FILE_SEPARATOR[ 0 ] ) ) {
+        if ( target ) target[ len ] = JST_FILE_SEPARATOR[ 0 ] ;
+        len++ ;
+      }
 
-      if ( !jst_appendPointer( (void***)(void*)&pathElements, &pathElementsSize, s ) ) goto end ;
+      elementLen = strlen( s ) ;
+      if ( target ) memcpy( target + len, s, elementLen ) ;
+      len += elementLen ;
       previous = s ;
     }
   }
 
+  if ( target ) target[ len ] = '\0' ;
 
-  fileName = jst_concatenateStrArray( pathElements ) ;
+  return len ;
 
-  end:
+}
+
+extern char* jst_createFileName( const char* root, ... ) {
+
+  va_list args ;
+  char    *fileName ;
+  size_t  len ;
+
+  assert( root ) ;
+
+  va_start( args, root ) ;
+  len = buildFileName( NULL, root, args ) ;
+  va_end( args ) ;
+
+  if ( !( fileName = jst_malloc( len + 1 ) ) ) return NULL ;
+
+  va_start( args, root ) ;
+  buildFileName( fileName, root, args ) ;
+  va_end( args ) ;
 
+  return fileName ;
+
+}
+
+extern char* jst_arenaCreateFileName( JstArena* arena, const char* root, ... ) {
+
+  va_list args ;
+  char    *fileName ;
+  size_t  len ;
+
+  assert( root ) ;
+
+  va_start( args, root ) ;
+  len = buildFileName( NULL, root, args ) ;
+  va_end( args ) ;
+
+  if ( !( fileName = jst_arenaAlloc( arena, len + 1 ) ) ) return NULL ;
+
+  va_start( args, root ) ;
+  buildFileName( fileName, root, args ) ;
   va_end( args ) ;
 
-  if ( pathElements ) free( pathElements ) ;
   return fileName ;
 
 }
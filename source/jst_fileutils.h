@@ -18,6 +18,8 @@
 #if !defined( _JST_FILEUTILS_H_ )
 #  define _JST_FILEUTILS_H_
 
+#include "jst_dynmem.h"
+
 #if defined( __cplusplus )
   extern "C" {
 #endif
@@ -30,6 +32,11 @@ int jst_fileExists( const char* fileName ) ;
  * a crash. Use jst_fileExists to check before calling this. */
 int jst_isDir( const char* fileName ) ;
 
+/** Stores the last modification time of the given file or dir into *mtime (in nanoseconds where the platform provides that
+ * resolution, otherwise whole seconds scaled to nanoseconds). Returns 0 if the file does not exist (or could not be stat'ed),
+ * in which case *mtime is not modified. No error msg is printed. */
+int jst_getModificationTime( const char* fileName, jlong* mtime ) ;
+
 /** Figures out the path to the parent dir of the given path (which may be a file or a dir). Modifies the argument so
  * that it points to the parent dir. Returns NULL (but does not modify the given string) if the given dir is the root dir.
  * For files, the dir containing the file is the parent dir.
@@ -43,14 +50,29 @@ char* jst_pathToParentDir( char* path ) ;
  *        Suffix here means the file type identifier part, e.g. in "foo.jar" -> ".jar"
  * @param selector pointer to a function that is called to decide whether the given file will be included (returns != 0 if file is to be included).
  *        it is to return true when the file is to be included in the returned list. May be NULL
+ * The names are sorted by byte value.
  *  */
 char** jst_getFileNames( char* dirName, char* fileNamePrefix, char* fileNameSuffix, int (*selector)( const char* dirname, const char* filename ) ) ;
 
+typedef enum {
+  JST_ANY_ENTRY,
+  JST_DIR_ENTRY,
+  /** anything but a dir */
+  JST_FILE_ENTRY
+} JstDirEntryType ;
+
+/** As jst_getFileNames, but only returns the entries of the given type. Where the os tells the type of the entries when
+ * listing the dir, this takes no extra system calls. */
+char** jst_getFileNamesOfType( char* dirName, char* fileNamePrefix, char* fileNameSuffix, JstDirEntryType entryType, int (*selector)( const char* dirname, const char* filename ) ) ;
+
 /** Creates a string that represents a file (or dir) name, i.e. all the elements are
  * ensured to contain a file separator between them.
  * Usage: give as many strings as you like and a NULL as the last param to terminate. */
 char* jst_createFileName( const char* root, ... ) ;
 
+/** As jst_createFileName, but the result is allocated from the given arena. */
+char* jst_arenaCreateFileName( JstArena* arena, const char* root, ... ) ;
+
 
 /** Returns the path to the directory where the current executable lives, excluding the last path separator, e.g.
  * c:\programs\groovy\bin or /usr/loca/groovy/bin
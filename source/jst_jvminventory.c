@@ -0,0 +1,516 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_cache.h"
+#include "jst_jvminventory.h"
+
+#if defined( _WIN32 )
+#  include "jst_winreg.h"
+#endif
+
+#define INVENTORY_KEY_VERSION "jst-jvms-1"
+
+/** The number of fields stored per installation in the cache, see appendJvmRecord. */
+#define JVM_RECORD_FIELD_COUNT 8
+
+/** The class data sharing archive of the jdk classes, in the same dir as the jvm dynamic library. */
+#define DEFAULT_SHARED_ARCHIVE "classes.jsa"
+
+// the dirs whose subdirs are java installations (or contain one in the given subdir)
+#if defined( _WIN32 )
+   // under %ProgramFiles% and %ProgramFiles(x86)%
+#  define JVM_HOME_SUBDIR NULL
+#elif defined( __APPLE__ )
+   static const char* standardJvmDirs[] = { "/Library/Java/JavaVirtualMachines", NULL } ;
+#  define JVM_HOME_SUBDIR "Contents/Home"
+#elif defined( __sun__ )
+   static const char* standardJvmDirs[] = { "/usr/jdk/instances", NULL } ;
+#  define JVM_HOME_SUBDIR NULL
+#else
+   static const char* standardJvmDirs[] = { "/usr/lib/jvm", "/usr/lib64/jvm", "/usr/java", NULL } ;
+#  define JVM_HOME_SUBDIR NULL
+#endif
+
+static unsigned int littleEndianInt( const unsigned char* bytes ) {
+  return (unsigned int)bytes[ 0 ] | ( (unsigned int)bytes[ 1 ] << 8 ) | ( (unsigned int)bytes[ 2 ] << 16 ) | ( (unsigned int)bytes[ 3 ] << 24 ) ;
+}
+
+/** Reads the word size (32 or 64) and the machine type of the given executable or dynamic library from its header. ELF (linux,
+ * solaris), PE (windows) and Mach-O (os x, word size only) files are recognized. The values not known are set to 0.
+ * Returns 0 if the file could not be read or is of an unknown format. */
+static int readBinaryArchitecture( const char* fileName, int* dataModel, int* machine ) {
+  unsigned char header[ 64 ] ;
+  size_t        headerSize ;
+  FILE          *f ;
+
+  *dataModel = *machine = 0 ;
+
+  if ( !( f = fopen( fileName, "rb" ) ) ) return 0 ;
+
+  headerSize = fread( header, 1, sizeof( header ), f ) ;
+
+  if ( headerSize >= 20 && memcmp( header, "\177ELF", 4 ) == 0 ) {
+    // e_ident[ EI_CLASS ] tells the word size, e_ident[ EI_DATA ] the byte order of e_machine
+    *dataModel = ( header[ 4 ] == 2 ) ? 64 : ( header[ 4 ] == 1 ) ? 32 : 0 ;
+    *machine   = ( header[ 5 ] == 2 ) ? ( header[ 18 ] << 8 ) | header[ 19 ] : header[ 18 ] | ( header[ 19 ] << 8 ) ;
+  } else if ( headerSize >= 4 && ( memcmp( header, "\xce\xfa\xed\xfe", 4 ) == 0 || memcmp( header, "\xfe\xed\xfa\xce", 4 ) == 0 ) ) {
+    *dataModel = 32 ;
+  } else if ( headerSize >= 4 && ( memcmp( header, "\xcf\xfa\xed\xfe", 4 ) == 0 || memcmp( header, "\xfe\xed\xfa\xcf", 4 ) == 0 ) ) {
+    *dataModel = 64 ;
+  } else if ( headerSize >= 64 && header[ 0 ] == 'M' && header[ 1 ] == 'Z' ) {
+    // the dos header points to the pe signature, which is followed by the coff header (machine first) and the optional header,
+    // whose magic tells the word size
+    unsigned char pe[ 26 ] ;
+    if ( fseek( f, (long)littleEndianInt( header + 60 ), SEEK_SET ) == 0 && fread( pe, 1, sizeof( pe ), f ) == sizeof( pe ) &&
+         memcmp( pe, "PE\0\0", 4 ) == 0 ) {
+      *machine   = pe[ 4 ] | ( pe[ 5 ] << 8 ) ;
+      *dataModel = ( pe[ 24 ] == 0x0b && pe[ 25 ] == 0x02 ) ? 64 : ( pe[ 24 ] == 0x0b && pe[ 25 ] == 0x01 ) ? 32 : 0 ;
+    }
+  }
+  // anything else, e.g. an os x universal binary, which may contain code for several architectures, is of unknown architecture
+
+  fclose( f ) ;
+
+  return *dataModel != 0 ;
+}
+
+/** The machine type of this launcher in the form readBinaryArchitecture returns it, 0 if not known. */
+static int getLauncherMachine( void ) {
+  int machine = 0 ;
+#if defined( __linux__ ) || defined( __sun__ )
+  int dataModel ;
+#  if defined( __linux__ )
+  readBinaryArchitecture( "/proc/self/exe", &dataModel, &machine ) ;
+#  else
+  readBinaryArchitecture( "/proc/self/object/a.out", &dataModel, &machine ) ;
+#  endif
+#elif defined( _WIN32 )
+#  if defined( _M_X64 ) || defined( __x86_64__ )
+  machine = 0x8664 ;
+#  elif defined( _M_IX86 ) || defined( __i386__ )
+  machine = 0x14c ;
+#  endif
+#endif
+  return machine ;
+}
+
+typedef struct {
+  JstJvmInventory*       inventory ;
+  size_t                 capacity ;
+  int                    launcherMachine ;
+  /** The files and dirs whose modification invalidates the cached inventory. malloc'd */
+  JstDynamicPointerArray stampFiles ;
+} InventoryBuilder ;
+
+/** Returns 0 on error. */
+static int addStampFile( InventoryBuilder* builder, const char* fileName ) {
+  char* stampFile = jst_strdup( fileName ) ;
+
+  if ( !stampFile ) return 0 ;
+
+  // creating a dir that did not exist changes the modification time of its parent
+  while ( !jst_fileExists( stampFile ) ) {
+    if ( !jst_pathToParentDir( stampFile ) ) {
+      free( stampFile ) ;
+      return 1 ;
+    }
+  }
+
+  if ( !jst_appendPointerToDynamicArray( &builder->stampFiles, stampFile ) ) {
+    free( stampFile ) ;
+    return 0 ;
+  }
+
+  return 1 ;
+}
+
+/** Adds the java installation in the given dir to the inventory, unless it already is there. If the dir does not contain
+ * a jvm, nothing is done. Returns 0 on error. */
+static int addJvm( InventoryBuilder* builder, const char* dirName ) {
+  JstJvmInventory *inventory = builder->inventory ;
+  JstJvmInfo      *jvm,
+                  *jvms ;
+  char            *javaHome = NULL,
+                  *serverJvm = NULL,
+                  *clientJvm = NULL,
+                  *version = NULL,
+                  *jvmDir = NULL,
+                  *file = NULL ;
+  int             machine,
+                  i,
+                  rval = 0 ;
+
+  // the fields are stored tab and newline separated
+  if ( !dirName || !*dirName || strchr( dirName, '\t' ) || strchr( dirName, '\n' ) || !jst_fileExists( dirName ) ) return 1 ;
+
+  if ( !( javaHome = jst_fullPathName( dirName ) ) ) return 0 ;
+  if ( javaHome == dirName && !( javaHome = jst_strdup( dirName ) ) ) return 0 ;
+
+  for ( i = 0 ; i < inventory->count ; i++ ) {
+    if ( strcmp( inventory->jvms[ i ].javaHome, javaHome ) == 0 ) {
+      rval = 1 ;
+      goto end ;
+    }
+  }
+
+  serverJvm = jst_findJvmDynLibPathQuietly( javaHome, JST_SERVERVM ) ;
+  clientJvm = jst_findJvmDynLibPathQuietly( javaHome, JST_CLIENTVM ) ;
+  if ( !serverJvm && !clientJvm ) {
+    rval = 1 ;
+    goto end ;
+  }
+
+  if ( !( jvms = jst_ensureArrayCapacity( inventory->jvms, &builder->capacity, (size_t)inventory->count + 1, sizeof( JstJvmInfo ) ) ) ) goto end ;
+  inventory->jvms = jvms ;
+  jvm = jvms + inventory->count ;
+
+  version = jst_getJavaVersion( javaHome ) ;
+
+  if ( !( jvm->javaHome  = jst_arenaStrdup( &inventory->arena, javaHome ) ) ||
+       !( jvm->version   = jst_arenaStrdup( &inventory->arena, version   ? version   : "" ) ) ||
+       !( jvm->serverJvm = jst_arenaStrdup( &inventory->arena, serverJvm ? serverJvm : "" ) ) ||
+       !( jvm->clientJvm = jst_arenaStrdup( &inventory->arena, clientJvm ? clientJvm : "" ) ) ) goto end ;
+
+  jvm->majorVersion = version ? jst_parseJavaMajorVersion( version ) : 0 ;
+
+  readBinaryArchitecture( serverJvm ? serverJvm : clientJvm, &jvm->dataModel, &machine ) ;
+  jvm->loadable = ( ( !jvm->dataModel || jvm->dataModel == (int)sizeof( void* ) * 8 ) &&
+                    ( !machine || !builder->launcherMachine || machine == builder->launcherMachine ) ) ? JNI_TRUE : JNI_FALSE ;
+
+  if ( !( jvmDir = jst_strdup( serverJvm ? serverJvm : clientJvm ) ) ) goto end ;
+  jst_pathToParentDir( jvmDir ) ;
+  if ( !( file = jst_createFileName( jvmDir, DEFAULT_SHARED_ARCHIVE, NULL ) ) ) goto end ;
+  jvm->hasSharedArchive = jst_fileExists( file ) ? JNI_TRUE : JNI_FALSE ;
+  free( file ) ;
+
+  inventory->count++ ;
+
+  // the release file changes when the installation is upgraded in place
+  if ( !( file = jst_createFileName( javaHome, "release", NULL ) ) ) goto end ;
+  rval = addStampFile( builder, jst_fileExists( file ) ? file : javaHome ) ;
+
+  end:
+  if ( javaHome  ) free( javaHome ) ;
+  if ( serverJvm ) free( serverJvm ) ;
+  if ( clientJvm ) free( clientJvm ) ;
+  if ( version   ) free( version ) ;
+  if ( jvmDir    ) free( jvmDir ) ;
+  if ( file      ) free( file ) ;
+
+  return rval ;
+}
+
+/** Adds the java installations that are subdirs of the given dir. Returns 0 on error. */
+static int addJvmsUnder( InventoryBuilder* builder, const char* dirName ) {
+  char **names ;
+  int  i,
+       rval = 1 ;
+
+  if ( !addStampFile( builder, dirName ) ) return 0 ;
+
+  if ( !jst_fileExists( dirName ) || !jst_isDir( dirName ) ) return 1 ;
+
+  // may be symlinks to dirs, e.g. those managed by update-alternatives
+  if ( !( names = jst_getFileNamesOfType( (char*)dirName, NULL, NULL, JST_ANY_ENTRY, NULL ) ) ) return 0 ;
+
+  for ( i = 0 ; rval && names[ i ] ; i++ ) {
+    char* javaHome = jst_createFileName( dirName, names[ i ], JVM_HOME_SUBDIR, NULL ) ;
+    rval = javaHome && addJvm( builder, javaHome ) ;
+    if ( javaHome ) free( javaHome ) ;
+  }
+
+  free( names ) ;
+
+  return rval ;
+}
+
+/** The dirs from JST_JVMDIRS_ENV_VAR_NAME and the standard install locations. Returns 0 on error. */
+static int addJvmsFromStandardLocations( InventoryBuilder* builder ) {
+  char *dirs = getenv( JST_JVMDIRS_ENV_VAR_NAME ),
+       *dir ;
+  int  rval = 1 ;
+
+  if ( dirs && *dirs ) {
+    if ( !( dirs = jst_strdup( dirs ) ) ) return 0 ;
+    for ( dir = strtok( dirs, JST_PATH_SEPARATOR ) ; rval && dir ; dir = strtok( NULL, JST_PATH_SEPARATOR ) ) {
+      rval = addJvmsUnder( builder, dir ) ;
+    }
+    free( dirs ) ;
+    if ( !rval ) return 0 ;
+  }
+
+#if defined( _WIN32 )
+  {
+    static const char* programFilesEnvVars[] = { "ProgramFiles", "ProgramFiles(x86)", NULL } ;
+    int i ;
+    for ( i = 0 ; rval && programFilesEnvVars[ i ] ; i++ ) {
+      char *programFiles = getenv( programFilesEnvVars[ i ] ) ;
+      if ( programFiles && ( dir = jst_createFileName( programFiles, "Java", NULL ) ) ) {
+        rval = addJvmsUnder( builder, dir ) ;
+        free( dir ) ;
+      }
+    }
+  }
+#else
+  {
+    int i ;
+    for ( i = 0 ; rval && standardJvmDirs[ i ] ; i++ ) rval = addJvmsUnder( builder, standardJvmDirs[ i ] ) ;
+  }
+#endif
+
+  return rval ;
+}
+
+/** Looks at all the installations. Returns 0 on error. */
+static int scanJvms( InventoryBuilder* builder ) {
+  char* javaHome ;
+  int   rval ;
+
+  // the same places jst_findJavaHome looks at first, so that the java home found by it comes first
+  if ( !addJvm( builder, getenv( "JAVA_HOME" ) ) ) return 0 ;
+
+  javaHome = jst_findJavaHomeFromPath() ;
+  rval = addJvm( builder, javaHome ) ;
+  if ( javaHome ) free( javaHome ) ;
+  if ( !rval ) return 0 ;
+
+#if defined( _WIN32 )
+  javaHome = jst_findJavaHomeFromWinRegistry() ;
+  rval = addJvm( builder, javaHome ) ;
+  if ( javaHome ) free( javaHome ) ;
+  if ( !rval ) return 0 ;
+#endif
+
+  return addJvmsFromStandardLocations( builder ) ;
+}
+
+/** Everything the places looked at and the launcher architecture the installations were checked against. Returns NULL on error. */
+static char* createInventoryKey( int launcherMachine ) {
+  static const char* envVars[] = { "JAVA_HOME", "PATH", JST_JVMDIRS_ENV_VAR_NAME,
+#if defined( _WIN32 )
+                                   "ProgramFiles", "ProgramFiles(x86)",
+#endif
+                                   NULL } ;
+  JstStringBuilder key = JST_STRING_BUILDER_INITIALIZER ;
+  char             *value,
+                   architecture[ 32 ] ;
+  int              i ;
+
+  sprintf( architecture, "%d %d\n", (int)sizeof( void* ) * 8, launcherMachine ) ;
+
+  if ( !jst_appendToStringBuilder( &key, INVENTORY_KEY_VERSION "\n", architecture, NULL ) ) return NULL ;
+
+  for ( i = 0 ; envVars[ i ] ; i++ ) {
+    value = getenv( envVars[ i ] ) ;
+    if ( !jst_appendToStringBuilder( &key, envVars[ i ], value ? "=" : "", value ? value : "", "\n", NULL ) ) return NULL ;
+  }
+
+  return key.chars ;
+}
+
+/** Appends the fields of the given installation as a tab separated line. Returns NULL on error. */
+static char* appendJvmRecord( JstStringBuilder* records, const JstJvmInfo* jvm ) {
+  char majorVersion[ 16 ],
+       dataModel[ 16 ] ;
+
+  sprintf( majorVersion, "%d", jvm->majorVersion ) ;
+  sprintf( dataModel,    "%d", jvm->dataModel ) ;
+
+  return jst_appendToStringBuilder( records, jvm->javaHome, "\t", jvm->version, "\t", majorVersion, "\t", dataModel, "\t",
+                                    jvm->loadable ? "1" : "0", "\t", jvm->serverJvm, "\t", jvm->clientJvm, "\t",
+                                    jvm->hasSharedArchive ? "1" : "0", "\n", NULL ) ;
+}
+
+/** Fills in the inventory from the records created by appendJvmRecord. Returns 0 if they are not valid. */
+static int parseJvmRecords( JstJvmInventory* inventory, const char* storedRecords ) {
+  char   *records,
+         *fields[ JVM_RECORD_FIELD_COUNT ],
+         *lineEnd ;
+  size_t capacity = 0 ;
+  int    i ;
+
+  if ( !( records = jst_arenaStrdup( &inventory->arena, storedRecords ) ) ) return 0 ;
+
+  for ( ; *records ; records = lineEnd + 1 ) {
+    JstJvmInfo *jvm,
+               *jvms ;
+
+    if ( !( lineEnd = strchr( records, '\n' ) ) ) return 0 ;
+    *lineEnd = '\0' ;
+
+    for ( i = 0 ; i < JVM_RECORD_FIELD_COUNT ; i++ ) {
+      fields[ i ] = records ;
+      if ( !( records = strchr( records, ( i < JVM_RECORD_FIELD_COUNT - 1 ) ? '\t' : '\0' ) ) ) return 0 ;
+      *records++ = '\0' ;
+    }
+    // the terminator written over the newline was skipped over above
+    if ( records != lineEnd + 1 ) return 0 ;
+
+    if ( !( jvms = jst_ensureArrayCapacity( inventory->jvms, &capacity, (size_t)inventory->count + 1, sizeof( JstJvmInfo ) ) ) ) return 0 ;
+    inventory->jvms = jvms ;
+    jvm = jvms + inventory->count++ ;
+
+    jvm->javaHome         = fields[ 0 ] ;
+    jvm->version          = fields[ 1 ] ;
+    jvm->majorVersion     = atoi( fields[ 2 ] ) ;
+    jvm->dataModel        = atoi( fields[ 3 ] ) ;
+    jvm->loadable         = ( *fields[ 4 ] == '1' ) ? JNI_TRUE : JNI_FALSE ;
+    jvm->serverJvm        = fields[ 5 ] ;
+    jvm->clientJvm        = fields[ 6 ] ;
+    jvm->hasSharedArchive = ( *fields[ 7 ] == '1' ) ? JNI_TRUE : JNI_FALSE ;
+  }
+
+  return 1 ;
+}
+
+extern int jst_loadJvmInventory( JstJvmInventory* inventory ) {
+  InventoryBuilder builder ;
+  JstStringBuilder records = JST_STRING_BUILDER_INITIALIZER ;
+  char             *key = NULL,
+                   **plan = NULL,
+                   *entries[ 2 ] ;
+  int              i,
+                   rval = 0 ;
+
+  memset( inventory, 0, sizeof( *inventory ) ) ;
+  memset( &builder, 0, sizeof( builder ) ) ;
+
+  builder.inventory       = inventory ;
+  builder.launcherMachine = getLauncherMachine() ;
+
+  if ( jst_cachingEnabled() ) {
+    if ( !( key = createInventoryKey( builder.launcherMachine ) ) ) goto end ;
+    if ( ( plan = jst_loadLaunchPlan( key, 1 ) ) ) {
+      if ( parseJvmRecords( inventory, plan[ 0 ] ) ) {
+        if ( _jst_debug ) fprintf( stderr, "debug: using the cached inventory of %d java installations\n", inventory->count ) ;
+        rval = 1 ;
+        goto end ;
+      }
+      // start over
+      if ( inventory->jvms ) free( inventory->jvms ) ;
+      jst_freeArena( &inventory->arena ) ;
+      memset( inventory, 0, sizeof( *inventory ) ) ;
+    }
+  }
+
+  if ( !jst_initializeDynamicPointerArray( &builder.stampFiles, 16 ) || !scanJvms( &builder ) ) goto end ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: found %d java installations\n", inventory->count ) ;
+
+  if ( key && builder.stampFiles.count > 0 ) {
+    for ( i = 0 ; i < inventory->count ; i++ ) {
+      if ( !appendJvmRecord( &records, inventory->jvms + i ) ) goto end ;
+    }
+    entries[ 0 ] = records.chars ? records.chars : "" ;
+    entries[ 1 ] = NULL ;
+    jst_storeLaunchPlan( key, entries, (char**)builder.stampFiles.pointers ) ;
+  }
+
+  rval = 1 ;
+
+  end:
+  // the array is only adopted once complete, as it moves while growing
+  if ( inventory->jvms && !jst_arenaAdopt( &inventory->arena, inventory->jvms ) ) rval = 0 ;
+  if ( builder.stampFiles.pointers ) jst_freeDynamicArray( &builder.stampFiles, JNI_TRUE ) ;
+  jst_freeStringBuilder( &records ) ;
+  if ( plan ) free( plan ) ;
+  if ( key  ) free( key ) ;
+
+  if ( _jst_debug && rval ) {
+    for ( i = 0 ; i < inventory->count ; i++ ) {
+      JstJvmInfo* jvm = inventory->jvms + i ;
+      fprintf( stderr, "  %s: version %s, %d bit%s%s%s%s\n", jvm->javaHome, *jvm->version ? jvm->version : "unknown", jvm->dataModel,
+               *jvm->serverJvm ? ", server" : "", *jvm->clientJvm ? ", client" : "",
+               jvm->hasSharedArchive ? ", class data sharing archive" : "", jvm->loadable ? "" : ", not loadable by this launcher" ) ;
+    }
+  }
+
+  return rval ;
+}
+
+extern void jst_freeJvmInventory( JstJvmInventory* inventory ) {
+  // the jvm array is owned by the arena
+  jst_freeArena( &inventory->arena ) ;
+  memset( inventory, 0, sizeof( *inventory ) ) ;
+}
+
+/** Parses the given version spec into a range of major versions. Returns 0 if it is not valid. */
+static int parseVersionSpec( const char* versionSpec, int* minVersion, int* maxVersion ) {
+  const char* dash = strchr( versionSpec, '-' ) ;
+  size_t      len  = strlen( versionSpec ) ;
+
+  if ( !len || !( *minVersion = jst_parseJavaMajorVersion( versionSpec ) ) ) return 0 ;
+
+  if ( versionSpec[ len - 1 ] == '+' ) {
+    *maxVersion = 0x7fffffff ;
+  } else if ( dash ) {
+    if ( !( *maxVersion = jst_parseJavaMajorVersion( dash + 1 ) ) || *maxVersion < *minVersion ) return 0 ;
+  } else {
+    *maxVersion = *minVersion ;
+  }
+
+  return 1 ;
+}
+
+extern char* jst_findJavaHomeByVersion( const char* versionSpec ) {
+  JstJvmInventory inventory ;
+  JstJvmInfo      *best = NULL ;
+  char            *javaHome = NULL ;
+  int             minVersion,
+                  maxVersion,
+                  i ;
+
+  if ( !parseVersionSpec( versionSpec, &minVersion, &maxVersion ) ) {
+    fprintf( stderr, "error: invalid java version %s, give e.g. 17, 11+ or 8-11\n", versionSpec ) ;
+    return NULL ;
+  }
+
+  if ( !jst_loadJvmInventory( &inventory ) ) goto end ;
+
+  for ( i = 0 ; i < inventory.count ; i++ ) {
+    JstJvmInfo* jvm = inventory.jvms + i ;
+
+    if ( !jvm->loadable || jvm->majorVersion < minVersion || jvm->majorVersion > maxVersion ) continue ;
+
+    // an archive of the jdk classes saves more startup time than anything else that differs between installations, and newer
+    // jvms start faster
+    if ( !best || ( jvm->hasSharedArchive && !best->hasSharedArchive ) ||
+         ( jvm->hasSharedArchive == best->hasSharedArchive && jvm->majorVersion > best->majorVersion ) ) best = jvm ;
+  }
+
+  if ( !best ) {
+    fprintf( stderr, "error: no matching jvm found, there is no java installation of version %s\n"
+                     "       the dirs listed in env var " JST_JVMDIRS_ENV_VAR_NAME " are looked at in addition to JAVA_HOME, PATH and the standard locations\n",
+                     versionSpec ) ;
+    goto end ;
+  }
+
+  if ( _jst_debug ) fprintf( stderr, "debug: using java %s in %s for version %s\n", best->version, best->javaHome, versionSpec ) ;
+
+  javaHome = jst_strdup( best->javaHome ) ;
+
+  end:
+  jst_freeJvmInventory( &inventory ) ;
+
+  return javaHome ;
+}
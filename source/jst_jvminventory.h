@@ -0,0 +1,79 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// An inventory of the java installations on this machine, for selecting one by version w/out loading any of them.
+// The version is read from the release file of the installation and the word size and architecture from the header of
+// its jvm dynamic library, so installations this launcher can not load (e.g. a 32 bit jvm for a 64 bit launcher) are
+// known before trying.
+//
+// The installations looked at are the ones in JAVA_HOME and on the PATH (and the windows registry), and those in the
+// dirs given in __JLAUNCHER_JVM_DIRS and the standard install locations of the os, e.g. /usr/lib/jvm on linux.
+// The inventory is cached (see jst_cache.h) until one of those dirs or installations changes.
+
+#if !defined( _JST_JVMINVENTORY_H_ )
+#  define _JST_JVMINVENTORY_H_
+
+#include "jst_dynmem.h"
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** Extra dirs (separated by the platform path separator) whose subdirs are looked at for java installations. */
+#define JST_JVMDIRS_ENV_VAR_NAME "__JLAUNCHER_JVM_DIRS"
+
+typedef struct {
+  char*    javaHome ;
+  /** As given in the release file, e.g. "17.0.2" or "1.8.0_392". "" if not known. */
+  char*    version ;
+  /** e.g. 8 or 17, 0 if not known. */
+  int      majorVersion ;
+  /** 32 or 64, 0 if not known. */
+  int      dataModel ;
+  /** False if the jvm dynamic library is known to be for another architecture than this launcher. */
+  jboolean loadable ;
+  /** The paths to the server and client jvm dynamic libraries, "" if there is no such jvm. */
+  char*    serverJvm ;
+  char*    clientJvm ;
+  /** Whether the default class data sharing archive of the jdk classes is there, which makes the jvm start faster. */
+  jboolean hasSharedArchive ;
+} JstJvmInfo ;
+
+typedef struct {
+  /** In the order found, JAVA_HOME first. */
+  JstJvmInfo* jvms ;
+  int         count ;
+  JstArena    arena ;
+} JstJvmInventory ;
+
+/** Fills in the given inventory from the cache or by looking at the installations. Returns 0 on error (err msg printed).
+ * Free w/ jst_freeJvmInventory, whatever the return value. */
+int jst_loadJvmInventory( JstJvmInventory* inventory ) ;
+
+void jst_freeJvmInventory( JstJvmInventory* inventory ) ;
+
+/** Returns the java home of the installation matching the given version spec that starts fastest: one w/ a class data
+ * sharing archive is preferred, then the newest one. Installations this launcher can not load are not considered.
+ * The spec is a major version, optionally followed by a + (that version or newer) or - and another major version (a range,
+ * inclusive), e.g. "17", "11+" or "8-11". 1.x is taken to mean x.
+ * Returns NULL (err msg printed) if there is no matching installation or on error. Freeing the returned value is up to the caller. */
+char* jst_findJavaHomeByVersion( const char* versionSpec ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_jvmoptsfile.h"
+
+/** Options files bigger than this are rejected, they are meant to be written by hand. */
+#define JVM_OPTIONS_FILE_MAX_SIZE 65536
+
+/** Reads at most maxSize bytes from the start of the given file into a nul terminated buffer allocated from the given arena.
+ * Returns NULL if the file does not exist or on error (*error set, err msg printed).
+ * @param truncated set to whether there was more in the file than was read */
+static char* readFileStart( const char* fileName, size_t maxSize, jboolean* truncated, JstArena* arena, jboolean* error ) {
+  FILE*  file ;
+  char*  data ;
+  size_t size ;
+
+  if ( !( file = fopen( fileName, "rb" ) ) ) {
+    if ( errno != ENOENT ) {
+      fprintf( stderr, "error: could not open %s\n%s\n", fileName, strerror( errno ) ) ;
+      *error = JNI_TRUE ;
+    }
+    return NULL ;
+  }
+
+  if ( ( data = jst_arenaAlloc( arena, maxSize + 1 ) ) ) {
+    size = fread( data, 1, maxSize, file ) ;
+    if ( ferror( file ) ) {
+      fprintf( stderr, "error: could not read %s\n%s\n", fileName, strerror( errno ) ) ;
+      data = NULL ;
+    } else {
+      data[ size ] = '\0' ;
+      *truncated = ( size == maxSize && fgetc( file ) != EOF ) ? JNI_TRUE : JNI_FALSE ;
+    }
+  }
+
+  if ( !data ) *error = JNI_TRUE ;
+  fclose( file ) ;
+  return data ;
+}
+
+/** Terminates the given line at its end. Returns the start of the next line, NULL if this is the last. */
+static char* splitLine( char* line ) {
+  char* end = strchr( line, '\n' ) ;
+
+  if ( !end ) return NULL ;
+  *end = '\0' ;
+  return end + 1 ;
+}
+
+static char* skipSpace( char* s ) {
+  while ( isspace( (unsigned char)*s ) ) s++ ;
+  return s ;
+}
+
+static int handleOptions( char* options, const char* fileName, JstJvmOptions* jvmOptions, JVMSelectStrategy* jvmStrategyOut ) {
+  if ( handleJVMOptsString( options, jvmOptions, jvmStrategyOut ) ) return 1 ;
+  fprintf( stderr, "error: could not read the jvm options in %s\n", fileName ) ;
+  return 0 ;
+}
+
+extern int jst_readJvmOptionsFile( const char* fileName, JstJvmOptions* jvmOptions, JVMSelectStrategy* jvmStrategyOut, JstArena* arena ) {
+  jboolean truncated = JNI_FALSE,
+           error     = JNI_FALSE ;
+  int      count     = jvmOptions->optionsCount ;
+  char     *line,
+           *next ;
+
+  if ( !( line = readFileStart( fileName, JVM_OPTIONS_FILE_MAX_SIZE, &truncated, arena, &error ) ) ) return error ? 0 : 1 ;
+
+  if ( truncated ) {
+    fprintf( stderr, "error: jvm options file %s is too big, the maximum size is %d bytes\n", fileName, JVM_OPTIONS_FILE_MAX_SIZE ) ;
+    return 0 ;
+  }
+
+  for ( ; line ; line = next ) {
+    next = splitLine( line ) ;
+    if ( *skipSpace( line ) == '#' ) continue ;
+    if ( !handleOptions( line, fileName, jvmOptions, jvmStrategyOut ) ) return 0 ;
+  }
+
+  if ( _jst_debug ) fprintf( stderr, "debug: read %d jvm options from %s\n", jvmOptions->optionsCount - count, fileName ) ;
+
+  return 1 ;
+}
+
+extern int jst_readScriptJvmOptions( const char* scriptFile, JstJvmOptions* jvmOptions, JVMSelectStrategy* jvmStrategyOut, JstArena* arena ) {
+  jboolean truncated = JNI_FALSE,
+           error     = JNI_FALSE ;
+  size_t   tagLen    = strlen( JST_SCRIPT_JVM_OPTIONS_TAG ) ;
+  int      count     = jvmOptions->optionsCount ;
+  char     *data,
+           *line,
+           *next,
+           *start ;
+
+  if ( !( data = readFileStart( scriptFile, JST_SCRIPT_HEADER_MAX_SIZE, &truncated, arena, &error ) ) ) return error ? 0 : 1 ;
+
+  // a line cut off at the end of what was read might be missing some of its options
+  if ( truncated ) {
+    if ( ( line = strrchr( data, '\n' ) ) ) line[ 1 ] = '\0' ; else *data = '\0' ;
+  }
+
+  // utf-8 byte order mark
+  if ( (unsigned char)data[ 0 ] == 0xEF && (unsigned char)data[ 1 ] == 0xBB && (unsigned char)data[ 2 ] == 0xBF ) data += 3 ;
+
+  line = ( data[ 0 ] == '#' && data[ 1 ] == '!' ) ? splitLine( data ) : data ;
+
+  // the header ends at the first line that is neither empty nor a // comment
+  for ( ; line ; line = next ) {
+    next  = splitLine( line ) ;
+    start = skipSpace( line ) ;
+    if ( !*start ) continue ;
+    if ( strncmp( start, "//", 2 ) != 0 ) break ;
+    if ( strncmp( start, JST_SCRIPT_JVM_OPTIONS_TAG, tagLen ) == 0 && ( !start[ tagLen ] || isspace( (unsigned char)start[ tagLen ] ) ) ) {
+      if ( !handleOptions( start + tagLen, scriptFile, jvmOptions, jvmStrategyOut ) ) return 0 ;
+    }
+  }
+
+  if ( _jst_debug && jvmOptions->optionsCount > count ) fprintf( stderr, "debug: read %d jvm options from the header of %s\n", jvmOptions->optionsCount - count, scriptFile ) ;
+
+  return 1 ;
+}
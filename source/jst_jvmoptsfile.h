@@ -0,0 +1,58 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Jvm options read from files, so that an installation or a script can carry its own jvm tuning instead of every caller
+// having to give it.
+//
+// An options file (e.g. $GROOVY_HOME/conf/jvm.options) has any number of options per line, split as in handleJVMOptsString
+// (i.e. "double" or 'single' quotes can be used for options containing spaces). Lines starting w/ # are comments.
+//
+// A script gives its options in its header, i.e. the comment lines at its start (after a possible #! line), e.g.
+//   #!/usr/bin/env groovy
+//   //@jvm -Xmx8g -XX:+UseG1GC
+//   //@jvm "-Dapp.title=My app"
+// Only the first JST_SCRIPT_HEADER_MAX_SIZE bytes of the script are read for this.
+
+#if !defined( _JST_JVMOPTSFILE_H_ )
+#  define _JST_JVMOPTSFILE_H_
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** The most of a script read when looking for jvm options in its header. */
+#define JST_SCRIPT_HEADER_MAX_SIZE 4096
+
+/** Starts a comment line in a script header giving jvm options. */
+#define JST_SCRIPT_JVM_OPTIONS_TAG "//@jvm"
+
+/** Appends the options in the given options file to the given ones. A file that does not exist is not an error.
+ * @param jvmStrategyOut modified if -client or -server is given in the file, left alone otherwise
+ * @param arena holds the option strings, so it must not be freed before the jvm is started
+ * @return 0 on error (err msg printed) */
+int jst_readJvmOptionsFile( const char* fileName, JstJvmOptions* jvmOptions, JVMSelectStrategy* jvmStrategyOut, JstArena* arena ) ;
+
+/** As jst_readJvmOptionsFile, but the options are read from the header of the given script. */
+int jst_readScriptJvmOptions( const char* scriptFile, JstJvmOptions* jvmOptions, JVMSelectStrategy* jvmStrategyOut, JstArena* arena ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
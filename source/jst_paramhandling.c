@@ -56,7 +56,7 @@ static char* cygwinConvertStringAndAppendInTheEndOfGivenBufferIfNotEqualToOrigin
     if ( _jst_debug ) fprintf( stderr, "  cygwin converted param %s to %s\n", value, convertedValue ) ;
 
     if ( *usedSize + len > *actualSize ) {
-      *processedParams = jst_realloc( *processedParams, *actualSize += len + 200 ) ;
+      *processedParams = jst_ensureArrayCapacity( *processedParams, actualSize, *usedSize + len, 1 ) ;
       if ( !*processedParams ) return NULL ;
     }
 
@@ -73,15 +73,241 @@ static char* cygwinConvertStringAndAppendInTheEndOfGivenBufferIfNotEqualToOrigin
 #endif
 
 
-// TODO: presorting param infos would improve performance as then the param definition would not need to
-//       be sought w/ exhaustive search
-//       The performance is atm O(n*m) where n = number of actual params, m = number of param definitions.
-//       Thenagain, this should only be optimized if profiling says it must (for a real case),
-//       as n and m are both likely to be very small.
-//       It would also be possible to use a (balanced) binary tree ( O(log(N)) ) or a hash.
-//       However, it is unlikely that the number of parameters is ever significant enough for this to be an
-//       issue, so doing these improvements is left till it is verified that there are cases where
-//       this actually makes a difference.
+// The param definitions are indexed on each call to jst_processInputParameters: the names of the single and double
+// params are sorted for binary search, the names of the prefix params are grouped by length so that an arg can be
+// matched against all the prefixes of one length w/ a single binary search. The index also records where each
+// defined param first occurs, so jst_getParameterValue does not need to go through the actual params.
+// The index lives in the same memory block as the actual params, right after the terminating entry, so that
+// everything can be freed w/ a single call to free. It contains no pointers into the block, so the block can be
+// realloc'd freely while being filled in.
+
+/** A param name in the index. */
+typedef struct {
+  const char* name ;
+  size_t      length ;
+  /** the index of the param definition the name belongs to */
+  int         definition ;
+} ParamName ;
+
+/** Where a defined param first occurs in the actual params. */
+typedef struct {
+  /** the index of the first actual param, -1 if the param was not given */
+  int    firstParam ;
+  /** for prefix params, the length of the prefix given */
+  size_t prefixLength ;
+} ParamOccurrence ;
+
+struct JstParamIndex_ {
+  /** the number of actual params, not counting the terminating entry */
+  int    paramCount ;
+  int    definitionCount ;
+  /** The names of the single and double params come first, sorted w/ compareNameTo. A name given in several
+   * definitions is only present once, w/ the first definition. The names of the prefix params follow, sorted
+   * by length first. The names are followed by the occurrences of the definitions. */
+  size_t exactNameCount,
+         prefixNameCount ;
+} ;
+
+#define PARAM_INDEX( params, numArgs ) ( (JstParamIndex*)( (params) + (numArgs) + 1 ) )
+#define INDEX_NAMES( index )           ( (ParamName*)( (index) + 1 ) )
+#define INDEX_OCCURRENCES( index )     ( (ParamOccurrence*)( INDEX_NAMES( index ) + (index)->exactNameCount + (index)->prefixNameCount ) )
+
+/** Counts the param definitions and the names of the single / double and prefix params in them. */
+static void countParamNames( const JstParamInfo* paramInfos, int* definitionCount, size_t* exactNameCount, size_t* prefixNameCount ) {
+  const char** names ;
+
+  *definitionCount = 0 ;
+  *exactNameCount = *prefixNameCount = 0 ;
+
+  for ( ; paramInfos->names ; paramInfos++ ) {
+    (*definitionCount)++ ;
+    for ( names = paramInfos->names ; *names ; names++ ) {
+      if ( paramInfos->type == JST_PREFIX_PARAM ) (*prefixNameCount)++ ; else (*exactNameCount)++ ;
+    }
+  }
+}
+
+static int compareNameTo( const char* str, size_t length, const ParamName* name ) {
+  int rval = memcmp( str, name->name, ( length < name->length ) ? length : name->length ) ;
+  return rval ? rval :
+         ( length < name->length ) ? -1 :
+         ( length > name->length ) ?  1 : 0 ;
+}
+
+static int compareExactNames( const void* name1, const void* name2 ) {
+  const ParamName *n1 = (const ParamName*)name1,
+                  *n2 = (const ParamName*)name2 ;
+  int rval = compareNameTo( n1->name, n1->length, n2 ) ;
+  return rval ? rval : n1->definition - n2->definition ;
+}
+
+static int comparePrefixNames( const void* name1, const void* name2 ) {
+  const ParamName *n1 = (const ParamName*)name1,
+                  *n2 = (const ParamName*)name2 ;
+  if ( n1->length != n2->length ) return ( n1->length < n2->length ) ? -1 : 1 ;
+  return compareExactNames( name1, name2 ) ;
+}
+
+/** Binary search in the given names, which must be sorted w/ compareNameTo. Returns NULL if not found. */
+static const ParamName* searchName( const ParamName* names, size_t count, const char* str, size_t length ) {
+  size_t low = 0,
+         high = count ;
+
+  while ( low < high ) {
+    size_t middle = low + ( high - low ) / 2 ;
+    int    cmp    = compareNameTo( str, length, names + middle ) ;
+    if ( !cmp ) return names + middle ;
+    if ( cmp < 0 ) high = middle ; else low = middle + 1 ;
+  }
+
+  return NULL ;
+}
+
+/** Returns the end of the group of the prefix names of the same length as the first of the given names. */
+static const ParamName* endOfPrefixGroup( const ParamName* names, const ParamName* end ) {
+  const ParamName *low  = names,
+                  *high = end ;
+
+  while ( low < high ) {
+    const ParamName* middle = low + ( high - low ) / 2 ;
+    if ( middle->length == names->length ) low = middle + 1 ; else high = middle ;
+  }
+
+  return low ;
+}
+
+/** Removes the duplicates from the given sorted names, keeping the first of each. Returns the number of names left. */
+static size_t removeDuplicateNames( ParamName* names, size_t count ) {
+  size_t i, j ;
+
+  for ( i = j = 0 ; i < count ; i++ ) {
+    if ( j && compareNameTo( names[ i ].name, names[ i ].length, names + j - 1 ) == 0 ) continue ;
+    names[ j++ ] = names[ i ] ;
+  }
+
+  return j ;
+}
+
+/** Fills in the index of the given param definitions, which must have room for the counts given by countParamNames. */
+static void indexParamDefinitions( JstParamIndex* paramIndex, const JstParamInfo* paramInfos, int paramCount ) {
+  ParamName       *names = INDEX_NAMES( paramIndex ),
+                  *prefixNames ;
+  ParamOccurrence *occurrences ;
+  size_t          exactNameCount,
+                  i, j ;
+  const char      **name ;
+  int             definition ;
+
+  countParamNames( paramInfos, &paramIndex->definitionCount, &exactNameCount, &paramIndex->prefixNameCount ) ;
+  prefixNames = names + exactNameCount ;
+  paramIndex->paramCount = paramCount ;
+
+  for ( definition = 0, i = j = 0 ; definition < paramIndex->definitionCount ; definition++ ) {
+    for ( name = paramInfos[ definition ].names ; *name ; name++ ) {
+      ParamName* target = ( paramInfos[ definition ].type == JST_PREFIX_PARAM ) ? prefixNames + j++ : names + i++ ;
+      target->name       = *name ;
+      target->length     = strlen( *name ) ;
+      target->definition = definition ;
+    }
+  }
+
+  qsort( names,       exactNameCount,         sizeof( ParamName ), compareExactNames ) ;
+  qsort( prefixNames, paramIndex->prefixNameCount, sizeof( ParamName ), comparePrefixNames ) ;
+
+  // the sorts put the first definition of a name first
+  paramIndex->exactNameCount  = removeDuplicateNames( names, exactNameCount ) ;
+  paramIndex->prefixNameCount = removeDuplicateNames( prefixNames, paramIndex->prefixNameCount ) ;
+  memmove( names + paramIndex->exactNameCount, prefixNames, paramIndex->prefixNameCount * sizeof( ParamName ) ) ;
+
+  occurrences = INDEX_OCCURRENCES( paramIndex ) ;
+  for ( definition = 0 ; definition < paramIndex->definitionCount ; definition++ ) occurrences[ definition ].firstParam = -1 ;
+}
+
+/** Returns the index of the definition the given arg matches, -1 if none. If several do, returns the first one given,
+ * as the param definitions used to be tried out in order.
+ * @param prefixLength set to the length of the prefix matched if the arg matches a prefix param, 0 otherwise */
+static int findParamDefinition( const JstParamIndex* paramIndex, const char* arg, size_t* prefixLength ) {
+  const ParamName *names = INDEX_NAMES( paramIndex ),
+                  *prefixNames = names + paramIndex->exactNameCount,
+                  *end         = prefixNames + paramIndex->prefixNameCount,
+                  *groupEnd,
+                  *found ;
+  size_t          argLength  = strlen( arg ) ;
+  int             definition = -1 ;
+
+  *prefixLength = 0 ;
+
+  if ( ( found = searchName( names, paramIndex->exactNameCount, arg, argLength ) ) ) definition = found->definition ;
+
+  // one binary search per prefix length
+  for ( ; prefixNames < end && prefixNames->length <= argLength ; prefixNames = groupEnd ) {
+    groupEnd = endOfPrefixGroup( prefixNames, end ) ;
+    if ( ( found = searchName( prefixNames, groupEnd - prefixNames, arg, prefixNames->length ) ) &&
+         ( definition == -1 || found->definition < definition ) ) {
+      definition    = found->definition ;
+      *prefixLength = found->length ;
+    }
+  }
+
+  return definition ;
+}
+
+
+struct JstParamScanner_ {
+  const JstParamInfo* paramInfos ;
+  const char**        terminatingSuffixes ;
+  /** the double param the next arg is the value of, NULL if none */
+  const JstParamInfo* valueOf ;
+  jboolean            terminated ;
+} ;
+
+/** The index of the param definitions follows the scanner in the same memory block. */
+#define SCANNER_INDEX( scanner ) ( (JstParamIndex*)( (scanner) + 1 ) )
+
+extern JstParamScanner* jst_createParamScanner( JstParamInfo* paramInfos, const char** terminatingSuffixes ) {
+  JstParamScanner* scanner ;
+  int    definitionCount ;
+  size_t exactNameCount, prefixNameCount ;
+
+  countParamNames( paramInfos, &definitionCount, &exactNameCount, &prefixNameCount ) ;
+
+  if ( !( scanner = jst_calloc( sizeof( JstParamScanner ) + sizeof( JstParamIndex ) +
+                                ( exactNameCount + prefixNameCount ) * sizeof( ParamName ) + definitionCount * sizeof( ParamOccurrence ), 1 ) ) ) return NULL ;
+
+  scanner->paramInfos          = paramInfos ;
+  scanner->terminatingSuffixes = terminatingSuffixes ;
+  indexParamDefinitions( SCANNER_INDEX( scanner ), paramInfos, 0 ) ;
+
+  return scanner ;
+}
+
+extern jboolean jst_scanParam( JstParamScanner* scanner, const char* arg ) {
+  size_t prefixLength ;
+  int    j ;
+
+  if ( scanner->terminated ) return JNI_TRUE ;
+
+  // the same rules as in jst_processInputParameters
+  if ( scanner->valueOf ) {
+    scanner->terminated = ( scanner->valueOf->handling & JST_TERMINATING ) ? JNI_TRUE : JNI_FALSE ;
+    scanner->valueOf    = NULL ;
+  } else if ( !arg[ 0 ] || jst_arrayContainsString( scanner->terminatingSuffixes, arg, SUFFIX_SEARCH ) != -1 ) {
+    scanner->terminated = JNI_TRUE ;
+  } else if ( ( j = findParamDefinition( SCANNER_INDEX( scanner ), arg, &prefixLength ) ) == -1 ) {
+    scanner->terminated = ( arg[ 0 ] != '-' ) ? JNI_TRUE : JNI_FALSE ;
+  } else if ( scanner->paramInfos[ j ].type == JST_DOUBLE_PARAM ) {
+    scanner->valueOf = scanner->paramInfos + j ;
+  } else {
+    scanner->terminated = ( scanner->paramInfos[ j ].handling & JST_TERMINATING ) ? JNI_TRUE : JNI_FALSE ;
+  }
+
+  return scanner->terminated ;
+}
+
+extern jboolean jst_scannerExpectsValue( const JstParamScanner* scanner ) {
+  return ( scanner->valueOf && !scanner->terminated ) ? JNI_TRUE : JNI_FALSE ;
+}
+
 
 static void printParameterClassification( JstInputParamHandling handlingFlags ) {
   // these correspond to the bits in JstInputParamHandling
@@ -131,112 +357,100 @@ extern JstActualParam* jst_processInputParameters( char** args, int numArgs, Jst
   // TODO: cygwin conversions of param values
   //       + for all input params after termination (if requested) => not a good idea, e.g. xpath params migh be transformed weird.
 
-  int    i, j ;
-  size_t usedSize   = ( numArgs + 1 ) * sizeof( JstActualParam ),
-         actualSize = usedSize
+  int    i, j, definitionCount ;
+  size_t exactNameCount, prefixNameCount, prefixLength ;
+  size_t usedSize, actualSize ;
+  JstActualParam* processedParams ;
+
+  countParamNames( paramInfos, &definitionCount, &exactNameCount, &prefixNameCount ) ;
+
+  usedSize   = ( numArgs + 1 ) * sizeof( JstActualParam ) + sizeof( JstParamIndex ) +
+               ( exactNameCount + prefixNameCount ) * sizeof( ParamName ) + definitionCount * sizeof( ParamOccurrence ) ;
+  actualSize = usedSize
 #if defined( _WIN32 ) && defined( _cwcompat )
-         + 50 * numArgs
+               + 50 * numArgs
 #endif
-         , len ;
-  JstActualParam* processedParams = jst_calloc( actualSize, 1 ) ;
+               ;
 
-  if ( !processedParams ) return NULL ;
+  if ( !( processedParams = jst_calloc( actualSize, 1 ) ) ) return NULL ;
+
+  indexParamDefinitions( PARAM_INDEX( processedParams, numArgs ), paramInfos, numArgs ) ;
 
   // FIXME - this is too complex - refactor into smaller pieces
 
   for ( i = 0 ; i < numArgs ; i++ ) {
-    char *arg = args[ i ] ;
-    int found = JNI_FALSE ;
+    char *arg = args[ i ],
+         *value = NULL ;
+    JstParamClass paramClass ;
 
     if ( ( arg[ 0 ] == 0 ) ||  // empty strs are always considered to be terminating args to the launchee
          ( jst_arrayContainsString( terminatingSuffixes, arg, SUFFIX_SEARCH ) != -1 ) ) {
       goto end ;
     }
 
-    for ( j = 0 ; paramInfos[ j ].names && !found ; j++ ) {
-      char* value = NULL ;
-      JstParamClass paramClass = paramInfos[ j ].type ;
-
-      switch ( paramClass ) {
-        case JST_SINGLE_PARAM :
-          if ( jst_arrayContainsString( paramInfos[ j ].names, arg, EXACT_SEARCH ) != -1 ) {
-            found = JNI_TRUE ;
-            processedParams[ i ].param = arg ;
-            value = "" ;
-            processedParams[ i ].handling = paramInfos[ j ].handling ;
-          }
-          break ;
-        case JST_DOUBLE_PARAM :
-          if ( jst_arrayContainsString( paramInfos[ j ].names, arg, EXACT_SEARCH ) != -1 ) {
-            JstInputParamHandling handling = paramInfos[ j ].handling ;
-            found = JNI_TRUE ;
-            processedParams[ i ].param = arg ;
-            processedParams[ i ].handling = handling ;
-            if ( ++i >= numArgs ) {
-              fprintf( stderr, "error: illegal use of %s (requires a value)\n", arg ) ;
-              free( processedParams ) ;
-              return NULL ;
-            }
-            processedParams[ i ].param = value = args[ i ] ;
-            processedParams[ i ].handling = handling ;
-          }
-          break ;
-        case JST_PREFIX_PARAM :
-        {
-          const char* pname ;
-          int k ;
-          for ( k = 0 ; !found && ( pname = paramInfos[ j ].names[ k ] ) ; k++ ) {
-            len = strlen( pname ) ;
-            if ( memcmp( pname, arg, len ) == 0 ) {
-              found = JNI_TRUE ;
-              processedParams[ i ].param = arg ;
-              if ( (int)( usedSize + len + 1 ) > (int)actualSize ) {
-                processedParams = jst_realloc( processedParams, actualSize += ( 100 + len ) ) ;
-                if ( !processedParams ) return NULL ;
-              }
-
-              value = arg ;
-              processedParams[ i ].handling = paramInfos[ j ].handling ;
-            }
-          }
-          break ;
-        }
-      } // switch
+    j = findParamDefinition( PARAM_INDEX( processedParams, numArgs ), arg, &prefixLength ) ;
 
-      if ( found ) {
+    if ( j == -1 ) {
+      if ( arg[ 0 ] == '-' ) {
+        processedParams[ i ].param = arg ;
+        processedParams[ i ].handling = JST_UNRECOGNIZED ;
+        processedParams[ i ].value = arg ;
+        continue ;
+      } else {
+        goto end ;
+      }
+    }
 
-#if defined ( _WIN32 ) && defined ( _cwcompat )
+    paramClass = paramInfos[ j ].type ;
+    processedParams[ i ].param = arg ;
+    processedParams[ i ].handling = paramInfos[ j ].handling ;
 
-        if ( CYGWIN_LOADED &&
-             ( processedParams[ i ].handling & ( JST_CYGWIN_PATH_CONVERT | JST_CYGWIN_PATHLIST_CONVERT ) ) ) {
-          value = cygwinConvertStringAndAppendInTheEndOfGivenBufferIfNotEqualToOriginal( value, &processedParams, &usedSize, &actualSize, processedParams[ i ].handling ) ;
-          if ( !value ) return NULL ;
+    switch ( paramClass ) {
+      case JST_SINGLE_PARAM :
+        value = "" ;
+        break ;
+      case JST_DOUBLE_PARAM :
+        if ( ++i >= numArgs ) {
+          fprintf( stderr, "error: illegal use of %s (requires a value)\n", arg ) ;
+          free( processedParams ) ;
+          return NULL ;
         }
+        processedParams[ i ].param = value = args[ i ] ;
+        processedParams[ i ].handling = paramInfos[ j ].handling ;
+        break ;
+      case JST_PREFIX_PARAM :
+        value = arg ;
+        break ;
+    } // switch
+
+#if defined ( _WIN32 ) && defined ( _cwcompat )
+
+    if ( CYGWIN_LOADED &&
+         ( processedParams[ i ].handling & ( JST_CYGWIN_PATH_CONVERT | JST_CYGWIN_PATHLIST_CONVERT ) ) ) {
+      value = cygwinConvertStringAndAppendInTheEndOfGivenBufferIfNotEqualToOriginal( value, &processedParams, &usedSize, &actualSize, processedParams[ i ].handling ) ;
+      if ( !value ) return NULL ;
+    }
 
 #endif
 
-        processedParams[ i ].value = value ;
-        if ( paramClass == JST_DOUBLE_PARAM ) {
-          processedParams[ i - 1 ].value = value ;
-          processedParams[ i - 1 ].paramDefinition = paramInfos + j ;
-        }
-        processedParams[ i ].paramDefinition = paramInfos + j ;
-        if ( ( processedParams[ i ].handling ) & JST_TERMINATING ) {
-          goto end ;
-        }
-        break ;
-      }
-    } // for j
+    processedParams[ i ].value = value ;
+    if ( paramClass == JST_DOUBLE_PARAM ) {
+      processedParams[ i - 1 ].value = value ;
+      processedParams[ i - 1 ].paramDefinition = paramInfos + j ;
+    }
+    processedParams[ i ].paramDefinition = paramInfos + j ;
+    if ( ( processedParams[ i ].handling ) & JST_TERMINATING ) {
+      goto end ;
+    }
 
-    if ( !found ) {
-      if ( arg[ 0 ] == '-' ) {
-        processedParams[ i ].param = arg ;
-        processedParams[ i ].handling = JST_UNRECOGNIZED ;
-        processedParams[ i ].value = arg ;
-      } else {
-        goto end ;
+    {
+      ParamOccurrence* occurrence = INDEX_OCCURRENCES( PARAM_INDEX( processedParams, numArgs ) ) + j ;
+      if ( occurrence->firstParam == -1 ) {
+        occurrence->firstParam   = ( paramClass == JST_DOUBLE_PARAM ) ? i - 1 : i ;
+        occurrence->prefixLength = prefixLength ;
       }
     }
+
   } // for i
 
   end:
@@ -263,6 +477,9 @@ extern JstActualParam* jst_processInputParameters( char** args, int numArgs, Jst
     assert( processedParams ) ; // shrinking the buffer, should always succeed
   }
 
+  // the block does not move any more
+  for ( i = 0 ; i <= numArgs ; i++ ) processedParams[ i ].index = PARAM_INDEX( processedParams, numArgs ) ;
+
   return processedParams ;
 
 }
@@ -284,25 +501,28 @@ extern int jst_isToBePassedToLaunchee( const JstActualParam* processedParam, Jst
 
 extern char* jst_getParameterValue( const JstActualParam* processedParams, const char* paramName ) {
 
-  JstParamInfo* paramDef ;
-  char* rval = NULL ;
-
-  for ( ; !rval && processedParams->param ; processedParams++ ) {
-    if ( ( processedParams->handling ) & JST_TERMINATING_OR_AFTER ) break ;
-    paramDef = processedParams->paramDefinition ;
-    if ( paramDef ) {
-       if ( ( paramDef->handling & JST_SINGLE_PARAM || paramDef->handling & JST_DOUBLE_PARAM ) &&
-          ( jst_arrayContainsString( paramDef->names, paramName, EXACT_SEARCH ) != -1 ) ) {
-        rval = processedParams->value ;
-      } else if ( ( paramDef->type == JST_PREFIX_PARAM ) &&
-                  ( jst_arrayContainsString( paramDef->names, paramName, PREFIX_SEARCH ) != -1 ) ) {
-        size_t len = strlen( paramName ) ;
-        rval = ( processedParams->value ) + len ;
-      }
+  const JstParamIndex   *paramIndex = processedParams->index ;
+  // the index is right after the params it was created for (processedParams may be a copy)
+  const JstActualParam  *params = (const JstActualParam*)paramIndex - ( paramIndex->paramCount + 1 ) ;
+  const ParamName       *names  = INDEX_NAMES( paramIndex ),
+                        *name ;
+  const ParamOccurrence *occurrence ;
+  size_t                length = strlen( paramName ) ;
+
+  if ( !( name = searchName( names, paramIndex->exactNameCount, paramName, length ) ) ) {
+    const ParamName *prefixNames = names + paramIndex->exactNameCount,
+                    *end         = prefixNames + paramIndex->prefixNameCount,
+                    *groupEnd ;
+    for ( ; prefixNames < end && !name ; prefixNames = groupEnd ) {
+      groupEnd = endOfPrefixGroup( prefixNames, end ) ;
+      if ( prefixNames->length == length ) name = searchName( prefixNames, groupEnd - prefixNames, paramName, length ) ;
     }
+    if ( !name ) return NULL ;
   }
 
-  return rval ;
+  occurrence = INDEX_OCCURRENCES( paramIndex ) + name->definition ;
+
+  return ( occurrence->firstParam == -1 ) ? NULL : params[ occurrence->firstParam ].value + occurrence->prefixLength ;
 
 }
 
@@ -0,0 +1,167 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined( _WIN32 )
+#  include <limits.h>
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <pthread.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#endif
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_prefetch.h"
+
+#if !defined( _WIN32 )
+
+/** The end of central directory record of a zip file is this long plus a comment of at most 64k. */
+#define ZIP_EOCD_SIZE        22
+#define ZIP_MAX_COMMENT_SIZE 0xffff
+#define ZIP_EOCD_SIGNATURE   "PK\005\006"
+
+#define JIMAGE_MAGIC       0xcafedadaU
+#define JIMAGE_HEADER_SIZE 28
+
+/** Asks the os to read the given range of the file. Returns the number of bytes asked for, 0 if the advice failed. */
+static jlong adviseRead( int fd, jlong offset, jlong length ) {
+  if ( length <= 0 ) return 0 ;
+#if defined( __APPLE__ )
+  {
+    struct radvisory advice ;
+    advice.ra_offset = (off_t)offset ;
+    advice.ra_count  = ( length > INT_MAX ) ? INT_MAX : (int)length ;
+    if ( fcntl( fd, F_RDADVISE, &advice ) == -1 ) return 0 ;
+  }
+#else
+  if ( posix_fadvise( fd, (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED ) ) return 0 ;
+#endif
+  return length ;
+}
+
+static unsigned int littleEndianInt( const unsigned char* bytes ) {
+  return (unsigned int)bytes[ 0 ] | ( (unsigned int)bytes[ 1 ] << 8 ) | ( (unsigned int)bytes[ 2 ] << 16 ) | ( (unsigned int)bytes[ 3 ] << 24 ) ;
+}
+
+/** The central directory first, then the entries. If the central directory can not be found, the whole file. */
+static jlong prefetchZip( int fd, jlong fileSize, unsigned char* buffer ) {
+  jlong  tailStart = ( fileSize > ZIP_EOCD_SIZE + ZIP_MAX_COMMENT_SIZE ) ? fileSize - ( ZIP_EOCD_SIZE + ZIP_MAX_COMMENT_SIZE ) : 0 ;
+  size_t tailSize  = (size_t)( fileSize - tailStart ) ;
+  jlong  cdOffset,
+         cdSize ;
+  int    i ;
+
+  if ( tailSize >= ZIP_EOCD_SIZE && pread( fd, buffer, tailSize, (off_t)tailStart ) == (ssize_t)tailSize ) {
+    for ( i = (int)( tailSize - ZIP_EOCD_SIZE ) ; i >= 0 ; i-- ) {
+      if ( memcmp( buffer + i, ZIP_EOCD_SIGNATURE, 4 ) ) continue ;
+
+      cdSize   = littleEndianInt( buffer + i + 12 ) ;
+      cdOffset = littleEndianInt( buffer + i + 16 ) ;
+      // zip64 files (with the offset in another record) and broken ones are read as a whole
+      if ( cdOffset + cdSize > fileSize ) break ;
+
+      return adviseRead( fd, cdOffset, cdSize ) + adviseRead( fd, 0, cdOffset ) ;
+    }
+  }
+
+  return adviseRead( fd, 0, fileSize ) ;
+}
+
+/** The jimage index (header, lookup tables and strings). The resources are left out, reading them all would mean reading
+ * the whole jdk. */
+static jlong prefetchJimageIndex( int fd, jlong fileSize ) {
+  unsigned int header[ JIMAGE_HEADER_SIZE / 4 ] ;
+  jlong        indexSize ;
+  int          i ;
+
+  if ( pread( fd, header, sizeof( header ), 0 ) != (ssize_t)sizeof( header ) ) return 0 ;
+
+  // the image is written in the native byte order of the platform it was built for
+  if ( header[ 0 ] != JIMAGE_MAGIC ) {
+    for ( i = 0 ; i < JIMAGE_HEADER_SIZE / 4 ; i++ ) {
+      header[ i ] = ( header[ i ] >> 24 ) | ( ( header[ i ] >> 8 ) & 0xff00U ) | ( ( header[ i ] << 8 ) & 0xff0000U ) | ( header[ i ] << 24 ) ;
+    }
+    if ( header[ 0 ] != JIMAGE_MAGIC ) return 0 ;
+  }
+
+  // header, redirect table, offsets table, locations, strings
+  indexSize = JIMAGE_HEADER_SIZE + (jlong)header[ 4 ] * 8 + header[ 5 ] + header[ 6 ] ;
+
+  return adviseRead( fd, 0, ( indexSize < fileSize ) ? indexSize : fileSize ) ;
+}
+
+static void* prefetchThread( void* arg ) {
+  char          **files = (char**)arg ;
+  unsigned char *buffer = (unsigned char*)malloc( ZIP_EOCD_SIZE + ZIP_MAX_COMMENT_SIZE ) ;
+  jlong         bytes   = 0 ;
+  int           fileCount = 0,
+                i ;
+
+  for ( i = 0 ; files[ i ] ; i++ ) {
+    const char  *name = files[ i ],
+                *baseName = strrchr( name, JST_FILE_SEPARATOR[ 0 ] ) ;
+    size_t      nameLen = strlen( name ) ;
+    struct stat fileStat ;
+    int         fd ;
+
+    if ( ( fd = open( name, O_RDONLY ) ) == -1 ) continue ;
+
+    if ( fstat( fd, &fileStat ) == 0 && S_ISREG( fileStat.st_mode ) && fileStat.st_size > 0 ) {
+      baseName = baseName ? baseName + 1 : name ;
+      fileCount++ ;
+      if ( buffer && nameLen > 4 && ( strcmp( name + nameLen - 4, ".jar" ) == 0 || strcmp( name + nameLen - 4, ".zip" ) == 0 ) ) {
+        bytes += prefetchZip( fd, (jlong)fileStat.st_size, buffer ) ;
+      } else if ( strcmp( baseName, "modules" ) == 0 ) {
+        bytes += prefetchJimageIndex( fd, (jlong)fileStat.st_size ) ;
+      } else {
+        bytes += adviseRead( fd, 0, (jlong)fileStat.st_size ) ;
+      }
+    }
+
+    close( fd ) ;
+  }
+
+  if ( _jst_debug ) fprintf( stderr, "debug: prefetched %ld kB of %d files\n", (long)( bytes / 1024 ), fileCount ) ;
+
+  if ( buffer ) free( buffer ) ;
+  jst_freeAll( (void***)(void*)&files ) ;
+
+  return NULL ;
+}
+
+#endif
+
+extern void jst_prefetchFiles( char** files ) {
+#if !defined( _WIN32 )
+  pthread_t      thread ;
+  pthread_attr_t attr ;
+
+  if ( !getenv( JST_NOPREFETCH_ENV_VAR_NAME ) && pthread_attr_init( &attr ) == 0 ) {
+    int started = pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED ) == 0 &&
+                  pthread_create( &thread, &attr, prefetchThread, files ) == 0 ;
+    pthread_attr_destroy( &attr ) ;
+    if ( started ) return ;
+  }
+#endif
+
+  jst_freeAll( (void***)(void*)&files ) ;
+}
@@ -0,0 +1,45 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Readahead of the files the jvm reads at startup. When the os page cache is cold, creating the jvm and loading the
+// first classes stall on reads scattered all over the jars and the jdk files. Telling the os up front which files are
+// about to be read lets it read them in large sequential chunks while the jvm is being created.
+//
+// The advice is given on a background thread, as it may block while the os queues the reads. Only supported on posix
+// systems, nothing is done on windows.
+
+#if !defined( _JST_PREFETCH_H_ )
+#  define _JST_PREFETCH_H_
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** If this env var is set, no prefetching is done. */
+#define JST_NOPREFETCH_ENV_VAR_NAME "__JLAUNCHER_NOPREFETCH"
+
+/** Starts reading the given files into the os page cache in the background. Of zip files (jars), the central directory is
+ * read first as that is what the jvm reads when opening one. Of a jdk modules image, only the index is read, as the
+ * classes needed at startup usually come from the class data sharing archive.
+ * Files that do not exist are skipped. Nothing is printed except debug output, which reports the number of bytes prefetched.
+ * @param files NULL terminated. Owned by this function, it is freed w/ jst_freeAll when no longer needed. */
+void jst_prefetchFiles( char** files ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
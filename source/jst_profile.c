@@ -0,0 +1,245 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined( _WIN32 )
+#  include <sys/time.h>
+#  include <sys/resource.h>
+#endif
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_cache.h"
+#include "jst_profile.h"
+
+#define HISTORY_SUBDIR "history"
+
+/** The number of most recent runs kept in the history. */
+#define HISTORY_LENGTH 10
+
+/** The number of runs needed before a profile is chosen automatically. */
+#define MIN_HISTORY_LENGTH 3
+
+/** Apps whose median run is shorter than this get the startup profile, unless they use a lot of memory, as the serial gc
+ * pauses get long on big heaps. */
+#define STARTUP_MAX_MILLIS 2000
+#define STARTUP_MAX_RSS_KB ( 512 * 1024 )
+
+/** Apps whose median run is longer than this get the throughput profile, as do those running longer than GC_BOUND_MIN_MILLIS
+ * that spend at least GC_BOUND_MIN_PERCENT of the time in gc. */
+#define THROUGHPUT_MIN_MILLIS 60000
+#define GC_BOUND_MIN_MILLIS   10000
+#define GC_BOUND_MIN_PERCENT  10
+
+typedef struct {
+  long runMillis ;
+  /** -1 if not known */
+  long peakRssKb ;
+  /** -1 if not known */
+  long gcMillis ;
+} RunRecord ;
+
+/** The history file of the app being run, NULL if no history is kept. */
+static char* historyFile = NULL ;
+
+static const char* gcOptions[]           = { "-XX:+UseSerialGC", "-XX:+UseParallelGC", "-XX:+UseParallelOldGC", "-XX:+UseParNewGC",
+                                             "-XX:+UseConcMarkSweepGC", "-XX:+UseG1GC", "-XX:+UseZGC", "-XX:+UseShenandoahGC",
+                                             "-XX:+UseEpsilonGC", NULL } ;
+static const char* jitOptions[]          = { "-XX:TieredStopAtLevel=", "-XX:-TieredCompilation", "-Xint", "-Xcomp", NULL } ;
+static const char* initialHeapOptions[]  = { "-Xms", "-XX:InitialHeapSize=", "-Xmx", "-XX:MaxHeapSize=", NULL } ;
+
+static const char* profileNames[] = { "none", "auto", "startup", "throughput", NULL } ;
+
+extern int jst_parseJvmProfile( const char* name ) {
+  int i ;
+
+  for ( i = 0 ; profileNames[ i ] ; i++ ) {
+    if ( strcmp( name, profileNames[ i ] ) == 0 ) return i ;
+  }
+
+  fprintf( stderr, "error: unknown jvm profile %s, expected one of auto, startup, throughput or none\n", name ) ;
+  return -1 ;
+}
+
+/** Returns the history file of the given app, NULL if there is no usable cache dir or on error. */
+static char* getHistoryFile( const char* historyKey ) {
+  char *dir,
+       *file,
+       hex[ JST_HASH_HEX_LEN ] ;
+
+  if ( !( dir = jst_getCacheDir( HISTORY_SUBDIR, JNI_TRUE ) ) ) return NULL ;
+
+  jst_hashToHex( jst_hashString( jst_hashString( JST_HASH_INIT, "jst-history-1" ), historyKey ), hex ) ;
+  file = jst_createFileName( dir, hex, NULL ) ;
+
+  free( dir ) ;
+  return file ;
+}
+
+/** Reads the runs in the history file into the given array (of HISTORY_LENGTH records), oldest first. Returns the count. */
+static int loadHistory( RunRecord* runs ) {
+  FILE* file = fopen( historyFile, "r" ) ;
+  int   count = 0 ;
+
+  if ( !file ) return 0 ;
+
+  while ( count < HISTORY_LENGTH && fscanf( file, "%ld %ld %ld", &runs[ count ].runMillis, &runs[ count ].peakRssKb, &runs[ count ].gcMillis ) == 3 ) count++ ;
+
+  fclose( file ) ;
+  return count ;
+}
+
+static int compareLongs( const void* a, const void* b ) {
+  long x = *(const long*)a,
+       y = *(const long*)b ;
+  return ( x < y ) ? -1 : ( x > y ) ? 1 : 0 ;
+}
+
+/** Returns the median of the given field of the given runs, leaving out the unknown (negative) values. -1 if none is known. */
+static long medianOf( const RunRecord* runs, int count, size_t fieldOffset ) {
+  long values[ HISTORY_LENGTH ] ;
+  int  known = 0,
+       i ;
+
+  for ( i = 0 ; i < count ; i++ ) {
+    long value = *(const long*)( (const char*)( runs + i ) + fieldOffset ) ;
+    if ( value >= 0 ) values[ known++ ] = value ;
+  }
+
+  if ( !known ) return -1 ;
+
+  qsort( values, (size_t)known, sizeof( long ), compareLongs ) ;
+  return values[ known / 2 ] ;
+}
+
+/** Chooses the profile by the history of the app. */
+static JstJvmProfile chooseProfile( void ) {
+  RunRecord runs[ HISTORY_LENGTH ] ;
+  int       count = loadHistory( runs ) ;
+  long      runMillis,
+            peakRssKb,
+            gcMillis ;
+
+  if ( count < MIN_HISTORY_LENGTH ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not choosing a jvm profile, only %d runs in the history\n", count ) ;
+    return JST_PROFILE_NONE ;
+  }
+
+  runMillis = medianOf( runs, count, offsetof( RunRecord, runMillis ) ) ;
+  peakRssKb = medianOf( runs, count, offsetof( RunRecord, peakRssKb ) ) ;
+  gcMillis  = medianOf( runs, count, offsetof( RunRecord, gcMillis ) ) ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: median of the last %d runs: %ld ms, peak rss %ld KB, gc %ld ms\n", count, runMillis, peakRssKb, gcMillis ) ;
+
+  if ( runMillis < STARTUP_MAX_MILLIS && peakRssKb < STARTUP_MAX_RSS_KB ) return JST_PROFILE_STARTUP ;
+
+  if ( runMillis >= THROUGHPUT_MIN_MILLIS ||
+       ( runMillis >= GC_BOUND_MIN_MILLIS && gcMillis * 100 >= runMillis * GC_BOUND_MIN_PERCENT ) ) return JST_PROFILE_THROUGHPUT ;
+
+  return JST_PROFILE_NONE ;
+}
+
+/** Appends the given option unless the user has given one of the given options. Returns 0 on error. */
+static int addOption( JstJvmOptions* jvmOptions, char* option, const char** userOptions ) {
+  const char* userOption = jst_findJvmOption( jvmOptions, userOptions ) ;
+
+  if ( userOption ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not adding %s, the user has given %s\n", option, userOption ) ;
+    return 1 ;
+  }
+
+  return appendJvmOption( jvmOptions, option, NULL ) ? 1 : 0 ;
+}
+
+extern int jst_addProfileOptions( JstJvmOptions* jvmOptions, JstJvmProfile profile, const char* historyKey ) {
+
+  if ( historyKey && !historyFile && jst_cachingEnabled() ) historyFile = getHistoryFile( historyKey ) ;
+
+  if ( profile == JST_PROFILE_AUTO ) profile = historyFile ? chooseProfile() : JST_PROFILE_NONE ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: using the %s jvm profile\n", profileNames[ profile ] ) ;
+
+  switch ( profile ) {
+    case JST_PROFILE_STARTUP :
+      // only the fast c1 jit, which is all a short run has time for
+      return addOption( jvmOptions, "-XX:TieredStopAtLevel=1", jitOptions ) &&
+             addOption( jvmOptions, "-XX:+UseSerialGC",        gcOptions ) &&
+             addOption( jvmOptions, "-Xms16m",                 initialHeapOptions ) ;
+    case JST_PROFILE_THROUGHPUT :
+      return addOption( jvmOptions, "-XX:+UseParallelGC", gcOptions ) ;
+    default :
+      return 1 ;
+  }
+
+}
+
+extern jboolean jst_keepingRunHistory( void ) {
+  return historyFile ? JNI_TRUE : JNI_FALSE ;
+}
+
+/** Returns the peak rss of this process in kilobytes, -1 if not known. */
+static long getPeakRssKb( void ) {
+#if !defined( _WIN32 )
+  struct rusage usage ;
+
+  if ( getrusage( RUSAGE_SELF, &usage ) ) return -1 ;
+#  if defined( __APPLE__ )
+  // bytes on os x, kilobytes elsewhere
+  return (long)( usage.ru_maxrss / 1024 ) ;
+#  else
+  return (long)usage.ru_maxrss ;
+#  endif
+#else
+  return -1 ;
+#endif
+}
+
+extern void jst_recordRun( jlong runMillis, jlong gcMillis ) {
+  RunRecord runs[ HISTORY_LENGTH ] ;
+  char      data[ HISTORY_LENGTH * 64 ] ;
+  size_t    size = 0 ;
+  int       count,
+            recorded,
+            i ;
+
+  if ( !historyFile ) return ;
+
+  count = loadHistory( runs ) ;
+  if ( count == HISTORY_LENGTH ) {
+    memmove( runs, runs + 1, ( HISTORY_LENGTH - 1 ) * sizeof( RunRecord ) ) ;
+    count-- ;
+  }
+  runs[ count ].runMillis = (long)runMillis ;
+  runs[ count ].peakRssKb = getPeakRssKb() ;
+  runs[ count ].gcMillis  = (long)gcMillis ;
+  count++ ;
+
+  for ( i = 0 ; i < count ; i++ ) {
+    size += (size_t)sprintf( data + size, "%ld %ld %ld\n", runs[ i ].runMillis, runs[ i ].peakRssKb, runs[ i ].gcMillis ) ;
+  }
+
+  recorded = jst_writeFileAtomically( historyFile, data, size ) ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: %s the run (%ld ms, peak rss %ld KB, gc %ld ms) in %s\n", recorded ? "recorded" : "could not record",
+                             runs[ count - 1 ].runMillis, runs[ count - 1 ].peakRssKb, runs[ count - 1 ].gcMillis, historyFile ) ;
+
+  jst_free( historyFile ) ;
+}
@@ -0,0 +1,57 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Jvm flag profiles (see JstJvmProfile) and the run history they are chosen by. The history of an app holds the run time
+// (of the main method), peak rss and gc time of its last few runs, and is kept in the launcher cache dir (see jst_cache.h).
+// An app whose runs have been short gets the startup profile, one whose runs have been long (or gc bound) the throughput
+// profile. Until there is enough history, and for apps in between, no flags are added.
+//
+// The flags of a profile are only added if the user has not given any flags to the same effect, e.g. the startup profile
+// does not add -XX:+UseSerialGC if the user has chosen a gc.
+
+#if !defined( _JST_PROFILE_H_ )
+#  define _JST_PROFILE_H_
+
+#include "jvmstarter.h"
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** Returns the profile w/ the given name ("auto", "startup", "throughput" or "none"), -1 if there is no such profile (err msg printed). */
+int jst_parseJvmProfile( const char* name ) ;
+
+/** Appends the flags of the given profile to the given jvm options, which must already contain all the options given by
+ * the user. For JST_PROFILE_AUTO the profile is chosen by the run history of the given app. The choice is reported in
+ * debug output. The run of the app is recorded w/ jst_recordRun.
+ * @param historyKey identifies the app in the run history. If NULL (or caching is disabled), no history is kept.
+ * @return 0 on error (err msg printed) */
+int jst_addProfileOptions( JstJvmOptions* jvmOptions, JstJvmProfile profile, const char* historyKey ) ;
+
+/** Whether a history is kept of the app given to jst_addProfileOptions, i.e. whether jst_recordRun does anything. */
+jboolean jst_keepingRunHistory( void ) ;
+
+/** Records a run of the app given to jst_addProfileOptions in its history. The peak rss of the process is taken at the time
+ * of the call. Failing to record is not an error, it is just reported in debug output. Only the first call does anything.
+ * @param runMillis how long the app ran, from calling its main method until the jvm was destroyed (or exited)
+ * @param gcMillis the time spent in gc, -1 if not known */
+void jst_recordRun( jlong runMillis, jlong gcMillis ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
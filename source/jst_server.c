@@ -0,0 +1,563 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if !defined( _WIN32 )
+#  include <limits.h>
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <sys/wait.h>
+#endif
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_fileutils.h"
+#include "jst_server.h"
+
+#if defined( _WIN32 )
+
+extern char* jst_getServerSocketPath( JstHash key ) {
+  if ( _jst_debug ) fprintf( stderr, "debug: server mode is not supported on windows\n" ) ;
+  return NULL ;
+}
+
+extern int  jst_sendServerRequest( const char* socketPath, char** args, char** properties, int* exitCode ) { return 0 ; }
+extern int  jst_spawnServer( const char* socketPath ) { return -1 ; }
+extern int  jst_acceptServerRequest( int serverSocket, JstServerRequest* request ) { return 0 ; }
+extern void jst_finishServerRequest( JstServerRequest* request, int exitCode ) {}
+extern void JNICALL jst_serverExitHook( jint exitCode ) {}
+
+#else
+
+#define SERVER_SUBDIR "servers"
+
+/** "JST2" */
+#define SERVER_PROTOCOL_MAGIC 0x4a535432u
+
+/** Requests larger than this are rejected. */
+#define MAX_REQUEST_SIZE ( 16 * 1024 * 1024 )
+
+/** Sent by the server once it has taken a request. If the client does not get this, the request was not handled. */
+#define REQUEST_ACCEPTED 'A'
+
+/** A request is this header, followed by payloadSize bytes of nul terminated strings: the working dir, argCount args,
+ * envCount environment entries and propertyCount system properties. The client's stdin, stdout and stderr are sent along with the header. */
+typedef struct {
+  unsigned int magic ;
+  unsigned int argCount ;
+  unsigned int envCount ;
+  unsigned int propertyCount ;
+  unsigned int payloadSize ;
+} ServerRequestHeader ;
+
+// a peer that has gone away must not kill the process w/ SIGPIPE
+#if defined( MSG_NOSIGNAL )
+#  define SEND_FLAGS MSG_NOSIGNAL
+#else
+#  define SEND_FLAGS 0
+#endif
+
+extern char** environ ;
+
+/** The socket path and stderr of the server process (w/ stdin and stdout, stderr is redirected to the clients' for the duration of each request). */
+static char* serverSocketPath = NULL ;
+static int   serverLogFd      = -1 ;
+/** the connection to the client whose request is being run, -1 if none */
+static int   currentConnection = -1 ;
+
+/** Returns 0 on failure. */
+static int readFully( int fd, void* buffer, size_t size ) {
+  char *p = (char*)buffer ;
+
+  while ( size ) {
+    ssize_t count = read( fd, p, size ) ;
+    if ( count < 0 && errno == EINTR ) continue ;
+    if ( count <= 0 ) return 0 ;
+    p    += count ;
+    size -= count ;
+  }
+
+  return 1 ;
+}
+
+/** Writes to the given socket. Returns 0 on failure. */
+static int writeFully( int fd, const void* data, size_t size ) {
+  const char *p = (const char*)data ;
+
+  while ( size ) {
+    ssize_t count = send( fd, p, size, SEND_FLAGS ) ;
+    if ( count < 0 && errno == EINTR ) continue ;
+    if ( count <= 0 ) return 0 ;
+    p    += count ;
+    size -= count ;
+  }
+
+  return 1 ;
+}
+
+static int fillSocketAddress( struct sockaddr_un* address, const char* socketPath ) {
+  if ( strlen( socketPath ) >= sizeof( address->sun_path ) ) return 0 ;
+
+  memset( address, 0, sizeof( *address ) ) ;
+  address->sun_family = AF_UNIX ;
+  strcpy( address->sun_path, socketPath ) ;
+
+  return 1 ;
+}
+
+extern char* jst_getServerSocketPath( JstHash key ) {
+  char        *dir  = NULL,
+              *path = NULL,
+              hex[ JST_HASH_HEX_LEN ] ;
+  struct stat dirStat ;
+  struct sockaddr_un address ;
+
+  if ( !( dir = jst_getCacheDir( SERVER_SUBDIR, JNI_TRUE ) ) ) return NULL ;
+
+  // anyone who can connect to a server can make it run code as this user, so no one else may get to the sockets
+  if ( chmod( dir, 0700 ) || stat( dir, &dirStat ) || dirStat.st_uid != getuid() ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not using server mode as the permissions of %s can not be restricted\n", dir ) ;
+    goto end ;
+  }
+
+  path = jst_createFileName( dir, jst_hashToHex( key, hex ), NULL ) ;
+
+  if ( path && !fillSocketAddress( &address, path ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: not using server mode as the socket path %s is too long\n", path ) ;
+    jst_free( path ) ;
+  }
+
+  end:
+  jst_free( dir ) ;
+  return path ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// client
+
+/** Returns the connected socket or -1 if there is no server listening. */
+static int connectToServer( const char* socketPath ) {
+  struct sockaddr_un address ;
+  int sock ;
+
+  if ( !fillSocketAddress( &address, socketPath ) ||
+       ( sock = socket( AF_UNIX, SOCK_STREAM, 0 ) ) == -1 ) return -1 ;
+
+#if defined( SO_NOSIGPIPE )
+  {
+    int on = 1 ;
+    setsockopt( sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof( on ) ) ;
+  }
+#endif
+
+  if ( connect( sock, (struct sockaddr*)&address, sizeof( address ) ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: no server listening on %s: %s\n", socketPath, strerror( errno ) ) ;
+    close( sock ) ;
+    return -1 ;
+  }
+
+  return sock ;
+}
+
+/** Appends the given strings to the payload (if given) and returns the total size of the strings. */
+static size_t appendStrings( char** strings, char* payload, unsigned int* count ) {
+  size_t size = 0 ;
+
+  for ( *count = 0 ; strings && *strings ; strings++, (*count)++ ) {
+    size_t len = strlen( *strings ) + 1 ;
+    if ( payload ) memcpy( payload + size, *strings, len ) ;
+    size += len ;
+  }
+
+  return size ;
+}
+
+/** Sends the header with the given fds attached. Returns 0 on failure. */
+static int sendHeader( int sock, ServerRequestHeader* header, int* fds, int fdCount ) {
+  struct msghdr   message ;
+  struct iovec    iov ;
+  struct cmsghdr* controlMessage ;
+  union {
+    struct cmsghdr align ;
+    char           buffer[ CMSG_SPACE( 3 * sizeof( int ) ) ] ;
+  } control ;
+
+  memset( &message, 0, sizeof( message ) ) ;
+  memset( &control, 0, sizeof( control ) ) ;
+
+  iov.iov_base = (void*)header ;
+  iov.iov_len  = sizeof( *header ) ;
+  message.msg_iov        = &iov ;
+  message.msg_iovlen     = 1 ;
+  message.msg_control    = control.buffer ;
+  message.msg_controllen = CMSG_SPACE( fdCount * sizeof( int ) ) ;
+
+  controlMessage = CMSG_FIRSTHDR( &message ) ;
+  controlMessage->cmsg_level = SOL_SOCKET ;
+  controlMessage->cmsg_type  = SCM_RIGHTS ;
+  controlMessage->cmsg_len   = CMSG_LEN( fdCount * sizeof( int ) ) ;
+  memcpy( CMSG_DATA( controlMessage ), fds, fdCount * sizeof( int ) ) ;
+
+  return sendmsg( sock, &message, SEND_FLAGS ) == (ssize_t)sizeof( *header ) ;
+}
+
+extern int jst_sendServerRequest( const char* socketPath, char** args, char** properties, int* exitCode ) {
+  ServerRequestHeader header ;
+  char   workingDir[ PATH_MAX + 1 ],
+         *payload = NULL,
+         accepted ;
+  int    sock,
+         stdFds[ 3 ] = { 0, 1, 2 },
+         served = 0 ;
+  jint   code ;
+  size_t size ;
+
+  if ( !getcwd( workingDir, sizeof( workingDir ) ) ) return 0 ;
+
+  if ( ( sock = connectToServer( socketPath ) ) == -1 ) return 0 ;
+
+  size = strlen( workingDir ) + 1 ;
+  size += appendStrings( args,    NULL, &header.argCount ) ;
+  size += appendStrings( environ, NULL, &header.envCount ) ;
+  size += appendStrings( properties, NULL, &header.propertyCount ) ;
+
+  if ( size > MAX_REQUEST_SIZE || !( payload = malloc( size ) ) ) goto end ;
+
+  header.magic       = SERVER_PROTOCOL_MAGIC ;
+  header.payloadSize = (unsigned int)size ;
+
+  size = strlen( workingDir ) + 1 ;
+  memcpy( payload, workingDir, size ) ;
+  size += appendStrings( args,    payload + size, &header.argCount ) ;
+  size += appendStrings( environ, payload + size, &header.envCount ) ;
+  size += appendStrings( properties, payload + size, &header.propertyCount ) ;
+
+  // if the server goes away before accepting the request (e.g. because it just timed out), it is as if there was no server
+  if ( !sendHeader( sock, &header, stdFds, 3 ) ||
+       !writeFully( sock, payload, size ) ||
+       !readFully( sock, &accepted, 1 ) ||
+       accepted != REQUEST_ACCEPTED ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: the server at %s did not accept the request\n", socketPath ) ;
+    goto end ;
+  }
+
+  served = 1 ;
+
+  if ( readFully( sock, &code, sizeof( code ) ) ) {
+    *exitCode = (int)code ;
+  } else {
+    fprintf( stderr, "error: the launcher server exited without reporting an exit code\n" ) ;
+    *exitCode = -1 ;
+  }
+
+  end:
+  if ( payload ) free( payload ) ;
+  close( sock ) ;
+
+  return served ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// server
+
+/** Stops accepting requests and removes the socket. */
+static void stopServer( int serverSocket ) {
+  if ( serverSocketPath ) unlink( serverSocketPath ) ;
+  close( serverSocket ) ;
+}
+
+/** Points stdin and stdout to /dev/null and stderr to the server log. */
+static void redirectStdFdsToServerLog( void ) {
+  int devNull = open( "/dev/null", O_RDWR ) ;
+
+  if ( devNull != -1 ) {
+    dup2( devNull, 0 ) ;
+    dup2( devNull, 1 ) ;
+    if ( devNull > 2 ) close( devNull ) ;
+  }
+
+  if ( serverLogFd != -1 ) dup2( serverLogFd, 2 ) ;
+}
+
+extern int jst_spawnServer( const char* socketPath ) {
+  struct sockaddr_un address ;
+  char   *logFileName = NULL ;
+  int    sock = -1 ;
+  mode_t originalMask ;
+  pid_t  pid ;
+
+  if ( !fillSocketAddress( &address, socketPath ) ||
+       ( sock = socket( AF_UNIX, SOCK_STREAM, 0 ) ) == -1 ||
+       !( logFileName = jst_malloc( strlen( socketPath ) + 5 ) ) ) goto error ;
+
+  strcpy( logFileName, socketPath ) ;
+  strcat( logFileName, ".log" ) ;
+
+  // connecting to this failed, so it is a leftover from a server that died. If another launcher has just replaced it w/
+  // a fresh one, that one simply never gets any requests and exits after the idle timeout.
+  unlink( socketPath ) ;
+
+  originalMask = umask( 077 ) ;
+  if ( bind( sock, (struct sockaddr*)&address, sizeof( address ) ) ) {
+    umask( originalMask ) ;
+    goto error ;
+  }
+  umask( originalMask ) ;
+
+  // clients connecting from now on wait in the backlog until the server jvm is up
+  if ( listen( sock, 16 ) ) goto error ;
+
+  fflush( NULL ) ;
+
+  if ( ( pid = fork() ) == -1 ) goto error ;
+
+  if ( pid ) {
+    close( sock ) ;
+    while ( waitpid( pid, NULL, 0 ) == -1 && errno == EINTR ) ;
+    free( logFileName ) ;
+    return -1 ;
+  }
+
+  // detach from the terminal and the parent's session. Forking again makes sure the server is not the child of the
+  // launcher process (which would otherwise have to reap it) and can not reacquire a controlling terminal.
+  if ( setsid() == -1 || fork() ) _exit( 0 ) ;
+
+  serverLogFd = open( logFileName, O_WRONLY | O_CREAT | O_TRUNC, 0600 ) ;
+  redirectStdFdsToServerLog() ;
+  if ( !( serverSocketPath = jst_strdup( socketPath ) ) ) _exit( 1 ) ;
+  free( logFileName ) ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: server %d listening on %s\n", (int)getpid(), socketPath ) ;
+
+  return sock ;
+
+  error:
+  if ( _jst_debug ) fprintf( stderr, "debug: could not start a server on %s: %s\n", socketPath, strerror( errno ) ) ;
+  if ( sock != -1 ) close( sock ) ;
+  if ( logFileName ) free( logFileName ) ;
+  return -1 ;
+}
+
+/** Reads the request from the given connection. The received fds are put in fds, or -1 if there were none.
+ * Returns 0 if the request is not valid. */
+static int receiveRequest( int connection, JstServerRequest* request, int* fds ) {
+  ServerRequestHeader header ;
+  struct msghdr   message ;
+  struct iovec    iov ;
+  struct cmsghdr* controlMessage ;
+  union {
+    struct cmsghdr align ;
+    char           buffer[ CMSG_SPACE( 3 * sizeof( int ) ) ] ;
+  } control ;
+  ssize_t      received ;
+  unsigned int i,
+               stringCount = 0,
+               slotCount ;
+  char         *s ;
+
+  fds[ 0 ] = fds[ 1 ] = fds[ 2 ] = -1 ;
+
+  memset( &message, 0, sizeof( message ) ) ;
+  iov.iov_base = (void*)&header ;
+  iov.iov_len  = sizeof( header ) ;
+  message.msg_iov        = &iov ;
+  message.msg_iovlen     = 1 ;
+  message.msg_control    = control.buffer ;
+  message.msg_controllen = sizeof( control.buffer ) ;
+
+  while ( ( received = recvmsg( connection, &message, 0 ) ) == -1 && errno == EINTR ) ;
+  if ( received <= 0 ) return 0 ;
+
+  for ( controlMessage = CMSG_FIRSTHDR( &message ) ; controlMessage ; controlMessage = CMSG_NXTHDR( &message, controlMessage ) ) {
+    if ( controlMessage->cmsg_level == SOL_SOCKET && controlMessage->cmsg_type == SCM_RIGHTS &&
+         controlMessage->cmsg_len == CMSG_LEN( 3 * sizeof( int ) ) ) {
+      memcpy( fds, CMSG_DATA( controlMessage ), 3 * sizeof( int ) ) ;
+    }
+  }
+
+  if ( fds[ 0 ] == -1 || ( message.msg_flags & MSG_CTRUNC ) ||
+       !readFully( connection, (char*)&header + received, sizeof( header ) - received ) ||
+       header.magic != SERVER_PROTOCOL_MAGIC ||
+       header.payloadSize == 0 || header.payloadSize > MAX_REQUEST_SIZE ||
+       !( request->buffer = malloc( header.payloadSize ) ) ||
+       !readFully( connection, request->buffer, header.payloadSize ) ||
+       request->buffer[ header.payloadSize - 1 ] ) return 0 ;
+
+  for ( i = 0 ; i < header.payloadSize ; i++ ) {
+    if ( !request->buffer[ i ] ) stringCount++ ;
+  }
+  slotCount = header.argCount + header.envCount + header.propertyCount + 3 ;
+  if ( stringCount != 1 + header.argCount + header.envCount + header.propertyCount ||
+       !( request->args = malloc( slotCount * sizeof( char* ) ) ) ) return 0 ;
+
+  // args, env and properties are put into the same array, each terminated by a NULL
+  s = request->workingDir = request->buffer ;
+  for ( i = 0 ; i < slotCount ; i++ ) {
+    if ( i == header.argCount || i == header.argCount + header.envCount + 1 || i == slotCount - 1 ) {
+      request->args[ i ] = NULL ;
+    } else {
+      s += strlen( s ) + 1 ;
+      request->args[ i ] = s ;
+    }
+  }
+  request->properties = request->args + header.argCount + header.envCount + 2 ;
+
+  return 1 ;
+}
+
+/** Replaces the environment of this process with the given one. */
+static void setEnvironment( char** env ) {
+  char   **names ;
+  size_t count = 0,
+         i ;
+
+  // unsetting entries modifies environ, so the names need to be copied first
+  while ( environ[ count ] ) count++ ;
+  if ( ( names = malloc( ( count + 1 ) * sizeof( char* ) ) ) ) {
+    for ( i = 0 ; i < count ; i++ ) {
+      char *equals = strchr( environ[ i ], '=' ) ;
+      size_t len = equals ? (size_t)( equals - environ[ i ] ) : strlen( environ[ i ] ) ;
+      if ( ( names[ i ] = malloc( len + 1 ) ) ) {
+        memcpy( names[ i ], environ[ i ], len ) ;
+        names[ i ][ len ] = '\0' ;
+      }
+    }
+    for ( i = 0 ; i < count ; i++ ) {
+      if ( names[ i ] ) {
+        unsetenv( names[ i ] ) ;
+        free( names[ i ] ) ;
+      }
+    }
+    free( names ) ;
+  }
+
+  for ( ; *env ; env++ ) {
+    char *equals = strchr( *env, '=' ) ;
+    if ( !equals || equals == *env ) continue ;
+    *equals = '\0' ;
+    setenv( *env, equals + 1, 1 ) ;
+    *equals = '=' ;
+  }
+}
+
+static int getIdleTimeout( void ) {
+  char *timeout = getenv( JST_SERVER_IDLE_TIMEOUT_ENV_VAR_NAME ) ;
+  int  seconds  = timeout ? atoi( timeout ) : 0 ;
+
+  return ( seconds > 0 ) ? seconds : JST_DEFAULT_SERVER_IDLE_TIMEOUT ;
+}
+
+static void freeRequest( JstServerRequest* request ) {
+  if ( request->args   ) free( request->args ) ;
+  if ( request->buffer ) free( request->buffer ) ;
+  memset( request, 0, sizeof( *request ) ) ;
+}
+
+extern int jst_acceptServerRequest( int serverSocket, JstServerRequest* request ) {
+  // read at startup as the env is replaced by that of each request
+  static int      idleTimeout = 0 ;
+  static jboolean idle        = JNI_FALSE ;
+
+  if ( !idleTimeout ) idleTimeout = getIdleTimeout() ;
+
+  for ( ;; ) {
+    struct pollfd pollFd ;
+    int    connection,
+           fds[ 3 ],
+           pollResult,
+           i ;
+    char   accepted = REQUEST_ACCEPTED ;
+
+    pollFd.fd      = serverSocket ;
+    pollFd.events  = POLLIN ;
+    pollFd.revents = 0 ;
+
+    // once idle, the socket is removed first and then the connections that made it in before that are still served
+    if ( ( pollResult = poll( &pollFd, 1, idle ? 0 : idleTimeout * 1000 ) ) == -1 ) {
+      if ( errno == EINTR ) continue ;
+      break ;
+    }
+
+    if ( !pollResult ) {
+      if ( idle ) break ;
+      if ( _jst_debug ) fprintf( stderr, "debug: server idle for %d seconds, exiting\n", idleTimeout ) ;
+      if ( serverSocketPath ) unlink( serverSocketPath ) ;
+      idle = JNI_TRUE ;
+      continue ;
+    }
+
+    if ( ( connection = accept( serverSocket, NULL, NULL ) ) == -1 ) continue ;
+
+    memset( request, 0, sizeof( *request ) ) ;
+    request->connection = connection ;
+
+    if ( receiveRequest( connection, request, fds ) && writeFully( connection, &accepted, 1 ) ) {
+      dup2( fds[ 0 ], 0 ) ;
+      dup2( fds[ 1 ], 1 ) ;
+      dup2( fds[ 2 ], 2 ) ;
+      for ( i = 0 ; i < 3 ; i++ ) if ( fds[ i ] > 2 ) close( fds[ i ] ) ;
+
+      setEnvironment( request->args + jst_pointerArrayLen( (void**)request->args ) + 1 ) ;
+      currentConnection = connection ;
+
+      if ( chdir( request->workingDir ) == 0 ) return 1 ;
+
+      fprintf( stderr, "error: could not change working dir to %s: %s\n", request->workingDir, strerror( errno ) ) ;
+      jst_finishServerRequest( request, -1 ) ;
+      continue ;
+    }
+
+    if ( _jst_debug ) fprintf( stderr, "debug: received an invalid request\n" ) ;
+    for ( i = 0 ; i < 3 ; i++ ) if ( fds[ i ] != -1 ) close( fds[ i ] ) ;
+    close( connection ) ;
+    freeRequest( request ) ;
+  }
+
+  stopServer( serverSocket ) ;
+  return 0 ;
+}
+
+extern void jst_finishServerRequest( JstServerRequest* request, int exitCode ) {
+  jint code = (jint)exitCode ;
+
+  fflush( stdout ) ;
+  fflush( stderr ) ;
+
+  // the client's stdout may well be a pipe whose reader waits for eof, so the server may not keep it open
+  redirectStdFdsToServerLog() ;
+
+  writeFully( request->connection, &code, sizeof( code ) ) ;
+  close( request->connection ) ;
+  currentConnection = -1 ;
+
+  freeRequest( request ) ;
+}
+
+extern void JNICALL jst_serverExitHook( jint exitCode ) {
+  if ( serverSocketPath ) unlink( serverSocketPath ) ;
+  if ( currentConnection != -1 ) writeFully( currentConnection, &exitCode, sizeof( exitCode ) ) ;
+}
+
+#endif
@@ -0,0 +1,91 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Resident jvm server mode. Instead of creating a jvm, the launcher connects to a server process (a launcher
+// process that started a jvm earlier and stayed around) over a unix domain socket and passes it the args to the
+// main method, the working dir, the environment and its stdin, stdout and stderr file descriptors. The server runs
+// the main method w/ those and replies with the exit code.
+//
+// If no server is running, the launcher runs the app itself as usual and forks off a server for the following launches.
+// A server exits after having been idle for a while.
+//
+// The server applies the environment of each request to the process (so it is seen by native code and child processes
+// started via libc), but System.getenv() keeps returning the environment the server was started with.
+//
+// Only supported on posix systems. On windows jst_getServerSocketPath always returns NULL.
+
+#if !defined( _JST_SERVER_H_ )
+#  define _JST_SERVER_H_
+
+#include "jst_cache.h"
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** The number of seconds a server waits for requests before exiting. If not set, JST_DEFAULT_SERVER_IDLE_TIMEOUT is used. */
+#define JST_SERVER_IDLE_TIMEOUT_ENV_VAR_NAME "__JLAUNCHER_SERVER_IDLE_TIMEOUT"
+#define JST_DEFAULT_SERVER_IDLE_TIMEOUT 600
+
+typedef struct {
+  /** the working dir of the client */
+  char*  workingDir ;
+  /** NULL terminated args to the main method */
+  char** args ;
+  /** NULL terminated system properties to set for this request, in the form name=value */
+  char** properties ;
+  /** for internal use */
+  int    connection ;
+  char*  buffer ;
+} JstServerRequest ;
+
+/** Returns the path of the socket of the server for the given key, which should identify the jvm and everything given to it
+ * at startup. The dir containing the socket is created if necessary and made accessible to the current user only.
+ * Returns NULL if server mode can not be used, in which case no error msg is printed.
+ * Freeing the returned value is up to the caller. */
+char* jst_getServerSocketPath( JstHash key ) ;
+
+/** Passes the given args to the main method of the server listening on the given socket and waits for it to finish.
+ * properties (may be NULL) are the system properties, in the form name=value, that are specific to this launch and
+ * thus not covered by the server key.
+ * @return 1 if the request was handled by the server, in which case *exitCode is set. 0 if there is no server
+ *         accepting requests on the given socket. In that case nothing was done and no error msg is printed. */
+int jst_sendServerRequest( const char* socketPath, char** args, char** properties, int* exitCode ) ;
+
+/** Starts listening on the given socket and forks off a detached server process, which has its stdin and stdout
+ * redirected to /dev/null and stderr to a log file next to the socket.
+ * @return the listening socket in the server process. -1 in the calling process, and also if the server could not
+ *         be started, which is not considered an error (the caller just goes on without a server). */
+int jst_spawnServer( const char* socketPath ) ;
+
+/** Waits for the next request and sets the process up for running it: stdin, stdout and stderr are those of the client,
+ * the working dir and the environment are those of the client.
+ * @return 0 if the server has been idle for the idle timeout (or can not accept requests for some other reason).
+ *         In that case the socket has been closed and removed and the server should exit. */
+int jst_acceptServerRequest( int serverSocket, JstServerRequest* request ) ;
+
+/** Reports the given exit code to the client, restores stdin, stdout and stderr of the server and frees the request. */
+void jst_finishServerRequest( JstServerRequest* request, int exitCode ) ;
+
+/** To be called from the "exit" (and "abort") hook of the server jvm. Reports the exit code to the client of the request being run, if any,
+ * and removes the socket so no new requests are sent to the server that is exiting. */
+void JNICALL jst_serverExitHook( jint exitCode ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined( _WIN32 )
+#  include <Windows.h>
+#  include <process.h>
+#  define getpid _getpid
+#else
+#  include <unistd.h>
+#  include <sys/time.h>
+#  include <sys/resource.h>
+#  if defined( __APPLE__ )
+#    include <mach/mach_time.h>
+#  else
+#    include <time.h>
+#  endif
+#endif
+
+#include "jvmstarter.h"
+#include "jst_trace.h"
+
+/** -1 == not checked yet, 0 == disabled, 1 == enabled */
+static int _jst_traceState = -1 ;
+
+static JstTracePhase phases[ JST_MAX_TRACE_PHASES ] ;
+static int           phaseCount = 0 ;
+
+/** the absolute time and fault counts at the start of the first / current phase */
+static jlong         traceStartTime,
+                     currentPhaseMinorFaults,
+                     currentPhaseMajorFaults ;
+
+extern jlong jst_monotonicMicros( void ) {
+#if defined( _WIN32 )
+  static LARGE_INTEGER frequency ;
+  LARGE_INTEGER        now ;
+
+  if ( !frequency.QuadPart ) QueryPerformanceFrequency( &frequency ) ;
+  QueryPerformanceCounter( &now ) ;
+  // split to avoid overflowing when multiplying
+  return (jlong)( ( now.QuadPart / frequency.QuadPart ) * 1000000 + ( now.QuadPart % frequency.QuadPart ) * 1000000 / frequency.QuadPart ) ;
+#elif defined( __APPLE__ )
+  static mach_timebase_info_data_t timebase ;
+
+  if ( !timebase.denom ) mach_timebase_info( &timebase ) ;
+  return (jlong)( mach_absolute_time() * timebase.numer / timebase.denom / 1000 ) ;
+#else
+  struct timespec now ;
+
+  clock_gettime( CLOCK_MONOTONIC, &now ) ;
+  return (jlong)now.tv_sec * 1000000 + now.tv_nsec / 1000 ;
+#endif
+}
+
+static void getPageFaults( jlong* minorFaults, jlong* majorFaults ) {
+#if defined( _WIN32 )
+  // windows does not separate these. Leaving them out instead of linking in psapi for this.
+  *minorFaults = *majorFaults = 0 ;
+#else
+  struct rusage usage ;
+
+  if ( getrusage( RUSAGE_SELF, &usage ) == 0 ) {
+    *minorFaults = usage.ru_minflt ;
+    *majorFaults = usage.ru_majflt ;
+  } else {
+    *minorFaults = *majorFaults = 0 ;
+  }
+#endif
+}
+
+extern jboolean jst_tracingEnabled( void ) {
+  if ( _jst_traceState == -1 ) {
+    char* traceFile = getenv( JST_TRACE_ENV_VAR_NAME ) ;
+    _jst_traceState = ( traceFile && *traceFile ) ? 1 : 0 ;
+  }
+  return _jst_traceState ? JNI_TRUE : JNI_FALSE ;
+}
+
+static void endCurrentPhase( jlong now ) {
+  JstTracePhase* phase ;
+  jlong minorFaults, majorFaults ;
+
+  if ( !phaseCount ) return ;
+
+  phase = &phases[ phaseCount - 1 ] ;
+  if ( phase->duration ) return ; // already ended
+
+  getPageFaults( &minorFaults, &majorFaults ) ;
+
+  // a zero duration would make this look like the phase is still going on
+  phase->duration    = ( now - traceStartTime - phase->start ) ? now - traceStartTime - phase->start : 1 ;
+  phase->minorFaults = minorFaults - currentPhaseMinorFaults ;
+  phase->majorFaults = majorFaults - currentPhaseMajorFaults ;
+}
+
+extern void jst_tracePhase( const char* phaseName ) {
+  jlong now ;
+
+  if ( !jst_tracingEnabled() ) return ;
+
+  now = jst_monotonicMicros() ;
+
+  if ( !phaseCount ) {
+    traceStartTime = now ;
+  } else {
+    endCurrentPhase( now ) ;
+  }
+
+  if ( phaseCount == JST_MAX_TRACE_PHASES ) return ;
+
+  phases[ phaseCount ].name        = phaseName ;
+  phases[ phaseCount ].start       = now - traceStartTime ;
+  phases[ phaseCount ].duration    = 0 ;
+  phases[ phaseCount ].minorFaults = 0 ;
+  phases[ phaseCount ].majorFaults = 0 ;
+  phaseCount++ ;
+
+  // read after the timestamp so the cost of reading these is attributed to the new phase, same as in endCurrentPhase
+  getPageFaults( &currentPhaseMinorFaults, &currentPhaseMajorFaults ) ;
+}
+
+extern int jst_getTracePhases( const JstTracePhase** phasesOut ) {
+  *phasesOut = phases ;
+  return phaseCount ;
+}
+
+extern int jst_writeTrace( void ) {
+  char *traceFileName ;
+  FILE *f ;
+  int  i,
+       pid ;
+
+  if ( !jst_tracingEnabled() || !phaseCount ) return 1 ;
+
+  endCurrentPhase( jst_monotonicMicros() ) ;
+
+  traceFileName = getenv( JST_TRACE_ENV_VAR_NAME ) ;
+
+  if ( strcmp( traceFileName, "-" ) == 0 ) {
+    f = stderr ;
+  } else if ( !( f = fopen( traceFileName, "w" ) ) ) {
+    fprintf( stderr, "error: could not write launcher trace to %s: %s\n", traceFileName, strerror( errno ) ) ;
+    return 0 ;
+  }
+
+  pid = (int)getpid() ;
+
+  fprintf( f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" ) ;
+  for ( i = 0 ; i < phaseCount ; i++ ) {
+    // long is 32 bits on windows, so print via double to be safe for long running apps
+    fprintf( f, "{\"name\":\"%s\",\"cat\":\"launcher\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.0f,\"dur\":%.0f,"
+                "\"args\":{\"minorFaults\":%.0f,\"majorFaults\":%.0f}}%s\n",
+                phases[ i ].name, pid, pid, (double)phases[ i ].start, (double)phases[ i ].duration,
+                (double)phases[ i ].minorFaults, (double)phases[ i ].majorFaults,
+                ( i < phaseCount - 1 ) ? "," : "" ) ;
+  }
+  fprintf( f, "]}\n" ) ;
+
+  if ( f != stderr && fclose( f ) ) {
+    fprintf( stderr, "error: could not write launcher trace to %s: %s\n", traceFileName, strerror( errno ) ) ;
+    return 0 ;
+  }
+
+  return 1 ;
+}
@@ -0,0 +1,69 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Timing of the launch phases (finding java home, loading the jvm, creating it etc.). Tracing is off unless
+// the env var below is set, in which case each phase boundary records a monotonic timestamp and the page fault
+// counts of the process. The results are written out as Chrome trace event json (viewable in chrome://tracing
+// or https://ui.perfetto.dev) and also given to the launched app as jst.launch.* system properties.
+
+#if !defined( _JST_TRACE_H_ )
+#  define _JST_TRACE_H_
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+/** Setting this env var enables tracing. The value is the file the trace json is written to, "-" meaning stderr. */
+#define JST_TRACE_ENV_VAR_NAME "__JLAUNCHER_TRACE"
+
+/** The max number of phases recorded. Any phases beyond this are ignored. */
+#define JST_MAX_TRACE_PHASES 32
+
+typedef struct {
+  /** must be a string literal (or otherwise live until the end of the program) */
+  const char* name ;
+  /** microseconds since the first phase started */
+  jlong start ;
+  /** 0 while the phase is still going on */
+  jlong duration ;
+  /** the number of minor / major page faults that happened during the phase. 0 on platforms where these are not available. */
+  jlong minorFaults ;
+  jlong majorFaults ;
+} JstTracePhase ;
+
+/** Microseconds from some arbitrary fixed point of time, not affected by changes to system time. Works whether or not
+ * tracing is enabled. */
+jlong jst_monotonicMicros( void ) ;
+
+/** Returns true if tracing has been enabled. */
+jboolean jst_tracingEnabled( void ) ;
+
+/** Ends the current phase (if any) and starts a new one w/ the given name. A nop if tracing is not enabled.
+ * @param phaseName must be a string literal (or otherwise live until the end of the program) */
+void jst_tracePhase( const char* phaseName ) ;
+
+/** Returns the number of phases recorded so far and sets *phases to point to them. The last one may still be going on. */
+int jst_getTracePhases( const JstTracePhase** phases ) ;
+
+/** Ends the current phase and writes the trace to the file given in the env var. A nop if tracing is not enabled.
+ * Returns 0 on failure to write the trace (an error msg is printed). */
+int jst_writeTrace( void ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
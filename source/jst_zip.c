@@ -0,0 +1,442 @@
+//  A library for easy creation of a native launcher for Java applications.
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "jvmstarter.h"
+#include "jst_dynmem.h"
+#include "jst_cache.h"
+#include "jst_zip.h"
+
+// the fixed size parts of the zip records used here, see the zip file format spec (APPNOTE.TXT) for the layout
+#define END_OF_CENTRAL_DIR_SIGNATURE 0x06054b50
+#define END_OF_CENTRAL_DIR_SIZE      22
+#define CENTRAL_DIR_HEADER_SIGNATURE 0x02014b50
+#define CENTRAL_DIR_HEADER_SIZE      46
+#define LOCAL_HEADER_SIGNATURE       0x04034b50
+#define LOCAL_HEADER_SIZE            30
+
+/** The end of central dir record is followed by a zip file comment of at most this size. */
+#define MAX_ZIP_COMMENT_SIZE 65535
+
+#define METHOD_STORED   0
+#define METHOD_DEFLATED 8
+
+/** Bigger entries are not read, they are certainly not what this is meant for. */
+#define MAX_ENTRY_SIZE ( 16 * 1024 * 1024 )
+
+static unsigned int littleEndianShort( const unsigned char* bytes ) {
+  return (unsigned int)bytes[ 0 ] | ( (unsigned int)bytes[ 1 ] << 8 ) ;
+}
+
+static unsigned int littleEndianInt( const unsigned char* bytes ) {
+  return littleEndianShort( bytes ) | ( littleEndianShort( bytes + 2 ) << 16 ) ;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// inflating, i.e. decompressing deflated data (RFC 1951). Written for size, not speed: the huffman codes are decoded a bit at a
+// time, which is plenty fast for the entries read here.
+
+#define MAX_CODE_BITS       15
+#define MAX_LITLEN_CODES    288
+#define MAX_DIST_CODES      30
+#define CODE_LENGTH_CODES   19
+
+typedef struct {
+  /** The number of codes of each bit length. */
+  short count[ MAX_CODE_BITS + 1 ] ;
+  /** The symbols ordered by their codes. */
+  short symbol[ MAX_LITLEN_CODES ] ;
+} Huffman ;
+
+typedef struct {
+  const unsigned char* in ;
+  size_t               inSize ;
+  size_t               inPos ;
+  unsigned long        bitBuffer ;
+  int                  bitCount ;
+  unsigned char*       out ;
+  size_t               outSize ;
+  size_t               outPos ;
+  /** Set if the input ended prematurely. */
+  jboolean             error ;
+} Inflater ;
+
+static const short lengthBase[ 29 ]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 } ;
+static const short lengthExtra[ 29 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 } ;
+static const short distBase[ 30 ]    = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+                                         4097, 6145, 8193, 12289, 16385, 24577 } ;
+static const short distExtra[ 30 ]   = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 } ;
+
+/** Reads the given number (at most 16) of bits. Sets the error flag and returns 0 if the input ends. */
+static int getBits( Inflater* z, int count ) {
+  unsigned long value = z->bitBuffer ;
+
+  while ( z->bitCount < count ) {
+    if ( z->inPos == z->inSize ) {
+      z->error = JNI_TRUE ;
+      return 0 ;
+    }
+    value |= (unsigned long)z->in[ z->inPos++ ] << z->bitCount ;
+    z->bitCount += 8 ;
+  }
+
+  z->bitBuffer = value >> count ;
+  z->bitCount -= count ;
+
+  return (int)( value & ( ( 1UL << count ) - 1 ) ) ;
+}
+
+/** Builds the canonical huffman code w/ the given code lengths. Returns 0 if the lengths do not make up a valid code. */
+static int buildHuffman( Huffman* h, const unsigned char* lengths, int n ) {
+  short offsets[ MAX_CODE_BITS + 1 ] ;
+  int   left = 1,
+        len,
+        sym ;
+
+  memset( h->count, 0, sizeof( h->count ) ) ;
+  for ( sym = 0 ; sym < n ; sym++ ) h->count[ lengths[ sym ] ]++ ;
+
+  // more codes of some length than there is room for
+  for ( len = 1 ; len <= MAX_CODE_BITS ; len++ ) {
+    left = ( left << 1 ) - h->count[ len ] ;
+    if ( left < 0 ) return 0 ;
+  }
+
+  offsets[ 1 ] = 0 ;
+  for ( len = 1 ; len < MAX_CODE_BITS ; len++ ) offsets[ len + 1 ] = (short)( offsets[ len ] + h->count[ len ] ) ;
+
+  for ( sym = 0 ; sym < n ; sym++ ) {
+    if ( lengths[ sym ] ) h->symbol[ offsets[ lengths[ sym ] ]++ ] = (short)sym ;
+  }
+
+  return 1 ;
+}
+
+/** Returns the next symbol, -1 if the input is not valid. */
+static int decodeSymbol( Inflater* z, const Huffman* h ) {
+  int code  = 0, // the code read so far
+      first = 0, // the first code of the current length
+      index = 0, // the index of the first code of the current length in h->symbol
+      len ;
+
+  for ( len = 1 ; len <= MAX_CODE_BITS ; len++ ) {
+    code |= getBits( z, 1 ) ;
+    if ( z->error ) return -1 ;
+    if ( code - h->count[ len ] < first ) return h->symbol[ index + ( code - first ) ] ;
+    index += h->count[ len ] ;
+    first  = ( first + h->count[ len ] ) << 1 ;
+    code <<= 1 ;
+  }
+
+  return -1 ;
+}
+
+/** Inflates the data of a block compressed w/ the given codes. Returns 0 if the input is not valid. */
+static int inflateCodes( Inflater* z, const Huffman* litLenCode, const Huffman* distCode ) {
+  int    sym ;
+  size_t len,
+         dist ;
+
+  for ( ;; ) {
+    if ( ( sym = decodeSymbol( z, litLenCode ) ) < 0 ) return 0 ;
+
+    if ( sym < 256 ) {
+      if ( z->outPos == z->outSize ) return 0 ;
+      z->out[ z->outPos++ ] = (unsigned char)sym ;
+      continue ;
+    }
+
+    if ( sym == 256 ) return 1 ; // end of block
+
+    if ( ( sym -= 257 ) >= 29 ) return 0 ;
+    len = (size_t)( lengthBase[ sym ] + getBits( z, lengthExtra[ sym ] ) ) ;
+
+    if ( ( sym = decodeSymbol( z, distCode ) ) < 0 || sym >= MAX_DIST_CODES ) return 0 ;
+    dist = (size_t)( distBase[ sym ] + getBits( z, distExtra[ sym ] ) ) ;
+
+    if ( z->error || dist > z->outPos || len > z->outSize - z->outPos ) return 0 ;
+
+    for ( ; len ; len-- ) {
+      z->out[ z->outPos ] = z->out[ z->outPos - dist ] ;
+      z->outPos++ ;
+    }
+  }
+}
+
+static int inflateStored( Inflater* z ) {
+  size_t len ;
+
+  // the rest of the current byte is skipped
+  z->bitBuffer = 0 ;
+  z->bitCount  = 0 ;
+
+  if ( z->inSize - z->inPos < 4 ) return 0 ;
+  len = littleEndianShort( z->in + z->inPos ) ;
+  if ( len != ( ~littleEndianShort( z->in + z->inPos + 2 ) & 0xffff ) ) return 0 ;
+  z->inPos += 4 ;
+
+  if ( len > z->inSize - z->inPos || len > z->outSize - z->outPos ) return 0 ;
+  memcpy( z->out + z->outPos, z->in + z->inPos, len ) ;
+  z->inPos  += len ;
+  z->outPos += len ;
+
+  return 1 ;
+}
+
+static int inflateFixed( Inflater* z ) {
+  unsigned char lengths[ MAX_LITLEN_CODES ] ;
+  Huffman       litLenCode,
+                distCode ;
+
+  memset( lengths      , 8, 144 ) ;
+  memset( lengths + 144, 9, 112 ) ;
+  memset( lengths + 256, 7, 24  ) ;
+  memset( lengths + 280, 8, 8   ) ;
+  buildHuffman( &litLenCode, lengths, MAX_LITLEN_CODES ) ;
+
+  memset( lengths, 5, MAX_DIST_CODES ) ;
+  buildHuffman( &distCode, lengths, MAX_DIST_CODES ) ;
+
+  return inflateCodes( z, &litLenCode, &distCode ) ;
+}
+
+static int inflateDynamic( Inflater* z ) {
+  // the order the code lengths of the code length code are given in
+  static const unsigned char order[ CODE_LENGTH_CODES ] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 } ;
+  unsigned char lengths[ MAX_LITLEN_CODES + MAX_DIST_CODES ] ;
+  Huffman       litLenCode,
+                distCode ;
+  int           litLenCount = getBits( z, 5 ) + 257,
+                distCount   = getBits( z, 5 ) + 1,
+                codeCount   = getBits( z, 4 ) + 4,
+                index,
+                sym,
+                repeat ;
+  unsigned char len ;
+
+  if ( z->error || litLenCount > 286 || distCount > MAX_DIST_CODES ) return 0 ;
+
+  memset( lengths, 0, CODE_LENGTH_CODES ) ;
+  for ( index = 0 ; index < codeCount ; index++ ) lengths[ order[ index ] ] = (unsigned char)getBits( z, 3 ) ;
+  if ( z->error || !buildHuffman( &litLenCode, lengths, CODE_LENGTH_CODES ) ) return 0 ;
+
+  // the code lengths of the literal / length and distance codes, run length encoded
+  for ( index = 0 ; index < litLenCount + distCount ; ) {
+    if ( ( sym = decodeSymbol( z, &litLenCode ) ) < 0 ) return 0 ;
+    if ( sym < 16 ) {
+      lengths[ index++ ] = (unsigned char)sym ;
+      continue ;
+    }
+    len = 0 ;
+    if ( sym == 16 ) {
+      if ( index == 0 ) return 0 ;
+      len    = lengths[ index - 1 ] ;
+      repeat = 3 + getBits( z, 2 ) ;
+    } else {
+      repeat = ( sym == 17 ) ? 3 + getBits( z, 3 ) : 11 + getBits( z, 7 ) ;
+    }
+    if ( z->error || index + repeat > litLenCount + distCount ) return 0 ;
+    while ( repeat-- ) lengths[ index++ ] = len ;
+  }
+
+  // no end of block code
+  if ( !lengths[ 256 ] ) return 0 ;
+
+  if ( !buildHuffman( &litLenCode, lengths, litLenCount ) || !buildHuffman( &distCode, lengths + litLenCount, distCount ) ) return 0 ;
+
+  return inflateCodes( z, &litLenCode, &distCode ) ;
+}
+
+/** Inflates the given data into the given buffer. Returns 0 if the data is not valid or does not inflate to exactly outSize bytes. */
+static int inflate( const unsigned char* in, size_t inSize, unsigned char* out, size_t outSize ) {
+  Inflater z ;
+  int      last,
+           ok ;
+
+  memset( &z, 0, sizeof( z ) ) ;
+  z.in      = in ;
+  z.inSize  = inSize ;
+  z.out     = out ;
+  z.outSize = outSize ;
+
+  do {
+    last = getBits( &z, 1 ) ;
+    switch ( getBits( &z, 2 ) ) {
+      case 0  : ok = inflateStored( &z )  ; break ;
+      case 1  : ok = inflateFixed( &z )   ; break ;
+      case 2  : ok = inflateDynamic( &z ) ; break ;
+      default : ok = 0 ;
+    }
+  } while ( ok && !z.error && !last ) ;
+
+  return ok && !z.error && z.outPos == outSize ;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+/** Returns the central dir record of the given entry, NULL if not found. */
+static const unsigned char* findCentralDirHeader( const unsigned char* data, size_t size, const char* entryName ) {
+  const unsigned char *eocd,
+                      *header,
+                      *end ;
+  size_t              nameLen = strlen( entryName ),
+                      headerLen ;
+  unsigned int        entryCount,
+                      dirOffset ;
+
+  if ( size < END_OF_CENTRAL_DIR_SIZE ) return NULL ;
+
+  // the end of central dir record is at the end, followed by a comment of unknown length
+  for ( eocd = data + size - END_OF_CENTRAL_DIR_SIZE ; littleEndianInt( eocd ) != END_OF_CENTRAL_DIR_SIGNATURE ; eocd-- ) {
+    if ( eocd == data || (size_t)( data + size - eocd ) >= END_OF_CENTRAL_DIR_SIZE + MAX_ZIP_COMMENT_SIZE ) return NULL ;
+  }
+
+  entryCount = littleEndianShort( eocd + 10 ) ;
+  dirOffset  = littleEndianInt( eocd + 16 ) ;
+
+  // 0xffffffff means zip64
+  if ( dirOffset > (size_t)( eocd - data ) ) return NULL ;
+
+  end = eocd ;
+  for ( header = data + dirOffset ; entryCount-- ; header += headerLen ) {
+    if ( (size_t)( end - header ) < CENTRAL_DIR_HEADER_SIZE || littleEndianInt( header ) != CENTRAL_DIR_HEADER_SIGNATURE ) return NULL ;
+    headerLen = CENTRAL_DIR_HEADER_SIZE + littleEndianShort( header + 28 ) + littleEndianShort( header + 30 ) + littleEndianShort( header + 32 ) ;
+    if ( (size_t)( end - header ) < headerLen ) return NULL ;
+    if ( littleEndianShort( header + 28 ) == nameLen && memcmp( header + CENTRAL_DIR_HEADER_SIZE, entryName, nameLen ) == 0 ) return header ;
+  }
+
+  return NULL ;
+}
+
+extern char* jst_readZipEntry( const char* zipFile, const char* entryName, size_t* size ) {
+  JstMappedFile       file ;
+  const unsigned char *data,
+                      *header,
+                      *local ;
+  size_t              localOffset,
+                      dataOffset,
+                      compressedSize,
+                      entrySize ;
+  unsigned int        method ;
+  int                 ok ;
+  char                *entry = NULL ;
+
+  if ( !jst_mapFile( zipFile, &file ) ) return NULL ;
+
+  data = (const unsigned char*)file.data ;
+
+  if ( !( header = findCentralDirHeader( data, file.size, entryName ) ) ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: no entry %s found in %s\n", entryName, zipFile ) ;
+    goto end ;
+  }
+
+  method         = littleEndianShort( header + 10 ) ;
+  compressedSize = littleEndianInt( header + 20 ) ;
+  entrySize      = littleEndianInt( header + 24 ) ;
+  localOffset    = littleEndianInt( header + 42 ) ;
+
+  if ( ( method != METHOD_STORED && method != METHOD_DEFLATED ) || entrySize > MAX_ENTRY_SIZE ) {
+    if ( _jst_debug ) fprintf( stderr, "debug: can not read entry %s of %s, compression method %u, size %lu\n", entryName, zipFile, method, (unsigned long)entrySize ) ;
+    goto end ;
+  }
+
+  // the sizes are taken from the central dir, the local header may not have them. Its name and extra field lengths may differ too
+  if ( localOffset > file.size || file.size - localOffset < LOCAL_HEADER_SIZE ) goto end ;
+  local = data + localOffset ;
+  if ( littleEndianInt( local ) != LOCAL_HEADER_SIGNATURE ) goto end ;
+  dataOffset = localOffset + LOCAL_HEADER_SIZE + littleEndianShort( local + 26 ) + littleEndianShort( local + 28 ) ;
+  if ( dataOffset > file.size || file.size - dataOffset < compressedSize ) goto end ;
+
+  if ( !( entry = malloc( entrySize + 1 ) ) ) goto end ;
+
+  if ( method == METHOD_STORED ) {
+    if ( ( ok = ( compressedSize == entrySize ) ) ) memcpy( entry, data + dataOffset, entrySize ) ;
+  } else {
+    ok = inflate( data + dataOffset, compressedSize, (unsigned char*)entry, entrySize ) ;
+  }
+
+  if ( ok ) {
+    entry[ entrySize ] = '\0' ;
+    if ( size ) *size = entrySize ;
+  } else {
+    if ( _jst_debug ) fprintf( stderr, "debug: entry %s of %s is corrupted\n", entryName, zipFile ) ;
+    jst_free( entry ) ;
+  }
+
+  end:
+  jst_unmapFile( &file ) ;
+
+  return entry ;
+}
+
+/** Terminates the given manifest line at its end, which may be \r\n, \n or \r. Returns the start of the next line, NULL if this is the last. */
+static char* splitManifestLine( char* line ) {
+  char* end = line + strcspn( line, "\r\n" ) ;
+
+  if ( !*end ) return NULL ;
+  if ( end[ 0 ] == '\r' && end[ 1 ] == '\n' ) *end++ = '\0' ;
+  *end = '\0' ;
+
+  return end + 1 ;
+}
+
+/** Attribute names are case insensitive. */
+static jboolean isAttribute( const char* line, const char* attributeName, size_t nameLen ) {
+  size_t i ;
+
+  for ( i = 0 ; i < nameLen ; i++ ) {
+    if ( tolower( (unsigned char)line[ i ] ) != tolower( (unsigned char)attributeName[ i ] ) ) return JNI_FALSE ;
+  }
+
+  return ( line[ nameLen ] == ':' && line[ nameLen + 1 ] == ' ' ) ? JNI_TRUE : JNI_FALSE ;
+}
+
+extern char* jst_getJarManifestAttribute( const char* jarFile, const char* attributeName ) {
+  size_t nameLen = strlen( attributeName ) ;
+  char   *manifest,
+         *line,
+         *next,
+         *value = NULL,
+         *rval ;
+
+  if ( !( manifest = jst_readZipEntry( jarFile, JST_JAR_MANIFEST_ENTRY, NULL ) ) ) return NULL ;
+
+  for ( line = manifest ; line ; line = next ) {
+    next = splitManifestLine( line ) ;
+    if ( value ) {
+      // long values continue on lines starting w/ a space. The continuation is moved in place to the end of the value
+      if ( line[ 0 ] != ' ' ) break ;
+      memmove( value + strlen( value ), line + 1, strlen( line + 1 ) + 1 ) ;
+    } else if ( !*line ) {
+      // the main attributes end at the first empty line
+      break ;
+    } else if ( isAttribute( line, attributeName, nameLen ) ) {
+      value = line + nameLen + 2 ;
+    }
+  }
+
+  rval = value ? jst_strdup( value ) : NULL ;
+
+  free( manifest ) ;
+
+  return rval ;
+}
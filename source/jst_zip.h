@@ -0,0 +1,45 @@
+//  A simple library for creating a native launcher for a java app
+//
+//  Copyright (c) 2006 Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software distributed under the License is
+//  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//  implied. See the License for the specific language governing permissions and limitations under the
+//  License.
+//
+//  Author:  Antti Karanta (Antti dot Karanta (at) hornankuusi dot fi)
+
+// Reading single entries of zip (i.e. jar) files, e.g. the manifest of a jar, w/out starting a jvm.
+// Only what jars use is supported: entries that are stored or deflated, and no zip64 (i.e. jars smaller than 4 GB).
+// Meant for small entries, as the whole entry is read into memory.
+
+#if !defined( _JST_ZIP_H_ )
+#  define _JST_ZIP_H_
+
+#include <stddef.h>
+
+#if defined( __cplusplus )
+  extern "C" {
+#endif
+
+#define JST_JAR_MANIFEST_ENTRY "META-INF/MANIFEST.MF"
+
+/** Returns the contents of the given entry of the given zip file, nul terminated. Returns NULL if there is no such entry,
+ * the file is not a (supported) zip file or on error. No error msg is printed. Freeing the returned value is up to the caller.
+ * @param size set to the size of the entry (not including the terminating nul char) if not NULL */
+char* jst_readZipEntry( const char* zipFile, const char* entryName, size_t* size ) ;
+
+/** Returns the value of the given main attribute (e.g. "Implementation-Version") in the manifest of the given jar, NULL if
+ * there is no such attribute or on error. No error msg is printed. Freeing the returned value is up to the caller. */
+char* jst_getJarManifestAttribute( const char* jarFile, const char* attributeName ) ;
+
+#if defined( __cplusplus )
+  } // end extern "C"
+#endif
+
+#endif
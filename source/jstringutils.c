@@ -19,6 +19,9 @@
 #include "jniutils.h"
 #include <string.h>
 
+/** The strings are created in local frames of this many strings, so the refs to them are released in one go. */
+#define STRINGS_PER_LOCAL_FRAME 256
+
 static jmethodID getStringConstructorB( JNIEnv* env ) {
 
   static jmethodID _stringConstructor = NULL ;
@@ -37,12 +40,43 @@ static jmethodID getStringConstructorB( JNIEnv* env ) {
 
 
 
+/** Whether the given string is plain ascii. Sets *len to the length of the string. */
+static jboolean isAscii( const char* s, size_t* len ) {
+  unsigned long highBits = 0,
+                word ;
+  size_t        i ;
+
+  *len = strlen( s ) ;
+
+  // a word at a time, the compiler can vectorize this further
+  for ( i = 0 ; i + sizeof( word ) <= *len ; i += sizeof( word ) ) {
+    memcpy( &word, s + i, sizeof( word ) ) ;
+    highBits |= word ;
+  }
+  for ( ; i < *len ; i++ ) highBits |= (unsigned char)s[ i ] ;
+
+  return ( highBits & ( ~0UL / 0xff * 0x80 ) ) ? JNI_FALSE : JNI_TRUE ;
+}
+
 static jstring createJStringFromPlatformEncodedCString( JNIEnv* env, const char* stringInPlatformDefaultEncoding ) {
   jstring jstr = NULL ;
-  size_t  len  = strlen( stringInPlatformDefaultEncoding ) ;
+  size_t  len ;
   jbyteArray bytes ;
-  jmethodID stringConstructorB = getStringConstructorB( env ) ;
-  jclass stringClass = getJavaStringClass( env ) ;
+  jmethodID stringConstructorB ;
+  jclass stringClass ;
+
+  // ascii is the same in the platform encoding and in the modified utf-8 jni uses, so the jvm can create the string
+  // directly instead of running the platform decoder on a byte[]
+  if ( isAscii( stringInPlatformDefaultEncoding, &len ) ) {
+    if ( !( jstr = (*env)->NewStringUTF( env, stringInPlatformDefaultEncoding ) ) ) {
+      fprintf( stderr, "error: could not convert %s to java string\n", stringInPlatformDefaultEncoding ) ;
+      clearException( env ) ;
+    }
+    return jstr ;
+  }
+
+  stringConstructorB = getStringConstructorB( env ) ;
+  stringClass        = getJavaStringClass( env ) ;
 
   if ( !stringConstructorB || !stringClass ) {
     clearException( env ) ;
@@ -71,21 +105,27 @@ static jstring createJStringFromPlatformEncodedCString( JNIEnv* env, const char*
 }
 
 
-extern jboolean addStringToJStringArray( JNIEnv* env, char *strToAdd, jobjectArray jstrArr, jint ind ) {
-  jboolean success = JNI_FALSE ;
-  jstring  arg     = createJStringFromPlatformEncodedCString( env, strToAdd ) ;
+/** Creates the java string and stores it in the given array, leaving the local ref to it for the caller to release.
+ * Sets *arg to the created string (NULL if it could not be created). Returns false on error. */
+static jboolean storeStringInJStringArray( JNIEnv* env, char *strToAdd, jobjectArray jstrArr, jint ind, jstring* arg ) {
 
-  if ( !arg ) return JNI_FALSE ;
+  if ( !( *arg = createJStringFromPlatformEncodedCString( env, strToAdd ) ) ) return JNI_FALSE ;
 
-  (*env)->SetObjectArrayElement( env, jstrArr, ind, arg ) ;
+  (*env)->SetObjectArrayElement( env, jstrArr, ind, *arg ) ;
   if ( (*env)->ExceptionCheck( env ) ) {
     fprintf( stderr, "error: error when writing %dth element %s to Java String[]\n", (int)ind, strToAdd ) ;
     clearException( env ) ;
-  } else {
-    success = JNI_TRUE ;
+    return JNI_FALSE ;
   }
 
-  (*env)->DeleteLocalRef( env, arg ) ;
+  return JNI_TRUE ;
+}
+
+extern jboolean addStringToJStringArray( JNIEnv* env, char *strToAdd, jobjectArray jstrArr, jint ind ) {
+  jstring  arg ;
+  jboolean success = storeStringInJStringArray( env, strToAdd, jstrArr, ind, &arg ) ;
+
+  if ( arg ) (*env)->DeleteLocalRef( env, arg ) ;
 
   return success ;
 }
@@ -95,14 +135,26 @@ extern jboolean addStringToJStringArray( JNIEnv* env, char *strToAdd, jobjectArr
  * @return != 0 on error */
 extern int addStringsToJavaStringArray( JNIEnv* env, jobjectArray jstrings, char** strings, jint indx ) {
 
-  int errorOccurred = 0 ;
+  int errorOccurred = 0,
+      i ;
 
   if ( !strings ) return 0 ;
 
-  for ( ; *strings ; strings++ ) {
-    if ( ( errorOccurred = !addStringToJStringArray( env, *strings, jstrings, indx++ ) ) ) {
-      break ;
+  // instead of deleting the local ref to each string, they are released a frame at a time
+  while ( *strings && !errorOccurred ) {
+    // + 1 for the byte[] a non ascii string is decoded from
+    if ( (*env)->PushLocalFrame( env, STRINGS_PER_LOCAL_FRAME + 1 ) ) {
+      fprintf( stderr, "error: could not allocate memory in jvm local frame\n" ) ;
+      clearException( env ) ;
+      return 1 ;
     }
+
+    for ( i = 0 ; i < STRINGS_PER_LOCAL_FRAME && *strings ; i++, strings++ ) {
+      jstring arg ;
+      if ( ( errorOccurred = !storeStringInJStringArray( env, *strings, jstrings, indx++, &arg ) ) ) break ;
+    }
+
+    (*env)->PopLocalFrame( env, NULL ) ;
   }
 
   return errorOccurred ;
@@ -34,6 +34,13 @@
 #include "jst_stringutils.h"
 #include "jstringutils.h"
 #include "jniutils.h"
+#include "jst_trace.h"
+#include "jst_server.h"
+#include "jst_cds.h"
+#include "jst_prefetch.h"
+#include "jst_dirwalk.h"
+#include "jst_cgroup.h"
+#include "jst_profile.h"
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // NOTE: when compiling w/ gcc on cygwin, pass -mno-cygwin, which makes gcc define _WIN32 and handle the win headers ok
@@ -70,10 +77,11 @@
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 #  if defined( __linux__ )
 #    if defined( __i386__ )
-#      define PATHS_TO_SERVER_JVM "lib/i386/server/libjvm.so"
-#      define PATHS_TO_CLIENT_JVM "lib/i386/client/libjvm.so"
+// java 9 and newer have the jvm directly under lib
+#      define PATHS_TO_SERVER_JVM "lib/i386/server/libjvm.so", "lib/server/libjvm.so"
+#      define PATHS_TO_CLIENT_JVM "lib/i386/client/libjvm.so", "lib/client/libjvm.so"
 #    elif defined( __amd64__ )
-#      define PATHS_TO_SERVER_JVM "lib/amd64/server/libjvm.so"
+#      define PATHS_TO_SERVER_JVM "lib/amd64/server/libjvm.so", "lib/server/libjvm.so"
 #      define PATHS_TO_CLIENT_JVM ""
 #    else
 #      error "linux currently supported only on x86 and amd64. Please contact the author to have support added."
@@ -106,7 +114,7 @@
 //  The issue is that all the dynamic libraries are not in that part of the tree.  To deal with this we try
 //  two rather than one place to search.
 
-#    define PATHS_TO_SERVER_JVM "Libraries/libserver.dylib", "../Libraries/libserver.dylib"
+#    define PATHS_TO_SERVER_JVM "Libraries/libserver.dylib", "../Libraries/libserver.dylib", "lib/server/libjvm.dylib"
 #    define PATHS_TO_CLIENT_JVM "Libraries/libclient.dylib", "../Libraries/libclient.dylib"
 
 #    define CREATE_JVM_FUNCTION_NAME "JNI_CreateJavaVM_Impl"
@@ -125,6 +133,9 @@
 #    include <link.h>
 #  endif
 
+// for loading the jvm dynamic library on a helper thread
+#  include <pthread.h>
+
 #endif
 
 #if !defined( CREATE_JVM_FUNCTION_NAME )
@@ -326,6 +337,52 @@ extern char* jst_findJavaHome( void ) {
   return NULL ;
 }
 
+extern char* jst_getJavaReleaseProperty( const char* javaHome, const char* propertyName ) {
+  char   *releaseFile,
+         *value = NULL,
+         line[ 256 ] ;
+  size_t nameLen = strlen( propertyName ) ;
+  FILE   *f ;
+
+  if ( !javaHome || !( releaseFile = jst_createFileName( javaHome, "release", NULL ) ) ) return NULL ;
+
+  // the lines are of the form NAME="value"
+  if ( ( f = fopen( releaseFile, "r" ) ) ) {
+    while ( fgets( line, sizeof( line ), f ) ) {
+      if ( strncmp( line, propertyName, nameLen ) == 0 && line[ nameLen ] == '=' && line[ nameLen + 1 ] == '"' ) {
+        char *end = strchr( line + nameLen + 2, '"' ) ;
+        if ( end ) *end = '\0' ;
+        value = jst_strdup( line + nameLen + 2 ) ;
+        break ;
+      }
+    }
+    fclose( f ) ;
+  }
+
+  free( releaseFile ) ;
+
+  return value ;
+}
+
+extern char* jst_getJavaVersion( const char* javaHome ) {
+  return jst_getJavaReleaseProperty( javaHome, "JAVA_VERSION" ) ;
+}
+
+extern int jst_parseJavaMajorVersion( const char* version ) {
+  // up to java 8 the versions were of the form 1.x.y
+  if ( strncmp( version, "1.", 2 ) == 0 ) version += 2 ;
+  return atoi( version ) ;
+}
+
+extern int jst_getJavaMajorVersion( const char* javaHome ) {
+  char *version = jst_getJavaVersion( javaHome ) ;
+  int  majorVersion = version ? jst_parseJavaMajorVersion( version ) : 0 ;
+
+  if ( version ) free( version ) ;
+
+  return majorVersion ;
+}
+
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
@@ -470,48 +527,89 @@ static void resetDllSearchPath( SetDllDirFunc dllSearchDirSetter, const char* or
 }
 #endif
 
-/** returns != 0 if loaded successfully or on error. On error jvmLib == NULL */
-static int loadJvmDynLib( const char* java_home, const char* dynLibFile, JstDLHandle* jvmLib ) {
+/** Returns the path to the given jvm dynamic library under the given java home, trying both jdk and jre style layouts.
+ * Returns NULL if not found or on error. Freeing the returned value is up to the caller. */
+static char* findJvmDynLibUnder( const char* java_home, const char* dynLibFile ) {
 
-  int i,
-      found = 0;
-
-  *jvmLib = NULL ;
+  int i ;
 
-  for ( i = 0 ; i < 2 && !found ; i++ ) { // i=0..1 => try both jdk and jre style paths
+  for ( i = 0 ; i < 2 ; i++ ) { // i=0..1 => try both jdk and jre style paths
 
     char *path,
          *jreSubDir = ( i == 0 ) ? "jre" JST_FILE_SEPARATOR : "" ;
 
     // on a jdk, we need to add jre to the path
-    JST_CONCATA4( path, java_home, JST_FILE_SEPARATOR, jreSubDir, dynLibFile ) ;
-    if ( !path ) return 0 ;
+    if ( !( path = jst_append( NULL, NULL, java_home, JST_FILE_SEPARATOR, jreSubDir, dynLibFile, NULL ) ) ) return NULL ;
 
-    if ( ( found = jst_fileExists( path ) ) ) {
+    if ( jst_fileExists( path ) ) return path ;
 
-#if defined( _WIN32 )
-      char originalProcessWorkingDir[ PATH_MAX + 1 ] ;
-      SetDllDirFunc dllDirSetterFunc = getDllDirSetterFuncOrPathToCurrentDir( originalProcessWorkingDir, sizeof( originalProcessWorkingDir ) ) ;
-      if ( ( dllDirSetterFunc || *originalProcessWorkingDir ) &&
-           addJREBinDirToDllSearchPath( java_home, dllDirSetterFunc ) ) {
-#endif
+    free( path ) ;
+  }
 
-        *jvmLib = openDynLib( path ) ;
+  return NULL ;
+
+}
+
+extern char* jst_findJvmDynLibPath( const char* javaHome, JVMSelectStrategy jvmSelectStrategy ) {
+
+  char  *mode,
+        *dynLibFile,
+        *path = NULL ;
+  char** lookupDirs = NULL ;
+  int    i ;
+
+  mode = getJvmSelectStrategy( jvmSelectStrategy, &lookupDirs ) ;
+
+  for ( i = 0 ; ( dynLibFile = lookupDirs[ i ] ) ; i++ ) {
+    if ( *dynLibFile && ( path = findJvmDynLibUnder( javaHome, dynLibFile ) ) ) break ;
+  }
+
+  if ( !path ) {
+    fprintf( stderr, "error: could not find %s jvm under %s\n"
+                     "       please check that it is a valid jdk / jre containing the desired type of jvm\n",
+                     mode, javaHome ) ;
+  }
+
+  return path ;
+
+}
+
+extern char* jst_findJvmDynLibPathQuietly( const char* javaHome, JVMSelectStrategy jvmSelectStrategy ) {
+  char** lookupDirs = NULL ;
+  char*  path       = NULL ;
+  int    i ;
+
+  getJvmSelectStrategy( jvmSelectStrategy, &lookupDirs ) ;
+
+  for ( i = 0 ; lookupDirs[ i ] ; i++ ) {
+    if ( *lookupDirs[ i ] && ( path = findJvmDynLibUnder( javaHome, lookupDirs[ i ] ) ) ) break ;
+  }
+
+  return path ;
+}
+
+/** returns NULL on error (error msg already printed). */
+static JstDLHandle loadJvmDynLib( const char* java_home, const char* path ) {
+
+  JstDLHandle jvmLib = NULL ;
 
 #if defined( _WIN32 )
-        resetDllSearchPath( dllDirSetterFunc, originalProcessWorkingDir ) ;
+  char originalProcessWorkingDir[ PATH_MAX + 1 ] ;
+  SetDllDirFunc dllDirSetterFunc = getDllDirSetterFuncOrPathToCurrentDir( originalProcessWorkingDir, sizeof( originalProcessWorkingDir ) ) ;
+  if ( ( dllDirSetterFunc || *originalProcessWorkingDir ) &&
+       addJREBinDirToDllSearchPath( java_home, dllDirSetterFunc ) ) {
 #endif
 
-        if ( _jst_debug && *jvmLib ) fprintf( stderr, "debug: loaded jvm dynamic library %s\n", path ) ;
+    jvmLib = openDynLib( path ) ;
+
 #if defined( _WIN32 )
-      }
+    resetDllSearchPath( dllDirSetterFunc, originalProcessWorkingDir ) ;
+  }
 #endif
-    }
 
-    jst_freea( path ) ;
-  }
+  if ( _jst_debug && jvmLib ) fprintf( stderr, "debug: loaded jvm dynamic library %s\n", path ) ;
 
-  return *jvmLib != NULL ;
+  return jvmLib ;
 
 }
 
@@ -545,29 +643,116 @@ typedef struct {
 } JstJVM ;
 
 
-/** returns 0 on error. */
-static int findJVMDynamicLibrary( JstJVM* javavm_out, char* java_home, JVMSelectStrategy jvmSelectStrategy ) {
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// loading the jvm dynamic library on a helper thread, see jst_preloadJvmDynLib
 
-  char        *mode ;
-  int         i ;
-  JstDLHandle jvmLib = (JstDLHandle)0 ;
-  char**      lookupDirs = NULL ;
-  char*       dynLibFile ;
+#if !defined( _WIN32 )
 
-  mode = getJvmSelectStrategy( jvmSelectStrategy, &lookupDirs ) ;
+/** Written by the helper thread while it is running, only accessed from the main thread after that. */
+static struct {
+  char*             javaHome ;
+  char*             jvmDynLibPath ;
+  JVMSelectStrategy jvmSelectStrategy ;
+  JstDLHandle       dynLibHandle ;
+  JVMCreatorFunc    creatorFunc ;
+  pthread_t         thread ;
+  jboolean          started ;
+  jboolean          running ;
+} jvmPreload ;
+
+/** The helper thread. Prints nothing, failures are reported when the library is loaded the usual way. */
+static void* preloadJvmDynLib( void* arg ) {
+
+  if ( !jvmPreload.jvmDynLibPath &&
+       !( jvmPreload.jvmDynLibPath = jst_findJvmDynLibPathQuietly( jvmPreload.javaHome, jvmPreload.jvmSelectStrategy ) ) ) return NULL ;
+
+  if ( ( jvmPreload.dynLibHandle = dlopen( jvmPreload.jvmDynLibPath, RTLD_LAZY ) ) ) {
+    jvmPreload.creatorFunc = (JVMCreatorFunc)dlsym( jvmPreload.dynLibHandle, CREATE_JVM_FUNCTION_NAME ) ;
+  }
+
+  return NULL ;
+}
 
-  for ( i = 0; ( dynLibFile = lookupDirs[ i ] ) ; i++ ) {
+/** Waits for the helper thread. Also run before fork, as only the forking thread exists in the child. */
+static void finishJvmPreload( void ) {
+  if ( jvmPreload.running ) {
+    pthread_join( jvmPreload.thread, NULL ) ;
+    jvmPreload.running = JNI_FALSE ;
+  }
+}
 
-    if ( *dynLibFile && loadJvmDynLib( java_home, dynLibFile, &jvmLib ) ) break ;
+extern void jst_preloadJvmDynLib( const char* javaHome, const char* jvmDynLibPath, JVMSelectStrategy jvmSelectStrategy ) {
 
+  if ( jvmPreload.started || !javaHome ) return ;
+  jvmPreload.started = JNI_TRUE ;
+
+  jvmPreload.jvmSelectStrategy = jvmSelectStrategy ;
+  if ( !( jvmPreload.javaHome = jst_strdup( javaHome ) ) ||
+       ( jvmDynLibPath && !( jvmPreload.jvmDynLibPath = jst_strdup( jvmDynLibPath ) ) ) ||
+       pthread_atfork( finishJvmPreload, NULL, NULL ) ) return ;
+
+  if ( pthread_create( &jvmPreload.thread, NULL, preloadJvmDynLib, NULL ) == 0 ) {
+    jvmPreload.running = JNI_TRUE ;
+    if ( _jst_debug ) fprintf( stderr, "debug: preloading jvm dynamic library under %s\n", javaHome ) ;
   }
 
+}
 
-  if ( !jvmLib ) {
-    fprintf( stderr, "error: could not find %s jvm under %s\n"
-                     "       please check that it is a valid jdk / jre containing the desired type of jvm\n",
-                     mode, java_home ) ;
-  } else {
+/** Waits for the preload to finish. If it loaded the given library, fills in the jvm and returns true. Otherwise the
+ * preloaded library is discarded. */
+static jboolean usePreloadedJvmDynLib( JstJVM* javavm_out, const char* jvmDynLibPath ) {
+  jboolean used = JNI_FALSE ;
+
+  if ( !jvmPreload.started ) return JNI_FALSE ;
+
+  finishJvmPreload() ;
+
+  if ( jvmPreload.creatorFunc && jvmDynLibPath && strcmp( jvmPreload.jvmDynLibPath, jvmDynLibPath ) == 0 ) {
+    javavm_out->creatorFunc  = jvmPreload.creatorFunc ;
+    javavm_out->dynLibHandle = jvmPreload.dynLibHandle ;
+    used = JNI_TRUE ;
+    if ( _jst_debug ) fprintf( stderr, "debug: using jvm dynamic library %s preloaded at startup\n", jvmDynLibPath ) ;
+  } else if ( jvmPreload.dynLibHandle ) {
+    dlclose( jvmPreload.dynLibHandle ) ;
+  }
+
+  jvmPreload.dynLibHandle = NULL ;
+  jvmPreload.creatorFunc  = NULL ;
+  jst_free( jvmPreload.javaHome ) ;
+  jst_free( jvmPreload.jvmDynLibPath ) ;
+
+  return used ;
+}
+
+#else
+
+extern void jst_preloadJvmDynLib( const char* javaHome, const char* jvmDynLibPath, JVMSelectStrategy jvmSelectStrategy ) {
+  // the dll search path needs to be modified for loading the jvm, and that is process wide, so this is not done on windows
+}
+
+#  define usePreloadedJvmDynLib( javavm_out, jvmDynLibPath ) JNI_FALSE
+
+#endif
+
+/** returns 0 on error.
+ * @param jvmDynLibPath if NULL, the jvm dynamic library is looked up under java_home. */
+static int findJVMDynamicLibrary( JstJVM* javavm_out, char* java_home, char* jvmDynLibPath, JVMSelectStrategy jvmSelectStrategy ) {
+
+  JstDLHandle jvmLib = (JstDLHandle)0 ;
+  char*       foundDynLibPath = NULL ;
+
+  if ( !jvmDynLibPath ) jvmDynLibPath = foundDynLibPath = jst_findJvmDynLibPath( java_home, jvmSelectStrategy ) ;
+
+  if ( usePreloadedJvmDynLib( javavm_out, jvmDynLibPath ) ) {
+    if ( foundDynLibPath ) free( foundDynLibPath ) ;
+    return 1 ;
+  }
+
+  if ( jvmDynLibPath ) jvmLib = loadJvmDynLib( java_home, jvmDynLibPath ) ;
+
+  if ( foundDynLibPath ) free( foundDynLibPath ) ;
+
+  if ( jvmLib ) {
 
     javavm_out->creatorFunc = (JVMCreatorFunc)findJVMCreatorFunc( jvmLib ) ;
 
@@ -583,19 +768,29 @@ static int findJVMDynamicLibrary( JstJVM* javavm_out, char* java_home, JVMSelect
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 extern JavaVMOption* appendJvmOption( JstJvmOptions* opts, char* optStr, void* extraInfo ) {
-  JavaVMOption tmp ;
+  JavaVMOption* options = jst_ensureArrayCapacity( opts->options, &opts->optionsSize, (size_t)opts->optionsCount + 1, sizeof( JavaVMOption ) ) ;
 
-  tmp.optionString = optStr    ;
-  tmp.extraInfo    = extraInfo ;
+  if ( !options ) return NULL ;
 
-  if ( ( opts->options = jst_appendArrayItem( opts->options, opts->optionsCount, &opts->optionsSize, &tmp, sizeof( JavaVMOption ) ) ) ) {
-    opts->optionsCount++ ;
-    return opts->options ;
-  } else {
-    return NULL ;
-  }
+  opts->options = options ;
+  options[ opts->optionsCount ].optionString = optStr    ;
+  options[ opts->optionsCount ].extraInfo    = extraInfo ;
+  opts->optionsCount++ ;
+
+  return options ;
+
+}
+
+extern const char* jst_findJvmOption( const JstJvmOptions* opts, const char** prefixes ) {
+  int i, j ;
 
+  for ( i = 0 ; i < opts->optionsCount ; i++ ) {
+    for ( j = 0 ; prefixes[ j ] ; j++ ) {
+      if ( strncmp( opts->options[ i ].optionString, prefixes[ j ], strlen( prefixes[ j ] ) ) == 0 ) return opts->options[ i ].optionString ;
+    }
+  }
 
+  return NULL ;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -604,41 +799,56 @@ extern JavaVMOption* appendJvmOption( JstJvmOptions* opts, char* optStr, void* e
  * cp needs to contain before calling this func). Adds path separator
  * before the given entry, unless this is the first entry. Returns the cp buffer (which may be moved)
  * Returns 0 on error (err msg already printed). */
-static char* appendCPEntry(char* cp, size_t* cpsize, const char* entry) {
+static char* appendCPEntry( JstStringBuilder* cp, const char* entry ) {
 
   jboolean firstEntry =
     // "-Xbootclasspath:"
-    cp[ 15 ] == ':' ? !cp[ 16 ] :
+    cp->chars[ 15 ] == ':' ? !cp->chars[ 16 ] :
     // "-Djava.class.path=" == 18 chars -> if 19th char (index 18) is not a null char, we have more than that and need to append path separator
     // "-Xbootclasspath/a:" or "-Xbootclasspath/p:" are same length
-    !cp[ 18 ]
+    !cp->chars[ 18 ]
     ;
 
-  if ( !firstEntry
-      && !( cp = jst_append( cp, cpsize, JST_PATH_SEPARATOR, NULL ) ) ) return NULL ;
-
-  return jst_append( cp, cpsize, entry, NULL ) ;
+  return jst_appendToStringBuilder( cp, firstEntry ? "" : JST_PATH_SEPARATOR, entry, NULL ) ;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 
-/** returns != 0 on failure. May change the target to point to a new location */
-static jboolean appendJarsFromDir( JarDirSpecification* dirSpec, char** target, size_t* targetSize ) {
+/** Callback for jst_findJarsRecursively, appends the found jar to the classpath being constructed. */
+static int appendFoundJar( void* classpath, const char* dirName, const char* jarName ) {
+  JstStringBuilder* cp = (JstStringBuilder*)classpath ;
+
+  return appendCPEntry( cp, dirName ) &&
+         jst_appendToStringBuilder( cp, jst_dirNameEndsWithSeparator( dirName ) ? "" : JST_FILE_SEPARATOR, jarName, NULL ) ;
+}
+
+/** returns != 0 on failure, in which case the target has been freed. */
+static jboolean appendJarsFromDir( JarDirSpecification* dirSpec, JstStringBuilder* target ) {
 
   char *dirName = dirSpec->name ;
-  char **jarNames = jst_getFileNames( dirName, NULL, ".jar", NULL ),
+  char **jarNames,
        *s ;
   int i = 0 ;
   jboolean dirNameEndsWithSeparator = jst_dirNameEndsWithSeparator( dirName ),
            errorOccurred = JNI_FALSE ;
 
-  if ( !jarNames ) return JNI_TRUE ;
+  if ( dirSpec->fetchRecursively ) {
+    if ( jst_findJarsRecursively( dirName, dirSpec->filter, appendFoundJar, target ) ) return JNI_FALSE ;
+    // the builder may already have been freed, in which case this does nothing
+    jst_freeStringBuilder( target ) ;
+    return JNI_TRUE ;
+  }
+
+  if ( !( jarNames = jst_getFileNames( dirName, NULL, ".jar", NULL ) ) ) {
+    jst_freeStringBuilder( target ) ;
+    return JNI_TRUE ;
+  }
 
   while ( ( s = jarNames[ i++ ] ) ) {
     if ( !dirSpec->filter || dirSpec->filter( dirName, s ) ) {
-      if(    !( *target = appendCPEntry( *target, targetSize, dirName ) )
-          || !( *target = jst_append( *target, targetSize, dirNameEndsWithSeparator ? "" : JST_FILE_SEPARATOR, s, NULL ) )
+      if(    !appendCPEntry( target, dirName )
+          || !jst_appendToStringBuilder( target, dirNameEndsWithSeparator ? "" : JST_FILE_SEPARATOR, s, NULL )
         ) {
         errorOccurred = JNI_TRUE ;
         goto end ;
@@ -646,12 +856,6 @@ static jboolean appendJarsFromDir( JarDirSpecification* dirSpec, char** target,
     }
   }
 
-  if ( dirSpec->fetchRecursively ) {
-    // FIXME - implement this behavior
-    fprintf( stderr, "error: adding jars recursively from a directory not supported yet\n" ) ;
-    errorOccurred = JNI_TRUE ;
-  }
-
   end:
   free( jarNames ) ;
   return errorOccurred ;
@@ -695,25 +899,24 @@ static char* selectClasspathType( JstClasspathStrategy classpathStrategy ) {
   return cpPrefix ;
 }
 
-/** @param initialCP may be NULL */
-static char* constructClasspath( char* initialCP, JarDirSpecification* jarDirs, char** jars, JstClasspathStrategy classpathStrategy ) {
-  size_t cpsize    = 255 ; // just an initial guess for classpath length, will be expanded as necessary
-  char*  classpath = NULL ;
-  char*  cpPrefix  = selectClasspathType( classpathStrategy ) ;
+extern char* jst_constructClasspath( char* initialCP, JarDirSpecification* jarDirs, char** jars, JstClasspathStrategy classpathStrategy ) {
+  // on error the builder frees what has been built so far, so classpath.chars is NULL
+  JstStringBuilder classpath = JST_STRING_BUILDER_INITIALIZER ;
+  char*            cpPrefix  = selectClasspathType( classpathStrategy ) ;
 
   if ( !cpPrefix ) goto end ;
 
-  if ( !( classpath = jst_append( NULL, &cpsize, cpPrefix, NULL ) ) ) goto end ;
+  if ( !jst_appendToStringBuilder( &classpath, cpPrefix, NULL ) ) goto end ;
 
   if ( initialCP ) {
-    if ( !( classpath = appendCPEntry( classpath, &cpsize, initialCP ) ) ) goto end ;
+    if ( !appendCPEntry( &classpath, initialCP ) ) goto end ;
   }
 
   // add the jars from the given dirs
   if ( jarDirs ) {
     int i ;
     for ( i = 0 ; jarDirs[ i ].name ; i++ ) {
-      if ( appendJarsFromDir( &(jarDirs[ i ]), &classpath, &cpsize ) ) goto end ; // error msg already printed
+      if ( appendJarsFromDir( &(jarDirs[ i ]), &classpath ) ) goto end ; // error msg already printed
     }
 
   }
@@ -723,56 +926,78 @@ static char* constructClasspath( char* initialCP, JarDirSpecification* jarDirs,
   if ( jars ) {
 
     while ( *jars ) {
-      if ( !( classpath = appendCPEntry( classpath, &cpsize, *jars++ ) ) ) goto end ;
+      if ( !appendCPEntry( &classpath, *jars++ ) ) goto end ;
     }
 
   }
 
   end:
 
-  return classpath ;
+  return classpath.chars ;
 
 }
 
 /**
- * Adds the options in the param userOpts (separated by spaces) to the jvm options passed in.
+ * Adds the options in the param userOpts (separated by whitespace) to the jvm options passed in.
+ * A part of an option in "double" or 'single' quotes may contain whitespace and the other kind of quote,
+ * e.g. "-Dapp.title=My app". The quotes are removed. There are no escapes, so backslashes (e.g. in windows
+ * paths) are taken as they are.
  *
- * Known bug: always separates at ' ', does not take into account quoted values w/ spaces. Should not
- * usually be a problem, so fixing it is left till someone complains about it, i.e. actually has
- * a problem w/ it.
- *
- * @param userOpts contains ' '  separated options for the jvm. May not be NULL or empty. The given string is modified
- *                 so that nul char terminations are inserted at spaces and this buffer is used to hold the strings passed to the jvm.
- *                 I.e. Take care it is not freed or reused before jvm is started.
+ * @param userOpts contains the whitespace separated options for the jvm. May not be NULL. The given string is modified
+ *                 so that the quotes are removed and nul char terminations are inserted at the separators, and this buffer
+ *                 is used to hold the strings passed to the jvm. I.e. Take care it is not freed or reused before jvm is started.
  * @param jvmStrategyOut modified if -client or -server given on the command line, left alone otherwise.
- * @return 0 on error */
+ * @return 0 on error (err msg printed), e.g. on an unmatched quote */
 extern int handleJVMOptsString( char* userOpts, JstJvmOptions* jvmOptions, JVMSelectStrategy* jvmStrategyOut ) {
 
-  char *s ;
-  jboolean firstTime = JNI_TRUE,
-           success   = JNI_TRUE ;
+  char *in = userOpts,
+       *out,
+       *s ;
+  char quote ;
+
+  for ( ;; ) {
 
-  for ( ; ( s = strtok( firstTime ? userOpts : NULL, " " ) ) ; firstTime = JNI_FALSE ) {
+    while ( isspace( (unsigned char)*in ) ) in++ ;
+    if ( !*in ) break ;
+
+    // the option is unquoted in place, the result is never longer than the original
+    s = out = in ;
+    for ( quote = '\0' ; *in && ( quote || !isspace( (unsigned char)*in ) ) ; in++ ) {
+      if ( quote ? ( *in == quote ) : ( *in == '"' || *in == '\'' ) ) {
+        quote = quote ? '\0' : *in ;
+      } else {
+        *out++ = *in ;
+      }
+    }
+
+    if ( quote ) {
+      fprintf( stderr, "error: unmatched %c in jvm options\n", quote ) ;
+      return 0 ;
+    }
+
+    if ( *in ) in++ ;
+    *out = '\0' ;
+
+    if ( !*s ) continue ;
 
     if ( strcmp( s, "-client" ) == 0 ) {
       *jvmStrategyOut = JST_CLIENTVM ;
     } else if ( strcmp( s, "-server" ) == 0 ) {
       *jvmStrategyOut = JST_SERVERVM ;
     } else if ( !appendJvmOption( jvmOptions, s, NULL ) ) {
-      success = JNI_FALSE ;
-      break ;
+      return 0 ;
     }
 
   }
 
-  return success ;
+  return 1 ;
 
 }
 
 
 
 /** returns != 0 on error */
-static jint jst_startJvm( jint vmversion, JstJvmOptions *jvmOptions, jboolean ignoreUnrecognizedJvmParams, char* javaHome, JVMSelectStrategy jvmSelectStrategy,
+static jint jst_startJvm( jint vmversion, JstJvmOptions *jvmOptions, jboolean ignoreUnrecognizedJvmParams, char* javaHome, char* jvmDynLibPath, JVMSelectStrategy jvmSelectStrategy,
                     // output
                     JstJVM* javaVM ) {
   JavaVMInitArgs vm_args ;
@@ -785,8 +1010,10 @@ static jint jst_startJvm( jint vmversion, JstJvmOptions *jvmOptions, jboolean ig
   vm_args.ignoreUnrecognized = ignoreUnrecognizedJvmParams ;
 
 
+  jst_tracePhase( "dlopen" ) ;
+
   // fetch the pointer to jvm creator func and invoke it
-  if ( !findJVMDynamicLibrary( javaVM, javaHome, jvmSelectStrategy ) ) { // error message already printed
+  if ( !findJVMDynamicLibrary( javaVM, javaHome, jvmDynLibPath, jvmSelectStrategy ) ) { // error message already printed
     return -1 ;
   }
 
@@ -795,6 +1022,8 @@ static jint jst_startJvm( jint vmversion, JstJvmOptions *jvmOptions, jboolean ig
   // "dereferencing type-punned pointer will break strict-aliasing rules"
   // Found the fix from
   // http://mail.opensolaris.org/pipermail/tools-gcc/2005-August/000048.html
+  jst_tracePhase( "createjvm" ) ;
+
   result = (javaVM->creatorFunc)( &javaVM->javavm, (void**)(void*)&javaVM->env, &vm_args ) ;
 
   if ( result ) {
@@ -889,16 +1118,30 @@ void printParameterDebugInformation( JstActualParam* parameter, JstParamInfo* pa
 
 }
 
-static int addParametersToJStringArray( JNIEnv* env, jobjectArray launcheeJOptions, JstActualParam* parameters, JstUnrecognizedParamStrategy unrecognizedParamStrategy, jint indx ) {
+/** Returns a NULL terminated array of the args to give to the main method, or NULL on error (err msg already printed).
+ * Only the returned array needs to be freed, the strings in it are not copied. */
+static char** createMainArgs( JstActualParam* parameters, char** extraProgramOptions, JstUnrecognizedParamStrategy unrecognizedParamStrategy ) {
 
-  int i ;
+  char** args ;
+  int    indx = 0,
+         i ;
+
+  int passedParamCount = countParamsPassedToMainMethod( parameters, unrecognizedParamStrategy ) +
+                         jst_pointerArrayLen( (void**)(void*)extraProgramOptions ) ;
+
+  if ( _jst_debug ) fprintf( stderr, "passing %d parameters to main method: \n", passedParamCount ) ;
+
+  if ( !( args = jst_malloc( ( passedParamCount + 1 ) * sizeof( char* ) ) ) ) return NULL ;
+
+  if ( extraProgramOptions ) {
+    if ( _jst_debug ) jst_printStringArray( stderr, "  %s\n", extraProgramOptions ) ;
+    for ( ; *extraProgramOptions ; extraProgramOptions++ ) args[ indx++ ] = *extraProgramOptions ;
+  }
 
   for ( i = 0 ; parameters[ i ].param ; i++ ) {
 
     if ( jst_isToBePassedToLaunchee( parameters + i, unrecognizedParamStrategy ) ) {
 
-      int errorOccurred = 0 ;
-
       JstParamInfo* paramInfo  = parameters[ i ].paramDefinition ;
       JstParamClass paramClass = paramInfo ? paramInfo->type : 0 ;
 
@@ -907,73 +1150,48 @@ static int addParametersToJStringArray( JNIEnv* env, jobjectArray launcheeJOptio
       switch ( paramClass ) {
         case JST_SINGLE_PARAM :
         case JST_TERMINATING_OR_AFTER  :
-          errorOccurred = !addStringToJStringArray( env, parameters[ i ].param, launcheeJOptions, indx++ ) ;
+          args[ indx++ ] = parameters[ i ].param ;
           break ;
         case JST_DOUBLE_PARAM :
-          errorOccurred = !addStringToJStringArray( env, parameters[ i ].param,   launcheeJOptions, indx++ ) ||
-                          !addStringToJStringArray( env, parameters[ i++ ].value, launcheeJOptions, indx++ ) ;
+          args[ indx++ ] = parameters[ i ].param ;
+          args[ indx++ ] = parameters[ i++ ].value ;
           break ;
         default : // prefix params + all params after termination
           assert( paramClass == JST_PREFIX_PARAM || ( !paramInfo || ( paramInfo->handling & JST_TERMINATING_OR_AFTER ) ) ) ;
-          errorOccurred = !addStringToJStringArray( env, parameters[ i ].value, launcheeJOptions, indx++ ) ;
+          args[ indx++ ] = parameters[ i ].value ;
           break ;
       }
 
-      if ( errorOccurred ) return errorOccurred ;
-
     }
   } // for
 
-  return 0 ;
+  args[ indx ] = NULL ;
+
+  return args ;
 
 }
 
-static jobjectArray createJStringArrayToHoldParamsToMain( JNIEnv* env, JstActualParam* parameters, char** extraProgramOptions, JstUnrecognizedParamStrategy unrecognizedParamStrategy ) {
+/** Returns a java String[] holding the given strings, or NULL on error (err msg already printed). */
+static jobjectArray createJStringArray( JNIEnv* env, char** strings ) {
 
-  int          passedParamCount ;
+  jobjectArray jstrings ;
   jclass       strClass ;
 
-  passedParamCount = countParamsPassedToMainMethod( parameters, unrecognizedParamStrategy ) ;
-
-  passedParamCount += jst_pointerArrayLen( (void**)(void*)extraProgramOptions ) ;
-
-  if ( _jst_debug ) fprintf( stderr, "passing %d parameters to main method: \n", passedParamCount ) ;
+  int count = jst_pointerArrayLen( (void**)(void*)strings ) ;
 
-  if ( ensureJNILocalCapacity( env, passedParamCount + 1 ) || // + 1 for the String[] to hold the params
-       !( strClass = getJavaStringClass( env ) ) ) {
+  // the strings are created in local frames of their own, so only the String[] needs room here
+  if ( ensureJNILocalCapacity( env, 1 ) ||
+       !( strClass = getJavaStringClass( env ) ) ||
+       !( jstrings = createJObjectArray( env, count, strClass ) ) ) {
     return NULL ;
   }
 
-  return createJObjectArray( env, passedParamCount, strClass ) ;
-
-}
-
-static jobjectArray createJMainParams( JNIEnv* env, JstActualParam* parameters, char** extraProgramOptions, JstUnrecognizedParamStrategy unrecognizedParamStrategy ) {
-
-  jobjectArray launcheeJOptions ;
-
-  int indx             = 0, // index in java String[] (args to main)
-      errorOccurred    = 0 ;
-
-  launcheeJOptions = createJStringArrayToHoldParamsToMain( env, parameters, extraProgramOptions, unrecognizedParamStrategy ) ;
-  if ( !launcheeJOptions ) return NULL ;
-
-  if ( !( errorOccurred = addStringsToJavaStringArray( env, launcheeJOptions, extraProgramOptions, indx ) ) ) {
-
-    indx += jst_pointerArrayLen( (void**)(void*)extraProgramOptions ) ;
-
-    if ( _jst_debug ) jst_printStringArray( stderr, "  %s\n", extraProgramOptions ) ;
-
-    errorOccurred = addParametersToJStringArray( env, launcheeJOptions, parameters, unrecognizedParamStrategy, indx ) ;
-
+  if ( addStringsToJavaStringArray( env, jstrings, strings, 0 ) ) {
+    (*env)->DeleteLocalRef( env, jstrings ) ;
+    jstrings = NULL ;
   }
 
-  if ( errorOccurred ) {
-    (*env)->DeleteLocalRef( env, launcheeJOptions ) ;
-    launcheeJOptions = NULL ;
-  }
-
-  return launcheeJOptions ;
+  return jstrings ;
 
 }
 
@@ -1021,8 +1239,9 @@ static JavaVMOption* handleJVMOptionsGivenOnCommandLine( JavaLauncherOptions *la
 }
 
 
-/** string pointed to by userJvmOptsS_out must be freed by the caller */
-static int gatherJVMOptions( JstJvmOptions* jvmOptions, JavaLauncherOptions* launchOptions ) {
+/** string pointed to by userJvmOptsS_out must be freed by the caller
+ * @param launcherOptionCount set to the number of options before the ones tuning the jvm for this particular run */
+static int gatherJVMOptions( JstJvmOptions* jvmOptions, JavaLauncherOptions* launchOptions, int* launcherOptionCount ) {
 
   int i ;
 
@@ -1043,6 +1262,12 @@ static int gatherJVMOptions( JstJvmOptions* jvmOptions, JavaLauncherOptions* lau
 
   if ( !handleJVMOptionsGivenOnCommandLine( launchOptions, jvmOptions ) ) return 0 ;
 
+  *launcherOptionCount = jvmOptions->optionsCount ;
+
+  // these are only added if the user has not given them, so they come after the user's options
+  if ( !jst_addCgroupSizingOptions( jvmOptions, launchOptions->javaHome ) ) return 0 ;
+  if ( !jst_addProfileOptions( jvmOptions, launchOptions->jvmProfile, launchOptions->runHistoryKey ) ) return 0 ;
+
   if ( _jst_debug ) {
     fprintf( stderr, "DUBUG: Starting jvm with the following %d options:\n", jvmOptions->optionsCount ) ;
     for ( i = 0 ; i < jvmOptions->optionsCount ; i++ ) {
@@ -1054,35 +1279,629 @@ static int gatherJVMOptions( JstJvmOptions* jvmOptions, JavaLauncherOptions* lau
 
 }
 
-/** See the header file for information.
- */
-extern int jst_launchJavaApp( JavaLauncherOptions *launchOptions ) {
-  int          rval    = -1 ;
+/** Sets the given system property in the running jvm. Returns 0 on error (exception already cleared). */
+static int setSystemProperty( JNIEnv* env, jclass systemClass, jmethodID setPropertyMethod, const char* name, const char* value ) {
+  jstring jname  = (*env)->NewStringUTF( env, name ),
+          jvalue = jname ? (*env)->NewStringUTF( env, value ) : NULL ;
+  jobject previousValue = NULL ;
+  int     success = 0 ;
 
-  JstJVM       javavm ;
+  if ( jvalue ) {
+    previousValue = (*env)->CallStaticObjectMethod( env, systemClass, setPropertyMethod, jname, jvalue ) ;
+    success = !(*env)->ExceptionCheck( env ) ;
+  }
 
-  JstJvmOptions jvmOptions ;
+  if ( !success ) clearException( env ) ;
 
-  jclass       launcheeMainClassHandle  = NULL ;
-  jmethodID    launcheeMainMethodID     = NULL ;
-  jobjectArray launcheeJOptions         = NULL ;
+  if ( previousValue ) (*env)->DeleteLocalRef( env, previousValue ) ;
+  if ( jvalue        ) (*env)->DeleteLocalRef( env, jvalue ) ;
+  if ( jname         ) (*env)->DeleteLocalRef( env, jname ) ;
 
-  char* classpath = NULL ;
+  return success ;
+}
 
-  JVMSelectStrategy jvmSelectStrategy = launchOptions->jvmSelectStrategy ;
+/** Makes the timings of the launch phases completed so far available to the launched app as system properties
+ * jst.launch.<phase>.us (duration in microseconds), jst.launch.<phase>.minflt and jst.launch.<phase>.majflt (page faults).
+ * Failing to do so is not considered an error, it is just reported in debug output. */
+static void setLaunchTimingProperties( JNIEnv* env ) {
+  const JstTracePhase* phases ;
+  int       phaseCount = jst_getTracePhases( &phases ),
+            i ;
+  jclass    systemClass ;
+  jmethodID setPropertyMethod ;
+
+  if ( !( systemClass = (*env)->FindClass( env, "java/lang/System" ) ) ||
+       !( setPropertyMethod = (*env)->GetStaticMethodID( env, systemClass, "setProperty", "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;" ) ) ) {
+    clearException( env ) ;
+    if ( _jst_debug ) fprintf( stderr, "debug: could not set the launch timing system properties\n" ) ;
+    return ;
+  }
+
+  for ( i = 0 ; i < phaseCount ; i++ ) {
+    char name[ 64 ], value[ 32 ] ;
+
+    if ( !phases[ i ].duration || strlen( phases[ i ].name ) > 40 ) continue ;
+
+    sprintf( name, "jst.launch.%s.us", phases[ i ].name ) ;
+    sprintf( value, "%.0f", (double)phases[ i ].duration ) ;
+    if ( !setSystemProperty( env, systemClass, setPropertyMethod, name, value ) ) break ;
+
+    sprintf( name, "jst.launch.%s.minflt", phases[ i ].name ) ;
+    sprintf( value, "%.0f", (double)phases[ i ].minorFaults ) ;
+    if ( !setSystemProperty( env, systemClass, setPropertyMethod, name, value ) ) break ;
+
+    sprintf( name, "jst.launch.%s.majflt", phases[ i ].name ) ;
+    sprintf( value, "%.0f", (double)phases[ i ].majorFaults ) ;
+    if ( !setSystemProperty( env, systemClass, setPropertyMethod, name, value ) ) break ;
+  }
+
+  (*env)->DeleteLocalRef( env, systemClass ) ;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// server mode
+
+/** System properties that differ between launches that otherwise could share a server (e.g. script.name, which is
+ * different for each script run). They are left out of the server key and set for each request instead. */
+static const char* perRequestProperties[] = { "script.name", NULL } ;
+
+/** Returns true if the given jvm option sets one of the perRequestProperties. */
+static jboolean isPerRequestProperty( const char* option ) {
+  int i ;
+
+  if ( strncmp( option, "-D", 2 ) ) return JNI_FALSE ;
+
+  for ( i = 0 ; perRequestProperties[ i ] ; i++ ) {
+    size_t len = strlen( perRequestProperties[ i ] ) ;
+    if ( !strncmp( option + 2, perRequestProperties[ i ], len ) && option[ 2 + len ] == '=' ) return JNI_TRUE ;
+  }
+
+  return JNI_FALSE ;
+}
+
+/** A server is only used for launches that would start an equivalent jvm, so the key covers the jvm, the classpath and
+ * the jvm options given by the launcher and the user. The options the launcher adds to tune the jvm for a particular run
+ * (those after launcherOptionCount, see gatherJVMOptions) and the perRequestProperties are not part of it, otherwise
+ * e.g. every script would get a server of its own. */
+static JstHash createServerKey( JstJvmOptions* jvmOptions, int launcherOptionCount, JavaLauncherOptions* launchOptions ) {
+  JstHash key = jst_hashString( JST_HASH_INIT, "jst-server-2" ) ;
+  int     i ;
+
+  key = jst_hashString( key, launchOptions->javaHome ) ;
+  key = jst_hashString( key, launchOptions->jvmDynLibPath ) ;
+  key = jst_hashBytes( key, &launchOptions->jvmSelectStrategy, sizeof( launchOptions->jvmSelectStrategy ) ) ;
+  key = jst_hashString( key, launchOptions->mainClassName ) ;
+  key = jst_hashString( key, launchOptions->mainMethodName ) ;
+
+  // the first option is the classpath
+  for ( i = 0 ; i < launcherOptionCount ; i++ ) {
+    if ( !isPerRequestProperty( jvmOptions->options[ i ].optionString ) ) key = jst_hashString( key, jvmOptions->options[ i ].optionString ) ;
+  }
+
+  return key ;
+}
+
+/** Returns a global ref to a copy of the current system properties, NULL on error. */
+static jobject copySystemProperties( JNIEnv* env ) {
+  jclass    systemClass ;
+  jmethodID getPropertiesMethod,
+            cloneMethod ;
+  jobject   properties,
+            copy = NULL ;
+
+  if ( (*env)->PushLocalFrame( env, 8 ) ) {
+    clearException( env ) ;
+    return NULL ;
+  }
+
+  if ( ( systemClass = (*env)->FindClass( env, "java/lang/System" ) ) &&
+       ( getPropertiesMethod = (*env)->GetStaticMethodID( env, systemClass, "getProperties", "()Ljava/util/Properties;" ) ) &&
+       ( properties = (*env)->CallStaticObjectMethod( env, systemClass, getPropertiesMethod ) ) &&
+       ( cloneMethod = (*env)->GetMethodID( env, (*env)->GetObjectClass( env, properties ), "clone", "()Ljava/lang/Object;" ) ) ) {
+    copy = (*env)->CallObjectMethod( env, properties, cloneMethod ) ;
+  }
+
+  if ( (*env)->ExceptionCheck( env ) ) {
+    clearException( env ) ;
+    copy = NULL ;
+  }
+
+  if ( copy ) copy = (*env)->NewGlobalRef( env, copy ) ;
+
+  (*env)->PopLocalFrame( env, NULL ) ;
+
+  return copy ;
+}
+
+/** Puts the jvm in the same state for each request as far as practical: the system properties are reset to what they were
+ * when the server started (except for user.dir, which is set to the client's working dir, and the perRequestProperties,
+ * which are set to what the client gave), System.in is reopened so nothing buffered from the previous request's stdin
+ * is read, and the context class loader of the main thread is reset.
+ * Note that on recent jvms changing user.dir does not affect resolving relative java.io.File paths (the process working dir
+ * is changed, though, so opening files w/ relative paths works).
+ * Returns 0 on error. */
+static int resetJvmStateForRequest( JNIEnv* env, jobject initialProperties, const char* workingDir, char** requestProperties ) {
+  jclass    systemClass,
+            fileDescriptorClass,
+            fileInputStreamClass,
+            threadClass,
+            classLoaderClass ;
+  jmethodID setPropertiesMethod,
+            setPropertyMethod,
+            clearPropertyMethod,
+            cloneMethod,
+            fileInputStreamConstructor,
+            setInMethod,
+            currentThreadMethod,
+            getSystemClassLoaderMethod,
+            setContextClassLoaderMethod ;
+  jfieldID  stdinField ;
+  jobject   properties,
+            stdinDescriptor,
+            stdin,
+            thread,
+            classLoader ;
+  int       success = 0,
+            i ;
+
+  if ( (*env)->PushLocalFrame( env, 16 ) ) {
+    clearException( env ) ;
+    return 0 ;
+  }
+
+  if ( !( systemClass = (*env)->FindClass( env, "java/lang/System" ) ) ||
+       !( setPropertiesMethod = (*env)->GetStaticMethodID( env, systemClass, "setProperties", "(Ljava/util/Properties;)V" ) ) ||
+       !( setPropertyMethod = (*env)->GetStaticMethodID( env, systemClass, "setProperty", "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;" ) ) ||
+       !( clearPropertyMethod = (*env)->GetStaticMethodID( env, systemClass, "clearProperty", "(Ljava/lang/String;)Ljava/lang/String;" ) ) ||
+       !( setInMethod = (*env)->GetStaticMethodID( env, systemClass, "setIn", "(Ljava/io/InputStream;)V" ) ) ||
+       !( cloneMethod = (*env)->GetMethodID( env, (*env)->GetObjectClass( env, initialProperties ), "clone", "()Ljava/lang/Object;" ) ) ||
+       !( properties = (*env)->CallObjectMethod( env, initialProperties, cloneMethod ) ) ) goto end ;
+
+  (*env)->CallStaticVoidMethod( env, systemClass, setPropertiesMethod, properties ) ;
+  if ( (*env)->ExceptionCheck( env ) ||
+       !setSystemProperty( env, systemClass, setPropertyMethod, "user.dir", workingDir ) ) goto end ;
+
+  // the server was started w/ the per request properties of the launch that started it
+  for ( i = 0 ; perRequestProperties[ i ] ; i++ ) {
+    jstring name = (*env)->NewStringUTF( env, perRequestProperties[ i ] ) ;
+    jobject previousValue ;
+
+    if ( !name ) goto end ;
+    previousValue = (*env)->CallStaticObjectMethod( env, systemClass, clearPropertyMethod, name ) ;
+    if ( (*env)->ExceptionCheck( env ) ) goto end ;
+    if ( previousValue ) (*env)->DeleteLocalRef( env, previousValue ) ;
+    (*env)->DeleteLocalRef( env, name ) ;
+  }
+
+  for ( ; requestProperties && *requestProperties ; requestProperties++ ) {
+    char *name   = jst_strdup( *requestProperties ),
+         *equals = name ? strchr( name, '=' ) : NULL ;
+    int  set ;
+
+    if ( !equals ) {
+      if ( name ) free( name ) ;
+      goto end ;
+    }
+    *equals = '\0' ;
+    set = setSystemProperty( env, systemClass, setPropertyMethod, name, equals + 1 ) ;
+    free( name ) ;
+    if ( !set ) goto end ;
+  }
+
+  if ( !( fileDescriptorClass = (*env)->FindClass( env, "java/io/FileDescriptor" ) ) ||
+       !( stdinField = (*env)->GetStaticFieldID( env, fileDescriptorClass, "in", "Ljava/io/FileDescriptor;" ) ) ||
+       !( stdinDescriptor = (*env)->GetStaticObjectField( env, fileDescriptorClass, stdinField ) ) ||
+       !( fileInputStreamClass = (*env)->FindClass( env, "java/io/FileInputStream" ) ) ||
+       !( fileInputStreamConstructor = (*env)->GetMethodID( env, fileInputStreamClass, "<init>", "(Ljava/io/FileDescriptor;)V" ) ) ||
+       !( stdin = (*env)->NewObject( env, fileInputStreamClass, fileInputStreamConstructor, stdinDescriptor ) ) ) goto end ;
+
+  (*env)->CallStaticVoidMethod( env, systemClass, setInMethod, stdin ) ;
+  if ( (*env)->ExceptionCheck( env ) ) goto end ;
+
+  if ( !( threadClass = (*env)->FindClass( env, "java/lang/Thread" ) ) ||
+       !( currentThreadMethod = (*env)->GetStaticMethodID( env, threadClass, "currentThread", "()Ljava/lang/Thread;" ) ) ||
+       !( setContextClassLoaderMethod = (*env)->GetMethodID( env, threadClass, "setContextClassLoader", "(Ljava/lang/ClassLoader;)V" ) ) ||
+       !( thread = (*env)->CallStaticObjectMethod( env, threadClass, currentThreadMethod ) ) ||
+       !( classLoaderClass = (*env)->FindClass( env, "java/lang/ClassLoader" ) ) ||
+       !( getSystemClassLoaderMethod = (*env)->GetStaticMethodID( env, classLoaderClass, "getSystemClassLoader", "()Ljava/lang/ClassLoader;" ) ) ||
+       !( classLoader = (*env)->CallStaticObjectMethod( env, classLoaderClass, getSystemClassLoaderMethod ) ) ) goto end ;
+
+  (*env)->CallVoidMethod( env, thread, setContextClassLoaderMethod, classLoader ) ;
+  success = !(*env)->ExceptionCheck( env ) ;
+
+  end:
+  if ( !success ) {
+    clearException( env ) ;
+    fprintf( stderr, "error: could not reset the jvm state for running a new request\n" ) ;
+  }
+  (*env)->PopLocalFrame( env, NULL ) ;
+
+  return success ;
+}
+
+/** Flushes System.out and System.err so nothing written during a request ends up in the output of the next one. */
+static void flushJavaStdStreams( JNIEnv* env ) {
+  static const char* streamNames[] = { "out", "err", NULL } ;
+  jclass    systemClass ;
+  jmethodID flushMethod = NULL ;
+  int       i ;
+
+  if ( (*env)->PushLocalFrame( env, 8 ) ) {
+    clearException( env ) ;
+    return ;
+  }
+
+  if ( ( systemClass = (*env)->FindClass( env, "java/lang/System" ) ) ) {
+    for ( i = 0 ; streamNames[ i ] ; i++ ) {
+      jfieldID streamField = (*env)->GetStaticFieldID( env, systemClass, streamNames[ i ], "Ljava/io/PrintStream;" ) ;
+      jobject  stream      = streamField ? (*env)->GetStaticObjectField( env, systemClass, streamField ) : NULL ;
+
+      if ( !stream ) break ;
+      if ( !flushMethod && !( flushMethod = (*env)->GetMethodID( env, (*env)->GetObjectClass( env, stream ), "flush", "()V" ) ) ) break ;
+      (*env)->CallVoidMethod( env, stream, flushMethod ) ;
+      if ( (*env)->ExceptionCheck( env ) ) break ;
+    }
+  }
+
+  if ( (*env)->ExceptionCheck( env ) ) clearException( env ) ;
+  (*env)->PopLocalFrame( env, NULL ) ;
+}
+
+/** Runs the main method for each request received on the given server socket until the server has been idle for long enough.
+ * Classes are isolated between requests only to the extent the main class loads the app through a fresh class loader on
+ * each invocation (as e.g. GroovyStarter does), the classes on the startup classpath stay loaded for the lifetime of the server.
+ * Returns 0 when the server is done, != 0 if it could not be started. */
+static int serveRequests( JNIEnv* env, int serverSocket, jclass mainClass, jmethodID mainMethod ) {
+  JstServerRequest request ;
+  jobject initialProperties = copySystemProperties( env ) ;
+
+  if ( !initialProperties ) {
+    fprintf( stderr, "error: could not start the launcher server\n" ) ;
+    return -1 ;
+  }
+
+  while ( jst_acceptServerRequest( serverSocket, &request ) ) {
+    jobjectArray args ;
+    int exitCode = -1 ;
+
+    if ( resetJvmStateForRequest( env, initialProperties, request.workingDir, request.properties ) &&
+         ( args = createJStringArray( env, request.args ) ) ) {
+
+      (*env)->CallStaticVoidMethod( env, mainClass, mainMethod, args ) ;
+
+      if ( (*env)->ExceptionCheck( env ) ) {
+        (*env)->ExceptionClear( env ) ;
+      } else {
+        exitCode = 0 ;
+      }
+
+      (*env)->DeleteLocalRef( env, args ) ;
+    }
+
+    flushJavaStdStreams( env ) ;
+    jst_finishServerRequest( &request, exitCode ) ;
+  }
+
+  (*env)->DeleteGlobalRef( env, initialProperties ) ;
+
+  return 0 ;
+}
+
+/** The exit code reported to a server client when the jvm aborts, the same a shell reports for a process killed by SIGABRT. */
+#define ABORT_EXIT_CODE 134
+
+/** What the exit hook needs to finish the launch when the jvm exits the process itself, as it does on System.exit, w/out
+ * returning to jst_launchJavaApp. */
+static struct {
+  JstSharedArchive* sharedArchive ;
+  jboolean          serving ;
+  /** When the main method was called (see jst_monotonicMicros), 0 if the run is not going on or has been recorded. */
+  jlong             mainStarted ;
+  /** The time spent in gc by the time the main method returned, -1 if not known. */
+  jlong             gcMillis ;
+} exitHookState ;
+
+/** Runs shorter than this are not worth loading the management classes for to find out their gc time. */
+#define MIN_GC_QUERY_MILLIS 1000
+
+/** Returns the total time spent in gc by this jvm, -1 if it could not be found out. */
+static jlong getGcMillis( JNIEnv* env ) {
+  jclass    factoryClass,
+            listClass,
+            beanClass ;
+  jmethodID getBeansMethod,
+            sizeMethod,
+            getMethod,
+            getTimeMethod ;
+  jobject   beans ;
+  jint      count,
+            i ;
+  jlong     total = -1,
+            time ;
+
+  if ( (*env)->PushLocalFrame( env, 16 ) ) {
+    clearException( env ) ;
+    return -1 ;
+  }
+
+  if ( !( factoryClass   = (*env)->FindClass( env, "java/lang/management/ManagementFactory" ) ) ||
+       !( listClass      = (*env)->FindClass( env, "java/util/List" ) ) ||
+       !( beanClass      = (*env)->FindClass( env, "java/lang/management/GarbageCollectorMXBean" ) ) ||
+       !( getBeansMethod = (*env)->GetStaticMethodID( env, factoryClass, "getGarbageCollectorMXBeans", "()Ljava/util/List;" ) ) ||
+       !( sizeMethod     = (*env)->GetMethodID( env, listClass, "size", "()I" ) ) ||
+       !( getMethod      = (*env)->GetMethodID( env, listClass, "get", "(I)Ljava/lang/Object;" ) ) ||
+       !( getTimeMethod  = (*env)->GetMethodID( env, beanClass, "getCollectionTime", "()J" ) ) ||
+       !( beans          = (*env)->CallStaticObjectMethod( env, factoryClass, getBeansMethod ) ) ) goto end ;
+
+  count = (*env)->CallIntMethod( env, beans, sizeMethod ) ;
+  if ( (*env)->ExceptionCheck( env ) ) goto end ;
+
+  total = 0 ;
+  for ( i = 0 ; i < count ; i++ ) {
+    jobject bean = (*env)->CallObjectMethod( env, beans, getMethod, i ) ;
+
+    if ( bean ) time = (*env)->CallLongMethod( env, bean, getTimeMethod ) ;
+    if ( !bean || (*env)->ExceptionCheck( env ) ) {
+      total = -1 ;
+      goto end ;
+    }
+    // -1 if the collector does not know
+    if ( time > 0 ) total += time ;
+    (*env)->DeleteLocalRef( env, bean ) ;
+  }
+
+  end:
+  if ( (*env)->ExceptionCheck( env ) ) clearException( env ) ;
+  (*env)->PopLocalFrame( env, NULL ) ;
+  return total ;
+}
+
+/** Finds out the gc time of the run for recordRun while the jvm can still be called, i.e. when the main method returns. */
+static void queryGcTime( JNIEnv* env ) {
+  jlong runMillis = ( jst_monotonicMicros() - exitHookState.mainStarted ) / 1000 ;
+
+  if ( jst_keepingRunHistory() && runMillis >= MIN_GC_QUERY_MILLIS ) exitHookState.gcMillis = getGcMillis( env ) ;
+}
+
+/** Records the run in the run history (see jst_profile.h). Called once the jvm has been destroyed or is exiting, so that
+ * the time the jvm takes to shut down (e.g. waiting for non daemon threads to finish) is part of the run time. */
+static void recordRun( void ) {
+  jlong runMillis = ( jst_monotonicMicros() - exitHookState.mainStarted ) / 1000 ;
+
+  exitHookState.mainStarted = 0 ;
+  if ( !jst_keepingRunHistory() ) return ;
+
+  jst_recordRun( runMillis, exitHookState.gcMillis ) ;
+}
+
+/** Called by the jvm on System.exit, after the shutdown hooks have been run (and a class data sharing archive written).
+ * The jvm exits the process w/ the given code once this returns. */
+static void JNICALL launcheeExitHook( jint exitCode ) {
+  if ( exitHookState.serving ) jst_serverExitHook( exitCode ) ;
+  if ( exitHookState.mainStarted ) recordRun() ;
+  if ( _jst_debug ) fprintf( stderr, "debug: the jvm is exiting with code %d\n", (int)exitCode ) ;
+  if ( exitHookState.sharedArchive ) jst_finishSharedArchive( exitHookState.sharedArchive ) ;
+  jst_writeTrace() ;
+  fflush( NULL ) ;
+}
+
+/** Called by the jvm when it aborts, e.g. on a crash. Only what is safe to do in that state is done, i.e. a server client is
+ * told its request failed. */
+static void JNICALL launcheeAbortHook( void ) {
+  if ( exitHookState.serving ) jst_serverExitHook( ABORT_EXIT_CODE ) ;
+}
+
+/** Exits the jvm and the process the way System.exit does: the shutdown hooks are run, but threads still running are not
+ * waited for and the jvm is not torn down. The exit hook above finishes the launch. Only returns if System.exit fails, e.g.
+ * when forbidden by a security manager. */
+static void exitJvm( JNIEnv* env, int exitCode ) {
+  jclass    systemClass ;
+  jmethodID exitMethod ;
+
+  flushJavaStdStreams( env ) ;
+
+  if ( ( systemClass = (*env)->FindClass( env, "java/lang/System" ) ) &&
+       ( exitMethod  = (*env)->GetStaticMethodID( env, systemClass, "exit", "(I)V" ) ) ) {
+    (*env)->CallStaticVoidMethod( env, systemClass, exitMethod, (jint)exitCode ) ;
+  }
+
+  if ( (*env)->ExceptionCheck( env ) ) clearException( env ) ;
+  if ( _jst_debug ) fprintf( stderr, "debug: could not exit the jvm w/ System.exit, destroying it\n" ) ;
+}
+
+/** Adds a copy of the given file name to the array. Returns 0 on error. */
+static int appendPrefetchFile( JstDynamicPointerArray* files, const char* file, size_t len ) {
+  char* copy = (char*)jst_malloc( len + 1 ) ;
+
+  if ( !copy ) return 0 ;
+  memcpy( copy, file, len ) ;
+  copy[ len ] = '\0' ;
+
+  if ( !jst_appendPointerToDynamicArray( files, copy ) ) {
+    free( copy ) ;
+    return 0 ;
+  }
+
+  return 1 ;
+}
+
+/** Adds the entries of the given path (separated by JST_PATH_SEPARATOR) to the array. Returns 0 on error. */
+static int appendPrefetchPath( JstDynamicPointerArray* files, const char* path ) {
+  const char *entryEnd ;
+
+  for ( ; *path ; path = *entryEnd ? entryEnd + 1 : entryEnd ) {
+    if ( !( entryEnd = strchr( path, JST_PATH_SEPARATOR[ 0 ] ) ) ) entryEnd = path + strlen( path ) ;
+    if ( entryEnd > path && !appendPrefetchFile( files, path, entryEnd - path ) ) return 0 ;
+  }
+
+  return 1 ;
+}
+
+/** The class data sharing archive of the jdk classes that comes w/ the jdk, in the same dir as the jvm dynamic library. */
+#define DEFAULT_SHARED_ARCHIVE "classes.jsa"
+
+/** The files the jvm reads at startup: the jars on the classpath, the class data sharing archives given in the options,
+ * the jvm dynamic library and the default archive next to it and the modules image. Followed by the files in the given
+ * prefetchPath (may be NULL), which the app reads once it is running. Returns NULL on error. */
+static char** collectPrefetchFiles( JstJvmOptions* jvmOptions, const char* javaHome, char* jvmDynLibPath, JVMSelectStrategy jvmSelectStrategy,
+                                    const char* prefetchPath ) {
+  static const char* pathOptions[]    = { "-Djava.class.path=", "-Xbootclasspath/a:", "-Xbootclasspath/p:", NULL } ;
+  static const char* archiveOptions[] = { "-XX:SharedArchiveFile=", "-XX:AOTCache=", NULL } ;
+  JstDynamicPointerArray files ;
+  char   *foundDynLibPath = NULL ;
+  int    i, j ;
+
+  if ( !jst_initializeDynamicPointerArray( &files, 16 ) ) return NULL ;
+
+  for ( i = 0 ; i < jvmOptions->optionsCount ; i++ ) {
+    const char *option = jvmOptions->options[ i ].optionString ;
+
+    for ( j = 0 ; pathOptions[ j ] ; j++ ) {
+      if ( strncmp( option, pathOptions[ j ], strlen( pathOptions[ j ] ) ) == 0 &&
+           !appendPrefetchPath( &files, option + strlen( pathOptions[ j ] ) ) ) goto error ;
+    }
+
+    for ( j = 0 ; archiveOptions[ j ] ; j++ ) {
+      if ( strncmp( option, archiveOptions[ j ], strlen( archiveOptions[ j ] ) ) == 0 &&
+           !appendPrefetchFile( &files, option + strlen( archiveOptions[ j ] ), strlen( option + strlen( archiveOptions[ j ] ) ) ) ) goto error ;
+    }
+  }
+
+  if ( javaHome ) {
+    char* file ;
+
+    if ( !jvmDynLibPath ) jvmDynLibPath = foundDynLibPath = jst_findJvmDynLibPathQuietly( javaHome, jvmSelectStrategy ) ;
+
+    if ( jvmDynLibPath ) {
+      char* dirEnd = strrchr( jvmDynLibPath, JST_FILE_SEPARATOR[ 0 ] ) ;
+      if ( !appendPrefetchFile( &files, jvmDynLibPath, strlen( jvmDynLibPath ) ) ) goto error ;
+      if ( dirEnd ) {
+        size_t dirLen = dirEnd - jvmDynLibPath + 1 ;
+        if ( !( file = (char*)jst_malloc( dirLen + sizeof( DEFAULT_SHARED_ARCHIVE ) ) ) ) goto error ;
+        memcpy( file, jvmDynLibPath, dirLen ) ;
+        strcpy( file + dirLen, DEFAULT_SHARED_ARCHIVE ) ;
+        if ( !jst_appendPointerToDynamicArray( &files, file ) ) {
+          free( file ) ;
+          goto error ;
+        }
+      }
+    }
+
+    if ( !( file = jst_createFileName( javaHome, "lib", "modules", NULL ) ) ) goto error ;
+    if ( !jst_appendPointerToDynamicArray( &files, file ) ) {
+      free( file ) ;
+      goto error ;
+    }
+  }
+
+  if ( prefetchPath && !appendPrefetchPath( &files, prefetchPath ) ) goto error ;
+
+  if ( foundDynLibPath ) free( foundDynLibPath ) ;
+
+  return (char**)files.pointers ;
+
+  error:
+  if ( foundDynLibPath ) free( foundDynLibPath ) ;
+  jst_freeDynamicArray( &files, JNI_TRUE ) ;
+  return NULL ;
+}
+
+/** Sizes larger than this many bytes are not plausible. Also keeps the size calculations below from overflowing. */
+#define MAX_MEMORY_SIZE ( (jlong)1 << 50 )
+
+/** Parses a jvm memory size as given to e.g. -Xss, i.e. a number of bytes optionally followed by k, m, g or t. Returns -1 if
+ * the given string is not a valid size. */
+static jlong parseMemorySize( const char* size ) {
+  jlong value = 0 ;
+  int   shift ;
 
-  memset( &javavm,     0, sizeof( javavm ) ) ;
-  memset( &jvmOptions, 0, sizeof( jvmOptions ) ) ;
+  if ( !isdigit( (unsigned char)*size ) ) return -1 ;
 
+  for ( ; isdigit( (unsigned char)*size ) ; size++ ) {
+    if ( ( value = value * 10 + ( *size - '0' ) ) > MAX_MEMORY_SIZE ) return -1 ;
+  }
+
+  switch ( *size ) {
+    case '\0' :           shift = 0  ; break ;
+    case 'k' : case 'K' : shift = 10 ; break ;
+    case 'm' : case 'M' : shift = 20 ; break ;
+    case 'g' : case 'G' : shift = 30 ; break ;
+    case 't' : case 'T' : shift = 40 ; break ;
+    default  :            return -1 ;
+  }
 
-  if ( !( classpath = constructClasspath( launchOptions->initialClasspath, launchOptions->jarDirs, launchOptions->jars, launchOptions->classpathStrategy ) ) ) goto end ;
-  if ( !appendJvmOption( &jvmOptions, classpath, NULL ) ) goto end ;
+  if ( shift && size[ 1 ] ) return -1 ;
 
+  return ( value > ( MAX_MEMORY_SIZE >> shift ) ) ? -1 : value << shift ;
+}
 
-  if ( !gatherJVMOptions( &jvmOptions, launchOptions ) ) goto end ;
+/** Returns the stack size for the thread running the main method: the last -Xss given in the jvm options, or if there is
+ * none, the one given in the launch options. 0 means the main method is run on the calling thread. */
+static jlong getMainThreadStackSize( JstJvmOptions* jvmOptions, JavaLauncherOptions* launchOptions ) {
+  jlong stackSize = launchOptions->mainThreadStackSize ;
+  int   i ;
 
+  for ( i = 0 ; i < jvmOptions->optionsCount ; i++ ) {
+    const char* option = jvmOptions->options[ i ].optionString ;
+    jlong       size ;
 
-  if ( jst_startJvm( JNI_VERSION_1_4, &jvmOptions, JNI_FALSE, launchOptions->javaHome, jvmSelectStrategy,
+    if ( strncmp( option, "-Xss", 4 ) != 0 ) continue ;
+    // -Xss0 means the jvm default, which the jvm applies to the threads it creates itself
+    if ( ( size = parseMemorySize( option + 4 ) ) >= 0 ) stackSize = size ;
+  }
+
+  return stackSize ;
+}
+
+/** What runJvm needs and returns. The classpath, main args and jvm options are freed (and the pointers set to NULL) before
+ * the main method is invoked. */
+typedef struct {
+  JavaLauncherOptions* launchOptions ;
+  JstJvmOptions        jvmOptions ;
+  char*                classpath ;
+  char**               mainArgs ;
+  int                  serverSocket ;
+  int                  rval ;
+} JvmRun ;
+
+/** Passes this launch to the server listening on the given socket, along w/ the perRequestProperties given in the jvm options.
+ * Returns 1 if the server handled it, in which case run->rval is set. */
+static int sendServerRequest( const char* socketPath, JvmRun* run ) {
+  JstDynamicPointerArray properties ;
+  int i,
+      served = 0 ;
+
+  if ( !jst_initializeDynamicPointerArray( &properties, 2 ) ) return 0 ;
+
+  for ( i = 0 ; i < run->jvmOptions.optionsCount ; i++ ) {
+    char* option = run->jvmOptions.options[ i ].optionString ;
+    // w/out the leading -D
+    if ( isPerRequestProperty( option ) && !jst_appendPointerToDynamicArray( &properties, option + 2 ) ) goto end ;
+  }
+
+  served = jst_sendServerRequest( socketPath, run->mainArgs, (char**)properties.pointers, &run->rval ) ;
+
+  end:
+  jst_freeDynamicArray( &properties, JNI_FALSE ) ;
+
+  return served ;
+}
+
+/** Creates the jvm, runs the main method (or serves requests if this is a server) and destroys the jvm. */
+static void runJvm( JvmRun* run ) {
+  JavaLauncherOptions* launchOptions = run->launchOptions ;
+
+  JstJVM       javavm ;
+
+  jclass       launcheeMainClassHandle  = NULL ;
+  jmethodID    launcheeMainMethodID     = NULL ;
+  jobjectArray launcheeJOptions         = NULL ;
+
+  memset( &javavm, 0, sizeof( javavm ) ) ;
+
+  run->rval = -1 ;
+
+  if ( jst_startJvm( JNI_VERSION_1_4, &run->jvmOptions, JNI_FALSE, launchOptions->javaHome, launchOptions->jvmDynLibPath, launchOptions->jvmSelectStrategy,
                      // output
                      &javavm )
      ) goto end ;
@@ -1092,8 +1911,10 @@ extern int jst_launchJavaApp( JavaLauncherOptions *launchOptions ) {
   // find the application main class
   // find the startup method and call it
 
-  if ( !( launcheeJOptions = createJMainParams( javavm.env, launchOptions->parameters, launchOptions->extraProgramOptions, launchOptions->unrecognizedParamStrategy ) ) ) goto end ;
+  jst_tracePhase( "mainargs" ) ;
+  if ( run->serverSocket == -1 && !( launcheeJOptions = createJStringArray( javavm.env, run->mainArgs ) ) ) goto end ;
 
+  jst_tracePhase( "findmain" ) ;
 
   if ( !( launcheeMainClassHandle = findMainClassAndMethod( javavm.env, launchOptions->mainClassName, launchOptions->mainMethodName, &launcheeMainMethodID ) ) ) goto end ;
 
@@ -1103,22 +1924,45 @@ extern int jst_launchJavaApp( JavaLauncherOptions *launchOptions ) {
   }
 
   // free memory holding jvm params and such
-  jst_free( jvmOptions.options ) ;
-  jst_free( classpath ) ;
-  jst_freeAll( launchOptions->pointersToFreeBeforeRunningMainMethod ) ;
+  jst_free( run->jvmOptions.options ) ;
+  jst_free( run->classpath ) ;
+  jst_free( run->mainArgs ) ;
+  if ( launchOptions->arenaToFreeBeforeRunningMainMethod ) jst_freeArena( launchOptions->arenaToFreeBeforeRunningMainMethod ) ;
+
+  if ( run->serverSocket != -1 ) {
+    jst_tracePhase( "serve" ) ;
+    run->rval = serveRequests( javavm.env, run->serverSocket, launcheeMainClassHandle, launcheeMainMethodID ) ;
+    goto end ;
+  }
+
+  jst_tracePhase( "main" ) ;
+  if ( jst_tracingEnabled() ) setLaunchTimingProperties( javavm.env ) ;
+
   // finally: launch the java application!
+  exitHookState.mainStarted = jst_monotonicMicros() ;
+  exitHookState.gcMillis    = -1 ;
   (*javavm.env)->CallStaticVoidMethod( javavm.env, launcheeMainClassHandle, launcheeMainMethodID, launcheeJOptions ) ;
 
   if ( (*javavm.env)->ExceptionCheck( javavm.env ) ) {
     // TODO: provide an option which allows the caller to indicate whether to print the stack trace
     (*javavm.env)->ExceptionClear( javavm.env ) ;
   } else {
-    rval = 0 ;
+    run->rval = 0 ;
+  }
+
+  queryGcTime( javavm.env ) ;
+
+  if ( run->rval == 0 && launchOptions->mainReturnedHook ) launchOptions->mainReturnedHook( javavm.env ) ;
+
+  // destroying the jvm waits for all the non daemon threads to finish and tears down the jvm, which takes a while
+  if ( launchOptions->fastExit ) {
+    jst_tracePhase( "exit" ) ;
+    exitJvm( javavm.env, run->rval ) ;
   }
 
 
   end:
-  // cleanup
+  jst_tracePhase( "destroyjvm" ) ;
   if ( javavm.javavm ) {
     if ( (*javavm.javavm)->DetachCurrentThread( javavm.javavm ) ) {
       fprintf( stderr, "Warning: could not detach main thread from the jvm at shutdown (please report this as a bug)\n" ) ;
@@ -1126,10 +1970,131 @@ extern int jst_launchJavaApp( JavaLauncherOptions *launchOptions ) {
     (*javavm.javavm)->DestroyJavaVM( javavm.javavm ) ;
   }
 
+  // unless the jvm exited the process (see launcheeExitHook)
+  if ( exitHookState.mainStarted ) recordRun() ;
+
   if ( javavm.dynLibHandle ) dlclose( javavm.dynLibHandle ) ;
-  if ( classpath        ) free( classpath ) ;
-  if ( jvmOptions.options ) free( jvmOptions.options ) ;
 
-  return rval ;
+}
+
+#if !defined( _WIN32 )
+
+static void* runJvmThread( void* run ) {
+  runJvm( (JvmRun*)run ) ;
+  return NULL ;
+}
+
+/** Runs runJvm on a new thread w/ the given stack size and waits for it to finish. Returns 0 if the thread could not be
+ * created, in which case nothing has been run. */
+static int runJvmOnNewThread( JvmRun* run, jlong stackSize ) {
+  pthread_attr_t attr ;
+  pthread_t      thread ;
+  long           pageSize = sysconf( _SC_PAGESIZE ) ;
+  int            started ;
+
+  if ( pageSize > 0 ) stackSize = ( stackSize + pageSize - 1 ) / pageSize * pageSize ;
+  if ( stackSize < PTHREAD_STACK_MIN ) stackSize = PTHREAD_STACK_MIN ;
+
+  if ( pthread_attr_init( &attr ) ) return 0 ;
+
+  started = pthread_attr_setstacksize( &attr, (size_t)stackSize ) == 0 &&
+            pthread_create( &thread, &attr, runJvmThread, run ) == 0 ;
+
+  pthread_attr_destroy( &attr ) ;
+
+  if ( !started ) return 0 ;
+
+  if ( _jst_debug ) fprintf( stderr, "debug: running the jvm on a new thread with a %ld KB stack\n", (long)( stackSize >> 10 ) ) ;
+
+  pthread_join( thread, NULL ) ;
+  return 1 ;
+}
+
+#endif
+
+extern int jst_launchJavaApp( JavaLauncherOptions *launchOptions ) {
+  JvmRun       run ;
+
+  char*  serverSocketPath = NULL ;
+  int    launcherOptionCount = 0 ;
+
+  JstSharedArchive sharedArchive ;
+
+  JVMSelectStrategy jvmSelectStrategy = launchOptions->jvmSelectStrategy ;
+
+  memset( &run,           0, sizeof( run ) ) ;
+  memset( &sharedArchive, 0, sizeof( sharedArchive ) ) ;
+
+  run.launchOptions = launchOptions ;
+  run.serverSocket  = -1 ;
+  run.rval          = -1 ;
+
+  jst_tracePhase( "classpath" ) ;
+
+  run.classpath = launchOptions->classpathOption ? jst_strdup( launchOptions->classpathOption )
+                                                 : jst_constructClasspath( launchOptions->initialClasspath, launchOptions->jarDirs, launchOptions->jars, launchOptions->classpathStrategy ) ;
+  if ( !run.classpath ) goto end ;
+  if ( !appendJvmOption( &run.jvmOptions, run.classpath, NULL ) ) goto end ;
+
+
+  if ( !gatherJVMOptions( &run.jvmOptions, launchOptions, &launcherOptionCount ) ) goto end ;
+
+  if ( !( run.mainArgs = createMainArgs( launchOptions->parameters, launchOptions->extraProgramOptions, launchOptions->unrecognizedParamStrategy ) ) ) goto end ;
+
+
+  if ( launchOptions->serverMode && ( serverSocketPath = jst_getServerSocketPath( createServerKey( &run.jvmOptions, launcherOptionCount, launchOptions ) ) ) ) {
+    jst_tracePhase( "server" ) ;
+
+    if ( sendServerRequest( serverSocketPath, &run ) ) goto end ;
+
+    // no server running: this launch is run in this process as usual, and a server started for the following ones.
+    // Only the server process gets back a socket, and it does not run this launch, only the requests it receives.
+    run.serverSocket = jst_spawnServer( serverSocketPath ) ;
+  }
+
+  if ( launchOptions->useSharedArchive && !jst_addSharedArchiveOption( &sharedArchive, &run.jvmOptions, launcherOptionCount, launchOptions->javaHome ) ) goto end ;
+
+  // so the launch is finished (and a server client gets the exit code) also when the jvm exits the process itself
+  exitHookState.sharedArchive = &sharedArchive ;
+  exitHookState.serving       = ( run.serverSocket != -1 ) ? JNI_TRUE : JNI_FALSE ;
+  if ( !appendJvmOption( &run.jvmOptions, "exit",  (void*)launcheeExitHook  ) ||
+       !appendJvmOption( &run.jvmOptions, "abort", (void*)launcheeAbortHook ) ) goto end ;
+
+  // read the files needed at jvm startup into the os page cache while the jvm is being created
+  {
+    char** prefetchFiles = collectPrefetchFiles( &run.jvmOptions, launchOptions->javaHome, launchOptions->jvmDynLibPath, jvmSelectStrategy,
+                                                 launchOptions->prefetchPath ) ;
+    if ( prefetchFiles ) jst_prefetchFiles( prefetchFiles ) ;
+  }
+
+  // The stack size of the primordial thread is set by the os (e.g. ulimit -s) and -Xss does not apply to it, so deeply
+  // recursive code may overflow its stack unpredictably. That's why the java launcher does not use it, and neither do we
+  // if a stack size is given.
+#if !defined( _WIN32 )
+  {
+    jlong stackSize = getMainThreadStackSize( &run.jvmOptions, launchOptions ) ;
+    if ( stackSize > 0 ) {
+      if ( runJvmOnNewThread( &run, stackSize ) ) goto end ;
+      fprintf( stderr, "warning: could not create a thread with the given stack size, running the jvm on the main thread\n" ) ;
+    }
+  }
+#endif
+
+  runJvm( &run ) ;
+
+
+  end:
+  // cleanup
+  // the jvm writes the archive when it is destroyed
+  jst_finishSharedArchive( &sharedArchive ) ;
+  if ( run.classpath          ) free( run.classpath ) ;
+  if ( run.mainArgs           ) free( run.mainArgs ) ;
+  if ( serverSocketPath       ) free( serverSocketPath ) ;
+  if ( run.jvmOptions.options ) free( run.jvmOptions.options ) ;
+  exitHookState.sharedArchive = NULL ;
+
+  jst_writeTrace() ;
+
+  return run.rval ;
 
 }
@@ -21,6 +21,8 @@
 #include "applejnifix.h"
 #include <jni.h>
 
+#include "jst_dynmem.h"
+
 #if defined( __cplusplus )
   extern "C" {
 #endif
@@ -103,6 +105,9 @@ typedef struct {
 
 } JstParamInfo ;
 
+/** The lookup tables built from the param definitions and the actual params by jst_processInputParameters. */
+typedef struct JstParamIndex_ JstParamIndex ;
+
 // this is to be taken into use after some other refactorings
 typedef struct {
 
@@ -119,6 +124,10 @@ typedef struct {
   char *value ;
   JstInputParamHandling handling ;
 
+  // shared by all the params returned by the same call to jst_processInputParameters, used to look up param values
+  // w/out going through all the params
+  const JstParamIndex* index ;
+
 } JstActualParam ;
 
 
@@ -137,6 +146,18 @@ typedef enum {
   JST_SERVER_FIRST  = JST_CLIENTVM | JST_SERVERVM,
 } JVMSelectStrategy ;
 
+/** Sets of jvm flags tuned for how long the app runs. See jst_profile.h. */
+typedef enum {
+  /** no flags are added */
+  JST_PROFILE_NONE       = 0,
+  /** the profile is chosen by the run history of the app */
+  JST_PROFILE_AUTO       = 1,
+  /** for apps that run for a short while: fast jit, serial gc and a small initial heap */
+  JST_PROFILE_STARTUP    = 2,
+  /** for apps that run for a long while: the throughput gc */
+  JST_PROFILE_THROUGHPUT = 3
+} JstJvmProfile ;
+
 
 /** These may be or:d together. */
 typedef enum {
@@ -157,7 +178,7 @@ typedef enum {
 typedef struct {
   /** relative to apphome */
   char *name ;
-  // FIXME - not supported yet
+  /** If true, the jars in all the subdirs (at any depth) are added too, see jst_dirwalk.h for the order. */
   jboolean fetchRecursively ;
   /** May be null. The dirname parameter is there so one can differentiate between folders when fetching recursively.  */
   int (*filter)( const char* dirname, const char* filename ) ;
@@ -174,6 +195,9 @@ typedef struct {
 typedef struct {
   /** May be null. */
   char* javaHome ;
+  /** Full path to the jvm dynamic library to load, e.g. as previously returned by jst_findJvmDynLibPath. If NULL, the library
+   * is looked up under javaHome according to jvmSelectStrategy. */
+  char* jvmDynLibPath ;
   /** what kind of jvm to use. */
   JVMSelectStrategy jvmSelectStrategy ;
   JstUnrecognizedParamStrategy unrecognizedParamStrategy ;
@@ -195,10 +219,36 @@ typedef struct {
    * one of the possible classpaths, but finer grain of control may be provided in future implementation if
    * it is deemed necessary. */
   JstClasspathStrategy classpathStrategy ;
-  /** pointer to a null terminated pointer array containing pointers to dynallocated memory that should be freed (w/ jst_freeAll) before
-   * invoking the main method. Note that the array holding the pointers will also be freed.
+  /** A ready made classpath jvm option, e.g. as previously returned by jst_constructClasspath. If not NULL, this is used as is
+   * and initialClasspath, jarDirs, jars and classpathStrategy are ignored. */
+  char* classpathOption ;
+  /** Files the app reads at startup in addition to those the jvm does (e.g. jars it loads itself), separated by JST_PATH_SEPARATOR.
+   * They are read into the os page cache along w/ the jvm startup files, see jst_prefetch.h. May be NULL. */
+  char* prefetchPath ;
+  /** If true, the app is run by a resident server jvm if one has been started earlier w/ the same settings. If not, the app
+   * is run in this process as usual and a server is started for the following launches. See jst_server.h. Ignored on windows. */
+  jboolean serverMode ;
+  /** If true, a class data sharing archive is maintained for the jvm, classpath and jvm options used and used on later launches.
+   * See jst_cds.h. */
+  jboolean useSharedArchive ;
+  /** If true, the jvm is exited the way System.exit does once the main method returns, i.e. threads still running are not
+   * waited for and the jvm is not torn down. Saves the time destroying the jvm takes, which matters for short scripts. */
+  jboolean fastExit ;
+  /** If not 0, the jvm is created and the main method run on a new thread w/ a stack of this many bytes instead of on the
+   * calling thread, whose stack size is set by the os (e.g. ulimit -s) and not affected by -Xss. A -Xss given in the jvm
+   * options takes precedence over this, and also makes the main method run on a new thread. Ignored on windows. */
+  jlong mainThreadStackSize ;
+  /** The jvm flags to add. Flags the user has given always take precedence. */
+  JstJvmProfile jvmProfile ;
+  /** Identifies the app (e.g. the full path of the script) in the run history, which is used to choose the profile when
+   * jvmProfile is JST_PROFILE_AUTO and recorded to on each run. NULL means no history is kept. */
+  char* runHistoryKey ;
+  /** Called on the thread that ran the main method once it has returned normally (i.e. not thrown or called System.exit),
+   * while the jvm can still be called, e.g. to record something about the run. May be NULL. */
+  void (*mainReturnedHook)( JNIEnv* env ) ;
+  /** An arena to be freed (w/ jst_freeArena) before invoking the main method. May be NULL.
    * This is for those who are very keen not to hold memory any longer than necessaary ;) */
-  void*** pointersToFreeBeforeRunningMainMethod ;
+  JstArena* arenaToFreeBeforeRunningMainMethod ;
 } JavaLauncherOptions ;
 
 
@@ -227,6 +277,46 @@ void jst_printWinError( unsigned long errorCode ) ;
 
 int jst_launchJavaApp( JavaLauncherOptions* options ) ;
 
+/** Returns the major version (e.g. 8 or 17) of the java installation in the given java home as read from its release file,
+ * 0 if it can not be determined. */
+int jst_getJavaMajorVersion( const char* javaHome ) ;
+
+/** Returns the version (e.g. "17.0.2" or "1.8.0_392") of the java installation in the given java home as read from its release
+ * file, NULL if it can not be determined. No error msg is printed. Freeing the returned value is up to the caller. */
+char* jst_getJavaVersion( const char* javaHome ) ;
+
+/** Returns the value of the given property (e.g. "JAVA_VERSION" or "IMPLEMENTOR") in the release file of the java installation in
+ * the given java home, NULL if there is no such property. As jst_getJavaVersion otherwise. */
+char* jst_getJavaReleaseProperty( const char* javaHome, const char* propertyName ) ;
+
+/** Returns the major version of the given java version string, e.g. 8 for "1.8.0_392" and 17 for "17.0.2". 0 if it is not a
+ * java version string. */
+int jst_parseJavaMajorVersion( const char* version ) ;
+
+/** Returns the path to the jvm dynamic library (e.g. jvm.dll or libjvm.so) under the given java home. The strategy tells
+ * which type of jvm to look for. Returns NULL (and prints an error msg) if no suitable jvm was found.
+ * Freeing the returned value is up to the caller. */
+char* jst_findJvmDynLibPath( const char* javaHome, JVMSelectStrategy jvmSelectStrategy ) ;
+
+/** As jst_findJvmDynLibPath, but prints nothing if not found. */
+char* jst_findJvmDynLibPathQuietly( const char* javaHome, JVMSelectStrategy jvmSelectStrategy ) ;
+
+/** Starts loading the jvm dynamic library on a helper thread, so that reading it from disk overlaps w/ the rest of the launch
+ * preparations. The jvm is later created from the preloaded library if jst_launchJavaApp ends up using the same library,
+ * otherwise the preload is discarded. Only the first call per process does anything. Does nothing on windows.
+ * No error msg is printed if the preload fails, the library is then loaded (and the error reported) as usual.
+ * The helper thread is waited for before the process forks.
+ * @param jvmDynLibPath if NULL, the library is looked up under javaHome according to jvmSelectStrategy */
+void jst_preloadJvmDynLib( const char* javaHome, const char* jvmDynLibPath, JVMSelectStrategy jvmSelectStrategy ) ;
+
+/** Constructs the jvm option that sets the classpath, e.g. "-Djava.class.path=foo.jar:bar.jar" (or one of the
+ * -Xbootclasspath options, depending on the strategy) from the given entries. Returns NULL on error.
+ * Freeing the returned value is up to the caller.
+ * @param initialCP may be NULL
+ * @param jarDirs   may be NULL
+ * @param jars      may be NULL */
+char* jst_constructClasspath( char* initialCP, JarDirSpecification* jarDirs, char** jars, JstClasspathStrategy classpathStrategy ) ;
+
 
 
 
@@ -235,13 +325,29 @@ int jst_launchJavaApp( JavaLauncherOptions* options ) ;
 
 /** returns an array of JstActualParam, the last one of which contains NULL for field param.
  * All the memory allocated can be freed by freeing the returned pointer.
+ * The param definitions are indexed on each call, so classifying a param takes O(log m) time (m being the number of param names)
+ * regardless of the number of definitions.
  * Return NULL on error.
  * @param cygwinConvertParamsAfterTermination if cygwin compatibility is set in the build & cygwin1.dll is found and loaded,
  *                                            the terminating param (the param which w/ all the following params is passed to launchee)
  *                                            and all the following params are cygwin path converted with the given conversion type. */
 JstActualParam* jst_processInputParameters( char** args, int numArgs, JstParamInfo *paramInfos, const char** terminatingSuffixes, CygwinConversionType cygwinConvertParamsAfterTermination ) ;
 
-/** For single params, returns "" if the param is present, NULL otherwise. Note that you do not
+/** Follows args one at a time the way jst_processInputParameters classifies them, so that it can be told where the params
+ * terminate before all the args are known (e.g. while expanding argument files). */
+typedef struct JstParamScanner_ JstParamScanner ;
+
+/** Returns NULL on error (err msg printed). Freeing the returned value (w/ free) is up to the caller. */
+JstParamScanner* jst_createParamScanner( JstParamInfo* paramInfos, const char** terminatingSuffixes ) ;
+
+/** Takes the next arg. Returns true if the given arg is the terminating param or comes after it. */
+jboolean jst_scanParam( JstParamScanner* scanner, const char* arg ) ;
+
+/** Returns true if the next arg is taken as the value of the param before it (e.g. the code after -e). */
+jboolean jst_scannerExpectsValue( const JstParamScanner* scanner ) ;
+
+/** For single params, returns "" if the param is present, NULL otherwise. For prefix params, returns what follows the prefix.
+ * Takes O(log m) time, m being the number of param names, regardless of the number of actual params. Note that you do not
  * need to try out all the aliases for a param - e.g. if -jh and --javahome stand for the same param,
  * you will get the value passed for the param even if you ask just for "-jh".
  * Note also that you can only query values for recognized params w/ this function, i.e.
@@ -282,18 +388,21 @@ char* getJavaHomeFromParameter( JstActualParam* processedActualParams, const cha
  * @param extraInfo JavaVMOption.extraInfo. See jni.h or jni documentation (JavaVMOption is defined in jni.h). */
 JavaVMOption* appendJvmOption( JstJvmOptions* opts, char* optStr, void* extraInfo ) ;
 
+/** Returns the first of the given jvm options that starts w/ any of the given prefixes, NULL if there is none.
+ * @param prefixes NULL terminated */
+const char* jst_findJvmOption( const JstJvmOptions* opts, const char** prefixes ) ;
+
 /**
- * Adds the options in the param userOpts (separated by spaces) to the jvm options passed in.
- *
- * Known bug: always separates at ' ', does not take into account quoted values w/ spaces. Should not
- * usually be a problem, so fixing it is left till someone complains about it, i.e. actually has
- * a problem w/ it.
+ * Adds the options in the param userOpts (separated by whitespace) to the jvm options passed in.
+ * A part of an option in "double" or 'single' quotes may contain whitespace and the other kind of quote,
+ * e.g. "-Dapp.title=My app". The quotes are removed. There are no escapes, so backslashes (e.g. in windows
+ * paths) are taken as they are.
  *
- * @param userOpts contains ' '  separated options for the jvm. May not be NULL or empty. The given string is modified
- *                 so that nul char terminations are inserted at spaces and this buffer is used to hold the strings passed to the jvm.
- *                 I.e. Take care it is not freed or reused before jvm is started.
+ * @param userOpts contains the whitespace separated options for the jvm. May not be NULL. The given string is modified
+ *                 so that the quotes are removed and nul char terminations are inserted at the separators, and this buffer
+ *                 is used to hold the strings passed to the jvm. I.e. Take care it is not freed or reused before jvm is started.
  * @param jvmStrategyOut modified if -client or -server given on the command line, left alone otherwise.
- * @return 0 on error */
+ * @return 0 on error (err msg printed), e.g. on an unmatched quote */
 int handleJVMOptsString( char* userOpts, JstJvmOptions* jvmOptions, JVMSelectStrategy* jvmStrategyOut ) ;
 
 #if defined( __cplusplus )
@@ -33,17 +33,316 @@
 %import "jni.h"
 
 %{
+#include <stdio.h>
+#include <string.h>
+
 #include "jvmstarter.h"
+#include "jst_dynmem.h"
 #include "groovyutils.h"
 #include "jst_stringutils.h"
 #include "jst_fileutils.h"
+#include "jst_zip.h"
+#include "jst_cds.h"
+#include "jst_argfile.h"
+#include "groovycmanifest.h"
+#include "jst_cgroup.h"
+#include "jst_cache.h"
 %}
 
+// the names are returned as a python list. The returned array holds the names too, so freeing it frees them all.
+%typemap(out) char** jst_getFileNames, char** jst_getFileNamesOfType {
+  char** name ;
+  if ( !$1 ) {
+    PyErr_SetString( PyExc_IOError, "could not list the dir" ) ;
+    SWIG_fail ;
+  }
+  $result = PyList_New( 0 ) ;
+  for ( name = $1 ; *name && $result ; name++ ) {
+    PyObject* item = PyString_FromString( *name ) ;
+    if ( !item || PyList_Append( $result, item ) ) Py_CLEAR( $result ) ;
+    Py_XDECREF( item ) ;
+  }
+  free( $1 ) ;
+  if ( !$result ) SWIG_fail ;
+}
+
+// a python list of strings given as a NULL terminated string array. The strings are those of the python objects, so they
+// are not to be kept past the call.
+%typemap(in) char** args {
+  Py_ssize_t i, size ;
+  if ( !PyList_Check( $input ) ) {
+    PyErr_SetString( PyExc_TypeError, "a list of strings expected" ) ;
+    SWIG_fail ;
+  }
+  size = PyList_Size( $input ) ;
+  if ( !( $1 = (char**)calloc( size + 1, sizeof( char* ) ) ) ) {
+    PyErr_NoMemory() ;
+    SWIG_fail ;
+  }
+  for ( i = 0 ; i < size ; i++ ) {
+    if ( !( $1[ i ] = PyString_AsString( PyList_GetItem( $input, i ) ) ) ) SWIG_fail ;
+  }
+}
+
+%typemap(freearg) char** args {
+  free( $1 ) ;
+}
+
+%apply char** args { char** jvmDOptions, char** entries, char** stampFiles } ;
+
+// the files as a python list, None if the conf can not be handled natively
+%typemap(out) char** groovyStarterConfClasspath {
+  char** file ;
+  if ( !$1 ) {
+    Py_INCREF( Py_None ) ;
+    $result = Py_None ;
+  } else {
+    $result = PyList_New( 0 ) ;
+    for ( file = $1 ; *file && $result ; file++ ) {
+      PyObject* item = PyString_FromString( *file ) ;
+      if ( !item || PyList_Append( $result, item ) ) Py_CLEAR( $result ) ;
+      Py_XDECREF( item ) ;
+    }
+    jst_freeAll( (void***)(void*)&$1 ) ;
+    if ( !$result ) SWIG_fail ;
+  }
+}
+
+// the entries as a python list, None if there is no valid plan. The returned array holds the entries too.
+%typemap(out) char** jst_loadLaunchPlan {
+  char** entry ;
+  if ( !$1 ) {
+    Py_INCREF( Py_None ) ;
+    $result = Py_None ;
+  } else {
+    $result = PyList_New( 0 ) ;
+    for ( entry = $1 ; *entry && $result ; entry++ ) {
+      PyObject* item = PyString_FromString( *entry ) ;
+      if ( !item || PyList_Append( $result, item ) ) Py_CLEAR( $result ) ;
+      Py_XDECREF( item ) ;
+    }
+    free( $1 ) ;
+    if ( !$result ) SWIG_fail ;
+  }
+}
+
 %include "jvmstarter.h"
 %include "groovyutils.h"
 %include "jst_stringutils.h"
 %include "jst_fileutils.h"
 
+%newobject jst_readZipEntry ;
+%newobject jst_getJarManifestAttribute ;
+%include "jst_zip.h"
+%include "groovycmanifest.h"
+%include "jst_cgroup.h"
+%include "jst_cache.h"
+
+// Helpers for testing the param handling. The args are processed against the definitions below, which have all the
+// kinds of params groovy has.
+
+%inline %{
+
+static const char* testHelpParam[]     = { "-h", "--help", NULL } ;
+static const char* testEncodingParam[] = { "-c", "--encoding", NULL } ;
+static const char* testDefineParam[]   = { "-D", NULL } ;
+static const char* testDebugParam[]    = { "-d", NULL } ;
+static const char* testJavaHomeParam[] = { "-jh", "--javahome", NULL } ;
+static const char* testOnelinerParam[] = { "-e", NULL } ;
+
+static JstParamInfo testParameters[] = {
+  { testHelpParam,     JST_SINGLE_PARAM, JST_TO_LAUNCHEE },
+  { testEncodingParam, JST_DOUBLE_PARAM, JST_TO_LAUNCHEE },
+  { testDefineParam,   JST_PREFIX_PARAM, JST_TO_JVM },
+  { testDebugParam,    JST_SINGLE_PARAM, JST_TO_LAUNCHEE },
+  { testJavaHomeParam, JST_DOUBLE_PARAM, JST_IGNORE },
+  { testOnelinerParam, JST_DOUBLE_PARAM, JST_TO_LAUNCHEE | JST_TERMINATING },
+  { NULL,              0,                0 }
+} ;
+
+static const char* testTerminatingSuffixes[] = { ".groovy", NULL } ;
+
+static int countArgs( char** args ) {
+  int count = 0 ;
+  while ( args[ count ] ) count++ ;
+  return count ;
+}
+
+/** Returns what jst_getParameterValue returns for the given param after the given args have been processed. */
+char* testParameterValue( char** args, const char* paramName ) {
+  JstActualParam* processedParams = jst_processInputParameters( args, countArgs( args ), testParameters, testTerminatingSuffixes, JST_CYGWIN_NO_CONVERT ) ;
+  // the value is one of the args (or a literal), so it outlives the processed params
+  char*           value = processedParams ? jst_getParameterValue( processedParams, paramName ) : NULL ;
+  free( processedParams ) ;
+  return value ;
+}
+
+/** Returns what jst_getParameterAfterTermination returns for the given index after the given args have been processed. */
+char* testParameterAfterTermination( char** args, int indx ) {
+  JstActualParam* processedParams = jst_processInputParameters( args, countArgs( args ), testParameters, testTerminatingSuffixes, JST_CYGWIN_NO_CONVERT ) ;
+  char*           value = processedParams ? jst_getParameterAfterTermination( processedParams, indx ) : NULL ;
+  free( processedParams ) ;
+  return value ;
+}
+
+/** Returns the args jst_expandArgFiles expands the given args into as a list, None if it fails. The terminating params
+ * are those of testParameters. */
+PyObject* testExpandArgFiles( char** args ) {
+  JstArena  arena = JST_ARENA_INITIALIZER ;
+  char**    expandedArgs ;
+  PyObject* rval = NULL ;
+  int       count,
+            i ;
+
+  // the stdin of the test process is changed between the tests, and an earlier end of file must not stick
+  clearerr( stdin ) ;
+
+  if ( ( count = jst_expandArgFiles( countArgs( args ), args, testParameters, testTerminatingSuffixes, &expandedArgs, &arena ) ) != -1 ) {
+    rval = PyList_New( 0 ) ;
+    for ( i = 0 ; i < count && rval ; i++ ) {
+      PyObject* arg = PyString_FromString( expandedArgs[ i ] ) ;
+      if ( !arg || PyList_Append( rval, arg ) ) Py_CLEAR( rval ) ;
+      Py_XDECREF( arg ) ;
+    }
+  }
+
+  jst_freeArena( &arena ) ;
+
+  if ( !rval && !PyErr_Occurred() ) {
+    Py_INCREF( Py_None ) ;
+    rval = Py_None ;
+  }
+
+  return rval ;
+}
+
+/** Returns the jvm options handleJVMOptsString makes of the given string as a list, None if it fails. -client and
+ * -server are not options but select the jvm, so they are not in the list. */
+PyObject* testJVMOptsString( const char* userOpts ) {
+  JstJvmOptions     jvmOptions ;
+  JVMSelectStrategy jvmSelectStrategy = JST_CLIENT_FIRST ;
+  char*             opts = jst_strdup( userOpts ) ;
+  PyObject*         rval = NULL ;
+  int               i ;
+
+  memset( &jvmOptions, 0, sizeof( jvmOptions ) ) ;
+
+  if ( opts && handleJVMOptsString( opts, &jvmOptions, &jvmSelectStrategy ) ) {
+    rval = PyList_New( 0 ) ;
+    for ( i = 0 ; i < jvmOptions.optionsCount && rval ; i++ ) {
+      PyObject* option = PyString_FromString( jvmOptions.options[ i ].optionString ) ;
+      if ( !option || PyList_Append( rval, option ) ) Py_CLEAR( rval ) ;
+      Py_XDECREF( option ) ;
+    }
+  }
+
+  if ( jvmOptions.options ) free( jvmOptions.options ) ;
+  if ( opts ) free( opts ) ;
+
+  if ( !rval && !PyErr_Occurred() ) {
+    Py_INCREF( Py_None ) ;
+    rval = Py_None ;
+  }
+
+  return rval ;
+}
+
+%}
 
 
 
+
+
+// the key of the class data sharing archive used w/ the given jvm options
+
+%newobject testSharedArchiveKey ;
+
+%inline %{
+
+/** Returns what jst_createSharedArchiveKey returns for the given jvm options, the first launcherOptionCount of which
+ * are given by the launcher and the user. */
+char* testSharedArchiveKey( char** args, int launcherOptionCount, const char* javaHome ) {
+  JstJvmOptions jvmOptions ;
+  char*         key = NULL ;
+  int           i ;
+
+  memset( &jvmOptions, 0, sizeof( jvmOptions ) ) ;
+
+  for ( i = 0 ; args[ i ] ; i++ ) {
+    if ( !appendJvmOption( &jvmOptions, args[ i ], NULL ) ) goto end ;
+  }
+
+  key = jst_createSharedArchiveKey( &jvmOptions, launcherOptionCount, javaHome ) ;
+
+  end:
+  if ( jvmOptions.options ) free( jvmOptions.options ) ;
+
+  return key ;
+}
+
+%}
+
+
+
+// the groovyc up to date check. The args are processed against the groovyc params the check looks at.
+
+%inline %{
+
+static const char* testGroovycClassplaceParam[] = { "-d", NULL } ;
+static const char* testGroovycJointcompParam[]  = { "-j", "--jointCompilation", NULL } ;
+static const char* testGroovycVersionParam[]    = { "-v", "--version", NULL } ;
+
+static JstParamInfo testGroovycParameters[] = {
+  { testGroovycClassplaceParam, JST_DOUBLE_PARAM, JST_TO_LAUNCHEE },
+  { testGroovycJointcompParam,  JST_SINGLE_PARAM, JST_TO_LAUNCHEE },
+  { testGroovycVersionParam,    JST_SINGLE_PARAM, JST_TO_LAUNCHEE },
+  { NULL,                       0,                0 }
+} ;
+
+/** Returns a tuple of what groovycCheckSources returns for the given args and the sources it selects for compilation, the
+ * latter a list on GROOVYC_COMPILE_CHANGED and None otherwise. No jvm options are given. */
+PyObject* testGroovycCheckSources( char** args, const char* classpath, const char* startupJar, const char* groovyConfFile,
+                                   const char* javaHome ) {
+  JstJvmOptions      jvmOptions ;
+  JstActualParam     *processedParams,
+                     *compileParams = NULL,
+                     *param ;
+  GroovycCheckResult result ;
+  PyObject           *sources = NULL,
+                     *rval    = NULL ;
+
+  memset( &jvmOptions, 0, sizeof( jvmOptions ) ) ;
+
+  if ( !( processedParams = jst_processInputParameters( args, countArgs( args ), testGroovycParameters, testTerminatingSuffixes, JST_CYGWIN_NO_CONVERT ) ) ) {
+    PyErr_SetString( PyExc_RuntimeError, "could not process the args" ) ;
+    return NULL ;
+  }
+
+  result = groovycCheckSources( processedParams, &jvmOptions, classpath, startupJar, groovyConfFile, javaHome, &compileParams ) ;
+
+  if ( result == GROOVYC_COMPILE_CHANGED ) {
+    sources = PyList_New( 0 ) ;
+    for ( param = compileParams ; param->param && sources ; param++ ) {
+      PyObject* item ;
+      if ( !( param->handling & JST_TERMINATING_OR_AFTER ) ) continue ;
+      item = PyString_FromString( param->param ) ;
+      if ( !item || PyList_Append( sources, item ) ) Py_CLEAR( sources ) ;
+      Py_XDECREF( item ) ;
+    }
+  } else {
+    Py_INCREF( Py_None ) ;
+    sources = Py_None ;
+  }
+
+  if ( sources ) {
+    rval = Py_BuildValue( "(iO)", (int)result, sources ) ;
+    Py_DECREF( sources ) ;
+  }
+
+  if ( compileParams ) free( compileParams ) ;
+  free( processedParams ) ;
+
+  return rval ;
+}
+
+%}
@@ -0,0 +1,121 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import os
+import shutil
+import tempfile
+import unittest
+
+import supportModule
+import nativelauncher
+
+
+#  The args are classified using the param definitions in nativelauncher.i, see ParamHandlingTest.py.
+
+class ArgFileTestCase ( unittest.TestCase ) :
+
+    def setUp( self ) :
+        self.dirname = tempfile.mkdtemp()
+
+    def tearDown( self ) :
+        shutil.rmtree( self.dirname )
+
+    def argFile( self, contents, name = 'args' ) :
+        fileName = os.path.join( self.dirname, name )
+        f = open( fileName, 'wb' )
+        try :
+            f.write( contents )
+        finally :
+            f.close()
+        return fileName
+
+    def expandWithStdin( self, contents, args, pipe ) :
+        savedStdin = os.dup( 0 )
+        try :
+            if pipe :
+                readEnd, writeEnd = os.pipe()
+                os.write( writeEnd, contents )
+                os.close( writeEnd )
+            else :
+                readEnd = os.open( self.argFile( contents, 'stdin' ), os.O_RDONLY )
+            os.dup2( readEnd, 0 )
+            os.close( readEnd )
+            return nativelauncher.testExpandArgFiles( args )
+        finally :
+            os.dup2( savedStdin, 0 )
+            os.close( savedStdin )
+
+    def testNothingToExpand( self ) :
+        self.assertEqual( [ '-h', '-c', 'UTF-8', 'script.groovy' ], nativelauncher.testExpandArgFiles( [ '-h', '-c', 'UTF-8', 'script.groovy' ] ) )
+
+    def testArgFile( self ) :
+        argFile = self.argFile( '-c\nUTF 8\n\n-h\r\n' )
+        self.assertEqual( [ '-d', '-c', 'UTF 8', '-h', 'script.groovy', 'a' ],
+                          nativelauncher.testExpandArgFiles( [ '-d', '@' + argFile, 'script.groovy', 'a' ] ) )
+
+    def testArgFileWithoutFinalNewline( self ) :
+        argFile = self.argFile( '-h\n-c\nUTF-8' )
+        self.assertEqual( [ '-h', '-c', 'UTF-8', '-d' ], nativelauncher.testExpandArgFiles( [ '@' + argFile, '-d' ] ) )
+
+    def testEmptyArgFile( self ) :
+        argFile = self.argFile( '' )
+        self.assertEqual( [ '-h' ], nativelauncher.testExpandArgFiles( [ '@' + argFile, '-h' ] ) )
+
+    def testArgFilesAreNotExpandedRecursively( self ) :
+        inner = self.argFile( '-d\n', 'inner' )
+        outer = self.argFile( '-h\n@' + inner + '\n', 'outer' )
+        self.assertEqual( [ '-h', '@' + inner ], nativelauncher.testExpandArgFiles( [ '@' + outer ] ) )
+
+    def testMissingArgFile( self ) :
+        missing = '@' + os.path.join( self.dirname, 'missing' )
+        self.assertEqual( [ missing, '-h' ], nativelauncher.testExpandArgFiles( [ missing, '-h' ] ) )
+        # nor is a dir an argument file
+        self.assertEqual( [ '@' + self.dirname ], nativelauncher.testExpandArgFiles( [ '@' + self.dirname ] ) )
+
+    def testLiteralAt( self ) :
+        argFile = self.argFile( '-h\n' )
+        self.assertEqual( [ '@x' ], nativelauncher.testExpandArgFiles( [ '@@x' ] ) )
+        self.assertEqual( [ '@' + argFile ], nativelauncher.testExpandArgFiles( [ '@@' + argFile ] ) )
+
+    def testArgsFromStdin0( self ) :
+        for pipe in [ True, False ] :
+            self.assertEqual( [ '-d', '-c', 'UTF 8\nx', '-h', 'script.groovy' ],
+                              self.expandWithStdin( '-c\0UTF 8\nx\0-h\0', [ '-d', '--args-from-stdin0', 'script.groovy' ], pipe ) )
+            # the last arg need not be terminated, and an empty arg is an arg
+            self.assertEqual( [ '-h', '', '-d' ], self.expandWithStdin( '-h\0\0-d', [ '--args-from-stdin0' ], pipe ) )
+
+    def testNoExpansionAfterTerminatingParam( self ) :
+        argFile = self.argFile( '-h\n' )
+        args = [ 'script.groovy', '@' + argFile, '@@x', '--args-from-stdin0' ]
+        self.assertEqual( args, nativelauncher.testExpandArgFiles( args ) )
+        # the code given w/ -e is passed on as it is
+        args = [ '-e', '@' + argFile, '@' + argFile ]
+        self.assertEqual( args, nativelauncher.testExpandArgFiles( args ) )
+
+    def testTerminatingParamFromArgFile( self ) :
+        argFile = self.argFile( '-h\nscript.groovy\n' )
+        self.assertEqual( [ '-h', 'script.groovy', '@' + argFile ], nativelauncher.testExpandArgFiles( [ '@' + argFile, '@' + argFile ] ) )
+
+    def testNoExpansionInParamValue( self ) :
+        argFile = self.argFile( '-h\n' )
+        self.assertEqual( [ '-c', '@' + argFile, '-h' ], nativelauncher.testExpandArgFiles( [ '-c', '@' + argFile, '@' + argFile ] ) )
+        self.assertEqual( [ '-c', '@@x' ], nativelauncher.testExpandArgFiles( [ '-c', '@@x' ] ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , ArgFileTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'
@@ -0,0 +1,71 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import unittest
+
+import supportModule
+import nativelauncher
+
+
+class CgroupTestCase ( unittest.TestCase ) :
+
+    def testCountCpus( self ) :
+        self.assertEqual( 7 , nativelauncher.jst_countCpus( '0-3,8,10-11' ) )
+        self.assertEqual( 7 , nativelauncher.jst_countCpus( '0-3,8,10-11\n' ) )
+        self.assertEqual( 1 , nativelauncher.jst_countCpus( '5' ) )
+        self.assertEqual( 64 , nativelauncher.jst_countCpus( '0-63' ) )
+        self.assertEqual( 3 , nativelauncher.jst_countCpus( '2,4,6' ) )
+
+    def testCountCpusOfEmptyOrMalformedList( self ) :
+        self.assertEqual( 0 , nativelauncher.jst_countCpus( '' ) )
+        self.assertEqual( 0 , nativelauncher.jst_countCpus( '\n' ) )
+        self.assertEqual( 0 , nativelauncher.jst_countCpus( 'max' ) )
+        self.assertEqual( 0 , nativelauncher.jst_countCpus( '3-1' ) )
+        self.assertEqual( 4 , nativelauncher.jst_countCpus( '0-3,x' ) )
+
+    def testParseJavaUpdateVersion( self ) :
+        self.assertEqual( 372 , nativelauncher.jst_parseJavaUpdateVersion( '1.8.0_372' , 8 ) )
+        self.assertEqual( 191 , nativelauncher.jst_parseJavaUpdateVersion( '1.8.0_191' , 8 ) )
+        self.assertEqual( 16 , nativelauncher.jst_parseJavaUpdateVersion( '11.0.16' , 11 ) )
+        self.assertEqual( 16 , nativelauncher.jst_parseJavaUpdateVersion( '11.0.16.1' , 11 ) )
+        self.assertEqual( 0 , nativelauncher.jst_parseJavaUpdateVersion( '1.8.0' , 8 ) )
+        self.assertEqual( 0 , nativelauncher.jst_parseJavaUpdateVersion( '11' , 11 ) )
+        self.assertEqual( 0 , nativelauncher.jst_parseJavaUpdateVersion( '17.0' , 17 ) )
+
+    def testCgroupSupportOfJava8( self ) :
+        self.assertEqual( nativelauncher.JST_CGROUP_UNSUPPORTED , nativelauncher.jst_getCgroupSupport( '1.8.0_181' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_ACTIVE_PROCESSOR_COUNT , nativelauncher.jst_getCgroupSupport( '1.8.0_191' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_ACTIVE_PROCESSOR_COUNT , nativelauncher.jst_getCgroupSupport( '1.8.0_362' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_V2_SUPPORTED , nativelauncher.jst_getCgroupSupport( '1.8.0_372' ) )
+
+    def testCgroupSupportOfJava11( self ) :
+        self.assertEqual( nativelauncher.JST_CGROUP_ACTIVE_PROCESSOR_COUNT , nativelauncher.jst_getCgroupSupport( '11.0.15' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_V2_SUPPORTED , nativelauncher.jst_getCgroupSupport( '11.0.16' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_V2_SUPPORTED , nativelauncher.jst_getCgroupSupport( '11.0.16.1' ) )
+
+    def testCgroupSupportOfOtherVersions( self ) :
+        self.assertEqual( nativelauncher.JST_CGROUP_UNSUPPORTED , nativelauncher.jst_getCgroupSupport( '1.7.0_80' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_UNSUPPORTED , nativelauncher.jst_getCgroupSupport( '9.0.4' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_ACTIVE_PROCESSOR_COUNT , nativelauncher.jst_getCgroupSupport( '10.0.2' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_ACTIVE_PROCESSOR_COUNT , nativelauncher.jst_getCgroupSupport( '14.0.2' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_V2_SUPPORTED , nativelauncher.jst_getCgroupSupport( '15' ) )
+        self.assertEqual( nativelauncher.JST_CGROUP_V2_SUPPORTED , nativelauncher.jst_getCgroupSupport( '17.0.2' ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , CgroupTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'
@@ -14,6 +14,8 @@
 #  License.
 
 import os
+import shutil
+import tempfile
 import unittest
 
 import supportModule
@@ -41,6 +43,45 @@ class FileUtilsTestCase ( unittest.TestCase ) :
         parentdir = os.path.abspath( parentdir )
         self.assertEqual( parentdir, nativelauncher.jst_pathToParentDir( dirname ) )
 
+    def createDir( self, files, dirs = [] ) :
+        dirname = tempfile.mkdtemp()
+        self.addCleanup( shutil.rmtree, dirname )
+        for f in files :
+            open( os.path.join( dirname, f ), 'w' ).close()
+        for d in dirs :
+            os.mkdir( os.path.join( dirname, d ) )
+        return dirname
+
+    def testGetFileNamesOrder( self ) :
+        # in byte order, whatever order the os lists them in
+        names = [ 'b.jar', 'a.jar', 'B.jar', 'a-1.jar', 'a.jarx', '_c.jar', 'aa.jar' ]
+        dirname = self.createDir( names )
+        self.assertEqual( sorted( names ), nativelauncher.jst_getFileNames( dirname, None, None, None ) )
+        self.assertEqual( sorted( names ), nativelauncher.jst_getFileNames( dirname, '', '', None ) )
+
+    def testGetFileNamesFiltering( self ) :
+        dirname = self.createDir( [ 'groovy-1.8.jar', 'groovy-all.jar', 'groovy.jar', 'ant.jar', 'groovy-1.8.jar.txt', 'xgroovy.jar' ], [ 'groovy-dir.jar' ] )
+        self.assertEqual( [ 'ant.jar', 'groovy-1.8.jar', 'groovy-all.jar', 'groovy-dir.jar', 'groovy.jar', 'xgroovy.jar' ],
+                          nativelauncher.jst_getFileNames( dirname, None, '.jar', None ) )
+        self.assertEqual( [ 'groovy-1.8.jar', 'groovy-1.8.jar.txt', 'groovy-all.jar', 'groovy-dir.jar' ],
+                          nativelauncher.jst_getFileNames( dirname, 'groovy-', None, None ) )
+        self.assertEqual( [ 'groovy-1.8.jar', 'groovy-all.jar', 'groovy-dir.jar' ],
+                          nativelauncher.jst_getFileNames( dirname, 'groovy-', '.jar', None ) )
+        self.assertEqual( [], nativelauncher.jst_getFileNames( dirname, 'groovy-', '.zip', None ) )
+        # a name may be both the prefix and the suffix
+        self.assertEqual( [ 'groovy.jar' ], nativelauncher.jst_getFileNames( dirname, 'groovy.jar', '.jar', None ) )
+
+    def testGetFileNamesOfType( self ) :
+        dirname = self.createDir( [ 'a.jar', 'c.jar' ], [ 'b.jar' ] )
+        self.assertEqual( [ 'a.jar', 'b.jar', 'c.jar' ], nativelauncher.jst_getFileNamesOfType( dirname, None, '.jar', nativelauncher.JST_ANY_ENTRY, None ) )
+        self.assertEqual( [ 'a.jar', 'c.jar' ], nativelauncher.jst_getFileNamesOfType( dirname, None, '.jar', nativelauncher.JST_FILE_ENTRY, None ) )
+        self.assertEqual( [ 'b.jar' ], nativelauncher.jst_getFileNamesOfType( dirname, None, '.jar', nativelauncher.JST_DIR_ENTRY, None ) )
+
+    def testGetFileNamesOfMissingDir( self ) :
+        dirname = self.createDir( [] )
+        self.assertEqual( [], nativelauncher.jst_getFileNames( dirname, None, None, None ) )
+        self.assertRaises( IOError, nativelauncher.jst_getFileNames, os.path.join( dirname, 'missing' ), None, None, None )
+
         
 
 def runTests ( path , architecture ) :
@@ -0,0 +1,111 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import os
+import shutil
+import tempfile
+import unittest
+
+import supportModule
+import nativelauncher
+
+
+class GroovyStarterConfTestCase ( unittest.TestCase ) :
+
+    def setUp( self ) :
+        self.dirname = tempfile.mkdtemp()
+        self.groovyHome = os.path.join( self.dirname, 'groovy' )
+        self.userHome = os.path.join( self.dirname, 'home' )
+        for f in [ 'groovy/lib/b.jar', 'groovy/lib/a.jar', 'groovy/lib/notes.txt', 'groovy/lib/sub/c.jar', 'groovy/lib/sub/deep/d.jar',
+                   'home/.groovy/lib/u.jar' ] :
+            path = os.path.join( self.dirname, f )
+            if not os.path.isdir( os.path.dirname( path ) ) : os.makedirs( os.path.dirname( path ) )
+            open( path, 'w' ).close()
+        self.dOptions = [ '-Dgroovy.home=' + self.groovyHome, '-Duser.home=' + self.userHome ]
+
+    def tearDown( self ) :
+        shutil.rmtree( self.dirname )
+
+    def lib( self, *names ) :
+        return [ os.path.join( self.groovyHome, 'lib', name ) for name in names ]
+
+    def classpath( self, *lines ) :
+        confFile = os.path.join( self.dirname, 'groovy-starter.conf' )
+        conf = open( confFile, 'w' )
+        try :
+            conf.write( '\n'.join( lines ) + '\n' )
+        finally :
+            conf.close()
+        return nativelauncher.groovyStarterConfClasspath( confFile, self.dOptions )
+
+    def testStandardConf( self ) :
+        self.assertEqual( self.lib( 'a.jar', 'b.jar' ) + [ os.path.join( self.userHome, '.groovy', 'lib', 'u.jar' ) ],
+                          self.classpath( '# load required libraries',
+                                          '',
+                                          'load !{groovy.home}/lib/*.jar',
+                                          '   # load user specific libraries',
+                                          '  load ${user.home}/.groovy/lib/*.jar  ',
+                                          '',
+                                          'main is org.codehaus.groovy.tools.GroovyMain' ) )
+
+    def testLastDOptionStands( self ) :
+        self.dOptions = [ '-Dgroovy.home=/nonexistent' ] + self.dOptions
+        self.assertEqual( self.lib( 'a.jar', 'b.jar' ), self.classpath( 'load !{groovy.home}/lib/*.jar' ) )
+
+    def testOptionalPropertyNotSet( self ) :
+        # the line is dropped, as in LoaderConfiguration
+        self.assertEqual( self.lib( 'a.jar' ), self.classpath( 'load ${tools.jar}', 'load !{groovy.home}/lib/a.jar' ) )
+
+    def testRequiredPropertyNotSet( self ) :
+        # GroovyStarter reports the error
+        self.assertEqual( None, self.classpath( 'load !{tools.jar}', 'load !{groovy.home}/lib/a.jar' ) )
+
+    def testPropertyOnlyKnownToTheJvm( self ) :
+        self.assertEqual( None, self.classpath( 'load ${java.home}/lib/tools.jar' ) )
+        self.assertEqual( None, self.classpath( 'load !{java.home}/lib/tools.jar' ) )
+
+    def testSeveralProperties( self ) :
+        self.dOptions.append( '-Dlib.dir=lib' )
+        self.assertEqual( self.lib( 'a.jar' ), self.classpath( 'load !{groovy.home}/${lib.dir}/a.jar' ) )
+        self.assertEqual( [], self.classpath( 'load !{groovy.home}/${no.such.dir}/a.jar' ) )
+
+    def testWildcards( self ) :
+        # * does not match a file separator
+        self.assertEqual( self.lib( 'sub/c.jar' ), self.classpath( 'load !{groovy.home}/lib/sub/*.jar' ) )
+        self.assertEqual( self.lib( 'a.jar', 'b.jar', 'notes.txt' ), self.classpath( 'load !{groovy.home}/lib/*' ) )
+        # ** matches any number of dirs, the subdirs are gone through before the files of a dir
+        self.assertEqual( self.lib( 'sub/deep/d.jar', 'sub/c.jar' ), self.classpath( 'load !{groovy.home}/lib/**/*.jar' ) )
+        self.assertEqual( self.lib( 'sub/deep/d.jar', 'sub/c.jar', 'a.jar', 'b.jar' ), self.classpath( 'load !{groovy.home}/lib/**.jar' ) )
+        self.assertEqual( [], self.classpath( 'load !{groovy.home}/nonexistent/*.jar' ) )
+
+    def testMissingFileIsSkipped( self ) :
+        self.assertEqual( self.lib( 'b.jar' ), self.classpath( 'load !{groovy.home}/lib/missing.jar', 'load !{groovy.home}/lib/b.jar' ) )
+
+    def testUnrecognizedLine( self ) :
+        self.assertEqual( None, self.classpath( 'load !{groovy.home}/lib/*.jar', 'grab org.example:lib:1.0' ) )
+        self.assertEqual( None, self.classpath( 'loadx !{groovy.home}/lib/*.jar' ) )
+
+    def testEmptyConf( self ) :
+        self.assertEqual( [], self.classpath( '# nothing to load' ) )
+
+    def testMissingConf( self ) :
+        self.assertEqual( None, nativelauncher.groovyStarterConfClasspath( os.path.join( self.dirname, 'missing.conf' ), self.dOptions ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , GroovyStarterConfTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'
@@ -0,0 +1,132 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import os
+import shutil
+import tempfile
+import unittest
+
+import supportModule
+import nativelauncher
+
+
+#  The sources are compiled by writing a class file for each into the output dir between the check and recording the
+#  compilation, the way groovyc would.
+
+class GroovycManifestTestCase ( unittest.TestCase ) :
+
+    def setUp( self ) :
+        self.dirname = tempfile.mkdtemp()
+        for subdir in [ 'src' , 'out' , 'classpath' , 'lib' , 'cache' ] :
+            os.mkdir( os.path.join( self.dirname , subdir ) )
+        self.outputDir = os.path.join( self.dirname , 'out' )
+        self.startupJar = self.writeFile( os.path.join( 'lib' , 'groovy.jar' ) , 'jar' )
+        self.groovyConfFile = self.writeFile( 'groovy-starter.conf' , 'load ${groovy.home}/lib/*.jar\n' )
+        self.originalCacheDir = os.environ.get( '__JLAUNCHER_CACHE_DIR' )
+        os.environ[ '__JLAUNCHER_CACHE_DIR' ] = os.path.join( self.dirname , 'cache' )
+        self.a = self.writeSource( 'A' , 'class A {\n  String name\n}\n' )
+        self.b = self.writeSource( 'B' , 'class B {\n  A a = new A()\n}\n' )
+        self.c = self.writeSource( 'C' , 'class C {\n  int count\n}\n' )
+
+    def tearDown( self ) :
+        if self.originalCacheDir is None :
+            del os.environ[ '__JLAUNCHER_CACHE_DIR' ]
+        else :
+            os.environ[ '__JLAUNCHER_CACHE_DIR' ] = self.originalCacheDir
+        shutil.rmtree( self.dirname )
+
+    def writeFile( self , name , contents ) :
+        fileName = os.path.join( self.dirname , name )
+        f = open( fileName , 'wb' )
+        try :
+            f.write( contents )
+        finally :
+            f.close()
+        return fileName
+
+    def writeSource( self , className , contents ) :
+        return self.writeFile( os.path.join( 'src' , className + '.groovy' ) , contents )
+
+    def className( self , source ) :
+        return os.path.splitext( os.path.basename( source ) )[ 0 ]
+
+    def check( self , sources , options = [ ] ) :
+        return nativelauncher.testGroovycCheckSources( [ '-d' , self.outputDir ] + options + sources ,
+                                                       os.path.join( self.dirname , 'classpath' ) ,
+                                                       self.startupJar , self.groovyConfFile , None )
+
+    def compile( self , sources , options = [ ] ) :
+        '''Checks the sources, compiles those selected and records the compilation. Returns what the check returned.'''
+        result , selected = self.check( sources , options )
+        if result == nativelauncher.GROOVYC_COMPILE_ALL :
+            selected = sources
+        if result != nativelauncher.GROOVYC_UP_TO_DATE :
+            for source in selected :
+                self.writeFile( os.path.join( 'out' , self.className( source ) + '.class' ) , 'class ' + self.className( source ) )
+            nativelauncher.groovycRecordCompile( 0 )
+        return result , selected
+
+    def testFirstCompileCompilesAll( self ) :
+        self.assertEqual( ( nativelauncher.GROOVYC_COMPILE_ALL , None ) , self.check( [ self.a , self.b , self.c ] ) )
+
+    def testUpToDate( self ) :
+        self.compile( [ self.a , self.b , self.c ] )
+        self.assertEqual( ( nativelauncher.GROOVYC_UP_TO_DATE , None ) , self.check( [ self.a , self.b , self.c ] ) )
+
+    def testFailedCompileIsNotRecorded( self ) :
+        self.check( [ self.a , self.b , self.c ] )
+        nativelauncher.groovycRecordCompile( 1 )
+        self.assertEqual( nativelauncher.GROOVYC_COMPILE_ALL , self.check( [ self.a , self.b , self.c ] )[ 0 ] )
+
+    def testChangedSourceIsCompiledWithItsDependents( self ) :
+        self.compile( [ self.a , self.b , self.c ] )
+        self.writeSource( 'A' , 'class A {\n  String name\n  int age\n}\n' )
+        self.assertEqual( ( nativelauncher.GROOVYC_COMPILE_CHANGED , [ self.a , self.b ] ) , self.compile( [ self.a , self.b , self.c ] ) )
+        self.assertEqual( ( nativelauncher.GROOVYC_UP_TO_DATE , None ) , self.check( [ self.a , self.b , self.c ] ) )
+
+    def testChangedSourceWithoutDependents( self ) :
+        self.compile( [ self.a , self.b , self.c ] )
+        self.writeSource( 'C' , 'class C {\n  long count\n}\n' )
+        self.assertEqual( ( nativelauncher.GROOVYC_COMPILE_CHANGED , [ self.c ] ) , self.check( [ self.a , self.b , self.c ] ) )
+
+    def testJointCompilationCompilesAll( self ) :
+        self.compile( [ self.a , self.b , self.c ] , [ '-j' ] )
+        self.assertEqual( ( nativelauncher.GROOVYC_UP_TO_DATE , None ) , self.check( [ self.a , self.b , self.c ] , [ '-j' ] ) )
+        self.writeSource( 'C' , 'class C {\n  long count\n}\n' )
+        self.assertEqual( ( nativelauncher.GROOVYC_COMPILE_ALL , None ) , self.check( [ self.a , self.b , self.c ] , [ '-j' ] ) )
+
+    def testRemovedSourceCompilesAll( self ) :
+        self.compile( [ self.a , self.b , self.c ] )
+        self.assertEqual( ( nativelauncher.GROOVYC_COMPILE_ALL , None ) , self.check( [ self.a , self.b ] ) )
+
+    def testDeletedOutputCompilesAll( self ) :
+        self.compile( [ self.a , self.b , self.c ] )
+        os.remove( os.path.join( self.outputDir , 'C.class' ) )
+        self.assertEqual( ( nativelauncher.GROOVYC_COMPILE_ALL , None ) , self.check( [ self.a , self.b , self.c ] ) )
+
+    def testChangedFlagsCompileAll( self ) :
+        self.compile( [ self.a , self.b , self.c ] )
+        self.assertEqual( ( nativelauncher.GROOVYC_COMPILE_ALL , None ) , self.check( [ self.a , self.b , self.c ] , [ '-j' ] ) )
+
+    def testVersionIsNotTracked( self ) :
+        self.compile( [ self.a , self.b , self.c ] )
+        self.assertEqual( ( nativelauncher.GROOVYC_COMPILE_ALL , None ) , self.check( [ self.a , self.b , self.c ] , [ '-v' ] ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , GroovycManifestTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'
@@ -0,0 +1,59 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import unittest
+
+import supportModule
+import nativelauncher
+
+
+class JvmOptionsTestCase ( unittest.TestCase ) :
+
+    def testWhitespaceSeparated( self ) :
+        self.assertEqual( [ '-Xmx512m', '-Dfoo=bar' ], nativelauncher.testJVMOptsString( '-Xmx512m -Dfoo=bar' ) )
+        self.assertEqual( [ '-Xmx512m', '-Dfoo=bar' ], nativelauncher.testJVMOptsString( '  -Xmx512m \t\n -Dfoo=bar  ' ) )
+        self.assertEqual( [], nativelauncher.testJVMOptsString( '' ) )
+        self.assertEqual( [], nativelauncher.testJVMOptsString( ' \t ' ) )
+
+    def testQuotedValues( self ) :
+        self.assertEqual( [ '-Dapp.title=My app', '-Xss1m' ], nativelauncher.testJVMOptsString( '"-Dapp.title=My app" -Xss1m' ) )
+        self.assertEqual( [ '-Dapp.title=My app' ], nativelauncher.testJVMOptsString( "-Dapp.title='My app'" ) )
+        # a quoted part may be in the middle of an option, and an empty one leaves nothing
+        self.assertEqual( [ '-Dx=a b c' ], nativelauncher.testJVMOptsString( '-Dx=a" b "c' ) )
+        self.assertEqual( [ '-Xss1m' ], nativelauncher.testJVMOptsString( '"" -Xss1m \'\'' ) )
+
+    def testMixedQuotes( self ) :
+        self.assertEqual( [ '-Dmsg=say "hi"' ], nativelauncher.testJVMOptsString( '\'-Dmsg=say "hi"\'' ) )
+        self.assertEqual( [ "-Dmsg=it's" ], nativelauncher.testJVMOptsString( '"-Dmsg=it\'s"' ) )
+        self.assertEqual( [ '-Da=1 "2"', "-Db=3 '4'" ], nativelauncher.testJVMOptsString( '\'-Da=1 "2"\' "-Db=3 \'4\'"' ) )
+
+    def testBackslashesAreKept( self ) :
+        self.assertEqual( [ '-Dpath=C:\\Program Files\\x' ], nativelauncher.testJVMOptsString( '"-Dpath=C:\\Program Files\\x"' ) )
+
+    def testUnmatchedQuote( self ) :
+        self.assertEqual( None, nativelauncher.testJVMOptsString( '-Xmx512m "-Dapp.title=My app' ) )
+        self.assertEqual( None, nativelauncher.testJVMOptsString( "-Dx='a \"b\"" ) )
+
+    def testJvmSelection( self ) :
+        self.assertEqual( [ '-Xmx512m' ], nativelauncher.testJVMOptsString( '-server -Xmx512m -client' ) )
+        # quoted, -server is still the same option
+        self.assertEqual( [], nativelauncher.testJVMOptsString( '"-server"' ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , JvmOptionsTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'
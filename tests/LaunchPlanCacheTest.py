@@ -0,0 +1,168 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import os
+import shutil
+import struct
+import tempfile
+import time
+import unittest
+
+import supportModule
+import nativelauncher
+
+
+#  The layout of the header of a plan file (see jst_cache.c): magic, file size, stamp count, entry count, reserved.
+headerFormat = '=8sIIII'
+
+class LaunchPlanCacheTestCase ( unittest.TestCase ) :
+
+    def setUp( self ) :
+        self.dirname = tempfile.mkdtemp()
+        self.planDir = os.path.join( self.dirname , 'cache' , 'launchplans' )
+        self.originalEnv = dict( ( name , os.environ.get( name ) ) for name in [ '__JLAUNCHER_CACHE_DIR' , '__JLAUNCHER_NOCACHE' ] )
+        os.environ[ '__JLAUNCHER_CACHE_DIR' ] = os.path.join( self.dirname , 'cache' )
+        if '__JLAUNCHER_NOCACHE' in os.environ :
+            del os.environ[ '__JLAUNCHER_NOCACHE' ]
+        # stamps modified less than a couple of seconds ago are not trusted, see jst_cache.c
+        self.stamp = self.createFile( 'stamp' , time.time() - 100 )
+        self.entries = [ '/opt/java' , '' , '/opt/groovy/lib/groovy.jar' ]
+
+    def tearDown( self ) :
+        for name , value in self.originalEnv.items() :
+            if value is None :
+                if name in os.environ :
+                    del os.environ[ name ]
+            else :
+                os.environ[ name ] = value
+        shutil.rmtree( self.dirname )
+
+    def createFile( self , name , mtime ) :
+        fileName = os.path.join( self.dirname , name )
+        open( fileName , 'wb' ).close()
+        os.utime( fileName , ( mtime , mtime ) )
+        return fileName
+
+    def planFiles( self ) :
+        return set( os.listdir( self.planDir ) ) if os.path.isdir( self.planDir ) else set()
+
+    def storeNewPlan( self , key , entries , stampFiles ) :
+        '''Stores the plan and returns the name of the file it was stored in.'''
+        before = self.planFiles()
+        self.assertEqual( 1 , nativelauncher.jst_storeLaunchPlan( key , entries , stampFiles ) )
+        created = self.planFiles() - before
+        self.assertEqual( 1 , len( created ) )
+        return os.path.join( self.planDir , created.pop() )
+
+    def readFile( self , fileName ) :
+        f = open( fileName , 'rb' )
+        try :
+            return f.read()
+        finally :
+            f.close()
+
+    def writeFile( self , fileName , contents ) :
+        f = open( fileName , 'wb' )
+        try :
+            f.write( contents )
+        finally :
+            f.close()
+
+    def testRoundTrip( self ) :
+        self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        self.assertEqual( self.entries , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+
+    def testRoundTripWithoutStamps( self ) :
+        self.storeNewPlan( 'key\nwith lines' , [ 'a' ] , [ ] )
+        self.assertEqual( [ 'a' ] , nativelauncher.jst_loadLaunchPlan( 'key\nwith lines' , 1 ) )
+
+    def testStoringReplacesThePlan( self ) :
+        self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        self.assertEqual( 1 , nativelauncher.jst_storeLaunchPlan( 'key' , [ 'a' , 'b' , 'c' ] , [ self.stamp ] ) )
+        self.assertEqual( [ 'a' , 'b' , 'c' ] , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+
+    def testNoPlan( self ) :
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+
+    def testOtherKey( self ) :
+        self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key2' , 3 ) )
+
+    def testDifferentEntryCount( self ) :
+        self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 2 ) )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 4 ) )
+
+    def testModifiedStampInvalidatesThePlan( self ) :
+        otherStamp = self.createFile( 'otherStamp' , time.time() - 100 )
+        self.storeNewPlan( 'key' , self.entries , [ otherStamp , self.stamp ] )
+        os.utime( self.stamp , ( time.time() - 50 , time.time() - 50 ) )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+
+    def testRemovedStampInvalidatesThePlan( self ) :
+        self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        os.remove( self.stamp )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+
+    def testRecentlyModifiedOrMissingStampIsNotStored( self ) :
+        recentStamp = self.createFile( 'recentStamp' , time.time() )
+        self.assertEqual( 0 , nativelauncher.jst_storeLaunchPlan( 'key' , self.entries , [ self.stamp , recentStamp ] ) )
+        self.assertEqual( 0 , nativelauncher.jst_storeLaunchPlan( 'key' , self.entries , [ os.path.join( self.dirname , 'missing' ) ] ) )
+        self.assertEqual( set() , self.planFiles() )
+
+    def testKeyMismatchAfterHashCollision( self ) :
+        # a collision is simulated by moving the plan of one key to the file the other key hashes to
+        fileName = self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        otherFileName = self.storeNewPlan( 'other key' , [ 'a' , 'b' , 'c' ] , [ self.stamp ] )
+        shutil.copyfile( fileName , otherFileName )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'other key' , 3 ) )
+        self.assertEqual( self.entries , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+
+    def testTruncatedPlanIsRejected( self ) :
+        fileName = self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        contents = self.readFile( fileName )
+        for length in [ 0 , 4 , struct.calcsize( headerFormat ) , len( contents ) - 5 , len( contents ) - 1 ] :
+            self.writeFile( fileName , contents[ : length ] )
+            self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+
+    def testCorruptedPlanIsRejected( self ) :
+        fileName = self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        contents = self.readFile( fileName )
+        headerSize = struct.calcsize( headerFormat )
+        magic , fileSize , stampCount , entryCount , reserved = struct.unpack( headerFormat , contents[ : headerSize ] )
+        self.writeFile( fileName , 'X' + contents[ 1 : ] )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+        # the size in the header agrees w/ the file, but the last entry is missing
+        truncated = contents[ : - ( len( self.entries[ -1 ] ) + 1 ) ]
+        self.writeFile( fileName , struct.pack( headerFormat , magic , len( truncated ) , stampCount , entryCount , reserved ) + truncated[ headerSize : ] )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+        # more stamps than there are names for
+        self.writeFile( fileName , struct.pack( headerFormat , magic , fileSize , stampCount + 3 , entryCount , reserved ) + contents[ headerSize : ] )
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+        self.writeFile( fileName , contents )
+        self.assertEqual( self.entries , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+
+    def testCachingDisabled( self ) :
+        self.storeNewPlan( 'key' , self.entries , [ self.stamp ] )
+        os.environ[ '__JLAUNCHER_NOCACHE' ] = '1'
+        self.assertEqual( None , nativelauncher.jst_loadLaunchPlan( 'key' , 3 ) )
+        self.assertEqual( 0 , nativelauncher.jst_storeLaunchPlan( 'key2' , self.entries , [ self.stamp ] ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , LaunchPlanCacheTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'
@@ -0,0 +1,81 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import unittest
+
+import supportModule
+import nativelauncher
+
+
+#  The params are processed against the definitions in nativelauncher.i: -h/--help (single), -c/--encoding (double),
+#  -D (prefix), -d (single), -jh/--javahome (double), -e (double, terminating) and the terminating suffix .groovy.
+
+class ParamHandlingTestCase ( unittest.TestCase ) :
+
+    def testAliases( self ) :
+        self.assertEqual( '', nativelauncher.testParameterValue( [ '--help' ], '-h' ) )
+        self.assertEqual( '', nativelauncher.testParameterValue( [ '-h' ], '--help' ) )
+        self.assertEqual( 'UTF-8', nativelauncher.testParameterValue( [ '--encoding', 'UTF-8' ], '-c' ) )
+        self.assertEqual( '/opt/java', nativelauncher.testParameterValue( [ '-jh', '/opt/java' ], '--javahome' ) )
+        self.assertEqual( None, nativelauncher.testParameterValue( [ '--encoding', 'UTF-8' ], '-h' ) )
+        self.assertEqual( None, nativelauncher.testParameterValue( [ '--help' ], '--unknown' ) )
+
+    def testPrefixParams( self ) :
+        self.assertEqual( 'foo=bar', nativelauncher.testParameterValue( [ '-Dfoo=bar' ], '-D' ) )
+        self.assertEqual( '', nativelauncher.testParameterValue( [ '-D' ], '-D' ) )
+        # an exact name is not taken as a prefix
+        self.assertEqual( '', nativelauncher.testParameterValue( [ '-d' ], '-d' ) )
+        self.assertEqual( None, nativelauncher.testParameterValue( [ '-d' ], '-D' ) )
+        self.assertEqual( None, nativelauncher.testParameterValue( [ '-dx' ], '-d' ) )
+
+    def testRepeatedParams( self ) :
+        # the first occurrence counts
+        self.assertEqual( 'a', nativelauncher.testParameterValue( [ '-c', 'a', '--encoding', 'b' ], '-c' ) )
+        self.assertEqual( 'x=1', nativelauncher.testParameterValue( [ '-Dx=1', '-h', '-Dy=2' ], '-D' ) )
+        self.assertEqual( '', nativelauncher.testParameterValue( [ '-h', '-c', 'a', '--help' ], '--help' ) )
+
+    def testDoubleParamValueIsNotAParam( self ) :
+        self.assertEqual( '-h', nativelauncher.testParameterValue( [ '-c', '-h' ], '-c' ) )
+        self.assertEqual( None, nativelauncher.testParameterValue( [ '-c', '-h' ], '-h' ) )
+
+    def testValuesAfterTerminatingParam( self ) :
+        args = [ '-c', 'a', 'script.groovy', '-c', 'b', '--help', '-Dx=1' ]
+        self.assertEqual( 'a', nativelauncher.testParameterValue( args, '-c' ) )
+        self.assertEqual( None, nativelauncher.testParameterValue( args, '-h' ) )
+        self.assertEqual( None, nativelauncher.testParameterValue( args, '-D' ) )
+        self.assertEqual( 'script.groovy', nativelauncher.testParameterAfterTermination( args, 0 ) )
+        self.assertEqual( '-c', nativelauncher.testParameterAfterTermination( args, 1 ) )
+        self.assertEqual( '-Dx=1', nativelauncher.testParameterAfterTermination( args, 4 ) )
+        self.assertEqual( None, nativelauncher.testParameterAfterTermination( args, 5 ) )
+
+    def testValuesAfterTerminatingDoubleParam( self ) :
+        args = [ '-h', '-e', 'println 1', '-c', 'a' ]
+        self.assertEqual( '', nativelauncher.testParameterValue( args, '-h' ) )
+        # the terminating param is passed on as it is, the launcher does not look at it
+        self.assertEqual( None, nativelauncher.testParameterValue( args, '-e' ) )
+        self.assertEqual( None, nativelauncher.testParameterValue( args, '-c' ) )
+        self.assertEqual( '-e', nativelauncher.testParameterAfterTermination( args, 0 ) )
+        self.assertEqual( 'println 1', nativelauncher.testParameterAfterTermination( args, 1 ) )
+        self.assertEqual( '-c', nativelauncher.testParameterAfterTermination( args, 2 ) )
+
+    def testNoTerminatingParam( self ) :
+        self.assertEqual( None, nativelauncher.testParameterAfterTermination( [ '-h', '-c', 'a' ], 0 ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , ParamHandlingTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'
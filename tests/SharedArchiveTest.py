@@ -0,0 +1,64 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import unittest
+
+import supportModule
+import nativelauncher
+
+
+javaHome = '/usr/lib/jvm/java-17'
+classpath = '-Djava.class.path=/opt/groovy/lib/groovy-4.0.jar:/opt/groovy/lib/ivy.jar'
+
+def scriptOptions( scriptName, classpathOption = classpath ) :
+    return [ classpathOption, '-Dgroovy.home=/opt/groovy', '-Dscript.name=' + scriptName, '-Xmx512m' ]
+
+#  The options tuning the jvm for a run, added after the ones given by the launcher and the user.
+profileOptions = [ '-XX:TieredStopAtLevel=1', '-XX:+UseSerialGC', '-Xms16m', '-XX:ActiveProcessorCount=2' ]
+
+class SharedArchiveTestCase ( unittest.TestCase ) :
+
+    def key( self, options, launcherOptionCount = None, home = javaHome ) :
+        if launcherOptionCount is None : launcherOptionCount = len( options )
+        return nativelauncher.testSharedArchiveKey( options, launcherOptionCount, home )
+
+    def testScriptsShareArchive( self ) :
+        self.assertEqual( self.key( scriptOptions( '/home/me/a.groovy' ) ), self.key( scriptOptions( '/home/me/b.groovy' ) ) )
+
+    def testRunTuningOptionsDoNotMatter( self ) :
+        options = scriptOptions( 'a.groovy' )
+        self.assertEqual( self.key( options ), self.key( options + profileOptions, len( options ) ) )
+
+    def testOtherOptionsDoNotMatter( self ) :
+        self.assertEqual( self.key( scriptOptions( 'a.groovy' ) ), self.key( scriptOptions( 'a.groovy' ) + [ '-Xss4m', '-Dfoo=bar' ] ) )
+
+    def testClasspathMatters( self ) :
+        self.assertNotEqual( self.key( scriptOptions( 'a.groovy' ) ),
+                             self.key( scriptOptions( 'a.groovy', classpath + ':/home/me/lib/extra.jar' ) ) )
+        self.assertNotEqual( self.key( scriptOptions( 'a.groovy' ) ),
+                             self.key( scriptOptions( 'a.groovy' ) + [ '-Xbootclasspath/a:/opt/agent.jar' ] ) )
+
+    def testGcMatters( self ) :
+        self.assertNotEqual( self.key( scriptOptions( 'a.groovy' ) ), self.key( scriptOptions( 'a.groovy' ) + [ '-XX:+UseParallelGC' ] ) )
+
+    def testJavaHomeMatters( self ) :
+        self.assertNotEqual( self.key( scriptOptions( 'a.groovy' ) ), self.key( scriptOptions( 'a.groovy' ), home = '/usr/lib/jvm/java-21' ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , SharedArchiveTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'
@@ -0,0 +1,105 @@
+# -*- mode:python; coding:utf-8; -*-
+# jedit: :mode=python:
+
+#  Copyright � 2010 Antti Karanta
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+#  compliance with the License. You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software distributed under the License is
+#  distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+#  implied. See the License for the specific language governing permissions and limitations under the
+#  License.
+
+import os
+import shutil
+import tempfile
+import unittest
+import zipfile
+
+import supportModule
+import nativelauncher
+
+
+manifest = '''Manifest-Version: 1.0
+Created-By: 1.6.0_20 (Sun Microsystems Inc.)
+implementation-title: Groovy
+Implementation-Version: 1.7.5
+Implementation-Vendor: The Codehaus
+Main-Class: groovy.ui.GroovyMain
+Class-Path: lib/antlr-2.7.7.jar lib/asm-3.2.jar lib/asm-commons-3.2.jar lib/asm-tree-3.2.jar lib/asm-u
+ til-3.2.jar lib/commons-cli-1.2.jar
+
+Name: groovy/lang/
+Specification-Title: Groovy
+Implementation-Vendor-Id: org.codehaus.groovy
+
+'''
+
+class ZipTestCase ( unittest.TestCase ) :
+
+    def setUp( self ) :
+        self.dirname = tempfile.mkdtemp()
+
+    def tearDown( self ) :
+        shutil.rmtree( self.dirname )
+
+    def createJar( self, name, compression, entries ) :
+        jarFile = os.path.join( self.dirname, name )
+        jar = zipfile.ZipFile( jarFile, 'w', compression )
+        try :
+            # the manifest is not necessarily the first entry
+            jar.writestr( 'groovy/lang/GroovyObject.class', '\xca\xfe\xba\xbe' * 64 )
+            for entryName, contents in entries :
+                jar.writestr( entryName, contents )
+        finally :
+            jar.close()
+        return jarFile
+
+    def checkManifestAttributes( self, compression ) :
+        jarFile = self.createJar( 'groovy.jar', compression, [ ( 'META-INF/MANIFEST.MF', manifest ) ] )
+        self.assertEqual( '1.7.5', nativelauncher.jst_getJarManifestAttribute( jarFile, 'Implementation-Version' ) )
+        # attribute names are case insensitive
+        self.assertEqual( '1.7.5', nativelauncher.jst_getJarManifestAttribute( jarFile, 'implementation-version' ) )
+        self.assertEqual( 'Groovy', nativelauncher.jst_getJarManifestAttribute( jarFile, 'Implementation-Title' ) )
+        # a long value continues on the next line
+        self.assertEqual( 'lib/antlr-2.7.7.jar lib/asm-3.2.jar lib/asm-commons-3.2.jar lib/asm-tree-3.2.jar lib/asm-util-3.2.jar lib/commons-cli-1.2.jar',
+                          nativelauncher.jst_getJarManifestAttribute( jarFile, 'Class-Path' ) )
+        # only the main attributes are looked at
+        self.assertEqual( None, nativelauncher.jst_getJarManifestAttribute( jarFile, 'Implementation-Vendor-Id' ) )
+        self.assertEqual( None, nativelauncher.jst_getJarManifestAttribute( jarFile, 'Implementation' ) )
+
+    def testStoredJar( self ) :
+        self.checkManifestAttributes( zipfile.ZIP_STORED )
+
+    def testDeflatedJar( self ) :
+        self.checkManifestAttributes( zipfile.ZIP_DEFLATED )
+
+    def testWindowsLineEnds( self ) :
+        jarFile = self.createJar( 'groovy.jar', zipfile.ZIP_DEFLATED, [ ( 'META-INF/MANIFEST.MF', manifest.replace( '\n', '\r\n' ) ) ] )
+        self.assertEqual( '1.7.5', nativelauncher.jst_getJarManifestAttribute( jarFile, 'Implementation-Version' ) )
+        self.assertEqual( 'lib/antlr-2.7.7.jar lib/asm-3.2.jar lib/asm-commons-3.2.jar lib/asm-tree-3.2.jar lib/asm-util-3.2.jar lib/commons-cli-1.2.jar',
+                          nativelauncher.jst_getJarManifestAttribute( jarFile, 'Class-Path' ) )
+
+    def testNoManifest( self ) :
+        jarFile = self.createJar( 'nomanifest.jar', zipfile.ZIP_DEFLATED, [] )
+        self.assertEqual( None, nativelauncher.jst_getJarManifestAttribute( jarFile, 'Implementation-Version' ) )
+
+    def testNotAJar( self ) :
+        notAJar = os.path.join( self.dirname, 'notajar.jar' )
+        f = open( notAJar, 'w' )
+        try :
+            f.write( manifest )
+        finally :
+            f.close()
+        self.assertEqual( None, nativelauncher.jst_getJarManifestAttribute( notAJar, 'Implementation-Version' ) )
+        self.assertEqual( None, nativelauncher.jst_getJarManifestAttribute( os.path.join( self.dirname, 'missing.jar' ), 'Implementation-Version' ) )
+
+
+def runTests ( path , architecture ) :
+    return supportModule.runTests ( path , architecture , ZipTestCase )
+
+if __name__ == '__main__' :
+    print 'Run tests using command "scons test".'